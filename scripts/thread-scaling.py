@@ -0,0 +1,104 @@
+#!/usr/bin/env python
+"""
+Measures the thread scaling of the non-bonded pair loop.
+
+Each sample is copied to a scratch directory, its runTime is shortened,
+and it is run with increasing values of OMP_NUM_THREADS.  The wall time
+and speedup relative to the first thread count are reported, along with the
+largest relative deviation of the total energy in the .stat file from
+the first run.
+
+usage: thread-scaling.py [-e openmd] [-t 1,2,4,8] [-r runTime] [sample.omd ...]
+"""
+
+from __future__ import print_function
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import tempfile
+import time
+
+defaultSamples = [
+    'samples/water/spce/spce.omd',
+    'samples/metals/Sutton-Chen/Au_bulk_SC.omd',
+]
+
+def shortenRun(omdFile, runTime):
+    with open(omdFile) as f:
+        text = f.read()
+    text = re.sub(r'runTime\s*=\s*[^;]+;', 'runTime = %s;' % runTime, text, 1)
+    text = re.sub(r'sampleTime\s*=\s*[^;]+;', 'sampleTime = %s;' % runTime,
+                  text, 1)
+    with open(omdFile, 'w') as f:
+        f.write(text)
+
+def totalEnergies(statFile):
+    energies = []
+    with open(statFile) as f:
+        for line in f:
+            if line.startswith('#') or not line.strip():
+                continue
+            # columns are time, total energy, ...
+            energies.append(float(line.split()[1]))
+    return energies
+
+def runSample(openmd, sample, nThreads, runTime):
+    workDir = tempfile.mkdtemp(prefix='openmd-scaling-')
+    try:
+        sampleDir = os.path.dirname(os.path.abspath(sample))
+        for name in os.listdir(sampleDir):
+            src = os.path.join(sampleDir, name)
+            if os.path.isfile(src):
+                shutil.copy(src, workDir)
+        omd = os.path.join(workDir, os.path.basename(sample))
+        shortenRun(omd, runTime)
+
+        env = dict(os.environ, OMP_NUM_THREADS=str(nThreads))
+        start = time.time()
+        with open(os.devnull, 'w') as devnull:
+            subprocess.check_call([openmd, os.path.basename(omd)],
+                                  cwd=workDir, env=env, stdout=devnull)
+        elapsed = time.time() - start
+        return elapsed, totalEnergies(os.path.splitext(omd)[0] + '.stat')
+    finally:
+        shutil.rmtree(workDir)
+
+def maxDeviation(reference, energies):
+    dev = 0.0
+    for e0, e in zip(reference, energies):
+        if e0 != 0.0:
+            dev = max(dev, abs((e - e0) / e0))
+    return dev
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Thread scaling of the '
+                                     'OpenMD non-bonded pair loop')
+    parser.add_argument('samples', nargs='*', default=defaultSamples,
+                        help='.omd files to run')
+    parser.add_argument('-e', '--openmd', default='openmd',
+                        help='openmd executable')
+    parser.add_argument('-t', '--threads', default='1,2,4,8',
+                        help='comma separated list of thread counts')
+    parser.add_argument('-r', '--runTime', default='100',
+                        help='shortened runTime (fs) for each sample')
+    args = parser.parse_args()
+
+    threads = [int(t) for t in args.threads.split(',')]
+
+    for sample in args.samples:
+        print('%s' % sample)
+        print('%8s %12s %10s %14s' % ('threads', 'wall (s)', 'speedup',
+                                      'max dE/E'))
+        t1 = None
+        reference = None
+        for n in threads:
+            elapsed, energies = runSample(args.openmd, sample, n, args.runTime)
+            if t1 is None:
+                t1 = elapsed
+                reference = energies
+            print('%8d %12.3f %10.2f %14.3e' % (n, elapsed, t1 / elapsed,
+                                                maxDeviation(reference,
+                                                             energies)))
+        print()
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+/**
+ * @file dumpParseRate.cpp
+ *
+ * Measures how fast DumpReader reads a trajectory.  Every frame of
+ * the dump file is read, first with one thread and then with
+ * OMP_NUM_THREADS threads, and the rates are reported in MB of the
+ * dump file and in frames per second.  The frame positions are found
+ * (or loaded from the .idx file) before the timing starts.
+ *
+ * usage: dumpParseRate file.dump [nPasses]
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "brains/Register.hpp"
+#include "brains/SimInfo.hpp"
+#include "brains/SimCreator.hpp"
+#include "io/DumpReader.hpp"
+#include "utils/Utility.hpp"
+#include "utils/simError.h"
+
+using namespace std;
+using namespace OpenMD;
+
+int main(int argc, char *argv []) {
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s file.dump [nPasses]\n", argv[0]);
+    return 1;
+  }
+  string dumpFileName = argv[1];
+  int nPasses = (argc > 2) ? atoi(argv[2]) : 1;
+
+  registerAll();
+
+  SimCreator creator;
+  SimInfo* info = creator.createSim(dumpFileName, false);
+  DumpReader* reader = new DumpReader(info, dumpFileName);
+  int nFrames = reader->getNFrames();
+
+  struct stat status;
+  stat(dumpFileName.c_str(), &status);
+  double megabytes = double(status.st_size) / 1048576.0;
+
+  vector<int> threads;
+  threads.push_back(1);
+#ifdef _OPENMP
+  int maxThreads = omp_get_max_threads();
+  if (maxThreads > 1) threads.push_back(maxThreads);
+#endif
+
+  printf("# %s\n", dumpFileName.c_str());
+  printf("# frames: %d  size: %.1f MB  passes: %d\n", nFrames, megabytes,
+         nPasses);
+  printf("%8s %12s %12s %12s\n", "threads", "time (s)", "MB/s", "frames/s");
+
+  for (unsigned int t = 0; t < threads.size(); t++) {
+#ifdef _OPENMP
+    omp_set_num_threads(threads[t]);
+#endif
+    RealType start = wallTime();
+    for (int pass = 0; pass < nPasses; pass++) 
+      for (int i = 0; i < nFrames; i++)
+        reader->readFrame(i);
+    RealType elapsed = wallTime() - start;
+
+    printf("%8d %12.3f %12.2f %12.2f\n", threads[t], elapsed, 
+           nPasses * megabytes / elapsed, nPasses * nFrames / elapsed);
+  }
+
+  delete reader;
+  delete info;
+  return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+/**
+ * @file pairLoopAllocs.cpp
+ *
+ * Counts heap allocations made by the force calculation.  The
+ * configuration in an .omd file is loaded, and the forces are
+ * evaluated repeatedly.  Every call to the global operator new is
+ * counted, and the number of allocations per step is reported both
+ * for the whole calculation and for the non-bonded pair loop alone.
+ *
+ * usage: pairLoopAllocs file.omd [nSteps]
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+#include <string>
+
+#include "brains/Register.hpp"
+#include "brains/SimInfo.hpp"
+#include "brains/SimCreator.hpp"
+#include "brains/ForceManager.hpp"
+#include "utils/simError.h"
+
+using namespace std;
+using namespace OpenMD;
+
+static volatile long nAllocations = 0;
+
+void* operator new(size_t size) {
+  __sync_fetch_and_add(&nAllocations, 1L);
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == NULL) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* p) { free(p); }
+void operator delete[](void* p) { free(p); }
+
+namespace OpenMD {
+  /**
+   * Separates the allocations made inside the non-bonded pair loop
+   * from those made in the rest of the force calculation.
+   */
+  class CountingForceManager : public ForceManager {
+  public:
+    CountingForceManager(SimInfo* info) : ForceManager(info),
+                                          pairLoopAllocations_(0) {}
+    long getPairLoopAllocations() { return pairLoopAllocations_; }
+    void resetCounts() { pairLoopAllocations_ = 0; }
+
+  protected:
+    virtual void longRangeInteractions() {
+      long n0 = nAllocations;
+      ForceManager::longRangeInteractions();
+      pairLoopAllocations_ += nAllocations - n0;
+    }
+
+  private:
+    long pairLoopAllocations_;
+  };
+}
+
+int main(int argc, char *argv []) {
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s file.omd [nSteps]\n", argv[0]);
+    return 1;
+  }
+  string inputFileName = argv[1];
+  int nSteps = (argc > 2) ? atoi(argv[2]) : 100;
+
+  registerAll();
+
+  SimCreator creator;
+  SimInfo* info = creator.createSim(inputFileName, false);
+  // very important step:
+  info->update();
+
+  CountingForceManager* forceMan = new CountingForceManager(info);
+  forceMan->initialize();
+
+  // the first evaluation builds the neighbor list and sizes the work
+  // arrays, so it is reported separately:
+  long n0 = nAllocations;
+  forceMan->calcForces();
+  long firstStep = nAllocations - n0;
+  long firstPairLoop = forceMan->getPairLoopAllocations();
+
+  forceMan->resetCounts();
+  n0 = nAllocations;
+  for (int i = 0; i < nSteps; i++)
+    forceMan->calcForces();
+  long total = nAllocations - n0;
+  long pairLoop = forceMan->getPairLoopAllocations();
+
+  printf("# %s\n", inputFileName.c_str());
+  printf("# atoms: %d  cutoff groups: %d  steps: %d\n",
+         info->getNGlobalAtoms(), info->getNGlobalCutoffGroups(), nSteps);
+  printf("%-28s %14s %14s\n", "", "calcForces", "pair loop");
+  printf("%-28s %14ld %14ld\n", "allocations (first step)",
+         firstStep, firstPairLoop);
+  printf("%-28s %14.2f %14.2f\n", "allocations per step",
+         double(total) / nSteps, double(pairLoop) / nSteps);
+
+  delete forceMan;
+  delete info;
+  return 0;
+}
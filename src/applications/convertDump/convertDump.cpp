@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+/**
+ * @file convertDump.cpp
+ *
+ * Converts a dump file between the text format and the binary
+ * format described in BinaryDumpFile.  The format of the input file
+ * is detected; the output is written in the binary format if its
+ * name ends in .bdump and in the text format otherwise.  With -z,
+ * the frames of a binary output file are compressed.
+ *
+ * usage: convertDump [-z] input output
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "brains/Register.hpp"
+#include "brains/SimInfo.hpp"
+#include "brains/SimCreator.hpp"
+#include "io/DumpReader.hpp"
+#include "io/DumpWriter.hpp"
+#include "utils/simError.h"
+
+using namespace std;
+using namespace OpenMD;
+
+int main(int argc, char *argv []) {
+
+  bool compress = false;
+  int arg = 1;
+  if (arg < argc && strcmp(argv[arg], "-z") == 0) {
+    compress = true;
+    arg++;
+  }
+  if (argc - arg != 2) {
+    fprintf(stderr, "usage: %s [-z] input output\n", argv[0]);
+    return 1;
+  }
+  string inputFileName = argv[arg];
+  string outputFileName = argv[arg + 1];
+
+  DumpWriter::DumpFormat format = DumpWriter::TextFormat;
+  string::size_type dot = outputFileName.rfind(".");
+  if (dot != string::npos && outputFileName.substr(dot) == ".bdump")
+    format = DumpWriter::BinaryFormat;
+
+  registerAll();
+
+  SimCreator creator;
+  SimInfo* info = creator.createSim(inputFileName, false);
+
+  DumpReader* reader = new DumpReader(info, inputFileName);
+  DumpWriter* writer = new DumpWriter(info, outputFileName, format, compress);
+
+  int nFrames = reader->getNFrames();
+  for (int i = 0; i < nFrames; i++) {
+    reader->readFrame(i);
+    writer->writeDump();
+  }
+
+  delete writer;
+  delete reader;
+  delete info;
+  return 0;
+}
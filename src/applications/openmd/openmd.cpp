@@ -73,7 +73,13 @@ int main(int argc, char* argv[]){
   // first things first, all of the initializations
 
 #ifdef IS_MPI
+#ifdef _OPENMP
+  // only the master thread makes MPI calls:
+  int provided;
+  MPI_Init_thread( &argc, &argv, MPI_THREAD_FUNNELED, &provided );
+#else
   MPI_Init( &argc, &argv ); // the MPI communicators
+#endif
 #endif
    
   initSimError();           // the error handler
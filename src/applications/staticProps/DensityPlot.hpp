@@ -50,7 +50,10 @@ namespace OpenMD {
     class DensityPlot : public StaticAnalyser{
         public:
             DensityPlot(SimInfo* info, const std::string& filename, const std::string& sele, const std::string& cmSele,RealType len, int nrbins);
-            virtual void process();
+            virtual bool hasFrameInterface() { return true; }
+            virtual void beginFrames(int nFrames);
+            virtual void processFrame(int frame);
+            virtual void endFrames();
 
             int getNRBins() {
               return nRBins_; 
@@ -67,6 +70,7 @@ namespace OpenMD {
             void writeDensity();            
 
             Snapshot* currentSnapshot_;
+            int nProcessed_;
             RealType len_;
             RealType halfLen_;
             int nRBins_;
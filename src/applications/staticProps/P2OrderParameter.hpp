@@ -56,7 +56,9 @@ namespace OpenMD {
                      const string& sele1, const string& sele2);
     P2OrderParameter(SimInfo* info, const string& filename, 
                      const string& sele1, const int seleOffset);
-    virtual void process();
+    virtual bool hasFrameInterface() { return true; }
+    virtual void processFrame(int frame);
+    virtual void endFrames();
     
   private:
     
@@ -63,7 +63,10 @@ namespace OpenMD {
 
     virtual ~RadialDistrFunc() {}
         
-    void process();        
+    bool hasFrameInterface() { return true; }
+    void beginFrames(int nFrames);
+    void processFrame(int frame);
+    void endFrames();
 
 
         
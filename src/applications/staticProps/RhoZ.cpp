@@ -70,70 +70,54 @@ namespace OpenMD {
     setOutputName(getPrefix(filename) + ".RhoZ");
   }
 
-  void RhoZ::process() {
-    Molecule* mol;
-    RigidBody* rb;
-    StuntDouble* sd;
-    SimInfo::MoleculeIterator mi;
-    Molecule::RigidBodyIterator rbIter;
-    bool usePeriodicBoundaryConditions_ = info_->getSimParams()->getUsePeriodicBoundaryConditions();
-
-    DumpReader reader(info_, dumpFilename_);    
-    int nFrames = reader.getNFrames();
+  void RhoZ::beginFrames(int nFrames) {
     nProcessed_ = nFrames/step_;
+  }
 
-    for (int istep = 0; istep < nFrames; istep += step_) {
-      reader.readFrame(istep);
-      currentSnapshot_ = info_->getSnapshotManager()->getCurrentSnapshot();
+  void RhoZ::processFrame(int frame) {
+    StuntDouble* sd;
+    bool usePeriodicBoundaryConditions_ = info_->getSimParams()->getUsePeriodicBoundaryConditions();
 
-      for (mol = info_->beginMolecule(mi); mol != NULL; mol = info_->nextMolecule(mi)) {
-        //change the positions of atoms which belong to the rigidbodies
-        for (rb = mol->beginRigidBody(rbIter); rb != NULL; rb = mol->nextRigidBody(rbIter)) {
-          rb->updateAtoms();
-        }
-      }
+    currentSnapshot_ = info_->getSnapshotManager()->getCurrentSnapshot();
 
-      int i;    
-      for (i=0; i < nBins_; i++) {
-        sliceSDLists_[i].clear();
-      }
+    int i;    
+    for (i=0; i < nBins_; i++) {
+      sliceSDLists_[i].clear();
+    }
 
-      RealType sliceVolume = currentSnapshot_->getVolume() /nBins_;
-      Mat3x3d hmat = currentSnapshot_->getHmat();
-      zBox_.push_back(hmat(2,2));
+    RealType sliceVolume = currentSnapshot_->getVolume() /nBins_;
+    Mat3x3d hmat = currentSnapshot_->getHmat();
+    zBox_.push_back(hmat(2,2));
       
-      RealType halfBoxZ_ = hmat(2,2) / 2.0;      
+    RealType halfBoxZ_ = hmat(2,2) / 2.0;      
 
-      if (evaluator_.isDynamic()) {
-        seleMan_.setSelectionSet(evaluator_.evaluate());
-      }
-      
-      //wrap the stuntdoubles into a cell      
-      for (sd = seleMan_.beginSelected(i); sd != NULL; sd = seleMan_.nextSelected(i)) {
-        Vector3d pos = sd->getPos();
-        if (usePeriodicBoundaryConditions_)
-          currentSnapshot_->wrapVector(pos);
-        sd->setPos(pos);
-      }
+    if (evaluator_.isDynamic()) {
+      seleMan_.setSelectionSet(evaluateSelection(evaluator_));
+    }
       
-      //determine which atom belongs to which slice
-      for (sd = seleMan_.beginSelected(i); sd != NULL; sd = seleMan_.nextSelected(i)) {
-        Vector3d pos = sd->getPos();
-        // shift molecules by half a box to have bins start at 0
-        int binNo = int(nBins_ * (halfBoxZ_ + pos.z()) / hmat(2,2));
-        sliceSDLists_[binNo].push_back(sd);
-      }
+    //determine which atom belongs to which slice (the positions
+    //are wrapped into the cell here rather than in the snapshot,
+    //which may be shared with other analysers)
+    for (sd = seleMan_.beginSelected(i); sd != NULL; sd = seleMan_.nextSelected(i)) {
+      Vector3d pos = sd->getPos();
+      if (usePeriodicBoundaryConditions_)
+        currentSnapshot_->wrapVector(pos);
+      // shift molecules by half a box to have bins start at 0
+      int binNo = int(nBins_ * (halfBoxZ_ + pos.z()) / hmat(2,2));
+      sliceSDLists_[binNo].push_back(sd);
+    }
 
-      //loop over the slices to calculate the densities
-      for (i = 0; i < nBins_; i++) {
-        RealType totalMass = 0;
-        for (unsigned int k = 0; k < sliceSDLists_[i].size(); ++k) {
-          totalMass += sliceSDLists_[i][k]->getMass();
-        }
-        density_[i] += totalMass/sliceVolume;
+    //loop over the slices to calculate the densities
+    for (i = 0; i < nBins_; i++) {
+      RealType totalMass = 0;
+      for (unsigned int k = 0; k < sliceSDLists_[i].size(); ++k) {
+        totalMass += sliceSDLists_[i][k]->getMass();
       }
+      density_[i] += totalMass/sliceVolume;
     }
-    
+  }
+
+  void RhoZ::endFrames() {
     writeDensity();
 
   }
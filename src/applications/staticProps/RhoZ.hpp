@@ -64,7 +64,10 @@ namespace OpenMD {
       return nZBins_; 
     }
     
-    virtual void process();
+    virtual bool hasFrameInterface() { return true; }
+    virtual void beginFrames(int nFrames);
+    virtual void processFrame(int frame);
+    virtual void endFrames();
     
   private:
     
@@ -41,12 +41,14 @@
  */
 
 #include "applications/staticProps/StaticAnalyser.hpp"
+#include "applications/staticProps/AnalyserPipeline.hpp"
 #include "utils/simError.h"
 #include "utils/Revision.hpp"
 
 namespace OpenMD {
   StaticAnalyser::StaticAnalyser(SimInfo* info, const std::string& filename, unsigned int nbins) :
-    info_(info), dumpFilename_(filename), step_(1), nBins_(nbins) {
+    info_(info), dumpFilename_(filename), step_(1), nBins_(nbins),
+    selectionCache_(NULL) {
     
     // Pre-load an OutputData for the count of objects:
     counts_ = new OutputData;
@@ -59,6 +61,29 @@ namespace OpenMD {
       counts_->accumulator.push_back( new Accumulator() );     
   }
   
+  void StaticAnalyser::process() {
+    AnalyserPipeline pipeline(info_, dumpFilename_);
+    pipeline.addAnalyser(this);
+    pipeline.process();
+  }
+
+  /**
+   * Evaluates a dynamic selection in the current frame.  Inside a
+   * pipeline, analysers that use the same selection script share a
+   * single evaluation per frame.
+   */
+  SelectionSet StaticAnalyser::evaluateSelection(SelectionEvaluator& evaluator) {
+    if (selectionCache_ == NULL) 
+      return evaluator.evaluate();
+
+    SelectionCache::iterator i = selectionCache_->find(evaluator.getScript());
+    if (i == selectionCache_->end()) {
+      i = selectionCache_->insert(std::make_pair(evaluator.getScript(),
+                                                 evaluator.evaluate())).first;
+    }
+    return i->second;
+  }
+
   void StaticAnalyser::writeOutput() {
     vector<OutputData*>::iterator i;
     OutputData* outputData;
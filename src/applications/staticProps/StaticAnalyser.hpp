@@ -43,8 +43,10 @@
 #define APPLICATIONS_STATICPROPS_STATICANALYSER_HPP
 
 #include <string>
+#include <map>
 #include "brains/SimInfo.hpp"
 #include "brains/Snapshot.hpp"
+#include "selection/SelectionEvaluator.hpp"
 #include "utils/Accumulator.hpp"
 
 namespace OpenMD {
@@ -71,12 +73,35 @@ namespace OpenMD {
     vector<vector<BaseAccumulator*> > accumulatorArray2d;
   };
 
+  typedef std::map<std::string, SelectionSet> SelectionCache;
+
   class StaticAnalyser{
   public:
     StaticAnalyser(SimInfo* info, const std::string& filename, unsigned int nbins);
     
     virtual ~StaticAnalyser() {}
-    virtual void process()=0;
+
+    /**
+     * Runs the analysis over the dump file.  Analysers which
+     * implement the frame interface below don't need to override
+     * this; the frames are then fed to them by an AnalyserPipeline.
+     */
+    virtual void process();
+
+    /**
+     * Analysers that return true here can share a single pass over
+     * the dump file with other analysers.  Each frame is read, and
+     * the atoms of the rigid bodies are placed, before processFrame
+     * is called.
+     */
+    virtual bool hasFrameInterface() { return false; }
+    virtual void beginFrames(int nFrames) {}
+    virtual void processFrame(int frame) {}
+    virtual void endFrames() {}
+
+    void setSelectionCache(SelectionCache* cache) {
+      selectionCache_ = cache;
+    }
 
     void setOutputName(const std::string& filename) {
       outputFilename_ = filename;
@@ -106,6 +131,7 @@ namespace OpenMD {
     }
 
   protected:
+    SelectionSet evaluateSelection(SelectionEvaluator& evaluator);
     void writeOutput();
     void writeData(ostream& os, OutputData* dat, unsigned int bin);
     void writeErrorBars(ostream& os, OutputData* dat, unsigned int bin);
@@ -123,6 +149,7 @@ namespace OpenMD {
     OutputData* counts_;
     vector<OutputData*> data_;
 
+    SelectionCache* selectionCache_;
   };
 }
 #endif
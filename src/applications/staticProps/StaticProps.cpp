@@ -43,6 +43,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 
 #include "brains/SimCreator.hpp"
 #include "brains/SimInfo.hpp"
@@ -51,6 +52,7 @@
 
 #include "StaticPropsCmd.hpp"
 #include "applications/staticProps/StaticAnalyser.hpp"
+#include "applications/staticProps/AnalyserPipeline.hpp"
 #include "applications/staticProps/GofR.hpp"
 #include "applications/staticProps/GofZ.hpp"
 #include "applications/staticProps/GofRZ.hpp"
@@ -91,18 +93,11 @@
 
 using namespace OpenMD;
 
-int main(int argc, char* argv[]){
-  
-  
-  gengetopt_args_info args_info;
-  
-  //parse the command line option
-  if (cmdline_parser (argc, argv, &args_info) != 0) {
-    exit(1) ;
-  }
-  
-  //get the dumpfile name
-  std::string dumpFileName = args_info.input_arg;
+/**
+ * Creates the analyser requested by one set of command line options.
+ */
+StaticAnalyser* createAnalyser(SimInfo* info, const std::string& dumpFileName,
+                               gengetopt_args_info& args_info) {
   std::string sele1;
   std::string sele2;
   std::string sele3;
@@ -168,10 +163,6 @@ int main(int argc, char* argv[]){
       simError();
     }
   }
-  
-  //parse md file and set up the system
-  SimCreator creator;
-  SimInfo* info = creator.createSim(dumpFileName);
 
   RealType maxLen;
   RealType zmaxLen(0.0);
@@ -200,7 +191,7 @@ int main(int argc, char* argv[]){
     nanglebins = args_info.nbins_arg;
   }
   
-  StaticAnalyser* analyser;
+  StaticAnalyser* analyser = NULL;
   
                                        
   if (args_info.gofr_given){
@@ -517,17 +508,170 @@ int main(int argc, char* argv[]){
                                       nrbins);
   }
   
+  if (analyser == NULL) {
+    sprintf( painCave.errMsg,
+             "StaticProps was not asked to compute anything.\n");
+    painCave.severity = OPENMD_ERROR;
+    painCave.isFatal = 1;
+    simError();
+  }
+
   if (args_info.output_given) {
     analyser->setOutputName(args_info.output_arg);
   }
   if (args_info.step_given) {
     analyser->setStep(args_info.step_arg);
   }
+
+  return analyser;
+}
+
+/**
+ * Splits a line of a pipeline file into words.  Quotes group words
+ * (as in --sele1="select O*") and are removed.
+ */
+std::vector<std::string> splitArguments(const std::string& line) {
+  std::vector<std::string> words;
+  std::string word;
+  bool inWord = false;
+  char quote = 0;
+
+  for (std::size_t i = 0; i < line.size(); ++i) {
+    char c = line[i];
+    if (quote) {
+      if (c == quote) 
+        quote = 0;
+      else
+        word += c;
+    } else if (c == '"' || c == '\'') {
+      quote = c;
+      inWord = true;
+    } else if (isspace(c)) {
+      if (inWord) words.push_back(word);
+      word.clear();
+      inWord = false;
+    } else {
+      word += c;
+      inWord = true;
+    }
+  }
+  if (inWord) words.push_back(word);
+  return words;
+}
+
+int main(int argc, char* argv[]){
+  
+  
+  gengetopt_args_info args_info;
+  cmdline_parser_params* params = cmdline_parser_params_create();
+
+  //parse the command line option; an analysis is only optional when
+  //a pipeline file is given
+  params->check_required = 0;
+  if (cmdline_parser_ext (argc, argv, &args_info, params) != 0) {
+    exit(1) ;
+  }
+  if (!args_info.pipeline_given) {
+    if (cmdline_parser_required (&args_info, argv[0]) != 0) {
+      exit(1) ;
+    }
+  } else if (!args_info.input_given) {
+    fprintf (stderr, "%s: '--input' ('-i') option required\n", argv[0]);
+    exit(1) ;
+  }
   
-  analyser->process();
+  //get the dumpfile name
+  std::string dumpFileName = args_info.input_arg;
+
+  //parse md file and set up the system
+  SimCreator creator;
+  SimInfo* info = creator.createSim(dumpFileName);
+
+  std::vector<StaticAnalyser*> analysers;
+  if (args_info.staticProps_group_counter > 0) 
+    analysers.push_back(createAnalyser(info, dumpFileName, args_info));
+
+  // Each line of a pipeline file holds the options for one more
+  // analysis.  The options given on the command line are the
+  // defaults for every line.
+  if (args_info.pipeline_given) {
+    std::ifstream pipelineFile(args_info.pipeline_arg);
+    if (!pipelineFile.is_open()) {
+      sprintf( painCave.errMsg,
+               "Could not open pipeline file %s\n", args_info.pipeline_arg);
+      painCave.severity = OPENMD_ERROR;
+      painCave.isFatal = 1;
+      simError();
+    }
+
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(pipelineFile, line)) {
+      lineNo++;
+      std::vector<std::string> words = splitArguments(line);
+      if (words.empty() || words[0][0] == '#') continue;
+
+      std::vector<char*> lineArgv(1, argv[0]);
+      for (unsigned int i = 0; i < words.size(); i++) 
+        lineArgv.push_back(const_cast<char*>(words[i].c_str()));
+
+      gengetopt_args_info lineArgs;
+      params->override = 0;
+      if (cmdline_parser_ext (lineArgv.size(), &lineArgv[0], &lineArgs,
+                              params) != 0) {
+        exit(1) ;
+      }
+      int nAnalyses = lineArgs.staticProps_group_counter;
+      cmdline_parser_free (&lineArgs);
+      if (nAnalyses != 1) {
+        sprintf( painCave.errMsg,
+                 "Line %d of %s must ask for exactly one analysis.\n",
+                 lineNo, args_info.pipeline_arg);
+        painCave.severity = OPENMD_ERROR;
+        painCave.isFatal = 1;
+        simError();
+      }
+
+      lineArgv.assign(argv, argv + argc);
+      for (unsigned int i = 0; i < words.size(); i++) 
+        lineArgv.push_back(const_cast<char*>(words[i].c_str()));
+
+      params->override = 1;
+      if (cmdline_parser_ext (lineArgv.size(), &lineArgv[0], &lineArgs,
+                              params) != 0) {
+        exit(1) ;
+      }
+      analysers.push_back(createAnalyser(info, dumpFileName, lineArgs));
+      cmdline_parser_free (&lineArgs);
+    }
+  }
+
+  for (unsigned int i = 0; i < analysers.size(); i++) {
+    for (unsigned int j = 0; j < i; j++) {
+      if (analysers[i]->getOutputFileName() == 
+          analysers[j]->getOutputFileName()) {
+        sprintf( painCave.errMsg,
+                 "Two analyses would write to %s; use --output to give\n"
+                 "\teach one its own file.\n", 
+                 analysers[i]->getOutputFileName().c_str());
+        painCave.severity = OPENMD_ERROR;
+        painCave.isFatal = 1;
+        simError();
+      }
+    }
+  }
+
+  // all of the analysers share a single pass over the dump file:
+  AnalyserPipeline pipeline(info, dumpFileName);
+  for (unsigned int i = 0; i < analysers.size(); i++) 
+    pipeline.addAnalyser(analysers[i]);
+  pipeline.process();
   
-  delete analyser;    
+  for (unsigned int i = 0; i < analysers.size(); i++) 
+    delete analysers[i];
   delete info;
+  cmdline_parser_free (&args_info);
+  free (params);
   
   return 0;   
 }
@@ -65,6 +65,7 @@ const char *gengetopt_args_info_help[] = {
   "      --radius=DOUBLE           nanoparticle radius",
   "  -v, --voxelSize=DOUBLE        voxel size (angstroms)",
   "      --gaussWidth=DOUBLE       Gaussian width (angstroms)",
+  "      --pipeline=filename       file listing analyses to compute in a single\n                                  pass (one line of options per analysis)",
   "\n Group: staticProps\n   an option of this group is required",
   "      --bo                      bond order parameter (--rcut must be specified)",
   "      --ior                     icosahedral bond order parameter as a function\n                                  of radius (--rcut must be specified)",
@@ -188,6 +189,7 @@ void clear_given (struct gengetopt_args_info *args_info)
   args_info->radius_given = 0 ;
   args_info->voxelSize_given = 0 ;
   args_info->gaussWidth_given = 0 ;
+  args_info->pipeline_given = 0 ;
   args_info->bo_given = 0 ;
   args_info->ior_given = 0 ;
   args_info->for_given = 0 ;
@@ -283,6 +285,8 @@ void clear_args (struct gengetopt_args_info *args_info)
   args_info->radius_orig = NULL;
   args_info->voxelSize_orig = NULL;
   args_info->gaussWidth_orig = NULL;
+  args_info->pipeline_arg = NULL;
+  args_info->pipeline_orig = NULL;
   
 }
 
@@ -323,45 +327,46 @@ void init_args_info(struct gengetopt_args_info *args_info)
   args_info->radius_help = gengetopt_args_info_help[29] ;
   args_info->voxelSize_help = gengetopt_args_info_help[30] ;
   args_info->gaussWidth_help = gengetopt_args_info_help[31] ;
-  args_info->bo_help = gengetopt_args_info_help[33] ;
-  args_info->ior_help = gengetopt_args_info_help[34] ;
-  args_info->for_help = gengetopt_args_info_help[35] ;
-  args_info->bad_help = gengetopt_args_info_help[36] ;
-  args_info->count_help = gengetopt_args_info_help[37] ;
-  args_info->gofr_help = gengetopt_args_info_help[38] ;
-  args_info->gofz_help = gengetopt_args_info_help[39] ;
-  args_info->r_theta_help = gengetopt_args_info_help[40] ;
-  args_info->r_omega_help = gengetopt_args_info_help[41] ;
-  args_info->r_z_help = gengetopt_args_info_help[42] ;
-  args_info->theta_omega_help = gengetopt_args_info_help[43] ;
-  args_info->gxyz_help = gengetopt_args_info_help[44] ;
-  args_info->twodgofr_help = gengetopt_args_info_help[45] ;
-  args_info->p2_help = gengetopt_args_info_help[46] ;
-  args_info->rp2_help = gengetopt_args_info_help[47] ;
-  args_info->scd_help = gengetopt_args_info_help[48] ;
-  args_info->density_help = gengetopt_args_info_help[49] ;
-  args_info->slab_density_help = gengetopt_args_info_help[50] ;
-  args_info->p_angle_help = gengetopt_args_info_help[51] ;
-  args_info->hxy_help = gengetopt_args_info_help[52] ;
-  args_info->rho_r_help = gengetopt_args_info_help[53] ;
-  args_info->angle_r_help = gengetopt_args_info_help[54] ;
-  args_info->hullvol_help = gengetopt_args_info_help[55] ;
-  args_info->rodlength_help = gengetopt_args_info_help[56] ;
-  args_info->tet_param_help = gengetopt_args_info_help[57] ;
-  args_info->tet_param_z_help = gengetopt_args_info_help[58] ;
-  args_info->tet_param_xyz_help = gengetopt_args_info_help[59] ;
-  args_info->rnemdz_help = gengetopt_args_info_help[60] ;
-  args_info->rnemdr_help = gengetopt_args_info_help[61] ;
-  args_info->rnemdrt_help = gengetopt_args_info_help[62] ;
-  args_info->nitrile_help = gengetopt_args_info_help[63] ;
-  args_info->multipole_help = gengetopt_args_info_help[64] ;
-  args_info->surfDiffusion_help = gengetopt_args_info_help[65] ;
-  args_info->gcn_help = gengetopt_args_info_help[66] ;
-  args_info->hbond_help = gengetopt_args_info_help[67] ;
-  args_info->potDiff_help = gengetopt_args_info_help[68] ;
-  args_info->tet_hb_help = gengetopt_args_info_help[69] ;
-  args_info->kirkwood_help = gengetopt_args_info_help[70] ;
-  args_info->kirkwoodQ_help = gengetopt_args_info_help[71] ;
+  args_info->pipeline_help = gengetopt_args_info_help[32] ;
+  args_info->bo_help = gengetopt_args_info_help[34] ;
+  args_info->ior_help = gengetopt_args_info_help[35] ;
+  args_info->for_help = gengetopt_args_info_help[36] ;
+  args_info->bad_help = gengetopt_args_info_help[37] ;
+  args_info->count_help = gengetopt_args_info_help[38] ;
+  args_info->gofr_help = gengetopt_args_info_help[39] ;
+  args_info->gofz_help = gengetopt_args_info_help[40] ;
+  args_info->r_theta_help = gengetopt_args_info_help[41] ;
+  args_info->r_omega_help = gengetopt_args_info_help[42] ;
+  args_info->r_z_help = gengetopt_args_info_help[43] ;
+  args_info->theta_omega_help = gengetopt_args_info_help[44] ;
+  args_info->gxyz_help = gengetopt_args_info_help[45] ;
+  args_info->twodgofr_help = gengetopt_args_info_help[46] ;
+  args_info->p2_help = gengetopt_args_info_help[47] ;
+  args_info->rp2_help = gengetopt_args_info_help[48] ;
+  args_info->scd_help = gengetopt_args_info_help[49] ;
+  args_info->density_help = gengetopt_args_info_help[50] ;
+  args_info->slab_density_help = gengetopt_args_info_help[51] ;
+  args_info->p_angle_help = gengetopt_args_info_help[52] ;
+  args_info->hxy_help = gengetopt_args_info_help[53] ;
+  args_info->rho_r_help = gengetopt_args_info_help[54] ;
+  args_info->angle_r_help = gengetopt_args_info_help[55] ;
+  args_info->hullvol_help = gengetopt_args_info_help[56] ;
+  args_info->rodlength_help = gengetopt_args_info_help[57] ;
+  args_info->tet_param_help = gengetopt_args_info_help[58] ;
+  args_info->tet_param_z_help = gengetopt_args_info_help[59] ;
+  args_info->tet_param_xyz_help = gengetopt_args_info_help[60] ;
+  args_info->rnemdz_help = gengetopt_args_info_help[61] ;
+  args_info->rnemdr_help = gengetopt_args_info_help[62] ;
+  args_info->rnemdrt_help = gengetopt_args_info_help[63] ;
+  args_info->nitrile_help = gengetopt_args_info_help[64] ;
+  args_info->multipole_help = gengetopt_args_info_help[65] ;
+  args_info->surfDiffusion_help = gengetopt_args_info_help[66] ;
+  args_info->gcn_help = gengetopt_args_info_help[67] ;
+  args_info->hbond_help = gengetopt_args_info_help[68] ;
+  args_info->potDiff_help = gengetopt_args_info_help[69] ;
+  args_info->tet_hb_help = gengetopt_args_info_help[70] ;
+  args_info->kirkwood_help = gengetopt_args_info_help[71] ;
+  args_info->kirkwoodQ_help = gengetopt_args_info_help[72] ;
   
 }
 
@@ -486,6 +491,8 @@ cmdline_parser_release (struct gengetopt_args_info *args_info)
   free_string_field (&(args_info->radius_orig));
   free_string_field (&(args_info->voxelSize_orig));
   free_string_field (&(args_info->gaussWidth_orig));
+  free_string_field (&(args_info->pipeline_arg));
+  free_string_field (&(args_info->pipeline_orig));
   
   
   for (i = 0; i < args_info->inputs_num; ++i)
@@ -585,6 +592,8 @@ cmdline_parser_dump(FILE *outfile, struct gengetopt_args_info *args_info)
     write_into_file(outfile, "voxelSize", args_info->voxelSize_orig, 0);
   if (args_info->gaussWidth_given)
     write_into_file(outfile, "gaussWidth", args_info->gaussWidth_orig, 0);
+  if (args_info->pipeline_given)
+    write_into_file(outfile, "pipeline", args_info->pipeline_orig, 0);
   if (args_info->bo_given)
     write_into_file(outfile, "bo", 0, 0 );
   if (args_info->ior_given)
@@ -1611,6 +1620,7 @@ cmdline_parser_internal (
         { "radius",	1, NULL, 0 },
         { "voxelSize",	1, NULL, 'v' },
         { "gaussWidth",	1, NULL, 0 },
+        { "pipeline",	1, NULL, 0 },
         { "bo",	0, NULL, 0 },
         { "ior",	0, NULL, 0 },
         { "for",	0, NULL, 0 },
@@ -2183,6 +2193,20 @@ cmdline_parser_internal (
                 additional_error))
               goto failure;
           
+          }
+          /* file listing analyses to compute in a single pass (one line of options per analysis).  */
+          else if (strcmp (long_options[option_index].name, "pipeline") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->pipeline_arg), 
+                 &(args_info->pipeline_orig), &(args_info->pipeline_given),
+                &(local_args_info.pipeline_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "pipeline", '-',
+                additional_error))
+              goto failure;
+          
           }
           /* bond order parameter (--rcut must be specified).  */
           else if (strcmp (long_options[option_index].name, "bo") == 0)
@@ -129,6 +129,9 @@ struct gengetopt_args_info
   double gaussWidth_arg;	/**< @brief Gaussian width (angstroms).  */
   char * gaussWidth_orig;	/**< @brief Gaussian width (angstroms) original value given at command line.  */
   const char *gaussWidth_help; /**< @brief Gaussian width (angstroms) help description.  */
+  char * pipeline_arg;	/**< @brief file listing analyses to compute in a single pass (one line of options per analysis).  */
+  char * pipeline_orig;	/**< @brief file listing analyses to compute in a single pass (one line of options per analysis) original value given at command line.  */
+  const char *pipeline_help; /**< @brief file listing analyses to compute in a single pass (one line of options per analysis) help description.  */
   const char *bo_help; /**< @brief bond order parameter (--rcut must be specified) help description.  */
   const char *ior_help; /**< @brief icosahedral bond order parameter as a function of radius (--rcut must be specified) help description.  */
   const char *for_help; /**< @brief FCC bond order parameter as a function of radius (--rcut must be specified) help description.  */
@@ -201,6 +204,7 @@ struct gengetopt_args_info
   unsigned int radius_given ;	/**< @brief Whether radius was given.  */
   unsigned int voxelSize_given ;	/**< @brief Whether voxelSize was given.  */
   unsigned int gaussWidth_given ;	/**< @brief Whether gaussWidth was given.  */
+  unsigned int pipeline_given ;	/**< @brief Whether pipeline was given.  */
   unsigned int bo_given ;	/**< @brief Whether bo was given.  */
   unsigned int ior_given ;	/**< @brief Whether ior was given.  */
   unsigned int for_given ;	/**< @brief Whether for was given.  */
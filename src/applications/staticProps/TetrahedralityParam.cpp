@@ -89,16 +89,22 @@ namespace OpenMD {
     std::fill(Q_histogram_.begin(), Q_histogram_.end(), 0);
   }
   
-  void TetrahedralityParam::process() {
+  void TetrahedralityParam::beginFrames(int nFrames) {
+    nFrames_ = nFrames;
+    frameCounter_ = 0;
+
+    Distorted_.clear();
+    Tetrahedral_.clear();
+  }
+
+  void TetrahedralityParam::processFrame(int frame) {
     Molecule* mol;
     StuntDouble* sd;
     StuntDouble* sd2;
     StuntDouble* sdi;
     StuntDouble* sdj;
-    RigidBody* rb;
     int myIndex;
     SimInfo::MoleculeIterator mi;
-    Molecule::RigidBodyIterator rbIter;
     Molecule::IntegrableObjectIterator ioi;
     Vector3d vec;
     Vector3d ri, rj, rk, rik, rkj, dposition, tposition;
@@ -109,143 +115,124 @@ namespace OpenMD {
     int isd;
     bool usePeriodicBoundaryConditions_ = info_->getSimParams()->getUsePeriodicBoundaryConditions();
 
-    DumpReader reader(info_, dumpFilename_);    
-    int nFrames = reader.getNFrames();
-    frameCounter_ = 0;
-
-    Distorted_.clear();
-    Tetrahedral_.clear();
-
-    for (int istep = 0; istep < nFrames; istep += step_) {
-      reader.readFrame(istep);
-      frameCounter_++;
-      currentSnapshot_ = info_->getSnapshotManager()->getCurrentSnapshot();
+    frameCounter_++;
+    currentSnapshot_ = info_->getSnapshotManager()->getCurrentSnapshot();
       
-      if (evaluator_.isDynamic()) {
-        seleMan_.setSelectionSet(evaluator_.evaluate());
-      }
-
-      // update the positions of atoms which belong to the rigidbodies
-      
-      for (mol = info_->beginMolecule(mi); mol != NULL; 
-           mol = info_->nextMolecule(mi)) {
-        for (rb = mol->beginRigidBody(rbIter); rb != NULL; 
-             rb = mol->nextRigidBody(rbIter)) {
-          rb->updateAtoms();
-        }        
-      }           
-            
+    if (evaluator_.isDynamic()) {
+      seleMan_.setSelectionSet(evaluateSelection(evaluator_));
+    }
 
-      // outer loop is over the selected StuntDoubles:
+    // outer loop is over the selected StuntDoubles:
 
-      for (sd = seleMan_.beginSelected(isd); sd != NULL; 
-           sd = seleMan_.nextSelected(isd)) {
+    for (sd = seleMan_.beginSelected(isd); sd != NULL; 
+         sd = seleMan_.nextSelected(isd)) {
 	
-        myIndex = sd->getGlobalIndex();
-	Qk = 1.0;
+      myIndex = sd->getGlobalIndex();
+      Qk = 1.0;
 
-	myNeighbors.clear();
+      myNeighbors.clear();
                 
-        // inner loop is over all StuntDoubles in the system:
+      // inner loop is over all StuntDoubles in the system:
         
-        for (mol = info_->beginMolecule(mi); mol != NULL; 
-             mol = info_->nextMolecule(mi)) {
+      for (mol = info_->beginMolecule(mi); mol != NULL; 
+           mol = info_->nextMolecule(mi)) {
 
-          for (sd2 = mol->beginIntegrableObject(ioi); sd2 != NULL; 
-               sd2 = mol->nextIntegrableObject(ioi)) {
+        for (sd2 = mol->beginIntegrableObject(ioi); sd2 != NULL; 
+             sd2 = mol->nextIntegrableObject(ioi)) {
 	    
-            if (sd2->getGlobalIndex() != myIndex) {
+          if (sd2->getGlobalIndex() != myIndex) {
 	      
-              vec = sd->getPos() - sd2->getPos();       
+            vec = sd->getPos() - sd2->getPos();       
 	      
-              if (usePeriodicBoundaryConditions_) 
-                currentSnapshot_->wrapVector(vec);
+            if (usePeriodicBoundaryConditions_) 
+              currentSnapshot_->wrapVector(vec);
 	      
-              r = vec.length();             
+            r = vec.length();             
 
-              // Check to see if neighbor is in bond cutoff 
+            // Check to see if neighbor is in bond cutoff 
               
-              if (r < rCut_) { 
+            if (r < rCut_) { 
 		
-		myNeighbors.push_back(std::make_pair(r,sd2));
-	      }
+	      myNeighbors.push_back(std::make_pair(r,sd2));
 	    }
 	  }
 	}
+      }
 
-	// Sort the vector using predicate and std::sort
-	std::sort(myNeighbors.begin(), myNeighbors.end());
+      // Sort the vector using predicate and std::sort
+      std::sort(myNeighbors.begin(), myNeighbors.end());
 
-	//std::cerr << myNeighbors.size() <<  " neighbors within " 
-	//          << rCut_  << " A" << " \n";
+      //std::cerr << myNeighbors.size() <<  " neighbors within " 
+      //          << rCut_  << " A" << " \n";
 	
-	// Use only the 4 closest neighbors to do the rest of the work:
+      // Use only the 4 closest neighbors to do the rest of the work:
 	
-	int nbors =  myNeighbors.size()> 4 ? 4 : myNeighbors.size();
-	int nang = int (0.5 * (nbors * (nbors - 1)));
-
-	rk = sd->getPos();
-	//std::cerr<<nbors<<endl;
-	for (int i = 0; i < nbors-1; i++) {	  
-
-	  sdi = myNeighbors[i].second;
-	  ri = sdi->getPos();
-	  rik = rk - ri;
-	  if (usePeriodicBoundaryConditions_) 
-	    currentSnapshot_->wrapVector(rik);
+      int nbors =  myNeighbors.size()> 4 ? 4 : myNeighbors.size();
+      int nang = int (0.5 * (nbors * (nbors - 1)));
+
+      rk = sd->getPos();
+      //std::cerr<<nbors<<endl;
+      for (int i = 0; i < nbors-1; i++) {       
+
+	sdi = myNeighbors[i].second;
+	ri = sdi->getPos();
+	rik = rk - ri;
+	if (usePeriodicBoundaryConditions_) 
+	  currentSnapshot_->wrapVector(rik);
 	  
-	  rik.normalize();
+	rik.normalize();
 
-	  for (int j = i+1; j < nbors; j++) {	    
+	for (int j = i+1; j < nbors; j++) {       
 
-	    sdj = myNeighbors[j].second;
-	    rj = sdj->getPos();
-	    rkj = rk - rj;
-	    if (usePeriodicBoundaryConditions_) 
-	      currentSnapshot_->wrapVector(rkj);
-	    rkj.normalize();
+	  sdj = myNeighbors[j].second;
+	  rj = sdj->getPos();
+	  rkj = rk - rj;
+	  if (usePeriodicBoundaryConditions_) 
+	    currentSnapshot_->wrapVector(rkj);
+	  rkj.normalize();
 	    
-	    cospsi = dot(rik,rkj);
+	  cospsi = dot(rik,rkj);
 
-	    //std::cerr << "cos(psi) = " << cospsi << " \n";
+	  //std::cerr << "cos(psi) = " << cospsi << " \n";
 
-	    // Calculates scaled Qk for each molecule using calculated
-	    // angles from 4 or fewer nearest neighbors.
-	    Qk = Qk - (pow(cospsi + 1.0 / 3.0, 2) * 2.25 / nang);
-	    //std::cerr<<Qk<<"\t"<<nang<<endl;
-	  }
+	  // Calculates scaled Qk for each molecule using calculated
+	  // angles from 4 or fewer nearest neighbors.
+	  Qk = Qk - (pow(cospsi + 1.0 / 3.0, 2) * 2.25 / nang);
+	  //std::cerr<<Qk<<"\t"<<nang<<endl;
+	}
+      }
+      //std::cerr<<nang<<endl;
+      if (nang > 0) {
+	collectHistogram(Qk);
+
+	// Saves positions of StuntDoubles & neighbors with distorted
+	// coordination (low Qk value)
+	if ((Qk < 0.55) && (Qk > 0.45)) {
+	  //std::cerr<<Distorted_.size()<<endl;
+	  Distorted_.push_back(sd);
+	  //std::cerr<<Distorted_.size()<<endl;
+	  dposition = sd->getPos();
+	  //std::cerr << "distorted position \t" << dposition << "\n";
 	}
-	//std::cerr<<nang<<endl;
-	if (nang > 0) {
-	  collectHistogram(Qk);
-
-	  // Saves positions of StuntDoubles & neighbors with distorted
-	  // coordination (low Qk value)
-	  if ((Qk < 0.55) && (Qk > 0.45)) {
-	    //std::cerr<<Distorted_.size()<<endl;
-	    Distorted_.push_back(sd);
-	    //std::cerr<<Distorted_.size()<<endl;
-	    dposition = sd->getPos();
-	    //std::cerr << "distorted position \t" << dposition << "\n";
-	  }
-
-	  // Saves positions of StuntDoubles & neighbors with
-	  // tetrahedral coordination (high Qk value)
-	  if (Qk > 0.05) { 
 
-	    Tetrahedral_.push_back(sd);
+	// Saves positions of StuntDoubles & neighbors with
+	// tetrahedral coordination (high Qk value)
+	if (Qk > 0.05) { 
 
-	    tposition = sd->getPos();
-	    //std::cerr << "tetrahedral position \t" << tposition << "\n";
-	  }
+	  Tetrahedral_.push_back(sd);
 
-	  //std::cerr<<Tetrahedral_.size()<<endl;
-       
+	  tposition = sd->getPos();
+	  //std::cerr << "tetrahedral position \t" << tposition << "\n";
 	}
 
+	//std::cerr<<Tetrahedral_.size()<<endl;
+       
       }
+
     }
-    
+  }
+
+  void TetrahedralityParam::endFrames() {
     writeOrderParameter();
     std::cerr << "number of distorted StuntDoubles = " 
 	      << Distorted_.size() << "\n";
@@ -267,7 +254,7 @@ namespace OpenMD {
     
     int nSelected = 0;
 
-    for (int i = 0; i < nBins_; ++i) {
+    for (unsigned int i = 0; i < nBins_; ++i) {
       nSelected = nSelected + int(Q_histogram_[i]*deltaQ_);
     }
     
@@ -279,7 +266,7 @@ namespace OpenMD {
       osq << "# selection: (" << selectionScript_ << ")\n";
       osq << "# \n";
       // Normalize by number of frames and write it out:
-      for (int i = 0; i < nBins_; ++i) {
+      for (unsigned int i = 0; i < nBins_; ++i) {
         RealType Qval = MinQ_ + (i + 0.5) * deltaQ_;               
         osq << Qval;
 	osq << "\t" << (RealType) (Q_histogram_[i]/deltaQ_)/nSelected;        
@@ -295,10 +282,7 @@ namespace OpenMD {
       simError();  
     }
 
-    DumpReader reader(info_, dumpFilename_);    
-    int nFrames = reader.getNFrames();
-
-    if (nFrames == 1) {
+    if (nFrames_ == 1) {
 
       std::vector<StuntDouble*>::iterator iter;
       std::ofstream osd((getOutputFileName() + "dxyz").c_str());
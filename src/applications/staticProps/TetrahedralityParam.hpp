@@ -86,7 +86,10 @@ namespace OpenMD {
 			const std::string& sele, double rCut, int nbins);
     
     virtual ~TetrahedralityParam();
-    virtual void process();
+    virtual bool hasFrameInterface() { return true; }
+    virtual void beginFrames(int nFrames);
+    virtual void processFrame(int frame);
+    virtual void endFrames();
     
   private:
     virtual void initializeHistogram();
@@ -100,7 +103,7 @@ namespace OpenMD {
             
     RealType rCut_;
     int frameCounter_;
-    int nBins_;
+    int nFrames_;
    
     RealType MinQ_;
     RealType MaxQ_;
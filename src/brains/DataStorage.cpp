@@ -384,12 +384,178 @@ namespace OpenMD {
     }
   }
 
+  void DataStorage::copyFrom(DataStorage& other, int whichArrays) {
+    int layout = whichArrays & storageLayout_ & other.storageLayout_;
+
+    if (size_ != other.size_) {
+      resize(other.size_);
+    }
+
+    if (layout & dslPosition) {
+      position = other.position;
+    } 
+
+    if (layout & dslVelocity) {
+      velocity = other.velocity;
+    } 
+
+    if (layout & dslForce) {
+      force = other.force;
+    } 
+
+    if (layout & dslAmat) {
+      aMat = other.aMat;
+    } 
+
+    if (layout & dslAngularMomentum) {
+      angularMomentum = other.angularMomentum;
+    } 
+
+    if (layout & dslTorque) {
+      torque = other.torque;
+    }
+
+    if (layout & dslParticlePot) {
+      particlePot = other.particlePot;
+    }
+
+    if (layout & dslDensity) {
+      density = other.density;
+    }
+
+    if (layout & dslFunctional) {
+      functional = other.functional;
+    }
+
+    if (layout & dslFunctionalDerivative) {
+      functionalDerivative = other.functionalDerivative;
+    }
+
+    if (layout & dslDipole) {
+      dipole = other.dipole;
+    }
+
+    if (layout & dslQuadrupole) {
+      quadrupole = other.quadrupole;
+    }
+
+    if (layout & dslElectricField) {
+      electricField = other.electricField;
+    }
+
+    if (layout & dslSkippedCharge) {
+      skippedCharge = other.skippedCharge;
+    }
+
+    if (layout & dslFlucQPosition) {
+      flucQPos = other.flucQPos;
+    }
+
+    if (layout & dslFlucQVelocity) {
+      flucQVel = other.flucQVel;
+    }
+
+    if (layout & dslFlucQForce) {
+      flucQFrc = other.flucQFrc;
+    }
+
+    if (layout & dslSitePotential) {
+      sitePotential = other.sitePotential;
+    }
+  }
+
+  void DataStorage::reorder(const vector<int>& order) {
+    if (order.size() != size_) {
+      //error
+      return;
+    }
+
+    if (storageLayout_ & dslPosition) {
+      internalReorder(position, order);
+    }
+
+    if (storageLayout_ & dslVelocity) {
+      internalReorder(velocity, order);
+    }
+
+    if (storageLayout_ & dslForce) {
+      internalReorder(force, order);
+    }
+
+    if (storageLayout_ & dslAmat) {
+      internalReorder(aMat, order);
+    }
+
+    if (storageLayout_ & dslAngularMomentum) {
+      internalReorder(angularMomentum, order);
+    }
+
+    if (storageLayout_ & dslTorque) {
+      internalReorder(torque, order);
+    }
+
+    if (storageLayout_ & dslParticlePot) {
+      internalReorder(particlePot, order);
+    }
+
+    if (storageLayout_ & dslDensity) {
+      internalReorder(density, order);
+    }
+
+    if (storageLayout_ & dslFunctional) {
+      internalReorder(functional, order);
+    }
+
+    if (storageLayout_ & dslFunctionalDerivative) {
+      internalReorder(functionalDerivative, order);
+    }
+
+    if (storageLayout_ & dslDipole) {
+      internalReorder(dipole, order);
+    }
+
+    if (storageLayout_ & dslQuadrupole) {
+      internalReorder(quadrupole, order);
+    }
+
+    if (storageLayout_ & dslElectricField) {
+      internalReorder(electricField, order);
+    }
+
+    if (storageLayout_ & dslSkippedCharge) {
+      internalReorder(skippedCharge, order);
+    }
+
+    if (storageLayout_ & dslFlucQPosition) {
+      internalReorder(flucQPos, order);
+    }
+
+    if (storageLayout_ & dslFlucQVelocity) {
+      internalReorder(flucQVel, order);
+    }
+
+    if (storageLayout_ & dslFlucQForce) {
+      internalReorder(flucQFrc, order);
+    }
+
+    if (storageLayout_ & dslSitePotential) {
+      internalReorder(sitePotential, order);
+    }
+  }
+
   int DataStorage::getStorageLayout() {
     return storageLayout_;
   }
 
   void DataStorage::setStorageLayout(int layout) {
     storageLayout_ = layout;
+
+    Vector3dArray::Layout arrayLayout = (layout & dslStructureOfArrays) ?
+      Vector3dArray::StructureOfArrays : Vector3dArray::ArrayOfStructures;
+    position.setLayout(arrayLayout);
+    velocity.setLayout(arrayLayout);
+    force.setLayout(arrayLayout);
+
     resize(size_);
   }
 
@@ -456,6 +622,41 @@ namespace OpenMD {
     }
   }    
 
+  RealType* DataStorage::getComponentPointer(int whichArray, int component) {
+    Vector3dArray* v = getVector3Array(whichArray);
+    if (v != NULL) {
+      return v->empty() ? NULL : v->component(component);
+    }
+    RealType* p = getArrayPointer(whichArray);
+    return (p == NULL) ? NULL : p + component;
+  }
+
+  std::size_t DataStorage::getComponentStride(int whichArray) {
+    Vector3dArray* v = getVector3Array(whichArray);
+    return (v != NULL) ? v->stride() : 3;
+  }
+
+  Vector3dArray* DataStorage::getVector3Array(int whichArray) {
+    switch (whichArray) {
+    case dslPosition:
+      return &position;
+    case dslVelocity:
+      return &velocity;
+    case dslForce:
+      return &force;
+    default:
+      return NULL;
+    }
+  }
+
+  RealType* DataStorage::internalGetArrayPointer(Vector3dArray& v) {
+    if (v.empty()) {
+      return NULL;
+    } else {
+      return v.data();
+    }
+  }
+
   RealType* DataStorage::internalGetArrayPointer(std::vector<Vector3d>& v) {
     if (v.empty()) {
       return NULL;
@@ -498,6 +699,17 @@ namespace OpenMD {
     }
   }
 
+  void DataStorage::internalResize(Vector3dArray& v, std::size_t newSize) {
+    v.resize(newSize);
+  }
+
+  void DataStorage::internalCopy(Vector3dArray& v, int source,
+                                 std::size_t num, std::size_t target) {
+    // same range as the std::copy in the vector version below:
+    for (std::size_t i = source; i < num + 1; i++)
+      v[target + i - source] = v[i];
+  }
+
   template<typename T>
   void DataStorage::internalCopy(std::vector<T>& v, int source,
                                  std::size_t num, std::size_t target) {
@@ -517,6 +729,25 @@ namespace OpenMD {
     std::copy(first, last, result);
   }
 
+  void DataStorage::internalReorder(Vector3dArray& v,
+                                    const vector<int>& order) {
+    const Vector3dArray& old = v;
+    Vector3dArray tmp(v.getLayout());
+    tmp.resize(order.size());
+    for (std::size_t i = 0; i < order.size(); i++)
+      tmp[i] = old[order[i]];
+    v.swap(tmp);
+  }
+
+  template<typename T>
+  void DataStorage::internalReorder(std::vector<T>& v,
+                                    const vector<int>& order) {
+    std::vector<T> tmp(order.size());
+    for (std::size_t i = 0; i < order.size(); i++)
+      tmp[i] = v[order[i]];
+    v.swap(tmp);
+  }
+
   std::size_t DataStorage::getBytesPerStuntDouble(int layout) {
     std::size_t  bytes = 0;
     if (layout & dslPosition) {
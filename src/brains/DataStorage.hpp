@@ -53,6 +53,7 @@
 #include <vector>
 #include <math/Vector3.hpp>
 #include <math/SquareMatrix3.hpp>
+#include <math/Vector3Array.hpp>
 
 using namespace std;
 namespace OpenMD {
@@ -84,7 +85,10 @@ namespace OpenMD {
       dslFlucQPosition = 16384,
       dslFlucQVelocity = 32768,
       dslFlucQForce = 65536,
-      dslSitePotential = 131072
+      dslSitePotential = 131072,
+      dslStructureOfArrays = 262144 /**< position, velocity and force
+                                       are stored as separate x, y and z
+                                       arrays */
     };
 
     DataStorage();
@@ -117,16 +121,41 @@ namespace OpenMD {
      * @param target
      */
     void copy(int source, std::size_t num, std::size_t target);
+    /**
+     * Copies whole arrays from another DataStorage.
+     *
+     * Only the arrays selected by whichArrays that are present in
+     * both storages are copied; the others are left untouched.
+     *
+     * @param other DataStorage to copy from
+     * @param whichArrays bitmask of arrays (dslPosition | dslVelocity ...)
+     */
+    void copyFrom(DataStorage& other, int whichArrays);
+    /**
+     * Permutes the elements of every array, so that element i
+     * becomes the element that was at order[i].
+     *
+     * @param order new-to-old index map with one entry per element
+     */
+    void reorder(const vector<int>& order);
     /** Returns the storage layout  */
     int getStorageLayout();
     /** Sets the storage layout  */
     void setStorageLayout(int layout);
     /** Returns the pointer of internal array */
     RealType *getArrayPointer(int whichArray);
+    /** 
+     * Returns the start of one component (0, 1 or 2) of a
+     * three-vector array.  Successive values of that component are
+     * getComponentStride() apart: 3 normally, and 1 when the
+     * dslStructureOfArrays layout is in use.
+     */
+    RealType *getComponentPointer(int whichArray, int component);
+    std::size_t getComponentStride(int whichArray);
 
-    vector<Vector3d> position;        /** position array */
-    vector<Vector3d> velocity;        /** velocity array */
-    vector<Vector3d> force;           /** force array */
+    Vector3dArray position;           /** position array */
+    Vector3dArray velocity;           /** velocity array */
+    Vector3dArray force;              /** force array */
     vector<RotMat3x3d> aMat;          /** rotation matrix array */
     vector<Vector3d> angularMomentum; /** angular momentum array (body-fixed) */
     vector<Vector3d> torque;          /** torque array */
@@ -148,6 +177,7 @@ namespace OpenMD {
   private:
 
     RealType* internalGetArrayPointer(vector<Vector3d>& v);
+    RealType* internalGetArrayPointer(Vector3dArray& v);
     RealType* internalGetArrayPointer(vector<Mat3x3d>& v);
     RealType* internalGetArrayPointer(vector<RealType>& v);
             
@@ -156,6 +186,12 @@ namespace OpenMD {
 
     template<typename T>
     void internalCopy(std::vector<T>& v, int source, std::size_t num, std::size_t target);
+    template<typename T>
+    void internalReorder(std::vector<T>& v, const vector<int>& order);
+    void internalResize(Vector3dArray& v, std::size_t newSize);
+    void internalCopy(Vector3dArray& v, int source, std::size_t num, std::size_t target);
+    void internalReorder(Vector3dArray& v, const vector<int>& order);
+    Vector3dArray* getVector3Array(int whichArray);
             
     std::size_t size_;
     int storageLayout_;
@@ -52,6 +52,7 @@
 #include "primitives/Molecule.hpp"
 #define __OPENMD_C
 #include "utils/simError.h"
+#include "utils/Utility.hpp"
 #include "primitives/Bond.hpp"
 #include "primitives/Bend.hpp"
 #include "primitives/Torsion.hpp"
@@ -60,19 +61,45 @@
 #include "perturbations/UniformField.hpp"
 #include "perturbations/UniformGradient.hpp"
 #include "parallel/ForceMatrixDecomposition.hpp"
+#include "parallel/ForceSpatialDecomposition.hpp"
+#include "brains/SpatialSorter.hpp"
 
 #include <cstdio>
 #include <iostream>
 #include <iomanip>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 using namespace std;
 namespace OpenMD {
   
   ForceManager::ForceManager(SimInfo * info) : initialized_(false), info_(info),
-                                               switcher_(NULL), seleMan_(info), evaluator_(info) {
+                                               vdwTable_(NULL), switcher_(NULL), seleMan_(info), evaluator_(info) {
     forceField_ = info_->getForceField();
     interactionMan_ = new InteractionManager();
-    fDecomp_ = new ForceMatrixDecomposition(info_, interactionMan_);
+    Globals* simParams = info_->getSimParams();
+    string decomp = toUpperCopy(simParams->getForceDecompositionMethod());
+    if (decomp == "SPATIAL")
+      fDecomp_ = new ForceSpatialDecomposition(info_, interactionMan_);
+    else
+      fDecomp_ = new ForceMatrixDecomposition(info_, interactionMan_);
+    if (simParams->getDynamicLoadBalancing() && decomp != "SPATIAL") {
+      sprintf(painCave.errMsg,
+              "ForceManager: dynamicLoadBalancing moves the boundaries of\n"
+              "\tthe spatial force decomposition, and will be ignored\n"
+              "\tunless forceDecomposition = \"spatial\".\n");
+      painCave.severity = OPENMD_WARNING;
+      painCave.isFatal = 0;
+      simError();
+    }
+    overlapCommunication_ = simParams->getOverlapCommunication();
+    distributeTime_ = 0.0;
+    collectTime_ = 0.0;
+    overlapTime_ = 0.0;
+    nThreads_ = 1;
+    threadInteractionMan_.push_back(interactionMan_);
     thermo = new Thermo(info_);
   }
 
@@ -80,7 +107,10 @@ namespace OpenMD {
     perturbations_.clear();
     
     delete switcher_;
+    for (unsigned int i = 1; i < threadInteractionMan_.size(); i++) 
+      delete threadInteractionMan_[i];
     delete interactionMan_;
+    delete vdwTable_;
     delete fDecomp_;
     delete thermo;
   }
@@ -99,7 +129,7 @@ namespace OpenMD {
    *      Use the maximum suggested value that was found.
    *
    * cutoffMethod : (one of HARD, SWITCHED, SHIFTED_FORCE, TAYLOR_SHIFTED, 
-   *                        SHIFTED_POTENTIAL, or EWALD_FULL)
+   *                        SHIFTED_POTENTIAL, EWALD_FULL, or EWALD_SPME)
    *      If cutoffMethod was explicitly set, use that choice.
    *      If cutoffMethod was not explicitly set, use SHIFTED_FORCE
    *
@@ -169,6 +199,10 @@ namespace OpenMD {
     stringToCutoffMethod["SHIFTED_FORCE"] = SHIFTED_FORCE;
     stringToCutoffMethod["TAYLOR_SHIFTED"] = TAYLOR_SHIFTED;
     stringToCutoffMethod["EWALD_FULL"] = EWALD_FULL;
+    // The mesh Ewald methods differ from EWALD_FULL only in how
+    // Electrostatic does the reciprocal space sum:
+    stringToCutoffMethod["EWALD_PME"] = EWALD_FULL;
+    stringToCutoffMethod["EWALD_SPME"] = EWALD_FULL;
   
     if (simParams_->haveCutoffMethod()) {
       string cutMeth = toUpperCopy(simParams_->getCutoffMethod());
@@ -179,7 +213,7 @@ namespace OpenMD {
                 "ForceManager::setupCutoffs: Could not find chosen cutoffMethod %s\n"
                 "\tShould be one of: "
                 "HARD, SWITCHED, SHIFTED_POTENTIAL, TAYLOR_SHIFTED,\n"
-                "\tSHIFTED_FORCE, or EWALD_FULL\n",
+                "\tSHIFTED_FORCE, EWALD_FULL, or EWALD_SPME\n",
                 cutMeth.c_str());
         painCave.isFatal = 1;
         painCave.severity = OPENMD_ERROR;
@@ -412,6 +446,51 @@ namespace OpenMD {
     }
     
     usePeriodicBoundaryConditions_ = info_->getSimParams()->getUsePeriodicBoundaryConditions();
+
+#ifdef _OPENMP
+    // The pair loop is shared by OMP_NUM_THREADS threads:
+    nThreads_ = omp_get_max_threads();
+#endif
+    for (int i = threadInteractionMan_.size(); i < nThreads_; i++) {
+      InteractionManager* iMan = new InteractionManager();
+      iMan->setSimInfo(info_);
+      iMan->initialize();
+      iMan->setCutoffRadius(rCut_);
+      threadInteractionMan_.push_back(iMan);
+    }
+    fDecomp_->setNumberOfThreads(nThreads_);
+
+    int nTypes = info_->getForceField()->getNAtomType();
+
+    Globals* simParams = info_->getSimParams();
+    if (simParams->getUseVdWTable() && vdwTable_ == NULL) {
+      bool shiftedPot = (cutoffMethod_ == SHIFTED_POTENTIAL);
+      bool shiftedForce = (cutoffMethod_ == SHIFTED_FORCE ||
+                           cutoffMethod_ == TAYLOR_SHIFTED);
+      vdwTable_ = new VanDerWaalsTable(nTypes, rCut_, shiftedPot, shiftedForce,
+                                       simParams->getVdWTableSpacing(),
+                                       simParams->getVdWTableOrder());
+      interactionMan_->tabulateVdW(vdwTable_);
+      vdwTable_->report();
+    }
+    if (vdwTable_ != NULL) {
+      for (int i = 0; i < nThreads_; i++) 
+        threadInteractionMan_[i]->setVdWTable(vdwTable_);
+    }
+    threadBatches_.resize(nThreads_);
+    threadActiveBins_.resize(nThreads_);
+    for (int i = 0; i < nThreads_; i++) {
+      threadBatches_[i].resize(nTypes);
+      threadActiveBins_[i].reserve(nTypes);
+    }
+    if (nThreads_ > 1) {
+      sprintf(painCave.errMsg,
+              "ForceManager: using %d threads for the non-bonded pair loop.\n",
+              nThreads_);
+      painCave.severity = OPENMD_INFO;
+      painCave.isFatal = 0;
+      simError();
+    }
     
     fDecomp_->distributeInitialData();
 
@@ -429,12 +508,34 @@ namespace OpenMD {
     initialized_ = true;
     
   }
+
+  /**
+   * The sorting bins are half as wide as the neighbor list radius.
+   * The force decomposition caches local indices, so its tables are
+   * rebuilt, and the next force calculation rebuilds the neighbor
+   * list in the new order.
+   */
+  void ForceManager::sortLocalData() {
+    if (!initialized_) initialize();
+
+    SpatialSorter sorter(info_);
+    sorter.sort(0.5 * (rCut_ + fDecomp_->getSkinThickness()));
+    fDecomp_->distributeInitialData();
+  }
   
   void ForceManager::calcForces() {
     
     if (!initialized_) initialize();
     preCalculation();
-    shortRangeInteractions();
+    if (overlapCommunication_) {
+      // the bonded forces are computed while the data for the
+      // non-bonded pair loop is in flight:
+      prepareLongRangeInteractions();
+      shortRangeInteractions();
+    } else {
+      shortRangeInteractions();
+      prepareLongRangeInteractions();
+    }
     longRangeInteractions();
     postCalculation();
   }
@@ -478,6 +579,7 @@ namespace OpenMD {
       //change the positions of atoms which belong to the rigidbodies
       for (rb = mol->beginRigidBody(rbIter); rb != NULL; 
            rb = mol->nextRigidBody(rbIter)) {
+        rb->updateAtoms();
 	rb->zeroForcesAndTorques();
       }        
       
@@ -505,13 +607,11 @@ namespace OpenMD {
   
   void ForceManager::shortRangeInteractions() {
     Molecule* mol;
-    RigidBody* rb;
     Bond* bond;
     Bend* bend;
     Torsion* torsion;
     Inversion* inversion;
     SimInfo::MoleculeIterator mi;
-    Molecule::RigidBodyIterator rbIter;
     Molecule::BondIterator bondIter;;
     Molecule::BendIterator  bendIter;
     Molecule::TorsionIterator  torsionIter;
@@ -526,12 +626,6 @@ namespace OpenMD {
     for (mol = info_->beginMolecule(mi); mol != NULL; 
          mol = info_->nextMolecule(mi)) {
 
-      //change the positions of atoms which belong to the rigidbodies
-      for (rb = mol->beginRigidBody(rbIter); rb != NULL; 
-           rb = mol->nextRigidBody(rbIter)) {
-        rb->updateAtoms();
-      }
-
       for (bond = mol->beginBond(bondIter); bond != NULL; 
            bond = mol->nextBond(bondIter)) {
         bond->calcForce(doParticlePot_);
@@ -673,7 +767,12 @@ namespace OpenMD {
     // curSnapshot->setShortRangePotential(shortRangePotential);
   }
   
-  void ForceManager::longRangeInteractions() {
+  /**
+   * Updates the cutoff group positions and starts sending the data
+   * needed by the non-bonded pair loop to the other processors.
+   * longRangeInteractions waits for it to arrive.
+   */
+  void ForceManager::prepareLongRangeInteractions() {
 
     Snapshot* curSnapshot = info_->getSnapshotManager()->getCurrentSnapshot();
     DataStorage* config = &(curSnapshot->atomData);
@@ -701,65 +800,35 @@ namespace OpenMD {
       cgConfig->velocity = config->velocity;
     }
 
+    RealType tStart = wallTime();
+    fDecomp_->startDistributeData();
+    distributePosted_ = wallTime();
+    distributeTime_ += distributePosted_ - tStart;
+  }
+
+  void ForceManager::longRangeInteractions() {
+
+    Snapshot* curSnapshot = info_->getSnapshotManager()->getCurrentSnapshot();
+
     fDecomp_->zeroWorkArrays();
-    fDecomp_->distributeData();
+
+    RealType tDistribute = wallTime();
+    overlapTime_ += tDistribute - distributePosted_;
+    fDecomp_->finishDistributeData();
+    distributeTime_ += wallTime() - tDistribute;
     
-    int cg1, cg2, atom1, atom2, topoDist;
-    Vector3d d_grp, dag, d, gvel2, vel2;
-    RealType rgrpsq, rgrp, r2, r;
-    RealType electroMult, vdwMult;
-    RealType vij(0.0);
-    Vector3d fij, fg, f1;
-    bool in_switching_region;
-    RealType sw, dswdr, swderiv;
-    vector<int> atomListColumn, atomListRow;
-    InteractionData idat;
     SelfData sdat;
-    RealType mf;
-    RealType vpair;
-    RealType dVdFQ1(0.0);
-    RealType dVdFQ2(0.0);
+    int gid1;
     potVec longRangePotential(0.0);
     RealType reciprocalPotential(0.0);
     RealType surfacePotential(0.0);
-    potVec workPot(0.0);
-    potVec exPot(0.0);
     potVec selectionPotential(0.0);
-    Vector3d eField1(0.0);
-    Vector3d eField2(0.0);
-    RealType sPot1(0.0);
-    RealType sPot2(0.0);
-    bool newAtom1;
-    int gid1, gid2;
-                   
-    vector<int>::iterator ia, jb;
 
     int loopStart, loopEnd;
     
-    idat.rcut = &rCut_;
-    idat.vdwMult = &vdwMult;
-    idat.electroMult = &electroMult;
-    idat.pot = &workPot;
-    idat.excludedPot = &exPot;
-    idat.selePot = &selectionPotential;
     sdat.selfPot = fDecomp_->getSelfPotential();    
     sdat.excludedPot = fDecomp_->getExcludedSelfPotential();
     sdat.selePot = fDecomp_->getSelectedSelfPotential();
-    idat.vpair = &vpair;
-    idat.dVdFQ1 = &dVdFQ1;
-    idat.dVdFQ2 = &dVdFQ2;
-    idat.eField1 = &eField1;
-    idat.eField2 = &eField2; 
-    idat.sPot1 = &sPot1;
-    idat.sPot2 = &sPot2;
-    idat.f1 = &f1;
-    idat.sw = &sw;
-    idat.shiftedPot = (cutoffMethod_ == SHIFTED_POTENTIAL) ? true : false;
-    idat.shiftedForce = (cutoffMethod_ == SHIFTED_FORCE ||
-                         cutoffMethod_ == TAYLOR_SHIFTED) ? true : false;
-    idat.doParticlePot = doParticlePot_;
-    idat.doElectricField = doElectricField_;
-    idat.doSitePotential = doSitePotential_;
     sdat.doParticlePot = doParticlePot_;
     
     loopEnd = PAIR_LOOP;
@@ -777,178 +846,334 @@ namespace OpenMD {
             Mat3x3d bbox = thermo->getBoundingBox();
           fDecomp_->buildNeighborList(neighborList_, point_);
         }
+        curSnapshot->setNeighborListStats(fDecomp_->getNeighborListBuilds(),
+                                          fDecomp_->getNeighborListTime());
       }
 
-      for (cg1 = 0; cg1 < int(point_.size()) - 1; cg1++) {
+      // The row groups are shared out among the threads.  Thread 0
+      // accumulates directly into the force decomposition's arrays,
+      // while the other threads use private copies which are folded
+      // back in by collectThreadIntermediateData / collectThreadData.
+      // The stress tensor and heat flux are reduced at the end of the
+      // parallel region.
+      RealType tLoop = wallTime();
+#pragma omp parallel num_threads(nThreads_)
+      {
+        int tid = 0;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+#endif
+        InteractionManager* iMan = threadInteractionMan_[tid];
+        vector<PairBatch>& batches = threadBatches_[tid];
+        vector<int>& activeBins = threadActiveBins_[tid];
+
+        // Pairs of single-atom cutoff groups that interact only via
+        // Lennard-Jones are collected into batches and evaluated
+        // after each row, the rest go through doPair one at a time.
+        bool batchPairs = (iLoop == PAIR_LOOP) && !doPotentialSelection_ && 
+          !doHeatFlux_;
+
+        int cg2, atom1, atom2, topoDist, atid1(-1), atid2;
+        Vector3d d_grp, dag, d, gvel2, vel2;
+        RealType rgrpsq, rgrp, r2, r;
+        RealType electroMult, vdwMult;
+        RealType vij(0.0);
+        Vector3d fij, fg, f1;
+        bool in_switching_region;
+        RealType sw, dswdr, swderiv;
+        AtomSpan atomListColumn, atomListRow;
+        InteractionData idat;
+        RealType mf;
+        RealType vpair;
+        RealType dVdFQ1(0.0);
+        RealType dVdFQ2(0.0);
+        potVec workPot(0.0);
+        potVec exPot(0.0);
+        potVec selePot(0.0);
+        Vector3d eField1(0.0);
+        Vector3d eField2(0.0);
+        RealType sPot1(0.0);
+        RealType sPot2(0.0);
+        bool newAtom1;
+        int gid1, gid2;
+        Mat3x3d threadStress(0.0);
+        Vector3d threadHeatFlux(0.0);
+        
+        const int *ia, *jb;
+
+        idat.rcut = &rCut_;
+        idat.vdwMult = &vdwMult;
+        idat.electroMult = &electroMult;
+        idat.pot = &workPot;
+        idat.excludedPot = &exPot;
+        idat.selePot = &selePot;
+        idat.vpair = &vpair;
+        idat.dVdFQ1 = &dVdFQ1;
+        idat.dVdFQ2 = &dVdFQ2;
+        idat.eField1 = &eField1;
+        idat.eField2 = &eField2; 
+        idat.sPot1 = &sPot1;
+        idat.sPot2 = &sPot2;
+        idat.f1 = &f1;
+        idat.sw = &sw;
+        idat.shiftedPot = (cutoffMethod_ == SHIFTED_POTENTIAL) ? true : false;
+        idat.shiftedForce = (cutoffMethod_ == SHIFTED_FORCE ||
+                             cutoffMethod_ == TAYLOR_SHIFTED) ? true : false;
+        idat.doParticlePot = doParticlePot_;
+        idat.doElectricField = doElectricField_;
+        idat.doSitePotential = doSitePotential_;
+
+#pragma omp for schedule(dynamic, 8)
+        for (int cg1 = 0; cg1 < int(point_.size()) - 1; cg1++) {
         
-        atomListRow = fDecomp_->getAtomsInGroupRow(cg1);        
-        newAtom1 = true;
+          atomListRow = fDecomp_->getAtomsInGroupRow(cg1);        
+          newAtom1 = true;
+          if (batchPairs && atomListRow.size() == 1)
+            atid1 = fDecomp_->getIdentRow(atomListRow[0]);
 
-        for (int m2 = point_[cg1]; m2 < point_[cg1+1]; m2++) {
+          for (int m2 = point_[cg1]; m2 < point_[cg1+1]; m2++) {
 
-          cg2 = neighborList_[m2];
+            cg2 = neighborList_[m2];
           
-          d_grp  = fDecomp_->getIntergroupVector(cg1, cg2);
+            d_grp  = fDecomp_->getIntergroupVector(cg1, cg2);
         
-          // already wrapped in the getIntergroupVector call:
-          // curSnapshot->wrapVector(d_grp);        
-          rgrpsq = d_grp.lengthSquare();
+            // already wrapped in the getIntergroupVector call:
+            // curSnapshot->wrapVector(d_grp);        
+            rgrpsq = d_grp.lengthSquare();
           
-          if (rgrpsq < rCutSq_) {
-            if (iLoop == PAIR_LOOP) {
-              vij = 0.0;
-              fij.zero();
-              eField1.zero();
-              eField2.zero();
-              sPot1 = 0.0;
-              sPot2 = 0.0;
-            }
+            if (rgrpsq < rCutSq_) {
+              if (iLoop == PAIR_LOOP) {
+                vij = 0.0;
+                fij.zero();
+                eField1.zero();
+                eField2.zero();
+                sPot1 = 0.0;
+                sPot2 = 0.0;
+              }
             
-            in_switching_region = switcher_->getSwitch(rgrpsq, sw, dswdr, 
-                                                       rgrp); 
+              in_switching_region = switcher_->getSwitch(rgrpsq, sw, dswdr, 
+                                                         rgrp); 
             
-            atomListColumn = fDecomp_->getAtomsInGroupColumn(cg2);
+              atomListColumn = fDecomp_->getAtomsInGroupColumn(cg2);
+
+              if (batchPairs && atomListRow.size() == 1 && 
+                  atomListColumn.size() == 1) {
+                atom1 = atomListRow[0];
+                atom2 = atomListColumn[0];
+                atid2 = fDecomp_->getIdentCol(atom2);
+
+                if (iMan->isBatchable(atid1, atid2)) {
+                  if (!fDecomp_->skipAtomPair(atom1, atom2, cg1, cg2) &&
+                      !fDecomp_->excludeAtomPair(atom1, atom2)) {
+                    topoDist = fDecomp_->getTopologicalDistance(atom1, atom2);
+                    if (batches[atid2].n == 0) activeBins.push_back(atid2);
+                    batches[atid2].add(atom2, d_grp, sqrt(rgrpsq), sw, dswdr,
+                                       vdwScale_[topoDist]);
+                  }
+                  continue;
+                }
+              }
             
-            if (doHeatFlux_)
-              gvel2 = fDecomp_->getGroupVelocityColumn(cg2);
+              if (doHeatFlux_)
+                gvel2 = fDecomp_->getGroupVelocityColumn(cg2);
             
-            for (ia = atomListRow.begin(); 
-                 ia != atomListRow.end(); ++ia) {            
-              atom1 = (*ia);
+              for (ia = atomListRow.begin(); 
+                   ia != atomListRow.end(); ++ia) {            
+                atom1 = (*ia);
               
-              if (doPotentialSelection_) {
-                gid1 = fDecomp_->getGlobalIDRow(atom1);
-                idat.isSelected = seleMan_.isGlobalIDSelected(gid1);
-              }
+                if (doPotentialSelection_) {
+                  gid1 = fDecomp_->getGlobalIDRow(atom1);
+                  idat.isSelected = seleMan_.isGlobalIDSelected(gid1);
+                }
               
-              for (jb = atomListColumn.begin(); 
-                   jb != atomListColumn.end(); ++jb) {              
-                atom2 = (*jb);
+                for (jb = atomListColumn.begin(); 
+                     jb != atomListColumn.end(); ++jb) {              
+                  atom2 = (*jb);
                 
-                if (doPotentialSelection_) {
-                  gid2 = fDecomp_->getGlobalIDCol(atom2);
-                  idat.isSelected |= seleMan_.isGlobalIDSelected(gid2);
-                }               
+                  if (doPotentialSelection_) {
+                    gid2 = fDecomp_->getGlobalIDCol(atom2);
+                    idat.isSelected |= seleMan_.isGlobalIDSelected(gid2);
+                  }               
                 
-                if (!fDecomp_->skipAtomPair(atom1, atom2, cg1, cg2)) {
+                  if (!fDecomp_->skipAtomPair(atom1, atom2, cg1, cg2)) {
                   
-                  vpair = 0.0;
-                  workPot = 0.0;
-                  exPot = 0.0;
-                  selectionPotential = 0.0;
-                  f1.zero();
-                  dVdFQ1 = 0.0;
-                  dVdFQ2 = 0.0;
+                    vpair = 0.0;
+                    workPot = 0.0;
+                    exPot = 0.0;
+                    selePot = 0.0;
+                    f1.zero();
+                    dVdFQ1 = 0.0;
+                    dVdFQ2 = 0.0;
                   
-                  fDecomp_->fillInteractionData(idat, atom1, atom2, newAtom1);
+                    fDecomp_->fillInteractionData(idat, atom1, atom2, 
+                                                  newAtom1, tid);
                   
-                  topoDist = fDecomp_->getTopologicalDistance(atom1, atom2);
-                  vdwMult = vdwScale_[topoDist];
-                  electroMult = electrostaticScale_[topoDist];
+                    topoDist = fDecomp_->getTopologicalDistance(atom1, atom2);
+                    vdwMult = vdwScale_[topoDist];
+                    electroMult = electrostaticScale_[topoDist];
                   
-                  if (atomListRow.size() == 1 && atomListColumn.size() == 1) {
-                    idat.d = &d_grp;
-                    idat.r2 = &rgrpsq;
-                    if (doHeatFlux_)
-                      vel2 = gvel2;
-                  } else {
-                    d = fDecomp_->getInteratomicVector(atom1, atom2);
-                    curSnapshot->wrapVector( d );
-                    r2 = d.lengthSquare();
-                    idat.d = &d;
-                    idat.r2 = &r2;
-                    if (doHeatFlux_)
-                      vel2 = fDecomp_->getAtomVelocityColumn(atom2);
-                  }
+                    if (atomListRow.size() == 1 && 
+                        atomListColumn.size() == 1) {
+                      idat.d = &d_grp;
+                      idat.r2 = &rgrpsq;
+                      if (doHeatFlux_)
+                        vel2 = gvel2;
+                    } else {
+                      d = fDecomp_->getInteratomicVector(atom1, atom2);
+                      curSnapshot->wrapVector( d );
+                      r2 = d.lengthSquare();
+                      idat.d = &d;
+                      idat.r2 = &r2;
+                      if (doHeatFlux_)
+                        vel2 = fDecomp_->getAtomVelocityColumn(atom2);
+                    }
                   
-                  r = sqrt( *(idat.r2) );
-                  idat.rij = &r;
+                    r = sqrt( *(idat.r2) );
+                    idat.rij = &r;
                   
-                  if (iLoop == PREPAIR_LOOP) {
-                    interactionMan_->doPrePair(idat);
-                  } else {
-                    interactionMan_->doPair(idat);
-                    fDecomp_->unpackInteractionData(idat, atom1, atom2);
-                    vij += vpair;
-                    fij += f1;
-                    stressTensor -= outProduct( *(idat.d), f1);
-                    if (doHeatFlux_) 
-                      fDecomp_->addToHeatFlux(*(idat.d) * dot(f1, vel2));
+                    if (iLoop == PREPAIR_LOOP) {
+                      iMan->doPrePair(idat);
+                    } else {
+                      iMan->doPair(idat);
+                      fDecomp_->unpackInteractionData(idat, atom1, atom2, tid);
+                      vij += vpair;
+                      fij += f1;
+                      threadStress -= outProduct( *(idat.d), f1);
+                      if (doHeatFlux_) 
+                        threadHeatFlux += *(idat.d) * dot(f1, vel2);
+                    }
                   }
                 }
               }
-            }
             
-            if (iLoop == PAIR_LOOP) {
-              if (in_switching_region) {
-                swderiv = vij * dswdr / rgrp;
-                fg = swderiv * d_grp;
-                fij += fg;
-                
-                if (atomListRow.size() == 1 && atomListColumn.size() == 1) {
-                  if (!fDecomp_->skipAtomPair(atomListRow[0], 
-                                              atomListColumn[0], 
-                                              cg1, cg2)) {
-                  stressTensor -= outProduct( *(idat.d), fg);
-                  if (doHeatFlux_)
-                    fDecomp_->addToHeatFlux(*(idat.d) * dot(fg, vel2));
-                  }                
-                }
+              if (iLoop == PAIR_LOOP) {
+                if (in_switching_region) {
+                  swderiv = vij * dswdr / rgrp;
+                  fg = swderiv * d_grp;
+                  fij += fg;
                 
-                for (ia = atomListRow.begin(); 
-                     ia != atomListRow.end(); ++ia) {            
-                  atom1 = (*ia);                
-                  mf = fDecomp_->getMassFactorRow(atom1);
-                  // fg is the force on atom ia due to cutoff group's
-                  // presence in switching region
-                  fg = swderiv * d_grp * mf;
-                  fDecomp_->addForceToAtomRow(atom1, fg);
-                  if (atomListRow.size() > 1) {
-                    if (info_->usesAtomicVirial()) {
-                      // find the distance between the atom
-                      // and the center of the cutoff group:
-                      dag = fDecomp_->getAtomToGroupVectorRow(atom1, cg1);
-                      stressTensor -= outProduct(dag, fg);
+                  if (atomListRow.size() == 1 && atomListColumn.size() == 1) {
+                    if (!fDecomp_->skipAtomPair(atomListRow[0], 
+                                                atomListColumn[0], 
+                                                cg1, cg2)) {
+                      threadStress -= outProduct( *(idat.d), fg);
                       if (doHeatFlux_)
-                        fDecomp_->addToHeatFlux( dag * dot(fg, vel2));
+                        threadHeatFlux += *(idat.d) * dot(fg, vel2);
+                    }                
+                  }
+                
+                  for (ia = atomListRow.begin(); 
+                       ia != atomListRow.end(); ++ia) {            
+                    atom1 = (*ia);                
+                    mf = fDecomp_->getMassFactorRow(atom1);
+                    // fg is the force on atom ia due to cutoff group's
+                    // presence in switching region
+                    fg = swderiv * d_grp * mf;
+                    fDecomp_->addForceToAtomRow(atom1, fg, tid);
+                    if (atomListRow.size() > 1) {
+                      if (info_->usesAtomicVirial()) {
+                        // find the distance between the atom
+                        // and the center of the cutoff group:
+                        dag = fDecomp_->getAtomToGroupVectorRow(atom1, cg1);
+                        threadStress -= outProduct(dag, fg);
+                        if (doHeatFlux_)
+                          threadHeatFlux += dag * dot(fg, vel2);
+                      }
                     }
                   }
-                }
-                for (jb = atomListColumn.begin(); 
-                     jb != atomListColumn.end(); ++jb) {              
-                  atom2 = (*jb);
-                  mf = fDecomp_->getMassFactorColumn(atom2);
-                  // fg is the force on atom jb due to cutoff group's
-                  // presence in switching region
-                  fg = -swderiv * d_grp * mf;
-                  fDecomp_->addForceToAtomColumn(atom2, fg);
+                  for (jb = atomListColumn.begin(); 
+                       jb != atomListColumn.end(); ++jb) {              
+                    atom2 = (*jb);
+                    mf = fDecomp_->getMassFactorColumn(atom2);
+                    // fg is the force on atom jb due to cutoff group's
+                    // presence in switching region
+                    fg = -swderiv * d_grp * mf;
+                    fDecomp_->addForceToAtomColumn(atom2, fg, tid);
                   
-                  if (atomListColumn.size() > 1) {
-                    if (info_->usesAtomicVirial()) {
-                      // find the distance between the atom
-                      // and the center of the cutoff group:
-                      dag = fDecomp_->getAtomToGroupVectorColumn(atom2, cg2);
-                      stressTensor -= outProduct(dag, fg);
-                      if (doHeatFlux_)
-                        fDecomp_->addToHeatFlux( dag * dot(fg, vel2));
+                    if (atomListColumn.size() > 1) {
+                      if (info_->usesAtomicVirial()) {
+                        // find the distance between the atom
+                        // and the center of the cutoff group:
+                        dag = fDecomp_->getAtomToGroupVectorColumn(atom2, cg2);
+                        threadStress -= outProduct(dag, fg);
+                        if (doHeatFlux_)
+                          threadHeatFlux += dag * dot(fg, vel2);
+                      }
                     }
                   }
                 }
+                //if (!info_->usesAtomicVirial()) {
+                //  stressTensor -= outProduct(d_grp, fij);
+                //  if (doHeatFlux_)
+                //     fDecomp_->addToHeatFlux( d_grp * dot(fij, vel2));
+                //}
               }
-              //if (!info_->usesAtomicVirial()) {
-              //  stressTensor -= outProduct(d_grp, fij);
-              //  if (doHeatFlux_)
-              //     fDecomp_->addToHeatFlux( d_grp * dot(fij, vel2));
-              //}
             }
           }
+
+          for (unsigned int b = 0; b < activeBins.size(); b++) {
+            PairBatch& batch = batches[activeBins[b]];
+            batch.atid1 = atid1;
+            batch.atid2 = activeBins[b];
+            iMan->doPairBatch(batch, rCut_, idat.shiftedPot, 
+                              idat.shiftedForce);
+
+            // fold in the switching function derivative (the groups
+            // are single atoms) and accumulate the virial:
+            RealType* fr = &batch.fr[0];
+            const RealType* dx = &batch.dx[0];
+            const RealType* dy = &batch.dy[0];
+            const RealType* dz = &batch.dz[0];
+            const RealType* rij = &batch.rij[0];
+            const RealType* dsw = &batch.dswdr[0];
+            const RealType* vp = &batch.vpair[0];
+            RealType sxx(0.0), syy(0.0), szz(0.0);
+            RealType sxy(0.0), sxz(0.0), syz(0.0);
+#pragma omp simd reduction(+:sxx,syy,szz,sxy,sxz,syz)
+            for (int k = 0; k < batch.n; k++) {
+              fr[k] += vp[k] * dsw[k] / rij[k];
+              sxx += dx[k] * dx[k] * fr[k];
+              syy += dy[k] * dy[k] * fr[k];
+              szz += dz[k] * dz[k] * fr[k];
+              sxy += dx[k] * dy[k] * fr[k];
+              sxz += dx[k] * dz[k] * fr[k];
+              syz += dy[k] * dz[k] * fr[k];
+            }
+            threadStress(0,0) -= sxx;
+            threadStress(1,1) -= syy;
+            threadStress(2,2) -= szz;
+            threadStress(0,1) -= sxy;
+            threadStress(1,0) -= sxy;
+            threadStress(0,2) -= sxz;
+            threadStress(2,0) -= sxz;
+            threadStress(1,2) -= syz;
+            threadStress(2,1) -= syz;
+
+            fDecomp_->unpackPairBatch(batch, atomListRow[0], doParticlePot_,
+                                      tid);
+            batch.n = 0;
+          }
+          activeBins.clear();
+
+          newAtom1 = false;
+        }
+
+        if (iLoop == PAIR_LOOP) {
+#pragma omp critical
+          {
+            stressTensor += threadStress;
+            if (doHeatFlux_)
+              fDecomp_->addToHeatFlux(threadHeatFlux);
+          }
         }
-        newAtom1 = false;
       }
 
+      fDecomp_->addPairLoopTime(wallTime() - tLoop);
+
       if (iLoop == PREPAIR_LOOP) {
         if (info_->requiresPrepair()) {
           
+          fDecomp_->collectThreadIntermediateData();
           fDecomp_->collectIntermediateData();
           
           for (unsigned int atom1 = 0; atom1 < info_->getNAtoms(); atom1++) {
@@ -968,9 +1193,29 @@ namespace OpenMD {
     }
 
     // collects pairwise information
-    fDecomp_->collectData();
-    if (cutoffMethod_ == EWALD_FULL) {
+    fDecomp_->collectThreadData();
+
+    RealType tStart = wallTime();
+    fDecomp_->startCollectData();
+    RealType tPosted = wallTime();
+
+    // the reciprocal space sum only touches the local atoms, so it
+    // can be done while the pair forces are in flight:
+    if (cutoffMethod_ == EWALD_FULL && overlapCommunication_) {
       interactionMan_->doReciprocalSpaceSum(reciprocalPotential);
+    }
+
+    RealType tWait = wallTime();
+    fDecomp_->finishCollectData();
+    RealType tDone = wallTime();
+    collectTime_ += (tPosted - tStart) + (tDone - tWait);
+    overlapTime_ += tWait - tPosted;
+    curSnapshot->setCommunicationStats(distributeTime_, collectTime_,
+                                       overlapTime_);
+
+    if (cutoffMethod_ == EWALD_FULL) {
+      if (!overlapCommunication_)
+        interactionMan_->doReciprocalSpaceSum(reciprocalPotential);
       curSnapshot->setReciprocalPotential(reciprocalPotential);
 
       // interactionMan_->doSurfaceTerm(surfacePotential);
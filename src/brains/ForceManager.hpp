@@ -82,6 +82,12 @@ namespace OpenMD {
     virtual ~ForceManager();
     virtual void calcForces();
     void initialize();
+    /**
+     * Renumbers the local atoms, rigid bodies and cutoff groups along
+     * a space-filling curve to improve the memory locality of the
+     * pair loop.  The output order is unchanged.
+     */
+    void sortLocalData();
 
   protected: 
     bool initialized_; 
@@ -95,6 +101,7 @@ namespace OpenMD {
     virtual void setupCutoffs();
     virtual void preCalculation();        
     virtual void shortRangeInteractions();
+    virtual void prepareLongRangeInteractions();
     virtual void longRangeInteractions();
     virtual void postCalculation();
 
@@ -102,6 +109,35 @@ namespace OpenMD {
     ForceField* forceField_;
     InteractionManager* interactionMan_;
     ForceDecomposition* fDecomp_;
+    int nThreads_;    /**< number of threads sharing the pair loop */
+    /**
+     * When overlapCommunication_ is set, the bonded forces are
+     * computed while the data for the pair loop is being sent, and
+     * the Ewald reciprocal space sum while the pair forces are being
+     * collected.  The accumulated wall times (s) spent waiting on the
+     * two exchanges, and doing other work while they were in flight,
+     * are reported in the stat file.
+     */
+    bool overlapCommunication_;
+    RealType distributeTime_;
+    RealType collectTime_;
+    RealType overlapTime_;
+    RealType distributePosted_; /**< wall time the pair loop data was sent */
+    /**
+     * The non-bonded interactions keep scratch data between calls, so
+     * each thread in the pair loop gets its own InteractionManager.
+     * The first entry is interactionMan_.
+     */
+    vector<InteractionManager*> threadInteractionMan_;
+    /**
+     * Per-thread batches of Lennard-Jones pairs, binned by the atom
+     * type of the second atom, and the list of bins in use for the
+     * current row.
+     */
+    vector<vector<PairBatch> > threadBatches_;
+    vector<vector<int> > threadActiveBins_;
+    /** Tabulated van der Waals interactions shared by all threads */
+    VanDerWaalsTable* vdwTable_;
     SwitchingFunction* switcher_;
     Thermo* thermo;
 
@@ -61,6 +61,7 @@
 #include "brains/SimCreator.hpp"
 #include "brains/SimSnapshotManager.hpp"
 #include "io/DumpReader.hpp"
+#include "io/IndexedGzStream.hpp"
 #include "brains/ForceField.hpp"
 #include "utils/simError.h"
 #include "utils/StringUtils.hpp"
@@ -284,8 +285,14 @@ namespace OpenMD {
     if (worldRank == masterNode) {
 #endif 
 
-      std::ifstream mdFile_;
-      mdFile_.open(mdFileName.c_str(), ifstream::in | ifstream::binary);
+      // dump files may have been gzipped:
+      std::istream* mdStream;
+      if (isGzipFile(mdFileName)) 
+        mdStream = new IndexedGzStream(mdFileName);
+      else
+        mdStream = new std::ifstream(mdFileName.c_str(), 
+                                     ifstream::in | ifstream::binary);
+      std::istream& mdFile_ = *mdStream;
       
       if (mdFile_.fail()) { 
         sprintf(painCave.errMsg, 
@@ -397,7 +404,7 @@ namespace OpenMD {
       
       if (!foundVersion) mdRawData += version + "\n";
       
-      mdFile_.close();
+      delete mdStream;
 
 #ifdef IS_MPI
     }
@@ -510,7 +517,10 @@ namespace OpenMD {
       }
       
       info->setFinalConfigFileName(prefix + ".eor");
-      info->setDumpFileName(prefix + ".dump");
+      if (toUpperCopy(simParams->getDumpFileFormat()) == "BINARY")
+        info->setDumpFileName(prefix + ".bdump");
+      else
+        info->setDumpFileName(prefix + ".dump");
       info->setStatFileName(prefix + ".stat");
       info->setRestFileName(prefix + ".zang");
       
@@ -523,10 +533,29 @@ namespace OpenMD {
   }
   
 #ifdef IS_MPI
+  /**
+   * A rough estimate of the cost of the non-bonded interactions of
+   * an atom type, relative to a Lennard-Jones site.  Metals pay for
+   * the extra density loop, and each electrostatic multipole or an
+   * ellipsoid adds to the work of every pair.
+   */
+  static RealType interactionCost(AtomType* atype) {
+    RealType cost = 1.0;
+    if (atype == NULL) return cost;
+    if (atype->isMetal()) cost += 2.0;
+    if (atype->isCharge()) cost += 1.0;
+    if (atype->isFluctuatingCharge()) cost += 1.0;
+    if (atype->isDipole()) cost += 2.0;
+    if (atype->isQuadrupole()) cost += 4.0;
+    if (atype->isGayBerne()) cost += 6.0;
+    if (atype->isSticky() || atype->isStickyPower()) cost += 2.0;
+    return cost;
+  }
+
   void SimCreator::divideMolecules(SimInfo *info) {
     RealType a;
     int nProcessors;
-    std::vector<int> atomsPerProc;
+    std::vector<RealType> atomsPerProc;
     int nGlobalMols = info->getNGlobalMolecules();
     std::vector<int> molToProcMap(nGlobalMols, -1); // default to an
                                                     // error
@@ -559,16 +588,37 @@ namespace OpenMD {
     }   
     
     
-    a = 3.0 * nGlobalMols / info->getNGlobalAtoms();
+    // With weightMoleculesByCost, each atom counts for the estimated
+    // cost of its interactions instead of 1, so processors holding
+    // expensive sites get fewer of them.
+    bool weighted = simParams->getWeightMoleculesByCost();
+    std::vector<RealType> stampWeights(info->getNMoleculeStamp(), 0.0);
+    RealType totalWeight = 0.0;
+    ForceField* ff = info->getForceField();
+    for (int i = 0; i < info->getNMoleculeStamp(); i++) {
+      MoleculeStamp* molStamp = info->getMoleculeStamp(i);
+      for (std::size_t j = 0; j < molStamp->getNAtoms(); j++) {
+        if (weighted) {
+          AtomType* atype = ff->getAtomType(molStamp->getAtomStamp(j)->getType());
+          stampWeights[i] += interactionCost(atype);
+        } else {
+          stampWeights[i] += 1.0;
+        }
+      }
+    }
+    for (int i = 0; i < nGlobalMols; i++) 
+      totalWeight += stampWeights[info->getMoleculeStampId(i)];
+
+    a = 3.0 * nGlobalMols / totalWeight;
     
     //initialize atomsPerProc
-    atomsPerProc.insert(atomsPerProc.end(), nProcessors, 0);
+    atomsPerProc.insert(atomsPerProc.end(), nProcessors, 0.0);
     
     if (worldRank == 0) {
-      RealType numerator = info->getNGlobalAtoms();
+      RealType numerator = totalWeight;
       RealType denominator = nProcessors;
       RealType precast = numerator / denominator;
-      int nTarget = (int)(precast + 0.5);
+      RealType nTarget = weighted ? precast : (int)(precast + 0.5);
       
       for(int i = 0; i < nGlobalMols; i++) {
 
@@ -584,12 +634,12 @@ namespace OpenMD {
           
           //get the molecule stamp first
           int stampId = info->getMoleculeStampId(i);
-          MoleculeStamp * moleculeStamp = info->getMoleculeStamp(stampId);
           
-          // How many atoms does this processor have so far?
-          int old_atoms = atomsPerProc[which_proc];
-          int add_atoms = moleculeStamp->getNAtoms();
-          int new_atoms = old_atoms + add_atoms;
+          // How many atoms (or how much work, if weighted) does this
+          // processor have so far?
+          RealType old_atoms = atomsPerProc[which_proc];
+          RealType add_atoms = stampWeights[stampId];
+          RealType new_atoms = old_atoms + add_atoms;
           
           // If we've been through this loop too many times, we need
           // to just give up and assign the molecule to this processor
@@ -633,7 +683,7 @@ namespace OpenMD {
           //           Pacc(x) = exp(- a * x)
           // where a = penalty / (average atoms per molecule)
           
-          RealType x = (RealType)(new_atoms - nTarget);
+          RealType x = new_atoms - nTarget;
           RealType y = myRandom->rand();
           
           if (y < exp(- a * x)) {
@@ -814,6 +864,10 @@ namespace OpenMD {
       storageLayout |= DataStorage::dslFlucQForce;
     }
 
+    if (simParams->getUseStructureOfArrays()) {
+      storageLayout |= DataStorage::dslStructureOfArrays;
+    }
+
     info->setStorageLayout(storageLayout);
 
     return storageLayout;
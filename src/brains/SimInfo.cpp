@@ -903,15 +903,15 @@ namespace OpenMD {
     Molecule::CutoffGroupIterator ci;
     CutoffGroup* cg;
 
-    vector<int> GlobalGroupIndices;
+    vector<int> GlobalGroupIndices(getNCutoffGroups(), 0);
     
     for (mol = beginMolecule(mi); mol != NULL; mol  = nextMolecule(mi)) {
       
-      //local index of cutoff group is trivial, it only depends on the
-      //order of travesing
+      // the local indices follow the order of traversal until the
+      // groups are spatially sorted:
       for (cg = mol->beginCutoffGroup(ci); cg != NULL; 
            cg = mol->nextCutoffGroup(ci)) {
-	GlobalGroupIndices.push_back(cg->getGlobalIndex());
+	GlobalGroupIndices[cg->getLocalIndex()] = cg->getGlobalIndex();
       }        
     }
     return GlobalGroupIndices;
@@ -958,15 +958,15 @@ namespace OpenMD {
     // Build the identArray_ and regions_
 
     identArray_.clear();
-    identArray_.reserve(getNAtoms());   
+    identArray_.resize(getNAtoms());   
     regions_.clear();
-    regions_.reserve(getNAtoms());
+    regions_.resize(getNAtoms());
  
     for(mol = beginMolecule(mi); mol != NULL; mol = nextMolecule(mi)) {      
       int reg = mol->getRegion();      
       for(atom = mol->beginAtom(ai); atom != NULL; atom = mol->nextAtom(ai)) {
-	identArray_.push_back(atom->getIdent());
-        regions_.push_back(reg);
+	identArray_[atom->getLocalIndex()] = atom->getIdent();
+        regions_[atom->getLocalIndex()] = reg;
       }
     }    
        
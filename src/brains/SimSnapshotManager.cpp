@@ -65,7 +65,7 @@ namespace OpenMD {
   }
   bool SimSnapshotManager::advance() {
 
-    *previousSnapshot_ = *currentSnapshot_;
+    previousSnapshot_->copyFrom(*currentSnapshot_, previousLayout_);
     currentSnapshot_->setID(currentSnapshot_->getID() + 1);    
     currentSnapshot_->clearDerivedProperties();
     return true;
@@ -59,7 +59,9 @@ namespace OpenMD{
   /**
    * @class SimSnapshotManager SimSnapshotManager.hpp "brains/SimSnapshotManager.hpp"
    * @brief SimSnapshotManager class is the concrete snapshot manager for actual simulation
-   * SimSnapshotManager only maintains two snapshots. 
+   * SimSnapshotManager only maintains two snapshots.  On advance(), the
+   * previous snapshot receives the frame data and only those arrays
+   * registered with requestPreviousData().
    * @see PropSimSnapshotManager
    */
   class SimSnapshotManager : public SnapshotManager {
@@ -83,6 +83,11 @@ namespace OpenMD {
     frameData.barostat = Mat3x3d(0.0);              
     frameData.stressTensor = Mat3x3d(0.0);              
     frameData.conductiveHeatFlux = Vector3d(0.0, 0.0, 0.0);
+    frameData.neighborListBuilds = 0;
+    frameData.neighborListTime = 0.0;
+    frameData.distributeTime = 0.0;
+    frameData.collectTime = 0.0;
+    frameData.overlapTime = 0.0;
 
     clearDerivedProperties();
   }
@@ -91,7 +96,8 @@ namespace OpenMD {
                      int storageLayout) : 
     atomData(nAtoms, storageLayout), 
     rigidbodyData(nRigidbodies, storageLayout),
-    cgData(nCutoffGroups, DataStorage::dslPosition),
+    cgData(nCutoffGroups, DataStorage::dslPosition | 
+           (storageLayout & DataStorage::dslStructureOfArrays)),
     orthoTolerance_(1e-6) {
     
     frameData.id = -1;                   
@@ -119,10 +125,53 @@ namespace OpenMD {
     frameData.barostat = Mat3x3d(0.0);              
     frameData.stressTensor = Mat3x3d(0.0);              
     frameData.conductiveHeatFlux = Vector3d(0.0, 0.0, 0.0);
+    frameData.neighborListBuilds = 0;
+    frameData.neighborListTime = 0.0;
+    frameData.distributeTime = 0.0;
+    frameData.collectTime = 0.0;
+    frameData.overlapTime = 0.0;
 
     clearDerivedProperties();
   }
 
+  void Snapshot::copyFrom(Snapshot& other, int whichArrays) {
+    if (this == &other) return;
+
+    frameData = other.frameData;
+    atomData.copyFrom(other.atomData, whichArrays);
+    rigidbodyData.copyFrom(other.rigidbodyData, whichArrays);
+    cgData.copyFrom(other.cgData, whichArrays);
+
+    hasTotalEnergy = other.hasTotalEnergy;
+    hasTranslationalKineticEnergy = other.hasTranslationalKineticEnergy;
+    hasRotationalKineticEnergy = other.hasRotationalKineticEnergy;
+    hasKineticEnergy = other.hasKineticEnergy;
+    hasShortRangePotential = other.hasShortRangePotential;
+    hasLongRangePotential = other.hasLongRangePotential;
+    hasPotentialEnergy = other.hasPotentialEnergy;
+    hasXYarea = other.hasXYarea;
+    hasVolume = other.hasVolume;
+    hasPressure = other.hasPressure;
+    hasTemperature = other.hasTemperature;
+    hasElectronicTemperature = other.hasElectronicTemperature;
+    hasNetCharge = other.hasNetCharge;
+    hasChargeMomentum = other.hasChargeMomentum;
+    hasCOM = other.hasCOM;
+    hasCOMvel = other.hasCOMvel;
+    hasCOMw = other.hasCOMw;
+    hasPressureTensor = other.hasPressureTensor;
+    hasSystemDipole = other.hasSystemDipole;
+    hasSystemQuadrupole = other.hasSystemQuadrupole;
+    hasConvectiveHeatFlux = other.hasConvectiveHeatFlux;
+    hasInertiaTensor = other.hasInertiaTensor;
+    hasGyrationalVolume = other.hasGyrationalVolume;
+    hasHullVolume = other.hasHullVolume;
+    hasConservedQuantity = other.hasConservedQuantity;
+    hasBoundingBox = other.hasBoundingBox;
+
+    orthoTolerance_ = other.orthoTolerance_;
+  }
+
   void Snapshot::clearDerivedProperties() {
     frameData.totalEnergy = 0.0;     
     frameData.translationalKinetic = 0.0;   
@@ -598,6 +647,38 @@ namespace OpenMD {
     frameData.chargeMomentum = cMom;
   }
 
+  int Snapshot::getNeighborListBuilds() {
+    return frameData.neighborListBuilds;
+  }
+
+  RealType Snapshot::getNeighborListTime() {
+    return frameData.neighborListTime;
+  }
+
+  void Snapshot::setNeighborListStats(int nBuilds, RealType time) {
+    frameData.neighborListBuilds = nBuilds;
+    frameData.neighborListTime = time;
+  }
+
+  RealType Snapshot::getDistributeTime() {
+    return frameData.distributeTime;
+  }
+
+  RealType Snapshot::getCollectTime() {
+    return frameData.collectTime;
+  }
+
+  RealType Snapshot::getOverlapTime() {
+    return frameData.overlapTime;
+  }
+
+  void Snapshot::setCommunicationStats(RealType distribute, RealType collect,
+                                       RealType overlap) {
+    frameData.distributeTime = distribute;
+    frameData.collectTime = collect;
+    frameData.overlapTime = overlap;
+  }
+
   RealType Snapshot::getPressure() {
     return frameData.pressure;
   }
@@ -107,6 +107,11 @@ namespace OpenMD{
     Vector3d conductiveHeatFlux;  /**< heat flux vector (conductive only) */
     Vector3d convectiveHeatFlux;  /**< heat flux vector (convective only) */
     RealType conservedQuantity;   /**< anything conserved by the integrator */
+    int      neighborListBuilds;  /**< number of neighbor list builds so far */
+    RealType neighborListTime;    /**< wall time (s) spent building neighbor lists */
+    RealType distributeTime;      /**< wall time (s) spent sending pair loop data */
+    RealType collectTime;         /**< wall time (s) spent collecting pair forces */
+    RealType overlapTime;         /**< wall time (s) of work done while those were in flight */
   };
 
 
@@ -130,6 +135,12 @@ namespace OpenMD{
     /** sets the state of the computed properties to false */
     void     clearDerivedProperties();
 
+    /** 
+     * Copies the frame data from another Snapshot along with the
+     * DataStorage arrays selected by whichArrays.
+     */
+    void     copyFrom(Snapshot& other, int whichArrays);
+
     int      getSize();
     /** Returns the number of atoms */
     int      getNumberOfAtoms();
@@ -231,6 +242,15 @@ namespace OpenMD{
     void     setNetCharge(const RealType nChg);
     RealType getChargeMomentum();
     void     setChargeMomentum(const RealType cMom);
+    int      getNeighborListBuilds();
+    RealType getNeighborListTime();
+    void     setNeighborListStats(const int nBuilds, const RealType time);
+    RealType getDistributeTime();
+    RealType getCollectTime();
+    RealType getOverlapTime();
+    void     setCommunicationStats(const RealType distribute, 
+                                   const RealType collect,
+                                   const RealType overlap);
     RealType getPressure();
     void     setPressure(const RealType pressure);
 
@@ -93,15 +93,33 @@ namespace OpenMD{
     int getStorageLayout() {
       return storageLayout_;
     }
+
+    /**
+     * Registers interest in DataStorage arrays of the previous
+     * snapshot.  advance() only carries the frame data and the
+     * requested arrays (dslPosition | dslVelocity ...) over to the
+     * previous snapshot, so anything reading getPrevSnapshot() data
+     * must ask for it here first.
+     * @param dataStorageLayout bitmask of the arrays that are needed
+     */
+    void requestPreviousData(int dataStorageLayout) {
+      previousLayout_ |= dataStorageLayout;
+    }
+
+    /** Returns the arrays copied into the previous snapshot */
+    int getPreviousDataLayout() {
+      return previousLayout_;
+    }
     
   private:
     int storageLayout_;
 
   protected:
 
-    SnapshotManager(int storageLayout) : storageLayout_(storageLayout), currentSnapshot_(NULL), previousSnapshot_(NULL) {
+    SnapshotManager(int storageLayout) : storageLayout_(storageLayout), previousLayout_(0), currentSnapshot_(NULL), previousSnapshot_(NULL) {
     }
-            
+
+    int previousLayout_;
     Snapshot* currentSnapshot_;
     Snapshot* previousSnapshot_;
             
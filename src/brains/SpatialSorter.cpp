@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+#include <algorithm>
+
+#include "brains/SpatialSorter.hpp"
+#include "brains/SnapshotManager.hpp"
+#include "primitives/Molecule.hpp"
+#include "primitives/RigidBody.hpp"
+#include "primitives/CutoffGroup.hpp"
+
+namespace OpenMD {
+
+  /** Interleaves the bits of the bin indices into a Morton key */
+  static unsigned long long mortonKey(int i, int j, int k) {
+    unsigned long long key = 0;
+    for (int b = 0; b < 21; b++) {
+      key |= ((unsigned long long)((i >> b) & 1)) << (3 * b);
+      key |= ((unsigned long long)((j >> b) & 1)) << (3 * b + 1);
+      key |= ((unsigned long long)((k >> b) & 1)) << (3 * b + 2);
+    }
+    return key;
+  }
+
+  /**
+   * Returns the indices of pos, ordered along the Morton curve
+   * through the bins.  In periodic boxes, the positions are wrapped
+   * into the box first; otherwise the bins cover the bounding box of
+   * the positions.  Positions in the same bin keep their order.
+   */
+  vector<int> SpatialSorter::sortPositions(const vector<Vector3d>& pos, 
+                                           RealType binWidth) {
+    int n = pos.size();
+    vector<int> order(n);
+    if (n == 0) return order;
+
+    bool periodic = info_->getSimParams()->getUsePeriodicBoundaryConditions();
+    Snapshot* snap = info_->getSnapshotManager()->getCurrentSnapshot();
+    Mat3x3d invHmat = snap->getInvHmat();
+
+    Vector3d lo(pos[0]), hi(pos[0]);
+    Vector3i nBins;
+    const int maxBins = 1 << 21;
+    for (int d = 0; d < 3; d++) {
+      RealType width;
+      if (periodic) {
+        width = 1.0 / invHmat.getRow(d).length();
+      } else {
+        for (int i = 1; i < n; i++) {
+          lo[d] = min(lo[d], pos[i][d]);
+          hi[d] = max(hi[d], pos[i][d]);
+        }
+        width = hi[d] - lo[d];
+      }
+      nBins[d] = (binWidth > 0.0) ? int(width / binWidth) : 1;
+      nBins[d] = min(max(nBins[d], 1), maxBins);
+    }
+
+    vector<pair<unsigned long long, int> > keys(n);
+    for (int i = 0; i < n; i++) {
+      Vector3d s;
+      if (periodic) {
+        s = invHmat * pos[i];
+        for (int d = 0; d < 3; d++) s[d] -= floor(s[d]);
+      } else {
+        for (int d = 0; d < 3; d++) 
+          s[d] = (hi[d] > lo[d]) ? (pos[i][d] - lo[d]) / (hi[d] - lo[d]) 
+            : 0.0;
+      }
+      int b[3];
+      for (int d = 0; d < 3; d++) 
+        b[d] = min(max(int(s[d] * nBins[d]), 0), nBins[d] - 1);
+      keys[i] = make_pair(mortonKey(b[0], b[1], b[2]), i);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    for (int i = 0; i < n; i++)
+      order[i] = keys[i].second;
+    return order;
+  }
+
+  void SpatialSorter::sort(RealType binWidth) {
+    SimInfo::MoleculeIterator mi;
+    Molecule* mol;
+    Molecule::CutoffGroupIterator ci;
+    CutoffGroup* cg;
+    Molecule::AtomIterator ai;
+    Atom* atom;
+    Molecule::RigidBodyIterator ri;
+    RigidBody* rb;
+
+    int nAtoms = info_->getNAtoms();
+    int nRigidBodies = info_->getNRigidBodies();
+    int nGroups = info_->getNCutoffGroups();
+
+    vector<Atom*> atoms(nAtoms, static_cast<Atom*>(NULL));
+    vector<RigidBody*> rigidBodies(nRigidBodies, 
+                                   static_cast<RigidBody*>(NULL));
+    vector<CutoffGroup*> groups(nGroups, static_cast<CutoffGroup*>(NULL));
+    vector<Vector3d> groupPos(nGroups);
+    vector<Vector3d> rbPos(nRigidBodies);
+
+    for (mol = info_->beginMolecule(mi); mol != NULL; 
+         mol = info_->nextMolecule(mi)) {
+      for (atom = mol->beginAtom(ai); atom != NULL; atom = mol->nextAtom(ai))
+        atoms[atom->getLocalIndex()] = atom;
+      for (rb = mol->beginRigidBody(ri); rb != NULL; 
+           rb = mol->nextRigidBody(ri)) {
+        rigidBodies[rb->getLocalIndex()] = rb;
+        rbPos[rb->getLocalIndex()] = rb->getPos();
+      }
+      for (cg = mol->beginCutoffGroup(ci); cg != NULL; 
+           cg = mol->nextCutoffGroup(ci)) {
+        groups[cg->getLocalIndex()] = cg;
+        groupPos[cg->getLocalIndex()] = cg->getPos();
+      }
+    }
+
+    // new-to-old index maps:
+    vector<int> groupOrder = sortPositions(groupPos, binWidth);
+    vector<int> rbOrder = sortPositions(rbPos, binWidth);
+    vector<int> atomOrder;
+    atomOrder.reserve(nAtoms);
+    for (int i = 0; i < nGroups; i++) {
+      cg = groups[groupOrder[i]];
+      for (atom = cg->beginAtom(ai); atom != NULL; atom = cg->nextAtom(ai))
+        atomOrder.push_back(atom->getLocalIndex());
+    }
+    // every atom is in exactly one cutoff group:
+    if (int(atomOrder.size()) != nAtoms) return;
+
+    SnapshotManager* sman = info_->getSnapshotManager();
+    Snapshot* snaps[2] = {sman->getCurrentSnapshot(), 
+                          sman->getPrevSnapshot()};
+    for (int k = 0; k < 2; k++) {
+      snaps[k]->atomData.reorder(atomOrder);
+      snaps[k]->rigidbodyData.reorder(rbOrder);
+      snaps[k]->cgData.reorder(groupOrder);
+    }
+
+    for (int i = 0; i < nAtoms; i++)
+      atoms[atomOrder[i]]->setLocalIndex(i);
+    for (int i = 0; i < nRigidBodies; i++)
+      rigidBodies[rbOrder[i]]->setLocalIndex(i);
+    for (int i = 0; i < nGroups; i++)
+      groups[groupOrder[i]]->setLocalIndex(i);
+
+    info_->prepareTopology();
+  }
+
+}
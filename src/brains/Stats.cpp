@@ -377,6 +377,46 @@ namespace OpenMD {
     data_[CHARGE_MOMENTUM] = chargeMomentum;
     statsMap_["CHARGE_MOMENTUM"] = CHARGE_MOMENTUM;
 
+    StatsData neighborListBuilds;
+    neighborListBuilds.units = "";
+    neighborListBuilds.title =  "Neighbor List Builds";  
+    neighborListBuilds.dataType = "RealType";
+    neighborListBuilds.accumulator = new Accumulator();
+    data_[NEIGHBOR_LIST_BUILDS] = neighborListBuilds;
+    statsMap_["NEIGHBOR_LIST_BUILDS"] = NEIGHBOR_LIST_BUILDS;
+
+    StatsData neighborListTime;
+    neighborListTime.units = "s";
+    neighborListTime.title =  "Neighbor List Time";  
+    neighborListTime.dataType = "RealType";
+    neighborListTime.accumulator = new Accumulator();
+    data_[NEIGHBOR_LIST_TIME] = neighborListTime;
+    statsMap_["NEIGHBOR_LIST_TIME"] = NEIGHBOR_LIST_TIME;
+
+    StatsData distributeTime;
+    distributeTime.units = "s";
+    distributeTime.title =  "Distribute Time";  
+    distributeTime.dataType = "RealType";
+    distributeTime.accumulator = new Accumulator();
+    data_[DISTRIBUTE_TIME] = distributeTime;
+    statsMap_["DISTRIBUTE_TIME"] = DISTRIBUTE_TIME;
+
+    StatsData collectTime;
+    collectTime.units = "s";
+    collectTime.title =  "Collect Time";  
+    collectTime.dataType = "RealType";
+    collectTime.accumulator = new Accumulator();
+    data_[COLLECT_TIME] = collectTime;
+    statsMap_["COLLECT_TIME"] = COLLECT_TIME;
+
+    StatsData overlapTime;
+    overlapTime.units = "s";
+    overlapTime.title =  "Overlap Time";  
+    overlapTime.dataType = "RealType";
+    overlapTime.accumulator = new Accumulator();
+    data_[OVERLAP_TIME] = overlapTime;
+    statsMap_["OVERLAP_TIME"] = OVERLAP_TIME;
+
     // Now, set some defaults in the mask:
 
     Globals* simParams = info_->getSimParams();
@@ -595,6 +635,21 @@ namespace OpenMD {
         case CHARGE_MOMENTUM:
           dynamic_cast<Accumulator *>(data_[i].accumulator)->add(thermo.getChargeMomentum());
           break; 
+        case NEIGHBOR_LIST_BUILDS:
+          dynamic_cast<Accumulator *>(data_[i].accumulator)->add(snap->getNeighborListBuilds());
+          break; 
+        case NEIGHBOR_LIST_TIME:
+          dynamic_cast<Accumulator *>(data_[i].accumulator)->add(snap->getNeighborListTime());
+          break; 
+        case DISTRIBUTE_TIME:
+          dynamic_cast<Accumulator *>(data_[i].accumulator)->add(snap->getDistributeTime());
+          break; 
+        case COLLECT_TIME:
+          dynamic_cast<Accumulator *>(data_[i].accumulator)->add(snap->getCollectTime());
+          break; 
+        case OVERLAP_TIME:
+          dynamic_cast<Accumulator *>(data_[i].accumulator)->add(snap->getOverlapTime());
+          break; 
 
           /*
         case SHADOWH:
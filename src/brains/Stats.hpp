@@ -98,6 +98,11 @@ namespace OpenMD {
       POTENTIAL_SELECTION,
       NET_CHARGE,
       CHARGE_MOMENTUM,
+      NEIGHBOR_LIST_BUILDS,
+      NEIGHBOR_LIST_TIME,
+      DISTRIBUTE_TIME,
+      COLLECT_TIME,
+      OVERLAP_TIME,
       ENDINDEX  //internal use
     };
 
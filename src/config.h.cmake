@@ -37,6 +37,12 @@
 /* have <conio.h> */
 #cmakedefine HAVE_CONIO_H 1
 
+/* have <sys/mman.h> */
+#cmakedefine HAVE_SYS_MMAN_H 1
+
+/* have POSIX threads */
+#cmakedefine HAVE_PTHREAD 1
+
 /* have symbol strncasecmp */
 #cmakedefine HAVE_STRNCASECMP 1
 
@@ -70,6 +70,8 @@ namespace OpenMD {
     }    
 
     currentSnapshot_ = info_->getSnapshotManager()->getCurrentSnapshot();
+    // constraintA() measures bond displacements from the old positions
+    info_->getSnapshotManager()->requestPreviousData(DataStorage::dslPosition);
     if (simParams->haveConstraintTime()){
       constraintTime_ = simParams->getConstraintTime();
     } else {
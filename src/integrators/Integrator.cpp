@@ -52,7 +52,7 @@ namespace OpenMD {
     : info_(info), forceMan_(NULL), rotAlgo_(NULL), flucQ_(NULL), 
       rattle_(NULL), velocitizer_(NULL), rnemd_(NULL), 
       needPotential(false), needStress(false), 
-      needReset(false),  needVelocityScaling(false), 
+      needReset(false),  needSpatialSort(false), needVelocityScaling(false), 
       useRNEMD(false), dumpWriter(NULL), statWriter(NULL), thermo(info_),
       snap(info_->getSnapshotManager()->getCurrentSnapshot()) {
     
@@ -103,6 +103,11 @@ namespace OpenMD {
       needReset = true;
       resetTime = simParams->getResetTime();
     }
+
+    if (simParams->haveSpatialSortTime()) {
+      needSpatialSort = true;
+      spatialSortTime = simParams->getSpatialSortTime();
+    }
     
     // Create a default ForceManager: If the subclass wants to use 
     // a different ForceManager, use setForceManager
@@ -152,6 +152,7 @@ namespace OpenMD {
     bool needPotential;
     bool needStress;
     bool needReset;    
+    bool needSpatialSort;
     bool needVelocityScaling;
     RealType targetScalingTemp;
 
@@ -167,6 +168,7 @@ namespace OpenMD {
     RealType statusTime;
     RealType thermalTime;
     RealType resetTime;
+    RealType spatialSortTime;
     RealType RNEMD_exchangeTime;
     RealType dt;
 
@@ -59,6 +59,28 @@ namespace OpenMD {
   }
 
   void NVE::moveA(){
+    if (!atomMass_.empty()) {
+      DataStorage& atoms = info_->getSnapshotManager()->getCurrentSnapshot()->atomData;
+      int nAtoms = atomMass_.size();
+      const RealType* mass = &atomMass_[0];
+
+      for (int d = 0; d < 3; d++) {
+        RealType* pos = atoms.position.component(d);
+        RealType* vel = atoms.velocity.component(d);
+        const RealType* frc = atoms.force.component(d);
+#pragma omp simd
+        for (int k = 0; k < nAtoms; k++) {
+          // velocity half step
+          vel[k] += (dt2 / mass[k] * PhysicalConstants::energyConvert) * frc[k];
+          // position whole step
+          pos[k] += dt * vel[k];
+        }
+      }
+      flucQ_->moveA();
+      rattle_->constraintA();
+      return;
+    }
+
     SimInfo::MoleculeIterator i;
     Molecule::IntegrableObjectIterator  j;
     Molecule* mol;
@@ -115,6 +137,23 @@ namespace OpenMD {
   }    
 
   void NVE::moveB(){
+    if (!atomMass_.empty()) {
+      DataStorage& atoms = info_->getSnapshotManager()->getCurrentSnapshot()->atomData;
+      int nAtoms = atomMass_.size();
+      const RealType* mass = &atomMass_[0];
+
+      for (int d = 0; d < 3; d++) {
+        RealType* vel = atoms.velocity.component(d);
+        const RealType* frc = atoms.force.component(d);
+#pragma omp simd
+        for (int k = 0; k < nAtoms; k++) 
+          vel[k] += (dt2 / mass[k] * PhysicalConstants::energyConvert) * frc[k];
+      }
+      flucQ_->moveB();
+      rattle_->constraintB();
+      return;
+    }
+
     SimInfo::MoleculeIterator i;
     Molecule::IntegrableObjectIterator  j;
     Molecule* mol;
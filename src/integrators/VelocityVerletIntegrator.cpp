@@ -59,10 +59,37 @@ namespace OpenMD {
   
   VelocityVerletIntegrator::~VelocityVerletIntegrator() { 
   }
+
+  void VelocityVerletIntegrator::setupArrayUpdate() {
+    atomMass_.clear();
+    if (!(info_->getStorageLayout() & DataStorage::dslStructureOfArrays))
+      return;
+
+    int nAtoms = info_->getNAtoms();
+    vector<RealType> mass(nAtoms, 0.0);
+    int nObjects = 0;
+
+    SimInfo::MoleculeIterator i;
+    Molecule::IntegrableObjectIterator j;
+    Molecule* mol;
+    StuntDouble* sd;
+
+    for (mol = info_->beginMolecule(i); mol != NULL; 
+         mol = info_->nextMolecule(i)) {
+      for (sd = mol->beginIntegrableObject(j); sd != NULL;
+           sd = mol->nextIntegrableObject(j)) {
+        if (!sd->isAtom() || sd->isDirectional()) return;
+        mass[sd->getLocalIndex()] = sd->getMass();
+        nObjects++;
+      }
+    }
+    if (nObjects == nAtoms) atomMass_ = mass;
+  }
   
   void VelocityVerletIntegrator::initialize(){
     
     forceMan_->initialize();
+    setupArrayUpdate();
     
     // remove center of mass drift velocity (in case we passed in a
     // configuration that was drifting)
@@ -109,6 +136,9 @@ namespace OpenMD {
     if (needReset) {
       currReset = resetTime + snap->getTime();
     }
+    if (needSpatialSort) {
+      currSpatialSort = spatialSortTime + snap->getTime();
+    }
     if (simParams->getRNEMDParameters()->getUseRNEMD()){
       currRNEMD = RNEMD_exchangeTime + snap->getTime();
     }
@@ -185,6 +215,12 @@ namespace OpenMD {
       resetIntegrator();
       currReset += resetTime;
     }        
+
+    if (needSpatialSort && snap->getTime() >= currSpatialSort) {
+      forceMan_->sortLocalData();
+      setupArrayUpdate();
+      currSpatialSort += spatialSortTime;
+    }
     //save snapshot
     info_->getSnapshotManager()->advance();
   
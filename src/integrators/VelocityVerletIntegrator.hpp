@@ -77,12 +77,23 @@ namespace OpenMD {
     virtual void postStep();
     virtual void finalize();
     virtual void resetIntegrator() {}
+
+    /**
+     * When the atoms are stored as a structure of arrays and every
+     * integrable object is a plain (non-directional) atom, the
+     * translational parts of moveA and moveB can work on whole
+     * arrays.  setupArrayUpdate fills atomMass_ with the mass of each
+     * local atom in that case, and leaves it empty otherwise.
+     */
+    void setupArrayUpdate();
+    vector<RealType> atomMass_;
     
     RealType dt2;
     RealType currSample;
     RealType currStatus;
     RealType currThermal;
     RealType currReset;
+    RealType currSpatialSort;
     RealType currRNEMD;
         
   private:
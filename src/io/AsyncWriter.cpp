@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+#include "io/AsyncWriter.hpp"
+#include "utils/simError.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+namespace OpenMD {
+
+  AsyncWriter::AsyncWriter(std::ostream* os, bool compress) :
+    os_(os), compress_(compress) {
+#ifdef HAVE_PTHREAD
+    busy_ = false;
+    done_ = false;
+    pthread_mutex_init(&mutex_, NULL);
+    pthread_cond_init(&cond_, NULL);
+    running_ = (pthread_create(&thread_, NULL, AsyncWriter::run, this) == 0);
+#endif
+  }
+
+  AsyncWriter::~AsyncWriter() {
+#ifdef HAVE_PTHREAD
+    if (running_) {
+      pthread_mutex_lock(&mutex_);
+      while (!jobs_.empty() || busy_) 
+        pthread_cond_wait(&cond_, &mutex_);
+      done_ = true;
+      pthread_cond_broadcast(&cond_);
+      pthread_mutex_unlock(&mutex_);
+      pthread_join(thread_, NULL);
+    }
+    pthread_cond_destroy(&cond_);
+    pthread_mutex_destroy(&mutex_);
+#endif
+    checkError();
+  }
+
+  void AsyncWriter::write(std::string& data) {
+    queue(std::string(), data);
+  }
+
+  void AsyncWriter::writeFile(const std::string& filename, std::string& data) {
+    queue(filename, data);
+  }
+
+  void AsyncWriter::queue(const std::string& filename, std::string& data) {
+    checkError();
+
+#ifdef HAVE_PTHREAD
+    if (running_) {
+      pthread_mutex_lock(&mutex_);
+      while (!jobs_.empty()) 
+        pthread_cond_wait(&cond_, &mutex_);
+      jobs_.push_back(Job());
+      jobs_.back().filename = filename;
+      jobs_.back().data.swap(data);
+      pthread_cond_broadcast(&cond_);
+      pthread_mutex_unlock(&mutex_);
+      return;
+    }
+#endif
+
+    Job job;
+    job.filename = filename;
+    job.data.swap(data);
+    process(job);
+    checkError();
+  }
+
+  void AsyncWriter::flush() {
+#ifdef HAVE_PTHREAD
+    if (running_) {
+      pthread_mutex_lock(&mutex_);
+      while (!jobs_.empty() || busy_) 
+        pthread_cond_wait(&cond_, &mutex_);
+      pthread_mutex_unlock(&mutex_);
+    }
+#endif
+    checkError();
+  }
+
+#ifdef HAVE_PTHREAD
+  void* AsyncWriter::run(void* writer) {
+    AsyncWriter* self = static_cast<AsyncWriter*>(writer);
+    Job job;
+
+    pthread_mutex_lock(&self->mutex_);
+    while (true) {
+      while (self->jobs_.empty() && !self->done_) 
+        pthread_cond_wait(&self->cond_, &self->mutex_);
+      if (self->jobs_.empty()) break;
+
+      job.filename.swap(self->jobs_.front().filename);
+      job.data.swap(self->jobs_.front().data);
+      self->jobs_.pop_front();
+      self->busy_ = true;
+      // wake a caller waiting for room in the queue:
+      pthread_cond_broadcast(&self->cond_);
+      pthread_mutex_unlock(&self->mutex_);
+
+      self->process(job);
+
+      pthread_mutex_lock(&self->mutex_);
+      self->busy_ = false;
+      pthread_cond_broadcast(&self->cond_);
+    }
+    pthread_mutex_unlock(&self->mutex_);
+    return NULL;
+  }
+#endif
+
+  /**
+   * Runs on the writer thread, so errors are only recorded here, and
+   * reported by the next call from the owner of the writer.
+   */
+  void AsyncWriter::process(Job& job) {
+    std::string packed;
+    const std::string* data = &job.data;
+    if (compress_) {
+      gzip(job.data, packed);
+      data = &packed;
+    }
+
+    bool failed;
+    if (job.filename.empty()) {
+      os_->write(data->data(), data->size());
+      os_->flush();
+      failed = os_->fail();
+    } else {
+      std::ofstream file(job.filename.c_str(), 
+                         std::ios::out | std::ios::binary);
+      file.write(data->data(), data->size());
+      file.close();
+      failed = file.fail();
+    }
+
+    if (failed) {
+#ifdef HAVE_PTHREAD
+      pthread_mutex_lock(&mutex_);
+#endif
+      error_ = job.filename.empty() ? std::string("the dump file") :
+        job.filename;
+#ifdef HAVE_PTHREAD
+      pthread_mutex_unlock(&mutex_);
+#endif
+    }
+    job.data.clear();
+  }
+
+  void AsyncWriter::checkError() {
+    std::string error;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&mutex_);
+#endif
+    error.swap(error_);
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&mutex_);
+#endif
+
+    if (!error.empty()) {
+      sprintf(painCave.errMsg, "AsyncWriter: could not write to %s\n",
+              error.c_str());
+      painCave.isFatal = 1;
+      simError();
+    }
+  }
+
+  void AsyncWriter::gzip(const std::string& in, std::string& out) {
+#ifdef HAVE_LIBZ
+    const std::size_t blockSize = 1 << 20;
+    int nBlocks = (in.size() + blockSize - 1) / blockSize;
+    std::vector<std::string> blocks(nBlocks);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < nBlocks; i++) {
+      std::size_t first = i * blockSize;
+      std::size_t length = std::min(blockSize, in.size() - first);
+
+      z_stream strm;
+      strm.zalloc = Z_NULL;
+      strm.zfree = Z_NULL;
+      strm.opaque = Z_NULL;
+      // 16 + MAX_WBITS asks for a gzip header and trailer:
+      deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS,
+                   8, Z_DEFAULT_STRATEGY);
+      blocks[i].resize(deflateBound(&strm, length));
+      strm.next_in = 
+        reinterpret_cast<Bytef*>(const_cast<char*>(in.data() + first));
+      strm.avail_in = length;
+      strm.next_out = reinterpret_cast<Bytef*>(&blocks[i][0]);
+      strm.avail_out = blocks[i].size();
+      deflate(&strm, Z_FINISH);
+      blocks[i].resize(strm.total_out);
+      deflateEnd(&strm);
+    }
+
+    std::size_t total = 0;
+    for (int i = 0; i < nBlocks; i++) total += blocks[i].size();
+    out.clear();
+    out.reserve(total);
+    for (int i = 0; i < nBlocks; i++) out += blocks[i];
+#else
+    out = in;
+#endif
+  }
+}
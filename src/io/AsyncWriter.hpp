@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+#ifndef IO_ASYNCWRITER_HPP
+#define IO_ASYNCWRITER_HPP
+
+#include <deque>
+#include <ostream>
+#include <string>
+
+#include "config.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+namespace OpenMD {
+
+  /**
+   * @class AsyncWriter AsyncWriter.hpp "io/AsyncWriter.hpp"
+   * @brief Writes buffers to disk on a background thread.
+   *
+   * A buffer handed to write() is appended to the stream given to the
+   * constructor, and a buffer handed to writeFile() becomes the whole
+   * of the named file.  The buffers are gzip compressed on the way
+   * out if compress is true.  The caller goes back to work as soon as
+   * the buffer is queued; only one buffer may wait behind the one
+   * being written, so a caller that outruns the disk is held up
+   * rather than piling up frames in memory.  Without pthreads, the
+   * buffers are written immediately.
+   *
+   * The writer thread makes no MPI calls, so it is safe alongside the
+   * MPI_THREAD_FUNNELED initialization in openmd.
+   */
+  class AsyncWriter {
+  public:
+    AsyncWriter(std::ostream* os, bool compress);
+    ~AsyncWriter();
+
+    /** Queues data (which is left empty) to go on the end of the stream */
+    void write(std::string& data);
+
+    /** Queues data (which is left empty) as the contents of filename */
+    void writeFile(const std::string& filename, std::string& data);
+
+    /** Waits until everything queued so far has been written */
+    void flush();
+
+    /**
+     * Compresses in to a series of gzip members, one for each
+     * megabyte of input, which are compressed in parallel.  The
+     * concatenation is itself a valid gzip file.
+     */
+    static void gzip(const std::string& in, std::string& out);
+
+  private:
+    struct Job {
+      std::string filename;
+      std::string data;
+    };
+
+    void queue(const std::string& filename, std::string& data);
+    void process(Job& job);
+    void checkError();
+
+    std::ostream* os_;
+    bool compress_;
+    std::string error_;
+
+#ifdef HAVE_PTHREAD
+    static void* run(void* writer);
+
+    pthread_t thread_;
+    pthread_mutex_t mutex_;
+    pthread_cond_t cond_;
+    std::deque<Job> jobs_;
+    bool running_;
+    bool busy_;
+    bool done_;
+#endif
+  };
+
+}
+#endif
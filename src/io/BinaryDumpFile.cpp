@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+#include "io/BinaryDumpFile.hpp"
+#include "utils/simError.h"
+
+#include <cstdio>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+namespace OpenMD {
+
+  static const char frameTag[4] = {'F', 'R', 'M', '1'};
+  static const char indexMagic[8] = {'O', 'M', 'D', 'B', 'I', 'D', 'X', '1'};
+  static const uint32_t byteOrderMark = 0x01020304;
+  static const uint32_t formatVersion = 1;
+
+  BinaryDumpFile::BinaryDumpFile(const std::string& filename) : 
+    filename_(filename), fileSize_(0), firstFrame_(-1), map_(NULL) {
+
+    std::ifstream header(filename_.c_str(), 
+                         std::ifstream::in | std::ifstream::binary);
+    if (header.fail()) {
+      sprintf(painCave.errMsg, "BinaryDumpFile: Cannot open file: %s\n",
+              filename_.c_str());
+      painCave.isFatal = 1;
+      simError();
+    }
+
+    std::string line;
+    while (std::getline(header, line)) {
+      if (line.find("<BinaryFrames") != std::string::npos) {
+        firstFrame_ = header.tellg();
+        break;
+      }
+    }
+    if (firstFrame_ < 0) {
+      sprintf(painCave.errMsg, 
+              "BinaryDumpFile: %s does not contain a <BinaryFrames> tag\n",
+              filename_.c_str());
+      painCave.isFatal = 1;
+      simError();
+    }
+    header.clear();
+    header.seekg(0, std::ios::end);
+    fileSize_ = header.tellg();
+    header.close();
+
+#ifdef HAVE_SYS_MMAN_H
+    int fd = open(filename_.c_str(), O_RDONLY);
+    void* map = (fd < 0) ? MAP_FAILED : 
+      mmap(NULL, fileSize_, PROT_READ, MAP_SHARED, fd, 0);
+    if (fd >= 0) close(fd);
+    if (map == MAP_FAILED) {
+      sprintf(painCave.errMsg, "BinaryDumpFile: Cannot map file: %s\n",
+              filename_.c_str());
+      painCave.isFatal = 1;
+      simError();
+    }
+    map_ = static_cast<char*>(map);
+#else
+    file_.open(filename_.c_str(), std::ifstream::in | std::ifstream::binary);
+#endif
+
+    readIndex();
+  }
+
+  BinaryDumpFile::~BinaryDumpFile() {
+#ifdef HAVE_SYS_MMAN_H
+    if (map_ != NULL) munmap(map_, fileSize_);
+#endif
+  }
+
+  bool BinaryDumpFile::isBinaryDump(const std::string& filename) {
+    std::ifstream in(filename.c_str(), 
+                     std::ifstream::in | std::ifstream::binary);
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line.find("</MetaData>") != std::string::npos) {
+        std::getline(in, line);
+        return line.find("<BinaryFrames") != std::string::npos;
+      }
+      if (line.find("<Snapshot>") != std::string::npos) return false;
+    }
+    return false;
+  }
+
+  const char* BinaryDumpFile::access(std::streamoff offset, std::size_t count) {
+#ifdef HAVE_SYS_MMAN_H
+    return map_ + offset;
+#else
+    scratch_.resize(count);
+    file_.clear();
+    file_.seekg(offset);
+    file_.read(&scratch_[0], count);
+    return scratch_.data();
+#endif
+  }
+
+  /**
+   * Reads the index from the trailer, or rebuilds it from the frame
+   * headers if the file was not closed properly.
+   */
+  void BinaryDumpFile::readIndex() {
+    frameOffsets_.clear();
+    frameTimes_.clear();
+
+    if (fileSize_ - firstFrame_ >= trailerSize) {
+      const char* p = access(fileSize_ - trailerSize, trailerSize);
+      uint64_t indexOffset = extract<uint64_t>(p);
+      uint64_t nFrames = extract<uint64_t>(p);
+      uint32_t byteOrder = extract<uint32_t>(p);
+      extract<uint32_t>(p);
+
+      if (memcmp(p, indexMagic, sizeof(indexMagic)) == 0) {
+        if (byteOrder != byteOrderMark) {
+          sprintf(painCave.errMsg, 
+                  "BinaryDumpFile: %s was written on a machine with a\n"
+                  "\tdifferent byte order.\n", filename_.c_str());
+          painCave.isFatal = 1;
+          simError();
+        }
+        
+        p = access(indexOffset, nFrames * 16);
+        for (uint64_t i = 0; i < nFrames; i++) {
+          frameOffsets_.push_back(extract<uint64_t>(p));
+          frameTimes_.push_back(extract<double>(p));
+        }
+        return;
+      }
+    }
+
+    sprintf(painCave.errMsg, 
+            "BinaryDumpFile: %s has no frame index, scanning the frames.\n",
+            filename_.c_str());
+    painCave.severity = OPENMD_WARNING;
+    painCave.isFatal = 0;
+    simError();
+    scanFrames();
+  }
+
+  void BinaryDumpFile::scanFrames() {
+    std::streamoff offset = firstFrame_;
+
+    while (offset + frameHeaderSize <= fileSize_) {
+      const char* p = access(offset, frameHeaderSize);
+      if (memcmp(p, frameTag, sizeof(frameTag)) != 0) break;
+      p += sizeof(frameTag);
+      extract<uint32_t>(p);
+      uint64_t stored = extract<uint64_t>(p);
+      extract<uint64_t>(p);
+      double time = extract<double>(p);
+
+      // a frame cut short by the end of the file is discarded:
+      if (offset + frameHeaderSize + std::streamoff(stored) > fileSize_) 
+        break;
+
+      frameOffsets_.push_back(offset);
+      frameTimes_.push_back(time);
+      offset += frameHeaderSize + stored;
+    }
+  }
+
+  void BinaryDumpFile::readFrame(int whichFrame, std::string& payload) {
+    std::streamoff offset = frameOffsets_[whichFrame];
+    const char* p = access(offset, frameHeaderSize);
+
+    if (memcmp(p, frameTag, sizeof(frameTag)) != 0) {
+      sprintf(painCave.errMsg, 
+              "BinaryDumpFile: frame %d of %s is corrupted\n", whichFrame,
+              filename_.c_str());
+      painCave.isFatal = 1;
+      simError();
+    }
+    p += sizeof(frameTag);
+    uint32_t flags = extract<uint32_t>(p);
+    uint64_t stored = extract<uint64_t>(p);
+    uint64_t raw = extract<uint64_t>(p);
+
+    p = access(offset + frameHeaderSize, stored);
+
+    if (flags & frameCompressed) {
+#ifdef HAVE_LIBZ
+      payload.resize(raw);
+      uLongf length = raw;
+      if (uncompress(reinterpret_cast<Bytef*>(&payload[0]), &length,
+                     reinterpret_cast<const Bytef*>(p), stored) != Z_OK ||
+          length != raw) {
+        sprintf(painCave.errMsg, 
+                "BinaryDumpFile: could not uncompress frame %d of %s\n",
+                whichFrame, filename_.c_str());
+        painCave.isFatal = 1;
+        simError();
+      }
+#else
+      sprintf(painCave.errMsg, 
+              "BinaryDumpFile: %s has compressed frames, but OpenMD was\n"
+              "\tbuilt without zlib.\n", filename_.c_str());
+      painCave.isFatal = 1;
+      simError();
+#endif
+    } else {
+      payload.assign(p, stored);
+    }
+  }
+
+  void BinaryDumpFile::writeFramesTag(std::ostream& os) {
+    os << "  <BinaryFrames version=" << formatVersion << ">\n";
+  }
+
+  std::streamoff BinaryDumpFile::writeFrame(std::ostream& os, 
+                                            const std::string& payload,
+                                            double time, bool compress) {
+    std::streamoff offset = os.tellp();
+    uint32_t flags = 0;
+    const std::string* data = &payload;
+
+#ifdef HAVE_LIBZ
+    std::string packed;
+    if (compress && !payload.empty()) {
+      uLongf length = compressBound(payload.size());
+      packed.resize(length);
+      if (compress2(reinterpret_cast<Bytef*>(&packed[0]), &length,
+                    reinterpret_cast<const Bytef*>(payload.data()),
+                    payload.size(), Z_BEST_SPEED) == Z_OK && 
+          length < payload.size()) {
+        packed.resize(length);
+        data = &packed;
+        flags |= frameCompressed;
+      }
+    }
+#endif
+
+    std::string header(frameTag, sizeof(frameTag));
+    append<uint32_t>(header, flags);
+    append<uint64_t>(header, data->size());
+    append<uint64_t>(header, payload.size());
+    append<double>(header, time);
+
+    os.write(header.data(), header.size());
+    os.write(data->data(), data->size());
+    return offset;
+  }
+
+  void BinaryDumpFile::writeIndex(std::ostream& os, 
+                                  const std::vector<std::streamoff>& offsets,
+                                  const std::vector<double>& times) {
+    uint64_t indexOffset = os.tellp();
+    std::string index;
+    for (unsigned int i = 0; i < offsets.size(); i++) {
+      append<uint64_t>(index, offsets[i]);
+      append<double>(index, times[i]);
+    }
+    append<uint64_t>(index, indexOffset);
+    append<uint64_t>(index, offsets.size());
+    append<uint32_t>(index, byteOrderMark);
+    append<uint32_t>(index, formatVersion);
+    index.append(indexMagic, sizeof(indexMagic));
+    os.write(index.data(), index.size());
+    os.flush();
+  }
+}
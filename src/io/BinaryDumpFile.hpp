@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+#ifndef IO_BINARYDUMPFILE_HPP
+#define IO_BINARYDUMPFILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+
+#include "config.h"
+
+namespace OpenMD {
+
+  /**
+   * @class BinaryDumpFile BinaryDumpFile.hpp "io/BinaryDumpFile.hpp"
+   * @brief Random access to the frames of a binary dump file.
+   *
+   * A binary dump starts with the same text header as a .dump file
+   * (the \<OpenMD\> line and the \<MetaData\> block), so SimCreator
+   * reads it without changes.  The header is followed by a
+   * \<BinaryFrames\> line and then the frames.  Each frame is a 32
+   * byte header (the "FRM1" tag, flags, the stored and uncompressed
+   * sizes of the payload, and the time) and the payload, which is
+   * optionally compressed with zlib.  The payload holds the frame
+   * data, the integrable objects, and the site data, all as doubles
+   * in the native byte order, in the order the text format uses.
+   *
+   * When the file is closed, an index of the frame offsets and times
+   * is appended, followed by a 32 byte trailer pointing at the index.
+   * The file is memory mapped for reading, so any frame can be
+   * reached without a scan.  A file without a trailer (from a run
+   * that did not finish) is indexed by hopping over the frame
+   * headers.
+   */
+  class BinaryDumpFile {
+  public:
+
+    /** fields of an integrable object, in the order they are stored */
+    enum {
+      fieldPosition = 1,
+      fieldVelocity = 2,
+      fieldQuaternion = 4,
+      fieldAngularMomentum = 8,
+      fieldForce = 16,
+      fieldTorque = 32
+    };
+
+    /** fields of a site, in the order they are stored */
+    enum {
+      siteFlucQPosition = 1,
+      siteFlucQVelocity = 2,
+      siteFlucQForce = 4,
+      siteElectricField = 8,
+      sitePotential = 16,
+      siteParticlePotential = 32
+    };
+
+    enum {
+      frameCompressed = 1
+    };
+
+    BinaryDumpFile(const std::string& filename);
+    ~BinaryDumpFile();
+
+    /** Checks the line after the MetaData block for the BinaryFrames tag */
+    static bool isBinaryDump(const std::string& filename);
+
+    int getNFrames() { return frameOffsets_.size(); }
+    double getFrameTime(int whichFrame) { return frameTimes_[whichFrame]; }
+
+    /** Copies the uncompressed payload of a frame into payload */
+    void readFrame(int whichFrame, std::string& payload);
+
+    /** Writes the line which separates the text header from the frames */
+    static void writeFramesTag(std::ostream& os);
+    /** 
+     * Writes one frame, and returns its offset from the start of the
+     * file.
+     */
+    static std::streamoff writeFrame(std::ostream& os, 
+                                     const std::string& payload,
+                                     double time, bool compress);
+    /** Writes the frame index and the trailer */
+    static void writeIndex(std::ostream& os, 
+                           const std::vector<std::streamoff>& offsets,
+                           const std::vector<double>& times);
+
+    template<typename T>
+    static void append(std::string& buffer, T value) {
+      buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    static T extract(const char*& p) {
+      T value;
+      memcpy(&value, p, sizeof(T));
+      p += sizeof(T);
+      return value;
+    }
+
+    static const int frameHeaderSize = 32;
+    static const int trailerSize = 32;
+
+  private:
+    /** returns a pointer to count bytes of the file at offset */
+    const char* access(std::streamoff offset, std::size_t count);
+    void readIndex();
+    void scanFrames();
+
+    std::string filename_;
+    std::streamoff fileSize_;
+    std::streamoff firstFrame_;
+    std::vector<std::streamoff> frameOffsets_;
+    std::vector<double> frameTimes_;
+
+    char* map_;
+#ifndef HAVE_SYS_MMAN_H
+    std::ifstream file_;
+    std::string scratch_;
+#endif
+  };
+
+}
+#endif
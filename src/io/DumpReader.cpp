@@ -51,6 +51,8 @@
 #include <sys/stat.h> 
  
 #include <iostream> 
+#include <fstream>
+#include <iterator>
 #include <math.h> 
  
 #include <stdio.h> 
@@ -58,17 +60,23 @@
 #include <string.h> 
  
 #include "io/DumpReader.hpp" 
+#include "io/BinaryDumpFile.hpp"
+#include "io/IndexedGzStream.hpp"
 #include "primitives/Molecule.hpp" 
 #include "utils/simError.h" 
 #include "utils/MemoryUtils.hpp" 
 #include "utils/StringTokenizer.hpp" 
+#include "utils/StringUtils.hpp"
 #include "brains/Thermo.hpp"
  
  
 namespace OpenMD { 
+
+  static const char indexMagic[8] = {'O', 'M', 'D', 'F', 'I', 'D', 'X', '1'};
    
   DumpReader::DumpReader(SimInfo* info, const std::string& filename) 
     : info_(info), filename_(filename), isScanned_(false), nframes_(0),
+      isCompressed_(false), isBinary_(false), binaryFile_(NULL),
       needCOMprops_(false) { 
     
 #ifdef IS_MPI 
@@ -76,8 +84,12 @@ namespace OpenMD {
     if (worldRank == 0) { 
 #endif 
       
-      inFile_ = new std::ifstream(filename_.c_str(),   
-                                  ifstream::in | ifstream::binary); 
+      isCompressed_ = isGzipFile(filename_);
+      if (isCompressed_)
+        inFile_ = new IndexedGzStream(filename_);
+      else
+        inFile_ = new std::ifstream(filename_.c_str(),   
+                                    ifstream::in | ifstream::binary); 
       
       if (inFile_->fail()) { 
 	sprintf(painCave.errMsg, 
@@ -86,10 +98,16 @@ namespace OpenMD {
 	painCave.isFatal = 1; 
 	simError(); 
       } 
+
+      isBinary_ = !isCompressed_ && BinaryDumpFile::isBinaryDump(filename_);
       
 #ifdef IS_MPI 
       
     } 
+
+    int binary = isBinary_;
+    MPI_Bcast(&binary, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    isBinary_ = binary;
     
     strcpy(checkPointMsg, "Dump file opened for reading successfully."); 
     errorCheckPoint(); 
@@ -107,6 +125,7 @@ namespace OpenMD {
 #endif
 
       delete inFile_; 
+      delete binaryFile_;
       
 #ifdef IS_MPI 
       
@@ -130,67 +149,20 @@ namespace OpenMD {
    
   void DumpReader::scanFile(void) { 
 
-    std::streampos prevPos;
-    std::streampos  currPos; 
-    
+    if (isBinary_) {
+      scanBinaryFile();
+      return;
+    }
+
 #ifdef IS_MPI 
     
     if (worldRank == 0) { 
 #endif // is_mpi 
-      
-      currPos = inFile_->tellg();
-      prevPos = currPos;
-      bool foundOpenSnapshotTag = false;
-      bool foundClosedSnapshotTag = false;
 
-      int lineNo = 0; 
-      while(inFile_->getline(buffer, bufferSize)) {
-        ++lineNo;
-        
-        std::string line = buffer;
-        currPos = inFile_->tellg(); 
-        if (line.find("<Snapshot>")!= std::string::npos) {
-          if (foundOpenSnapshotTag) {
-            sprintf(painCave.errMsg, 
-                    "DumpReader:<Snapshot> is multiply nested at line %d "
-                    "in %s \n", lineNo, filename_.c_str()); 
-            painCave.isFatal = 1; 
-            simError();           
-          }
-          foundOpenSnapshotTag = true;
-          foundClosedSnapshotTag = false;
-          framePos_.push_back(prevPos);
-          
-        } else if (line.find("</Snapshot>") != std::string::npos){
-          if (!foundOpenSnapshotTag) {
-            sprintf(painCave.errMsg, 
-                    "DumpReader:</Snapshot> appears before <Snapshot> at "
-                    "line %d in %s \n", lineNo, filename_.c_str()); 
-            painCave.isFatal = 1; 
-            simError(); 
-          }
-          
-          if (foundClosedSnapshotTag) {
-            sprintf(painCave.errMsg, 
-                    "DumpReader:</Snapshot> appears multiply nested at "
-                    "line %d in %s \n", lineNo, filename_.c_str()); 
-            painCave.isFatal = 1; 
-            simError(); 
-          }
-          foundClosedSnapshotTag = true;
-          foundOpenSnapshotTag = false;
-        }
-        prevPos = currPos;
-      }
-      
-      // only found <Snapshot> for the last frame means the file is
-      // corrupted, we should discard it and give a warning message
-      if (foundOpenSnapshotTag) {
-        sprintf(painCave.errMsg, 
-                "DumpReader: last frame in %s is invalid\n", filename_.c_str());
-        painCave.isFatal = 0; 
-        simError();       
-        framePos_.pop_back();
+      if (!readFrameIndex()) {
+        scanSnapshots();
+        // .omd and .eor files hold one frame, and don't need an index:
+        if (framePos_.size() > 1) writeFrameIndex();
       }
       
       nframes_ = framePos_.size(); 
@@ -206,11 +178,173 @@ namespace OpenMD {
     } 
      
     MPI_Bcast(&nframes_, 1, MPI_INT, 0, MPI_COMM_WORLD); 
+    frameTimes_.resize(nframes_);
+    MPI_Bcast(&frameTimes_[0], nframes_, MPI_REALTYPE, 0, MPI_COMM_WORLD);
     
 #endif // is_mpi 
     
     isScanned_ = true; 
   } 
+
+  /**
+   * Reads through the whole file to find the positions of the
+   * \<Snapshot\> tags and the time of each frame.
+   */
+  void DumpReader::scanSnapshots() {
+    std::streampos prevPos;
+    std::streampos  currPos; 
+
+    currPos = inFile_->tellg();
+    prevPos = currPos;
+    bool foundOpenSnapshotTag = false;
+    bool foundClosedSnapshotTag = false;
+    bool needTime = false;
+
+    int lineNo = 0; 
+    while(inFile_->getline(buffer, bufferSize)) {
+      ++lineNo;
+      
+      std::string line = buffer;
+      currPos = inFile_->tellg(); 
+      if (line.find("<Snapshot>")!= std::string::npos) {
+        if (foundOpenSnapshotTag) {
+          sprintf(painCave.errMsg, 
+                  "DumpReader:<Snapshot> is multiply nested at line %d "
+                  "in %s \n", lineNo, filename_.c_str()); 
+          painCave.isFatal = 1; 
+          simError();           
+        }
+        foundOpenSnapshotTag = true;
+        foundClosedSnapshotTag = false;
+        framePos_.push_back(prevPos);
+        frameTimes_.push_back(0.0);
+        needTime = true;
+        
+      } else if (needTime && line.find("Time:") != std::string::npos) {
+        frameTimes_.back() = atof(line.c_str() + line.find("Time:") + 5);
+        needTime = false;
+
+      } else if (line.find("</Snapshot>") != std::string::npos){
+        if (!foundOpenSnapshotTag) {
+          sprintf(painCave.errMsg, 
+                  "DumpReader:</Snapshot> appears before <Snapshot> at "
+                  "line %d in %s \n", lineNo, filename_.c_str()); 
+          painCave.isFatal = 1; 
+          simError(); 
+        }
+        
+        if (foundClosedSnapshotTag) {
+          sprintf(painCave.errMsg, 
+                  "DumpReader:</Snapshot> appears multiply nested at "
+                  "line %d in %s \n", lineNo, filename_.c_str()); 
+          painCave.isFatal = 1; 
+          simError(); 
+        }
+        foundClosedSnapshotTag = true;
+        foundOpenSnapshotTag = false;
+        needTime = false;
+      }
+      prevPos = currPos;
+    }
+    
+    // only found <Snapshot> for the last frame means the file is
+    // corrupted, we should discard it and give a warning message
+    if (foundOpenSnapshotTag) {
+      sprintf(painCave.errMsg, 
+              "DumpReader: last frame in %s is invalid\n", filename_.c_str());
+      painCave.isFatal = 0; 
+      simError();       
+      framePos_.pop_back();
+      frameTimes_.pop_back();
+    }
+  }
+
+  std::string DumpReader::getIndexFileName() {
+    return filename_ + ".idx";
+  }
+
+  /**
+   * Loads the frame index that an earlier scan left next to the dump
+   * file.  The index is only used if the size and modification time
+   * of the dump file match the ones stored in it.
+   */
+  bool DumpReader::readFrameIndex() {
+    struct stat status;
+    if (stat(filename_.c_str(), &status) != 0) return false;
+
+    std::ifstream indexFile(getIndexFileName().c_str(), 
+                            std::ios::in | std::ios::binary);
+    if (indexFile.fail()) return false;
+    std::string data((std::istreambuf_iterator<char>(indexFile)),
+                     std::istreambuf_iterator<char>());
+
+    const char* p = data.data();
+    const char* end = p + data.size();
+    if (data.size() < 32 || memcmp(p, indexMagic, sizeof(indexMagic)) != 0)
+      return false;
+    p += sizeof(indexMagic);
+
+    uint64_t fileSize = BinaryDumpFile::extract<uint64_t>(p);
+    int64_t modified = BinaryDumpFile::extract<int64_t>(p);
+    if (fileSize != uint64_t(status.st_size) || 
+        modified != int64_t(status.st_mtime))
+      return false;
+
+    uint64_t nFrames = BinaryDumpFile::extract<uint64_t>(p);
+    if (uint64_t(end - p) < nFrames * 16) return false;
+
+    std::vector<std::streampos> positions;
+    std::vector<RealType> times;
+    for (uint64_t i = 0; i < nFrames; i++) {
+      positions.push_back(std::streamoff(BinaryDumpFile::extract<uint64_t>(p)));
+      times.push_back(BinaryDumpFile::extract<double>(p));
+    }
+
+    if (isCompressed_) {
+      IndexedGzStream* gzFile = static_cast<IndexedGzStream*>(inFile_);
+      if (!gzFile->rdbuf()->unpackAccessPoints(p, end)) return false;
+    }
+
+    framePos_ = positions;
+    frameTimes_ = times;
+    return true;
+  }
+
+  /**
+   * Saves the frame positions and times (and the access points into
+   * a compressed file) so the next reader can skip the scan.  A
+   * directory we can't write to just means there is no index.
+   */
+  void DumpReader::writeFrameIndex() {
+    struct stat status;
+    if (stat(filename_.c_str(), &status) != 0) return;
+
+    std::string data(indexMagic, sizeof(indexMagic));
+    BinaryDumpFile::append<uint64_t>(data, status.st_size);
+    BinaryDumpFile::append<int64_t>(data, status.st_mtime);
+    BinaryDumpFile::append<uint64_t>(data, framePos_.size());
+    for (unsigned int i = 0; i < framePos_.size(); i++) {
+      BinaryDumpFile::append<uint64_t>(data, std::streamoff(framePos_[i]));
+      BinaryDumpFile::append<double>(data, frameTimes_[i]);
+    }
+
+    if (isCompressed_) {
+      IndexedGzStream* gzFile = static_cast<IndexedGzStream*>(inFile_);
+      gzFile->rdbuf()->packAccessPoints(data);
+    }
+
+    std::ofstream indexFile(getIndexFileName().c_str(), 
+                            std::ios::out | std::ios::binary);
+    if (indexFile.fail()) return;
+    indexFile.write(data.data(), data.size());
+  }
+
+  RealType DumpReader::getFrameTime(int whichFrame) {
+    if (!isScanned_) 
+      scanFile(); 
+
+    return frameTimes_[whichFrame];
+  }
    
   void DumpReader::readFrame(int whichFrame) { 
     if (!isScanned_) 
@@ -264,6 +398,11 @@ namespace OpenMD {
   void DumpReader::readSet(int whichFrame) {     
     std::string line;
 
+    if (isBinary_) {
+      readBinarySet(whichFrame);
+      return;
+    }
+
 #ifndef IS_MPI 
     inFile_->clear();  
     inFile_->seekg(framePos_[whichFrame]); 
@@ -342,29 +481,234 @@ namespace OpenMD {
     }
   } 
    
-  void DumpReader::parseDumpLine(const std::string& line) { 
+  /**
+   * The frame index of a binary dump is read from the end of the
+   * file, so there is nothing to scan.
+   */
+  void DumpReader::scanBinaryFile() {
+#ifdef IS_MPI 
+    if (worldRank == 0) { 
+#endif // is_mpi 
 
-       
-    StringTokenizer tokenizer(line); 
-    int nTokens; 
-     
-    nTokens = tokenizer.countTokens(); 
+      binaryFile_ = new BinaryDumpFile(filename_);
+      nframes_ = binaryFile_->getNFrames();
+      for (int i = 0; i < nframes_; i++) 
+        frameTimes_.push_back(binaryFile_->getFrameTime(i));
+
+      if (nframes_ == 0) {
+        sprintf(painCave.errMsg, 
+                "DumpReader: %s does not contain a valid frame\n",
+                filename_.c_str()); 
+        painCave.isFatal = 1; 
+        simError();      
+      }
+#ifdef IS_MPI 
+    } 
      
-    if (nTokens < 2) {  
+    MPI_Bcast(&nframes_, 1, MPI_INT, 0, MPI_COMM_WORLD); 
+    frameTimes_.resize(nframes_);
+    MPI_Bcast(&frameTimes_[0], nframes_, MPI_REALTYPE, 0, MPI_COMM_WORLD);
+#endif // is_mpi 
+
+    isScanned_ = true; 
+  }
+
+  template<unsigned int N>
+  static void unpackVector(const char*& p, Vector<RealType, N>& v) {
+    for (unsigned int i = 0; i < N; i++) 
+      v[i] = BinaryDumpFile::extract<double>(p);
+  }
+
+  void DumpReader::readBinarySet(int whichFrame) {
+    std::string payload;
+
+#ifdef IS_MPI
+    int masterNode = 0;
+    if (worldRank == masterNode) 
+      binaryFile_->readFrame(whichFrame, payload);
+
+    int payloadSize = payload.size();
+    MPI_Bcast(&payloadSize, 1, MPI_INT, masterNode, MPI_COMM_WORLD);
+    payload.resize(payloadSize);
+    MPI_Bcast(&payload[0], payloadSize, MPI_CHAR, masterNode, MPI_COMM_WORLD);
+#else
+    binaryFile_->readFrame(whichFrame, payload);
+#endif
+
+    const char* p = payload.data();
+    Snapshot* s = info_->getSnapshotManager()->getCurrentSnapshot();
+
+    s->setTime(BinaryDumpFile::extract<double>(p));
+    Mat3x3d hmat;
+    for (int i = 0; i < 3; i++)
+      for (int j = 0; j < 3; j++)
+        hmat(i, j) = BinaryDumpFile::extract<double>(p);
+    s->setHmat(hmat);
+    pair<RealType, RealType> thermostat;
+    thermostat.first = BinaryDumpFile::extract<double>(p);
+    thermostat.second = BinaryDumpFile::extract<double>(p);
+    s->setThermostat(thermostat); 
+    Mat3x3d eta;
+    for (int i = 0; i < 3; i++)
+      for (int j = 0; j < 3; j++)
+        eta(i, j) = BinaryDumpFile::extract<double>(p);
+    s->setBarostat(eta); 
+
+    int nObjects = BinaryDumpFile::extract<int32_t>(p);
+    for (int i = 0; i < nObjects; i++) 
+      unpackStuntDouble(p);
+
+    int nSites = BinaryDumpFile::extract<int32_t>(p);
+    for (int i = 0; i < nSites; i++) 
+      unpackSite(p);
+  }
+
+  /**
+   * The binary counterpart of parseDumpLine.  The record is always
+   * consumed, even when the object does not live on this processor.
+   */
+  void DumpReader::unpackStuntDouble(const char*& p) {
+    int index = BinaryDumpFile::extract<int32_t>(p);
+    uint32_t fields = BinaryDumpFile::extract<uint32_t>(p);
+
+    Vector3d pos, vel, ji, force, torque;
+    Quat4d q;
+    if (fields & BinaryDumpFile::fieldPosition) unpackVector(p, pos);
+    if (fields & BinaryDumpFile::fieldVelocity) unpackVector(p, vel);
+    if (fields & BinaryDumpFile::fieldQuaternion) unpackVector(p, q);
+    if (fields & BinaryDumpFile::fieldAngularMomentum) unpackVector(p, ji);
+    if (fields & BinaryDumpFile::fieldForce) unpackVector(p, force);
+    if (fields & BinaryDumpFile::fieldTorque) unpackVector(p, torque);
+
+    StuntDouble* sd = info_->getIOIndexToIntegrableObject(index);
+    if (sd == NULL) {
+      return;
+    }
+
+    if (needPos_ && !(fields & BinaryDumpFile::fieldPosition)) {
       sprintf(painCave.errMsg, 
-              "DumpReader Error: Not enough Tokens.\n%s\n", line.c_str()); 
+              "DumpReader Error: StuntDouble %d has no Position\n", index);
       painCave.isFatal = 1; 
       simError(); 
-    } 
+    }
+    if (sd->isDirectional() && needQuaternion_ && 
+        !(fields & BinaryDumpFile::fieldQuaternion)) {
+      sprintf(painCave.errMsg, 
+              "DumpReader Error: Directional StuntDouble %d has no\n"
+              "\tQuaternion\n", index);
+      painCave.isFatal = 1; 
+      simError(); 
+    }
+
+    if (needPos_) sd->setPos(pos);
+    if ((fields & BinaryDumpFile::fieldVelocity) && needVel_) sd->setVel(vel);
+
+    if ((fields & BinaryDumpFile::fieldQuaternion) && sd->isDirectional()) {
+      if (q.length() < OpenMD::epsilon) {
+        sprintf(painCave.errMsg, 
+                "DumpReader Error: initial quaternion error "
+                "(q0^2 + q1^2 + q2^2 + q3^2) ~ 0\n"); 
+        painCave.isFatal = 1; 
+        simError(); 
+      }
+      q.normalize(); 
+      if (needQuaternion_) sd->setQ(q); 
+    }
+    if ((fields & BinaryDumpFile::fieldAngularMomentum) && 
+        sd->isDirectional() && needAngMom_)
+      sd->setJ(ji);
+    if (fields & BinaryDumpFile::fieldForce) sd->setFrc(force);
+    if (fields & BinaryDumpFile::fieldTorque) sd->setTrq(torque);
+  }
+
+  /**
+   * The binary counterpart of parseSiteLine.  A site index of -1
+   * refers to a rigid body itself rather than one of its atoms.
+   */
+  void DumpReader::unpackSite(const char*& p) {
+    int index = BinaryDumpFile::extract<int32_t>(p);
+    int siteIndex = BinaryDumpFile::extract<int32_t>(p);
+    uint32_t fields = BinaryDumpFile::extract<uint32_t>(p);
+
+    RealType flucQPos(0.0), flucQVel(0.0), flucQFrc(0.0);
+    RealType sPot(0.0), particlePot(0.0);
+    Vector3d eField;
+    if (fields & BinaryDumpFile::siteFlucQPosition) 
+      flucQPos = BinaryDumpFile::extract<double>(p);
+    if (fields & BinaryDumpFile::siteFlucQVelocity) 
+      flucQVel = BinaryDumpFile::extract<double>(p);
+    if (fields & BinaryDumpFile::siteFlucQForce) 
+      flucQFrc = BinaryDumpFile::extract<double>(p);
+    if (fields & BinaryDumpFile::siteElectricField) 
+      unpackVector(p, eField);
+    if (fields & BinaryDumpFile::sitePotential) 
+      sPot = BinaryDumpFile::extract<double>(p);
+    if (fields & BinaryDumpFile::siteParticlePotential) 
+      particlePot = BinaryDumpFile::extract<double>(p);
 
-    int index = tokenizer.nextTokenAsInt();
+    StuntDouble* sd = info_->getIOIndexToIntegrableObject(index);
+    if (sd == NULL) {
+      return;
+    }
+    if (siteIndex >= 0 && sd->isRigidBody()) {
+      RigidBody* rb = static_cast<RigidBody*>(sd);
+      sd = rb->getAtoms()[siteIndex];
+    }
+
+    if (fields & BinaryDumpFile::siteFlucQPosition) sd->setFlucQPos(flucQPos);
+    if (fields & BinaryDumpFile::siteFlucQVelocity) sd->setFlucQVel(flucQVel);
+    if (fields & BinaryDumpFile::siteFlucQForce) sd->setFlucQFrc(flucQFrc);
+    if (fields & BinaryDumpFile::siteElectricField) 
+      sd->setElectricField(eField);
+    if (fields & BinaryDumpFile::sitePotential) sd->setSitePotential(sPot);
+    if (fields & BinaryDumpFile::siteParticlePotential) 
+      sd->setParticlePot(particlePot);
+  }
+
+  /**
+   * Reads the next n numbers of a line into v, and gives up on the
+   * whole line if they aren't there.
+   */
+  static void scanNumbers(const char*& p, RealType* v, int n, 
+                          const char* line) {
+    double x;
+    for (int i = 0; i < n; i++) {
+      if (!scanDouble(p, x)) {
+        sprintf(painCave.errMsg, 
+                "DumpReader Error: Not enough Tokens.\n%s\n", line); 
+        painCave.isFatal = 1; 
+        simError(); 
+      }
+      v[i] = x;
+    }
+  }
+
+  /**
+   * Parses one line of the StuntDoubles block in place.  The line
+   * isn't copied or split into strings, and the lines of a block are
+   * parsed by several threads at once, so this must only touch the
+   * object the line belongs to.
+   */
+  void DumpReader::parseDumpLine(const char* line) { 
+
+    const char* p = line;
+    const char* typeBegin;
+    const char* typeEnd;
+    int index;
+
+    if (!scanInt(p, index) || !scanToken(p, typeBegin, typeEnd)) {  
+      sprintf(painCave.errMsg, 
+              "DumpReader Error: Not enough Tokens.\n%s\n", line); 
+      painCave.isFatal = 1; 
+      simError(); 
+    } 
  
     StuntDouble* sd = info_->getIOIndexToIntegrableObject(index);
 
     if (sd == NULL) {
       return;
     }
-    std::string type = tokenizer.nextToken(); 
+    std::string type(typeBegin, typeEnd); 
     int size = type.size();
 
     size_t found;
@@ -375,7 +719,7 @@ namespace OpenMD {
         sprintf(painCave.errMsg, 
                 "DumpReader Error: StuntDouble %d has no Position\n"
                 "\tField (\"p\") specified.\n%s\n", index, 
-                line.c_str());  
+                line);  
         painCave.isFatal = 1; 
         simError(); 
       }
@@ -388,7 +732,7 @@ namespace OpenMD {
           sprintf(painCave.errMsg, 
                   "DumpReader Error: Directional StuntDouble %d has no\n"
                   "\tQuaternion Field (\"q\") specified.\n%s\n", index, 
-                  line.c_str());  
+                  line);  
           painCave.isFatal = 1; 
           simError(); 
         }
@@ -400,9 +744,7 @@ namespace OpenMD {
         
         case 'p': {
             Vector3d pos;
-            pos[0] = tokenizer.nextTokenAsDouble(); 
-            pos[1] = tokenizer.nextTokenAsDouble(); 
-            pos[2] = tokenizer.nextTokenAsDouble(); 
+            scanNumbers(p, pos.getArrayPointer(), 3, line);
             if (needPos_) { 
               sd->setPos(pos); 
             }             
@@ -410,9 +752,7 @@ namespace OpenMD {
         }
         case 'v' : {
             Vector3d vel;
-            vel[0] = tokenizer.nextTokenAsDouble(); 
-            vel[1] = tokenizer.nextTokenAsDouble(); 
-            vel[2] = tokenizer.nextTokenAsDouble(); 
+            scanNumbers(p, vel.getArrayPointer(), 3, line);
             if (needVel_) { 
               sd->setVel(vel); 
             } 
@@ -423,10 +763,7 @@ namespace OpenMD {
            Quat4d q;
            if (sd->isDirectional()) { 
               
-             q[0] = tokenizer.nextTokenAsDouble(); 
-             q[1] = tokenizer.nextTokenAsDouble(); 
-             q[2] = tokenizer.nextTokenAsDouble(); 
-             q[3] = tokenizer.nextTokenAsDouble(); 
+             scanNumbers(p, q.getArrayPointer(), 4, line);
               
              RealType qlen = q.length(); 
              if (qlen < OpenMD::epsilon) { //check quaternion is not
@@ -450,9 +787,7 @@ namespace OpenMD {
         case 'j' : {
           Vector3d ji;
           if (sd->isDirectional()) {
-             ji[0] = tokenizer.nextTokenAsDouble(); 
-             ji[1] = tokenizer.nextTokenAsDouble(); 
-             ji[2] = tokenizer.nextTokenAsDouble(); 
+             scanNumbers(p, ji.getArrayPointer(), 3, line);
              if (needAngMom_) { 
                sd->setJ(ji); 
              } 
@@ -462,62 +797,56 @@ namespace OpenMD {
         case 'f': {
 
           Vector3d force;
-          force[0] = tokenizer.nextTokenAsDouble(); 
-          force[1] = tokenizer.nextTokenAsDouble(); 
-          force[2] = tokenizer.nextTokenAsDouble();           
+          scanNumbers(p, force.getArrayPointer(), 3, line);
           sd->setFrc(force); 
           break;
         }
         case 't' : {
 
            Vector3d torque;
-           torque[0] = tokenizer.nextTokenAsDouble(); 
-           torque[1] = tokenizer.nextTokenAsDouble(); 
-           torque[2] = tokenizer.nextTokenAsDouble();           
+           scanNumbers(p, torque.getArrayPointer(), 3, line);
            sd->setTrq(torque);          
            break;
         }
         case 'u' : {
 
            RealType particlePot;
-           particlePot = tokenizer.nextTokenAsDouble(); 
+           scanNumbers(p, &particlePot, 1, line);
            sd->setParticlePot(particlePot);          
            break;
         }
         case 'c' : {
 
            RealType flucQPos;
-           flucQPos = tokenizer.nextTokenAsDouble(); 
+           scanNumbers(p, &flucQPos, 1, line);
            sd->setFlucQPos(flucQPos);          
            break;
         }
         case 'w' : {
 
            RealType flucQVel;
-           flucQVel = tokenizer.nextTokenAsDouble(); 
+           scanNumbers(p, &flucQVel, 1, line);
            sd->setFlucQVel(flucQVel);          
            break;
         }
         case 'g' : {
 
            RealType flucQFrc;
-           flucQFrc = tokenizer.nextTokenAsDouble(); 
+           scanNumbers(p, &flucQFrc, 1, line);
            sd->setFlucQFrc(flucQFrc);          
            break;
         }
         case 'e' : {
 
            Vector3d eField;
-           eField[0] = tokenizer.nextTokenAsDouble(); 
-           eField[1] = tokenizer.nextTokenAsDouble(); 
-           eField[2] = tokenizer.nextTokenAsDouble();           
+           scanNumbers(p, eField.getArrayPointer(), 3, line);
            sd->setElectricField(eField);          
            break;
         }
         case 's' : {
 
            RealType sPot;
-           sPot = tokenizer.nextTokenAsDouble(); 
+           scanNumbers(p, &sPot, 1, line);
            sd->setSitePotential(sPot);          
            break;
         }
@@ -535,25 +864,22 @@ namespace OpenMD {
   } 
    
 
-  void DumpReader::parseSiteLine(const std::string& line) { 
+  void DumpReader::parseSiteLine(const char* line) { 
 
-    StringTokenizer tokenizer(line); 
-    int nTokens; 
-         
-    nTokens = tokenizer.countTokens(); 
-     
-    if (nTokens < 2) {  
-      sprintf(painCave.errMsg, 
-              "DumpReader Error: Not enough Tokens.\n%s\n", line.c_str()); 
-      painCave.isFatal = 1; 
-      simError(); 
-    } 
+    const char* p = line;
+    int index;
 
     /**
      * The first token is the global integrable object index.
      */
 
-    int index = tokenizer.nextTokenAsInt();
+    if (!scanInt(p, index)) {
+      sprintf(painCave.errMsg, 
+              "DumpReader Error: Not enough Tokens.\n%s\n", line); 
+      painCave.isFatal = 1; 
+      simError(); 
+    } 
+
     StuntDouble* sd = info_->getIOIndexToIntegrableObject(index);
     if (sd == NULL) {
       return;
@@ -565,13 +891,8 @@ namespace OpenMD {
      * integer, we're parsing data for a site on a rigid body.
      */
 
-    std::string indexTest = tokenizer.peekNextToken();
-    std::istringstream i(indexTest);
     int siteIndex;
-    if (i >> siteIndex) {
-      // chew up this token and parse as an int:
-      siteIndex = tokenizer.nextTokenAsInt();
-
+    if (scanInt(p, siteIndex)) {
       if (sd->isRigidBody()) {
         RigidBody* rb = static_cast<RigidBody*>(sd);
         sd = rb->getAtoms()[siteIndex];
@@ -581,7 +902,15 @@ namespace OpenMD {
     /**
      * The next token contains information on what follows.
      */
-    std::string type = tokenizer.nextToken(); 
+    const char* typeBegin;
+    const char* typeEnd;
+    if (!scanToken(p, typeBegin, typeEnd)) {
+      sprintf(painCave.errMsg, 
+              "DumpReader Error: Not enough Tokens.\n%s\n", line); 
+      painCave.isFatal = 1; 
+      simError(); 
+    }
+    std::string type(typeBegin, typeEnd); 
     int size = type.size();
     
     for(int i = 0; i < size; ++i) {
@@ -590,44 +919,42 @@ namespace OpenMD {
       case 'u' : {
         
         RealType particlePot;
-        particlePot = tokenizer.nextTokenAsDouble(); 
+        scanNumbers(p, &particlePot, 1, line);
         sd->setParticlePot(particlePot);
         break;
       }
       case 'c' : {
         
         RealType flucQPos;
-        flucQPos = tokenizer.nextTokenAsDouble(); 
+        scanNumbers(p, &flucQPos, 1, line);
         sd->setFlucQPos(flucQPos);
         break;
       }
       case 'w' : {
         
         RealType flucQVel;
-        flucQVel = tokenizer.nextTokenAsDouble(); 
+        scanNumbers(p, &flucQVel, 1, line);
         sd->setFlucQVel(flucQVel);
         break;
       }
       case 'g' : {
         
         RealType flucQFrc;
-        flucQFrc = tokenizer.nextTokenAsDouble(); 
+        scanNumbers(p, &flucQFrc, 1, line);
         sd->setFlucQFrc(flucQFrc);
         break;
       }
       case 'e' : {
         
         Vector3d eField;
-        eField[0] = tokenizer.nextTokenAsDouble(); 
-        eField[1] = tokenizer.nextTokenAsDouble(); 
-        eField[2] = tokenizer.nextTokenAsDouble();  
+        scanNumbers(p, eField.getArrayPointer(), 3, line);
         sd->setElectricField(eField);          
         break;
       }
       case 's' : {
         
         RealType sPot;
-        sPot = tokenizer.nextTokenAsDouble(); 
+        scanNumbers(p, &sPot, 1, line);
         sd->setSitePotential(sPot);          
         break;
       }
@@ -642,8 +969,27 @@ namespace OpenMD {
     }    
   } 
   
+  /**
+   * Reads the lines of a block up to the closing tag into
+   * blockBuffer_, with the start of each line in lineStarts_.  The
+   * buffers are kept between frames, so this doesn't allocate once
+   * the first frame has been read.
+   */
+  void DumpReader::readBlock(std::istream& inputStream, const char* endTag) {
+    blockBuffer_.clear();
+    lineStarts_.clear();
+
+    while(inputStream.getline(buffer, bufferSize)) {
+      if (strstr(buffer, endTag) != NULL) {
+        break;
+      }
+      lineStarts_.push_back(blockBuffer_.size());
+      blockBuffer_.append(buffer);
+      blockBuffer_.push_back('\0');
+    }
+  }
   
-    void  DumpReader::readStuntDoubles(std::istream& inputStream) {
+  void  DumpReader::readStuntDoubles(std::istream& inputStream) {
     
     inputStream.getline(buffer, bufferSize);
     std::string line(buffer);
@@ -655,36 +1001,30 @@ namespace OpenMD {
       simError(); 
     }
 
-    while(inputStream.getline(buffer, bufferSize)) {
-      line = buffer;
-      
-      if(line.find("</StuntDoubles>") != std::string::npos) {
-        break;
-      }
+    readBlock(inputStream, "</StuntDoubles>");
 
-      parseDumpLine(line);
-    }
-  
+    // each line belongs to a different object, so the lines can be
+    // parsed in any order:
+    const char* block = blockBuffer_.data();
+    int nLines = lineStarts_.size();
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < nLines; i++) 
+      parseDumpLine(block + lineStarts_[i]);
   }
 
   void  DumpReader::readSiteData(std::istream& inputStream) {
 
-    std::string line(buffer);
-
     // We already found the starting <SiteData> tag or we wouldn't be
     // here, so just start parsing until we get to the ending
     // </SiteData> tag:
     
-    while(inputStream.getline(buffer, bufferSize)) {
-      line = buffer;
-      
-      if(line.find("</SiteData>") != std::string::npos) {
-        break;
-      }
+    readBlock(inputStream, "</SiteData>");
 
-      parseSiteLine(line);
-    }
-  
+    const char* block = blockBuffer_.data();
+    int nLines = lineStarts_.size();
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < nLines; i++) 
+      parseSiteLine(block + lineStarts_[i]);
   }
 
   void DumpReader::readFrameProperties(std::istream& inputStream) {
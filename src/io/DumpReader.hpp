@@ -55,10 +55,23 @@
 #include "brains/SimInfo.hpp" 
 #include "primitives/StuntDouble.hpp" 
 namespace OpenMD { 
+
+  class BinaryDumpFile;
  
   /** 
    * @class DumpReader DumpReader.hpp "io/DumpReader.hpp" 
    * @todo get rid of more junk code from DumpReader 
+   *
+   * Both the text format and the binary format written by
+   * DumpWriter are read; the binary format is recognized by the
+   * \<BinaryFrames\> line which follows the MetaData block.
+   *
+   * Scanning a text dump for the \<Snapshot\> tags is slow, so the
+   * frame positions and times are saved next to the dump in a .idx
+   * file, which is reused as long as the dump is unchanged.  Gzipped
+   * dumps are read through IndexedGzStream, and the .idx file also
+   * keeps its access points, so frames can be reached without
+   * decompressing the file from the start.
    */ 
   class DumpReader { 
   public: 
@@ -70,6 +83,9 @@ namespace OpenMD {
  
     /** Returns the number of frames in the dump file*/ 
     int getNFrames(); 
+
+    /** Returns the time of a frame without reading it */
+    RealType getFrameTime(int whichFrame);
  
     void setNeedCOMprops(bool ncp) {
       needCOMprops_ = ncp;
@@ -80,12 +96,22 @@ namespace OpenMD {
   protected: 
  
     void scanFile();  
+    void scanSnapshots();
+    std::string getIndexFileName();
+    bool readFrameIndex();
+    void writeFrameIndex();
     void readSet(int whichFrame); 
-    virtual void parseDumpLine(const std::string&); 
-    virtual void parseSiteLine(const std::string&);  
+    virtual void parseDumpLine(const char* line); 
+    virtual void parseSiteLine(const char* line);  
+    void readBlock(std::istream& inputStream, const char* endTag);
     virtual void readFrameProperties(std::istream& inputStream);
     void readStuntDoubles(std::istream& inputStream);
     void readSiteData(std::istream& inputStream);
+
+    void scanBinaryFile();
+    void readBinarySet(int whichFrame);
+    void unpackStuntDouble(const char*& p);
+    void unpackSite(const char*& p);
          
     SimInfo* info_; 
  
@@ -97,6 +123,12 @@ namespace OpenMD {
     std::istream* inFile_; 
      
     std::vector<std::streampos> framePos_; 
+    std::vector<RealType> frameTimes_;
+
+    bool isCompressed_;
+
+    bool isBinary_;
+    BinaryDumpFile* binaryFile_;
  
     bool needPos_; 
     bool needVel_; 
@@ -106,6 +138,9 @@ namespace OpenMD {
 
     const static int bufferSize = 4096;
     char buffer[bufferSize];
+
+    std::string blockBuffer_;
+    std::vector<std::size_t> lineStarts_;
   }; 
  
 }      //end namespace OpenMD 
@@ -49,11 +49,15 @@
 #include "io/DumpWriter.hpp"
 #include "primitives/Molecule.hpp"
 #include "utils/simError.h"
-#include "io/basic_teebuf.hpp"
-#ifdef HAVE_ZLIB
-#include "io/gzstream.hpp"
-#endif
 #include "io/Globals.hpp"
+#include "io/BinaryDumpFile.hpp"
+#include "utils/StringUtils.hpp"
+
+#include <sstream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #ifdef _MSC_VER
 #define isnan(x) _isnan((x))
@@ -63,6 +67,15 @@
 using namespace std;
 namespace OpenMD {
 
+#ifdef IS_MPI
+  struct DumpWriter::SharedDumpFile {
+    MPI_File handle;
+    MPI_Offset offset;
+    MPI_Request requests[2];
+    std::string sections[2];
+  };
+#endif
+
   DumpWriter::DumpWriter(SimInfo* info)
     : info_(info), filename_(info->getDumpFileName()),
       eorFilename_(info->getFinalConfigFileName()){
@@ -83,33 +96,17 @@ namespace OpenMD {
     }
 
     createDumpFile_ = true;
+    binary_ = (toUpperCopy(simParams->getDumpFileFormat()) == "BINARY");
+    // binary frames are compressed one at a time:
+    compressFrames_ = binary_ && needCompression_;
 #ifdef HAVE_LIBZ
     if (needCompression_) {
-      filename_ += ".gz";
+      if (!binary_) filename_ += ".gz";
       eorFilename_ += ".gz";
     }
 #endif
 
-#ifdef IS_MPI
-
-    if (worldRank == 0) {
-#endif // is_mpi
-
-      dumpFile_ = createOStream(filename_);
-
-      if (!dumpFile_) {
-        sprintf(painCave.errMsg, "Could not open \"%s\" for dump output.\n",
-                filename_.c_str());
-        painCave.isFatal = 1;
-        simError();
-      }
-
-#ifdef IS_MPI
-
-    }
-
-#endif // is_mpi
-
+    openDumpFile();
   }
 
 
@@ -134,6 +131,8 @@ namespace OpenMD {
     }
 
     createDumpFile_ = true;
+    binary_ = false;
+    compressFrames_ = false;
 #ifdef HAVE_LIBZ
     if (needCompression_) {
       filename_ += ".gz";
@@ -141,27 +140,7 @@ namespace OpenMD {
     }
 #endif
 
-#ifdef IS_MPI
-
-    if (worldRank == 0) {
-#endif // is_mpi
-
-
-      dumpFile_ = createOStream(filename_);
-
-      if (!dumpFile_) {
-        sprintf(painCave.errMsg, "Could not open \"%s\" for dump output.\n",
-                filename_.c_str());
-        painCave.isFatal = 1;
-        simError();
-      }
-
-#ifdef IS_MPI
-
-    }
-
-#endif // is_mpi
-
+    openDumpFile();
   }
 
   DumpWriter::DumpWriter(SimInfo* info, const std::string& filename, bool writeDumpFile)
@@ -184,6 +163,8 @@ namespace OpenMD {
       doSiteData_ = false;
     }
 
+    binary_ = false;
+    compressFrames_ = false;
 #ifdef HAVE_LIBZ
     if (needCompression_) {
       filename_ += ".gz";
@@ -191,47 +172,115 @@ namespace OpenMD {
     }
 #endif
 
-#ifdef IS_MPI
+    createDumpFile_ = writeDumpFile;
+    openDumpFile();
+  }
 
-    if (worldRank == 0) {
-#endif // is_mpi
+  /**
+   * Writes the frames to filename in the given format, whatever the
+   * dumpFileFormat of the simulation.  Used by the converters.
+   */
+  DumpWriter::DumpWriter(SimInfo* info, const std::string& filename, 
+                         DumpFormat format, bool compressFrames)
+    : info_(info), filename_(filename){
 
-      createDumpFile_ = writeDumpFile;
-      if (createDumpFile_) {
-        dumpFile_ = createOStream(filename_);
+    Globals* simParams = info->getSimParams();
+    eorFilename_ = filename_.substr(0, filename_.rfind(".")) + ".eor";
 
-        if (!dumpFile_) {
-          sprintf(painCave.errMsg, "Could not open \"%s\" for dump output.\n",
-                  filename_.c_str());
-          painCave.isFatal = 1;
-          simError();
-        }
-      }
-#ifdef IS_MPI
+    needCompression_   = false;
+    needForceVector_   = simParams->getOutputForceVector();
+    needParticlePot_   = simParams->getOutputParticlePotential();
+    needFlucQ_         = simParams->getOutputFluctuatingCharges();
+    needElectricField_ = simParams->getOutputElectricField();
+    needSitePotential_ = simParams->getOutputSitePotential();
 
+    if (needParticlePot_ || needFlucQ_ || needElectricField_ ||
+        needSitePotential_) {
+      doSiteData_ = true;
+    } else {
+      doSiteData_ = false;
     }
 
+    createDumpFile_ = true;
+    binary_ = (format == BinaryFormat);
+    compressFrames_ = binary_ && compressFrames;
 
-#endif // is_mpi
-
+    openDumpFile();
   }
 
   DumpWriter::~DumpWriter() {
 
+    if (createDumpFile_) {
+      if (binary_) {
 #ifdef IS_MPI
-
-    if (worldRank == 0) {
+        if (worldRank == 0) {
 #endif // is_mpi
-      if (createDumpFile_){
-        writeClosing(*dumpFile_);
-        delete dumpFile_;
-      }
+          writeBinaryClosing(*dumpFile_);
 #ifdef IS_MPI
+        }
+#endif // is_mpi
+      } else {
+        writeClosing();
+      }
+    }
+
+    // the writer finishes whatever is still queued before it goes:
+    delete writer_;
+    delete dumpFile_;
 
+#ifdef IS_MPI
+    if (shared_ != NULL) {
+      MPI_File_close(&shared_->handle);
+      delete shared_;
     }
+#endif // is_mpi
+  }
+
+  /**
+   * Opens the dump file and writes the MetaData.  On a single
+   * processor, the text dump goes through a background writer.  In
+   * parallel, every processor writes its own part of a text frame
+   * into the file with MPI-IO, while binary frames and the .eor
+   * files still go through the master node.
+   */
+  void DumpWriter::openDumpFile() {
+    dumpFile_ = NULL;
+    writer_ = NULL;
+    shared_ = NULL;
 
+#ifdef IS_MPI
+    if (createDumpFile_ && !binary_) {
+      openSharedDumpFile();
+    }
+    if (worldRank != 0) return;
 #endif // is_mpi
 
+    std::ostream* textFile = NULL;
+    if (createDumpFile_) {
+      if (binary_) {
+        dumpFile_ = createBinaryOStream(filename_);
+      } else {
+#ifndef IS_MPI
+        dumpFile_ = new std::ofstream(filename_.c_str(), 
+                                      std::ios::out | std::ios::binary);
+        textFile = dumpFile_;
+#endif
+      }
+
+      if (dumpFile_ != NULL && dumpFile_->fail()) {
+        sprintf(painCave.errMsg, "Could not open \"%s\" for dump output.\n",
+                filename_.c_str());
+        painCave.isFatal = 1;
+        simError();
+      }
+    }
+
+    // the same writer takes care of the .eor files:
+    writer_ = new AsyncWriter(textFile, needCompression_);
+    if (textFile != NULL) {
+      std::string header = metaDataHeader();
+      writer_->write(header);
+    }
   }
 
   void DumpWriter::writeFrameProperties(std::ostream& os, Snapshot* s) {
@@ -308,224 +357,477 @@ namespace OpenMD {
     os << "    </FrameData>\n";
   }
 
-  void DumpWriter::writeFrame(std::ostream& os) {
+  std::string DumpWriter::metaDataHeader() {
+    std::string header("<OpenMD version=2>\n  <MetaData>\n");
+    header += info_->getRawMetaData();
+    header += "  </MetaData>\n";
+    return header;
+  }
 
-#ifdef IS_MPI
-    MPI_Status istatus;
-#endif
+  std::string DumpWriter::frameHeader() {
+    std::ostringstream header;
+    header << "  <Snapshot>\n";
+    writeFrameProperties(header,
+                         info_->getSnapshotManager()->getCurrentSnapshot());
+    header << "    <StuntDoubles>\n";
+    return header.str();
+  }
 
+  /**
+   * Prepares the dump lines (and the site lines) of the local
+   * integrable objects.  The objects are dealt out to the OpenMP
+   * threads in contiguous chunks, and the chunks are joined in order,
+   * so the lines come out just as they would from a single thread.
+   */
+  void DumpWriter::prepareObjects(std::string& objects, std::string& sites) {
     Molecule* mol;
     StuntDouble* sd;
     SimInfo::MoleculeIterator mi;
     Molecule::IntegrableObjectIterator ii;
-    RigidBody::AtomIterator ai;
 
-#ifndef IS_MPI
-    os << "  <Snapshot>\n";
-
-    writeFrameProperties(os, info_->getSnapshotManager()->getCurrentSnapshot());
-
-    os << "    <StuntDoubles>\n";
+    std::vector<StuntDouble*> sds;
     for (mol = info_->beginMolecule(mi); mol != NULL;
          mol = info_->nextMolecule(mi)) {
-
       for (sd = mol->beginIntegrableObject(ii); sd != NULL;
            sd = mol->nextIntegrableObject(ii)) {
-          os << prepareDumpLine(sd);
-
+        sds.push_back(sd);
       }
     }
-    os << "    </StuntDoubles>\n";
 
-    if (doSiteData_) {
-      os << "    <SiteData>\n";
-      for (mol = info_->beginMolecule(mi); mol != NULL;
-           mol = info_->nextMolecule(mi)) {
+    int nObjects = sds.size();
+    int nChunks = 1;
+#ifdef _OPENMP
+    // a few chunks per thread evens out the rigid bodies:
+    nChunks = 4 * omp_get_max_threads();
+#endif
+    if (nChunks > nObjects) nChunks = max(nObjects, 1);
 
-        for (sd = mol->beginIntegrableObject(ii); sd != NULL;
-           sd = mol->nextIntegrableObject(ii)) {
+    std::vector<std::string> objectChunks(nChunks);
+    std::vector<std::string> siteChunks(nChunks);
 
-          int ioIndex = sd->getGlobalIntegrableObjectIndex();
-          // do one for the IO itself
-          os << prepareSiteLine(sd, ioIndex, 0);
+#pragma omp parallel for schedule(dynamic)
+    for (int chunk = 0; chunk < nChunks; chunk++) {
+      int first = (long(nObjects) * chunk) / nChunks;
+      int last = (long(nObjects) * (chunk + 1)) / nChunks;
+      RigidBody::AtomIterator ai;
 
-          if (sd->isRigidBody()) {
+      for (int i = first; i < last; i++) {
+        objectChunks[chunk] += prepareDumpLine(sds[i]);
 
-            RigidBody* rb = static_cast<RigidBody*>(sd);
+        if (doSiteData_) {
+          int ioIndex = sds[i]->getGlobalIntegrableObjectIndex();
+          // do one for the IO itself
+          siteChunks[chunk] += prepareSiteLine(sds[i], ioIndex, 0);
+
+          if (sds[i]->isRigidBody()) {
+            RigidBody* rb = static_cast<RigidBody*>(sds[i]);
             int siteIndex = 0;
             for (Atom* atom = rb->beginAtom(ai); atom != NULL;
                  atom = rb->nextAtom(ai)) {
-              os << prepareSiteLine(atom, ioIndex, siteIndex);
+              siteChunks[chunk] += prepareSiteLine(atom, ioIndex, siteIndex);
               siteIndex++;
             }
           }
         }
       }
-      os << "    </SiteData>\n";
     }
-    os << "  </Snapshot>\n";
 
-    os.flush();
-#else
+    std::size_t objectSize = 0;
+    std::size_t siteSize = 0;
+    for (int chunk = 0; chunk < nChunks; chunk++) {
+      objectSize += objectChunks[chunk].size();
+      siteSize += siteChunks[chunk].size();
+    }
+    objects.reserve(objectSize);
+    sites.reserve(siteSize);
+    for (int chunk = 0; chunk < nChunks; chunk++) {
+      objects += objectChunks[chunk];
+      sites += siteChunks[chunk];
+    }
+  }
 
-    const int masterNode = 0;
-    int worldRank;
-    int nProc;
+  /**
+   * Writes the current snapshot as a text frame to the dump file, the
+   * .eor file, or both.  The lines are prepared here, but the writing
+   * (and the compression) is left to the background writer, so the
+   * integrator can get on with the next step.
+   */
+  void DumpWriter::writeTextFrame(bool toDump, bool toEor) {
+    toDump = toDump && createDumpFile_;
 
-    MPI_Comm_size( MPI_COMM_WORLD, &nProc);
-    MPI_Comm_rank( MPI_COMM_WORLD, &worldRank);
+    std::string objects;
+    std::string sites;
+    prepareObjects(objects, sites);
 
+#ifdef IS_MPI
+    if (toDump) writeSections(objects, sites);
+    if (!toEor) return;
+
+    // the .eor file is assembled on the master node:
+    int nRecords = 0;
+    gatherRecords(objects, nRecords);
+    gatherRecords(sites, nRecords);
+    if (worldRank != 0) return;
+#endif // is_mpi
 
-    if (worldRank == masterNode) {
-      os << "  <Snapshot>\n";
-      writeFrameProperties(os,
-                           info_->getSnapshotManager()->getCurrentSnapshot());
-      os << "    <StuntDoubles>\n";
+    std::string frame = frameHeader();
+    frame.reserve(frame.size() + objects.size() + sites.size() + 128);
+    frame += objects;
+    frame += "    </StuntDoubles>\n";
+    if (doSiteData_) {
+      frame += "    <SiteData>\n";
+      frame += sites;
+      frame += "    </SiteData>\n";
     }
+    frame += "  </Snapshot>\n";
 
-    //every node prepares the dump lines for integrable objects belong to itself
-    std::string buffer;
-    for (mol = info_->beginMolecule(mi); mol != NULL;
-         mol = info_->nextMolecule(mi)) {
-      for (sd = mol->beginIntegrableObject(ii); sd != NULL;
-           sd = mol->nextIntegrableObject(ii)) {
-        buffer += prepareDumpLine(sd);
-      }
+    if (toEor) {
+      std::string eor = metaDataHeader();
+      eor += frame;
+      eor += "</OpenMD>\n";
+      writer_->writeFile(eorFilename_, eor);
     }
 
-    if (worldRank == masterNode) {
-      os << buffer;
+#ifndef IS_MPI
+    if (toDump) writer_->write(frame);
+#endif
+  }
 
-      for (int i = 1; i < nProc; ++i) {
-        // tell processor i to start sending us data:
+#ifdef IS_MPI
+  /**
+   * Creates the dump file for all of the processors, and writes the
+   * MetaData from the master node.
+   */
+  void DumpWriter::openSharedDumpFile() {
+    shared_ = new SharedDumpFile;
+    shared_->requests[0] = MPI_REQUEST_NULL;
+    shared_->requests[1] = MPI_REQUEST_NULL;
+
+    // SimCreator only gives the file names to the master node:
+    int nameLength = filename_.size();
+    MPI_Bcast(&nameLength, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    filename_.resize(nameLength);
+    MPI_Bcast(&filename_[0], nameLength, MPI_CHAR, 0, MPI_COMM_WORLD);
+
+    int err = MPI_File_open(MPI_COMM_WORLD, 
+                            const_cast<char*>(filename_.c_str()),
+                            MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL,
+                            &shared_->handle);
+    if (err != MPI_SUCCESS) {
+      sprintf(painCave.errMsg, "Could not open \"%s\" for dump output.\n",
+              filename_.c_str());
+      painCave.isFatal = 1;
+      simError();
+    }
+    MPI_File_set_size(shared_->handle, 0);
 
-        MPI_Bcast(&i, 1, MPI_INT, masterNode, MPI_COMM_WORLD);
+    long long headerSize = 0;
+    if (worldRank == 0) {
+      std::string header = metaDataHeader();
+      encode(header);
+      MPI_File_write_at(shared_->handle, 0, const_cast<char*>(header.data()),
+                        header.size(), MPI_CHAR, MPI_STATUS_IGNORE);
+      headerSize = header.size();
+    }
+    MPI_Bcast(&headerSize, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+    shared_->offset = headerSize;
+  }
+
+  /**
+   * Writes this processor's share of a text frame straight into the
+   * dump file.  A frame is laid out as the frame header, the object
+   * lines from each processor in rank order, and then the site lines
+   * in the same order, so every processor can work out where its two
+   * sections go from the sizes of everyone's sections.  The writes
+   * are collective, but don't block; they are finished off before
+   * the sections are reused for the next frame.
+   */
+  void DumpWriter::writeSections(const std::string& objects,
+                                 const std::string& sites) {
+    int nProc;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProc);
 
-        // receive the length of the string buffer that was
-        // prepared by processor i:
-        int recvLength;
-        MPI_Recv(&recvLength, 1, MPI_INT, i, MPI_ANY_TAG, MPI_COMM_WORLD,
-                 &istatus);
+    waitForSections();
+    std::string* sections = shared_->sections;
 
-        // create a buffer to receive the data
-        char* recvBuffer = new char[recvLength];
-        if (recvBuffer == NULL) {
-        } else {
-          // receive the data:
-          MPI_Recv(recvBuffer, recvLength, MPI_CHAR, i,
-                               MPI_ANY_TAG, MPI_COMM_WORLD, &istatus);
-          // send it to the file:
-          os << recvBuffer;
-          // get rid of the receive buffer:
-          delete [] recvBuffer;
-        }
+    sections[0].clear();
+    sections[1].clear();
+    if (worldRank == 0) {
+      sections[0] = frameHeader();
+      sections[1] = "    </StuntDoubles>\n";
+      if (doSiteData_) sections[1] += "    <SiteData>\n";
+    }
+    sections[0] += objects;
+    sections[1] += sites;
+    if (worldRank == nProc - 1) {
+      if (doSiteData_) sections[1] += "    </SiteData>\n";
+      sections[1] += "  </Snapshot>\n";
+    }
+
+    // each section becomes its own set of gzip members:
+    encode(sections[0]);
+    encode(sections[1]);
+
+    long long mySizes[2];
+    mySizes[0] = sections[0].size();
+    mySizes[1] = sections[1].size();
+    std::vector<long long> sizes(2 * nProc);
+    MPI_Allgather(mySizes, 2, MPI_LONG_LONG, &sizes[0], 2, MPI_LONG_LONG,
+                  MPI_COMM_WORLD);
+
+    long long before[2] = {0, 0};
+    long long total[2] = {0, 0};
+    for (int i = 0; i < nProc; i++) {
+      for (int j = 0; j < 2; j++) {
+        if (i < worldRank) before[j] += sizes[2 * i + j];
+        total[j] += sizes[2 * i + j];
       }
-    } else {
-      int sendBufferLength = buffer.size() + 1;
-      int myturn = 0;
-      for (int i = 1; i < nProc; ++i){
-        // wait for the master node to call our number:
-        MPI_Bcast(&myturn, 1, MPI_INT, masterNode, MPI_COMM_WORLD);
-        if (myturn == worldRank){
-          // send the length of our buffer:
+    }
+
+    MPI_Offset offsets[2];
+    offsets[0] = shared_->offset + before[0];
+    offsets[1] = shared_->offset + total[0] + before[1];
+    shared_->offset += total[0] + total[1];
+
+    for (int j = 0; j < 2; j++) {
+#if MPI_VERSION > 3 || (MPI_VERSION == 3 && MPI_SUBVERSION >= 1)
+      MPI_File_iwrite_at_all(shared_->handle, offsets[j],
+                             const_cast<char*>(sections[j].data()),
+                             sections[j].size(), MPI_CHAR,
+                             &shared_->requests[j]);
+#else
+      MPI_File_write_at_all(shared_->handle, offsets[j],
+                            const_cast<char*>(sections[j].data()),
+                            sections[j].size(), MPI_CHAR,
+                            MPI_STATUS_IGNORE);
+#endif
+    }
+  }
 
-          MPI_Send(&sendBufferLength, 1, MPI_INT, masterNode, 0, MPI_COMM_WORLD);
+  void DumpWriter::waitForSections() {
+    MPI_Waitall(2, shared_->requests, MPI_STATUSES_IGNORE);
+  }
+#endif // is_mpi
 
-          // send our buffer:
-          MPI_Send((void *)buffer.c_str(), sendBufferLength,
-                   MPI_CHAR, masterNode, 0, MPI_COMM_WORLD);
+  void DumpWriter::encode(std::string& text) {
+    if (needCompression_) {
+      std::string packed;
+      AsyncWriter::gzip(text, packed);
+      text.swap(packed);
+    }
+  }
 
-        }
+  /**
+   * Appends the components of v to buffer, with the same check for
+   * numerical errors that prepareDumpLine makes.
+   */
+  template<unsigned int N>
+  static void packVector(const Vector<RealType, N>& v, const char* what,
+                         int index, std::string& buffer) {
+    for (unsigned int i = 0; i < N; i++) {
+      if (isinf(v[i]) || isnan(v[i])) {
+        sprintf( painCave.errMsg,
+                 "DumpWriter detected a numerical error writing the %s"
+                 " for object %d", what, index);
+        painCave.isFatal = 1;
+        simError();
       }
+      BinaryDumpFile::append<double>(buffer, v[i]);
     }
+  }
 
-    if (worldRank == masterNode) {
-      os << "    </StuntDoubles>\n";
+  /**
+   * Packs an integrable object as its global index, a bit mask of
+   * the fields which follow (see BinaryDumpFile), and the fields.
+   */
+  void DumpWriter::packStuntDouble(StuntDouble* sd, std::string& buffer) {
+    int index = sd->getGlobalIntegrableObjectIndex();
+    uint32_t fields = BinaryDumpFile::fieldPosition | 
+      BinaryDumpFile::fieldVelocity;
+    if (sd->isDirectional())
+      fields |= BinaryDumpFile::fieldQuaternion | 
+        BinaryDumpFile::fieldAngularMomentum;
+    if (needForceVector_) {
+      fields |= BinaryDumpFile::fieldForce;
+      if (sd->isDirectional()) fields |= BinaryDumpFile::fieldTorque;
     }
 
-    if (doSiteData_) {
-      if (worldRank == masterNode) {
-        os << "    <SiteData>\n";
-      }
-      buffer.clear();
-      for (mol = info_->beginMolecule(mi); mol != NULL;
-           mol = info_->nextMolecule(mi)) {
+    BinaryDumpFile::append<int32_t>(buffer, index);
+    BinaryDumpFile::append<uint32_t>(buffer, fields);
 
-        for (sd = mol->beginIntegrableObject(ii); sd != NULL;
-             sd = mol->nextIntegrableObject(ii)) {
+    packVector(sd->getPos(), "position", index, buffer);
+    packVector(sd->getVel(), "velocity", index, buffer);
+    if (fields & BinaryDumpFile::fieldQuaternion) {
+      packVector(sd->getQ(), "quaternion", index, buffer);
+      packVector(sd->getJ(), "angular momentum", index, buffer);
+    }
+    if (fields & BinaryDumpFile::fieldForce)
+      packVector(sd->getFrc(), "force", index, buffer);
+    if (fields & BinaryDumpFile::fieldTorque)
+      packVector(sd->getTrq(), "torque", index, buffer);
+  }
+
+  /**
+   * Packs the site data with the same choice of fields as
+   * prepareSiteLine.  A siteIndex of -1 marks the rigid body itself.
+   */
+  void DumpWriter::packSite(StuntDouble* sd, int ioIndex, int siteIndex,
+                            std::string& buffer) {
+    int storageLayout = info_->getSnapshotManager()->getStorageLayout();
+    uint32_t fields = 0;
+
+    if (needFlucQ_) {
+      if (storageLayout & DataStorage::dslFlucQPosition)
+        fields |= BinaryDumpFile::siteFlucQPosition;
+      if (storageLayout & DataStorage::dslFlucQVelocity)
+        fields |= BinaryDumpFile::siteFlucQVelocity;
+      if (needForceVector_ && (storageLayout & DataStorage::dslFlucQForce))
+        fields |= BinaryDumpFile::siteFlucQForce;
+    }
+    if (needElectricField_ && (storageLayout & DataStorage::dslElectricField))
+      fields |= BinaryDumpFile::siteElectricField;
+    if (needSitePotential_ && (storageLayout & DataStorage::dslSitePotential))
+      fields |= BinaryDumpFile::sitePotential;
+    if (needParticlePot_ && (storageLayout & DataStorage::dslParticlePot))
+      fields |= BinaryDumpFile::siteParticlePotential;
+
+    BinaryDumpFile::append<int32_t>(buffer, ioIndex);
+    BinaryDumpFile::append<int32_t>(buffer, sd->isRigidBody() ? -1 : 
+                                    siteIndex);
+    BinaryDumpFile::append<uint32_t>(buffer, fields);
+
+    if (fields & BinaryDumpFile::siteFlucQPosition)
+      BinaryDumpFile::append<double>(buffer, sd->getFlucQPos());
+    if (fields & BinaryDumpFile::siteFlucQVelocity)
+      BinaryDumpFile::append<double>(buffer, sd->getFlucQVel());
+    if (fields & BinaryDumpFile::siteFlucQForce)
+      BinaryDumpFile::append<double>(buffer, sd->getFlucQFrc());
+    if (fields & BinaryDumpFile::siteElectricField) {
+      Vector3d eField = sd->getElectricField();
+      for (int i = 0; i < 3; i++) 
+        BinaryDumpFile::append<double>(buffer, eField[i]);
+    }
+    if (fields & BinaryDumpFile::sitePotential)
+      BinaryDumpFile::append<double>(buffer, sd->getSitePotential());
+    if (fields & BinaryDumpFile::siteParticlePotential)
+      BinaryDumpFile::append<double>(buffer, sd->getParticlePot());
+  }
+
+  /**
+   * Collects the records packed on every processor onto the master
+   * node, in processor order.  On the master node, buffer and
+   * nRecords hold the totals afterwards.
+   */
+  void DumpWriter::gatherRecords(std::string& buffer, int& nRecords) {
+#ifdef IS_MPI
+    const int masterNode = 0;
+    int nProc;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProc);
+
+    int myLength = buffer.size();
+    vector<int> lengths(nProc, 0);
+    vector<int> counts(nProc, 0);
+    MPI_Gather(&myLength, 1, MPI_INT, &lengths[0], 1, MPI_INT, masterNode,
+               MPI_COMM_WORLD);
+    MPI_Gather(&nRecords, 1, MPI_INT, &counts[0], 1, MPI_INT, masterNode,
+               MPI_COMM_WORLD);
+
+    vector<int> displacements(nProc, 0);
+    int total = 0;
+    nRecords = 0;
+    for (int i = 0; i < nProc; i++) {
+      displacements[i] = total;
+      total += lengths[i];
+      nRecords += counts[i];
+    }
+
+    // keep the buffers non-empty so that &buffer[0] is valid:
+    std::string all(max(total, 1), '\0');
+    buffer.push_back('\0');
+    MPI_Gatherv(&buffer[0], myLength, MPI_CHAR, &all[0], &lengths[0],
+                &displacements[0], MPI_CHAR, masterNode, MPI_COMM_WORLD);
+    all.resize(total);
+    buffer.swap(all);
+#endif
+  }
+
+  /**
+   * Writes the current snapshot as one binary frame: the time, the
+   * box, thermostat and barostat, then the integrable objects and
+   * the site data, each preceded by its number of records.
+   */
+  void DumpWriter::writeBinaryFrame(std::ostream& os) {
+    Molecule* mol;
+    StuntDouble* sd;
+    SimInfo::MoleculeIterator mi;
+    Molecule::IntegrableObjectIterator ii;
+    RigidBody::AtomIterator ai;
+
+    std::string objects;
+    std::string sites;
+    int nObjects = 0;
+    int nSites = 0;
+
+    for (mol = info_->beginMolecule(mi); mol != NULL;
+         mol = info_->nextMolecule(mi)) {
+      for (sd = mol->beginIntegrableObject(ii); sd != NULL;
+           sd = mol->nextIntegrableObject(ii)) {
+        packStuntDouble(sd, objects);
+        nObjects++;
 
+        if (doSiteData_) {
           int ioIndex = sd->getGlobalIntegrableObjectIndex();
-          // do one for the IO itself
-          buffer += prepareSiteLine(sd, ioIndex, 0);
+          packSite(sd, ioIndex, 0, sites);
+          nSites++;
 
           if (sd->isRigidBody()) {
-
             RigidBody* rb = static_cast<RigidBody*>(sd);
             int siteIndex = 0;
             for (Atom* atom = rb->beginAtom(ai); atom != NULL;
                  atom = rb->nextAtom(ai)) {
-              buffer += prepareSiteLine(atom, ioIndex, siteIndex);
+              packSite(atom, ioIndex, siteIndex, sites);
+              nSites++;
               siteIndex++;
             }
           }
         }
       }
-
-      if (worldRank == masterNode) {
-        os << buffer;
-
-        for (int i = 1; i < nProc; ++i) {
-
-          // tell processor i to start sending us data:
-          MPI_Bcast(&i, 1, MPI_INT, masterNode, MPI_COMM_WORLD);
-
-          // receive the length of the string buffer that was
-          // prepared by processor i:
-          int recvLength;
-          MPI_Recv(&recvLength, 1, MPI_INT, i, MPI_ANY_TAG, MPI_COMM_WORLD,
-                   &istatus);
-
-          // create a buffer to receive the data
-          char* recvBuffer = new char[recvLength];
-          if (recvBuffer == NULL) {
-          } else {
-            // receive the data:
-            MPI_Recv(recvBuffer, recvLength, MPI_CHAR, i,
-                     MPI_ANY_TAG, MPI_COMM_WORLD, &istatus);
-            // send it to the file:
-            os << recvBuffer;
-            // get rid of the receive buffer:
-            delete [] recvBuffer;
-          }
-        }
-      } else {
-        int sendBufferLength = buffer.size() + 1;
-        int myturn = 0;
-        for (int i = 1; i < nProc; ++i){
-          // wait for the master node to call our number:
-          MPI_Bcast(&myturn, 1, MPI_INT, masterNode, MPI_COMM_WORLD);
-          if (myturn == worldRank){
-            // send the length of our buffer:
-            MPI_Send(&sendBufferLength, 1, MPI_INT, masterNode, 0, MPI_COMM_WORLD);
-            // send our buffer:
-            MPI_Send((void *)buffer.c_str(), sendBufferLength,
-                     MPI_CHAR, masterNode, 0, MPI_COMM_WORLD);
-          }
-        }
-      }
-
-      if (worldRank == masterNode) {
-        os << "    </SiteData>\n";
-      }
     }
 
-    if (worldRank == masterNode) {
-      os << "  </Snapshot>\n";
-      os.flush();
-    }
+    gatherRecords(objects, nObjects);
+    gatherRecords(sites, nSites);
 
-#endif // is_mpi
+#ifdef IS_MPI
+    if (worldRank != 0) return;
+#endif
+
+    Snapshot* s = info_->getSnapshotManager()->getCurrentSnapshot();
+    std::string payload;
+    payload.reserve(objects.size() + sites.size() + 256);
 
+    double time = s->getTime();
+    BinaryDumpFile::append<double>(payload, time);
+    Mat3x3d hmat = s->getHmat();
+    for (int i = 0; i < 3; i++) 
+      for (int j = 0; j < 3; j++) 
+        BinaryDumpFile::append<double>(payload, hmat(i, j));
+    pair<RealType, RealType> thermostat = s->getThermostat();
+    BinaryDumpFile::append<double>(payload, thermostat.first);
+    BinaryDumpFile::append<double>(payload, thermostat.second);
+    Mat3x3d eta = s->getBarostat();
+    for (int i = 0; i < 3; i++) 
+      for (int j = 0; j < 3; j++) 
+        BinaryDumpFile::append<double>(payload, eta(i, j));
+
+    BinaryDumpFile::append<int32_t>(payload, nObjects);
+    payload += objects;
+    BinaryDumpFile::append<int32_t>(payload, nSites);
+    payload += sites;
+
+    frameOffsets_.push_back(BinaryDumpFile::writeFrame(os, payload, time,
+                                                       compressFrames_));
+    frameTimes_.push_back(time);
+    os.flush();
   }
 
   std::string DumpWriter::prepareDumpLine(StuntDouble* sd) {
@@ -757,90 +1059,53 @@ namespace OpenMD {
   }
 
   void DumpWriter::writeDump() {
-    writeFrame(*dumpFile_);
+    if (binary_) 
+      writeBinaryFrame(*dumpFile_);
+    else
+      writeTextFrame(true, false);
   }
 
   void DumpWriter::writeEor() {
-
-    std::ostream* eorStream = NULL;
-
-#ifdef IS_MPI
-    if (worldRank == 0) {
-#endif // is_mpi
-
-      eorStream = createOStream(eorFilename_);
-
-#ifdef IS_MPI
-    }
-#endif
-
-    writeFrame(*eorStream);
-
-#ifdef IS_MPI
-    if (worldRank == 0) {
-#endif
-
-      writeClosing(*eorStream);
-      delete eorStream;
-
-#ifdef IS_MPI
-    }
-#endif // is_mpi
-
+    writeTextFrame(false, true);
   }
 
-
   void DumpWriter::writeDumpAndEor() {
-    std::vector<std::streambuf*> buffers;
-    std::ostream* eorStream = NULL;
-#ifdef IS_MPI
-    if (worldRank == 0) {
-#endif // is_mpi
-      buffers.push_back(dumpFile_->rdbuf());
-      eorStream = createOStream(eorFilename_);
-      buffers.push_back(eorStream->rdbuf());
-#ifdef IS_MPI
+    if (binary_) {
+      writeBinaryFrame(*dumpFile_);
+      writeEor();
+    } else {
+      writeTextFrame(true, true);
     }
-#endif // is_mpi
-
-    TeeBuf tbuf(buffers.begin(), buffers.end());
-    std::ostream os(&tbuf);
-    writeFrame(os);
+  }
 
-#ifdef IS_MPI
-    if (worldRank == 0) {
-#endif // is_mpi
-      writeClosing(*eorStream);
-      delete eorStream;
-#ifdef IS_MPI
-    }
-#endif // is_mpi
+  std::ostream* DumpWriter::createBinaryOStream(const std::string& filename) {
+    std::ofstream* newOStream = new std::ofstream(filename.c_str(), 
+                                                  std::ios::out |
+                                                  std::ios::binary);
+    // the text header is shared with the text format, so SimCreator
+    // can read the MetaData:
+    (*newOStream) << metaDataHeader();
+    BinaryDumpFile::writeFramesTag(*newOStream);
+    return newOStream;
   }
 
-  std::ostream* DumpWriter::createOStream(const std::string& filename) {
+  void DumpWriter::writeBinaryClosing(std::ostream& os) {
+    BinaryDumpFile::writeIndex(os, frameOffsets_, frameTimes_);
+  }
 
-    std::ostream* newOStream;
-#ifdef HAVE_ZLIB
-    if (needCompression_) {
-      newOStream = new ogzstream(filename.c_str());
-    } else {
-      newOStream = new std::ofstream(filename.c_str());
+  void DumpWriter::writeClosing() {
+    std::string closing("</OpenMD>\n");
+#ifdef IS_MPI
+    waitForSections();
+    if (worldRank == 0) {
+      encode(closing);
+      MPI_File_write_at(shared_->handle, shared_->offset, 
+                        const_cast<char*>(closing.data()), closing.size(),
+                        MPI_CHAR, MPI_STATUS_IGNORE);
     }
 #else
-    newOStream = new std::ofstream(filename.c_str());
+    writer_->write(closing);
 #endif
-    //write out MetaData first
-    (*newOStream) << "<OpenMD version=2>" << std::endl;
-    (*newOStream) << "  <MetaData>" << std::endl;
-    (*newOStream) << info_->getRawMetaData();
-    (*newOStream) << "  </MetaData>" << std::endl;
-    return newOStream;
-  }
-
-  void DumpWriter::writeClosing(std::ostream& os) {
-
-    os << "</OpenMD>\n";
-    os.flush();
   }
 
 }//end namespace OpenMD
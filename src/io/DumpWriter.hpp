@@ -56,24 +56,43 @@
 // #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <vector>
 
 #include "primitives/Atom.hpp"
 #include "brains/SimInfo.hpp"
 #include "brains/Thermo.hpp"
 #include "primitives/StuntDouble.hpp"
+#include "io/AsyncWriter.hpp"
 
 namespace OpenMD {
 
   /**
    * @class DumpWriter DumpWriter.hpp "io/DumpWriter.hpp"
    * @todo 
+   *
+   * The trajectory of a simulation is written in the text format
+   * unless dumpFileFormat is "BINARY", in which case the frames are
+   * written in the format described in BinaryDumpFile.  The .eor
+   * file is always text.
+   *
+   * Text frames are handed to an AsyncWriter, which writes (and
+   * compresses) them in the background.  In parallel, each processor
+   * writes its own part of a text frame into the dump file with
+   * MPI-IO.
    */
   class DumpWriter{
 
   public:
+    enum DumpFormat {
+      TextFormat,
+      BinaryFormat
+    };
+
     DumpWriter(SimInfo* info);
     DumpWriter(SimInfo* info, const std::string& filename);
     DumpWriter(SimInfo* info, const std::string& filename,  bool writeDumpFile);
+    DumpWriter(SimInfo* info, const std::string& filename, DumpFormat format,
+               bool compressFrames = false);
     ~DumpWriter();
 
     void writeDumpAndEor();
@@ -82,12 +101,30 @@ namespace OpenMD {
     
   private:  
         
-    void writeFrame(std::ostream& os);
+    void openDumpFile();
     void writeFrameProperties(std::ostream& os, Snapshot* s);
     std::string prepareDumpLine(StuntDouble* sd);
     std::string prepareSiteLine(StuntDouble* sd, int ioIndex, int siteIndex);
-    std::ostream* createOStream(const std::string& filename);
-    void writeClosing(std::ostream& os);
+    std::string metaDataHeader();
+    std::string frameHeader();
+    void prepareObjects(std::string& objects, std::string& sites);
+    void writeTextFrame(bool toDump, bool toEor);
+    void encode(std::string& text);
+    void writeClosing();
+
+    void writeBinaryFrame(std::ostream& os);
+    void packStuntDouble(StuntDouble* sd, std::string& buffer);
+    void packSite(StuntDouble* sd, int ioIndex, int siteIndex,
+                  std::string& buffer);
+    void gatherRecords(std::string& buffer, int& nRecords);
+    std::ostream* createBinaryOStream(const std::string& filename);
+    void writeBinaryClosing(std::ostream& os);
+
+#ifdef IS_MPI
+    void openSharedDumpFile();
+    void writeSections(const std::string& objects, const std::string& sites);
+    void waitForSections();
+#endif
     
     SimInfo* info_;
     std::string filename_;
@@ -101,6 +138,18 @@ namespace OpenMD {
     bool needSitePotential_;
     bool doSiteData_;
     bool createDumpFile_;
+
+    bool binary_;
+    bool compressFrames_;
+    std::vector<std::streamoff> frameOffsets_;
+    std::vector<double> frameTimes_;
+
+    AsyncWriter* writer_;
+
+    // the MPI-IO state of a text dump is kept out of the header, so
+    // that DumpWriter has the same layout with and without IS_MPI:
+    struct SharedDumpFile;
+    SharedDumpFile* shared_;
   };
 
 }
@@ -88,6 +88,7 @@ namespace OpenMD {
     DefineOptionalParameter(ForceFieldVariant, "forceFieldVariant");
     DefineOptionalParameter(ForceFieldFileName, "forceFieldFileName");
     DefineOptionalParameter(DampingAlpha, "dampingAlpha");
+    DefineOptionalParameter(EwaldTolerance, "ewaldTolerance");
     DefineOptionalParameter(SurfaceTension, "surfaceTension");
     DefineOptionalParameter(PrintPressureTensor, "printPressureTensor");
     DefineOptionalParameter(ElectricField, "electricField");
@@ -158,6 +159,25 @@ namespace OpenMD {
                                             "outputSitePotential", false);
     DefineOptionalParameterWithDefaultValue(SkinThickness, "skinThickness", 
                                             1.0);
+    DefineOptionalParameterWithDefaultValue(AutoTuneSkinThickness, 
+                                            "autoTuneSkinThickness", false);
+    DefineOptionalParameterWithDefaultValue(UseStructureOfArrays, 
+                                            "useStructureOfArrays", false);
+    DefineOptionalParameterWithDefaultValue(UseVdWTable, "useVdWTable", false);
+    DefineOptionalParameterWithDefaultValue(VdWTableSpacing, "vdwTableSpacing",
+                                            0.05);
+    DefineOptionalParameterWithDefaultValue(VdWTableOrder, "vdwTableOrder", 5);
+    DefineOptionalParameterWithDefaultValue(ForceDecompositionMethod, 
+                                            "forceDecomposition", "MATRIX");
+    DefineOptionalParameterWithDefaultValue(OverlapCommunication, 
+                                            "overlapCommunication", false);
+    DefineOptionalParameterWithDefaultValue(WeightMoleculesByCost, 
+                                            "weightMoleculesByCost", false);
+    DefineOptionalParameterWithDefaultValue(DynamicLoadBalancing, 
+                                            "dynamicLoadBalancing", false);
+    DefineOptionalParameter(SpatialSortTime, "spatialSortTime");
+    DefineOptionalParameterWithDefaultValue(DumpFileFormat, 
+                                            "dumpFileFormat", "TEXT");
     DefineOptionalParameterWithDefaultValue(StatFileFormat, 
                                             "statFileFormat", 
                                             "TIME|TOTAL_ENERGY|POTENTIAL_ENERGY|KINETIC_ENERGY|TEMPERATURE|PRESSURE|VOLUME|CONSERVED_QUANTITY");    
@@ -226,6 +246,9 @@ namespace OpenMD {
     CheckParameter(FinalConfig, isNotEmpty());
     CheckParameter(SampleTime, isNonNegative());
     CheckParameter(ResetTime, isNonNegative());
+    CheckParameter(SpatialSortTime, isPositive());
+    CheckParameter(DumpFileFormat, isEqualIgnoreCase("TEXT") ||
+                   isEqualIgnoreCase("BINARY"));
     CheckParameter(StatusTime, isNonNegative());
     CheckParameter(CutoffRadius, isPositive());
     CheckParameter(SwitchingRadius, isNonNegative());
@@ -247,14 +270,19 @@ namespace OpenMD {
                    isEqualIgnoreCase("SHIFTED_POTENTIAL") || 
                    isEqualIgnoreCase("SHIFTED_FORCE") || 
                    isEqualIgnoreCase("TAYLOR_SHIFTED") ||
-                   isEqualIgnoreCase("EWALD_FULL"));
+                   isEqualIgnoreCase("EWALD_FULL") ||
+                   isEqualIgnoreCase("EWALD_PME") ||
+                   isEqualIgnoreCase("EWALD_SPME"));
     CheckParameter(ElectrostaticSummationMethod, isEqualIgnoreCase("NONE") || 
                    isEqualIgnoreCase("HARD") ||
                    isEqualIgnoreCase("SWITCHED") || 
                    isEqualIgnoreCase("SHIFTED_POTENTIAL") || 
                    isEqualIgnoreCase("SHIFTED_FORCE") || 
                    isEqualIgnoreCase("REACTION_FIELD") || 
-                   isEqualIgnoreCase("TAYLOR_SHIFTED"));
+                   isEqualIgnoreCase("TAYLOR_SHIFTED") ||
+                   isEqualIgnoreCase("EWALD_FULL") ||
+                   isEqualIgnoreCase("EWALD_PME") ||
+                   isEqualIgnoreCase("EWALD_SPME"));
     CheckParameter(ElectrostaticScreeningMethod, 
                    isEqualIgnoreCase("UNDAMPED") ||
                    isEqualIgnoreCase("DAMPED")); 
@@ -262,7 +290,12 @@ namespace OpenMD {
                    isEqualIgnoreCase("FIFTH_ORDER_POLYNOMIAL"));
     CheckParameter(OrthoBoxTolerance, isPositive());  
     CheckParameter(DampingAlpha,isNonNegative());
+    CheckParameter(EwaldTolerance, isPositive());
     CheckParameter(SkinThickness, isPositive());
+    CheckParameter(VdWTableSpacing, isPositive());
+    CheckParameter(VdWTableOrder, isPositive());
+    CheckParameter(ForceDecompositionMethod, isEqualIgnoreCase("MATRIX") ||
+                   isEqualIgnoreCase("SPATIAL"));
     CheckParameter(Viscosity, isNonNegative());
     CheckParameter(BeadSize, isPositive());
     CheckParameter(FrozenBufferRadius, isPositive());
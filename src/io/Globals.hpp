@@ -109,6 +109,7 @@ namespace OpenMD {
     DeclareParameter(ElectrostaticSummationMethod, std::string);
     DeclareParameter(ElectrostaticScreeningMethod, std::string);
     DeclareParameter(DampingAlpha, RealType);
+    DeclareParameter(EwaldTolerance, RealType);
     DeclareParameter(Dielectric, RealType);
     DeclareParameter(CutoffMethod, std::string);
     DeclareParameter(SwitchingFunctionType, std::string);
@@ -119,6 +120,17 @@ namespace OpenMD {
     DeclareParameter(OutputFluctuatingCharges, bool);
     DeclareParameter(OutputSitePotential, bool);
     DeclareParameter(SkinThickness, RealType);
+    DeclareParameter(AutoTuneSkinThickness, bool);
+    DeclareParameter(UseStructureOfArrays, bool);
+    DeclareParameter(UseVdWTable, bool);
+    DeclareParameter(VdWTableSpacing, RealType);
+    DeclareParameter(VdWTableOrder, int);
+    DeclareParameter(ForceDecompositionMethod, std::string);
+    DeclareParameter(OverlapCommunication, bool);
+    DeclareParameter(WeightMoleculesByCost, bool);
+    DeclareParameter(DynamicLoadBalancing, bool);
+    DeclareParameter(SpatialSortTime, RealType);
+    DeclareParameter(DumpFileFormat, std::string);
     DeclareParameter(StatFileFormat, std::string);    
     DeclareParameter(HydroPropFile, std::string);
     DeclareParameter(Viscosity, RealType);
@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+#include "io/IndexedGzStream.hpp"
+#include "io/BinaryDumpFile.hpp"
+#include "utils/simError.h"
+
+#include <cstdio>
+
+namespace OpenMD {
+
+  bool isGzipFile(const std::string& filename) {
+    std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+    unsigned char magic[2] = {0, 0};
+    in.read(reinterpret_cast<char*>(magic), 2);
+    return (in.gcount() == 2 && magic[0] == 0x1f && magic[1] == 0x8b);
+  }
+
+  IndexedGzStreamBuf::IndexedGzStreamBuf(const std::string& filename) : 
+    opened_(false), eof_(false), totalOut_(0), inPos_(0), have_(0),
+    wrapped_(false), raw_(false) {
+
+    setg(window_, window_, window_);
+
+#ifdef HAVE_LIBZ
+    file_.open(filename.c_str(), std::ios::in | std::ios::binary);
+    if (file_.fail()) return;
+
+    strm_.zalloc = Z_NULL;
+    strm_.zfree = Z_NULL;
+    strm_.opaque = Z_NULL;
+    strm_.avail_in = 0;
+    strm_.next_in = Z_NULL;
+    // 47 = 32 + 15: detect the gzip header, and use a 32 KB window
+    if (inflateInit2(&strm_, 47) != Z_OK) return;
+    opened_ = true;
+#else
+    sprintf(painCave.errMsg, 
+            "IndexedGzStreamBuf: %s is compressed, but OpenMD was built\n"
+            "\twithout zlib.\n", filename.c_str());
+    painCave.isFatal = 1;
+    simError();
+#endif
+  }
+
+  IndexedGzStreamBuf::~IndexedGzStreamBuf() {
+#ifdef HAVE_LIBZ
+    if (opened_) inflateEnd(&strm_);
+#endif
+  }
+
+  void IndexedGzStreamBuf::setAccessPoints(const std::vector<GzAccessPoint>& 
+                                           points) {
+    points_ = points;
+  }
+
+  void IndexedGzStreamBuf::packAccessPoints(std::string& buffer) {
+    BinaryDumpFile::append<uint64_t>(buffer, points_.size());
+#ifdef HAVE_LIBZ
+    std::string packed;
+    for (unsigned int i = 0; i < points_.size(); i++) {
+      const GzAccessPoint& point = points_[i];
+      uLongf length = compressBound(point.window.size());
+      packed.resize(length);
+      compress2(reinterpret_cast<Bytef*>(&packed[0]), &length,
+                reinterpret_cast<const Bytef*>(point.window.data()),
+                point.window.size(), Z_BEST_SPEED);
+      BinaryDumpFile::append<uint64_t>(buffer, point.out);
+      BinaryDumpFile::append<uint64_t>(buffer, point.in);
+      BinaryDumpFile::append<int32_t>(buffer, point.bits);
+      BinaryDumpFile::append<uint32_t>(buffer, point.window.size());
+      BinaryDumpFile::append<uint32_t>(buffer, length);
+      buffer.append(packed.data(), length);
+    }
+#endif
+  }
+
+  bool IndexedGzStreamBuf::unpackAccessPoints(const char*& p, 
+                                              const char* end) {
+    if (end - p < 8) return false;
+    uint64_t nPoints = BinaryDumpFile::extract<uint64_t>(p);
+    std::vector<GzAccessPoint> points;
+
+    for (uint64_t i = 0; i < nPoints; i++) {
+#ifdef HAVE_LIBZ
+      if (end - p < 28) return false;
+      GzAccessPoint point;
+      point.out = BinaryDumpFile::extract<uint64_t>(p);
+      point.in = BinaryDumpFile::extract<uint64_t>(p);
+      point.bits = BinaryDumpFile::extract<int32_t>(p);
+      uLongf length = BinaryDumpFile::extract<uint32_t>(p);
+      uint32_t stored = BinaryDumpFile::extract<uint32_t>(p);
+      if (length > uLongf(windowSize) || uint32_t(end - p) < stored) 
+        return false;
+
+      point.window.resize(length);
+      if (length > 0 && 
+          uncompress(reinterpret_cast<Bytef*>(&point.window[0]), &length,
+                     reinterpret_cast<const Bytef*>(p), stored) != Z_OK)
+        return false;
+      p += stored;
+      points.push_back(point);
+#else
+      return false;
+#endif
+    }
+    points_ = points;
+    return true;
+  }
+
+  IndexedGzStreamBuf::int_type IndexedGzStreamBuf::underflow() {
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+#ifdef HAVE_LIBZ
+    if (!opened_ || eof_) return traits_type::eof();
+
+    if (have_ == windowSize) {
+      have_ = 0;
+      wrapped_ = true;
+    }
+    int start = have_;
+
+    while (have_ == start && !eof_) {
+      if (strm_.avail_in == 0) {
+        file_.read(input_, chunkSize);
+        std::streamsize n = file_.gcount();
+        if (n == 0) {
+          eof_ = true;
+          break;
+        }
+        inPos_ += n;
+        strm_.next_in = reinterpret_cast<Bytef*>(input_);
+        strm_.avail_in = n;
+      }
+
+      strm_.next_out = reinterpret_cast<Bytef*>(window_ + have_);
+      strm_.avail_out = windowSize - have_;
+      int ret = inflate(&strm_, Z_BLOCK);
+      int produced = (windowSize - have_) - strm_.avail_out;
+      have_ += produced;
+      totalOut_ += produced;
+
+      if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) {
+        // trailing garbage or a damaged file ends the data:
+        eof_ = true;
+        break;
+      }
+
+      if (ret == Z_STREAM_END) {
+        // after a restart in the middle of a member, the gzip trailer
+        // has to be skipped by hand:
+        if (raw_) {
+          int skip = 8;
+          while (skip > 0) {
+            if (strm_.avail_in == 0) {
+              file_.read(input_, chunkSize);
+              std::streamsize n = file_.gcount();
+              if (n == 0) break;
+              inPos_ += n;
+              strm_.next_in = reinterpret_cast<Bytef*>(input_);
+              strm_.avail_in = n;
+            }
+            int k = (skip < int(strm_.avail_in)) ? skip : strm_.avail_in;
+            strm_.next_in += k;
+            strm_.avail_in -= k;
+            skip -= k;
+          }
+        }
+        // another member may follow:
+        inflateReset2(&strm_, 47);
+        raw_ = false;
+        continue;
+      }
+
+      // at the end of a deflate block (but not the last one), add an
+      // access point if we are a span past the last one:
+      if ((strm_.data_type & 128) && !(strm_.data_type & 64)) {
+        if (points_.empty() || totalOut_ >= points_.back().out + span) 
+          addAccessPoint(strm_.data_type & 7);
+      }
+    }
+
+    setg(window_ + start, window_ + start, window_ + have_);
+    if (have_ == start) return traits_type::eof();
+    return traits_type::to_int_type(*gptr());
+#else
+    return traits_type::eof();
+#endif
+  }
+
+  void IndexedGzStreamBuf::addAccessPoint(int bits) {
+#ifdef HAVE_LIBZ
+    GzAccessPoint point;
+    point.out = totalOut_;
+    point.in = inPos_ - strm_.avail_in;
+    point.bits = bits;
+    // the window holds the most recent output, oldest bytes first:
+    if (wrapped_) {
+      point.window.assign(window_ + have_, windowSize - have_);
+      point.window.append(window_, have_);
+    } else {
+      point.window.assign(window_, have_);
+    }
+    points_.push_back(point);
+#endif
+  }
+
+  /**
+   * Restarts the decompression at an access point, or at the start
+   * of the file if whichPoint is negative.
+   */
+  bool IndexedGzStreamBuf::restart(int whichPoint) {
+#ifdef HAVE_LIBZ
+    file_.clear();
+    eof_ = false;
+    strm_.avail_in = 0;
+    have_ = 0;
+    wrapped_ = false;
+    setg(window_, window_, window_);
+
+    if (whichPoint < 0) {
+      file_.seekg(0);
+      inPos_ = 0;
+      totalOut_ = 0;
+      raw_ = false;
+      return inflateReset2(&strm_, 47) == Z_OK && file_.good();
+    }
+
+    const GzAccessPoint& point = points_[whichPoint];
+    inPos_ = point.in - (point.bits ? 1 : 0);
+    file_.seekg(inPos_);
+    totalOut_ = point.out;
+    raw_ = true;
+    if (inflateReset2(&strm_, -15) != Z_OK) return false;
+
+    if (point.bits) {
+      int c = file_.get();
+      if (c == EOF) return false;
+      inPos_++;
+      inflatePrime(&strm_, point.bits, c >> (8 - point.bits));
+    }
+    if (!point.window.empty()) 
+      inflateSetDictionary(&strm_, 
+                           reinterpret_cast<const Bytef*>(point.window.data()),
+                           point.window.size());
+    return file_.good();
+#else
+    return false;
+#endif
+  }
+
+  IndexedGzStreamBuf::pos_type 
+  IndexedGzStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                              std::ios_base::openmode which) {
+    if (!opened_ || !(which & std::ios_base::in)) 
+      return pos_type(off_type(-1));
+
+    uint64_t current = totalOut_ - (egptr() - gptr());
+    if (dir == std::ios_base::cur) {
+      if (off == 0) return pos_type(off_type(current));
+      return seekpos(pos_type(off_type(current) + off), which);
+    }
+    if (dir == std::ios_base::beg) 
+      return seekpos(pos_type(off), which);
+
+    // the uncompressed length is not known in advance:
+    return pos_type(off_type(-1));
+  }
+
+  IndexedGzStreamBuf::pos_type 
+  IndexedGzStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    if (!opened_ || !(which & std::ios_base::in) || off_type(pos) < 0) 
+      return pos_type(off_type(-1));
+
+    uint64_t target = off_type(pos);
+    uint64_t bufferStart = totalOut_ - (egptr() - eback());
+
+    if (target >= bufferStart && target <= totalOut_) {
+      setg(eback(), eback() + (target - bufferStart), egptr());
+      return pos;
+    }
+
+    // find the last access point at or before the target:
+    int lo = 0;
+    int hi = points_.size();
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (points_[mid].out <= target) 
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    int best = lo - 1;
+
+    if (target < bufferStart || (best >= 0 && points_[best].out > totalOut_)) {
+      if (!restart(best)) return pos_type(off_type(-1));
+    }
+
+    while (totalOut_ < target) {
+      setg(egptr(), egptr(), egptr());
+      if (traits_type::eq_int_type(underflow(), traits_type::eof())) 
+        return pos_type(off_type(-1));
+    }
+
+    bufferStart = totalOut_ - (egptr() - eback());
+    setg(eback(), eback() + (target - bufferStart), egptr());
+    return pos;
+  }
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+#ifndef IO_INDEXEDGZSTREAM_HPP
+#define IO_INDEXEDGZSTREAM_HPP
+
+#include <istream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "config.h"
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+namespace OpenMD {
+
+  /** Returns true if filename starts with the gzip magic bytes */
+  bool isGzipFile(const std::string& filename);
+
+  /**
+   * A place in a gzip file where decompression can be restarted: the
+   * uncompressed and compressed offsets, the number of bits of the
+   * byte before in that belong to the next block, and the 32 KB of
+   * uncompressed data which precede out.
+   */
+  struct GzAccessPoint {
+    uint64_t out;
+    uint64_t in;
+    int bits;
+    std::string window;
+  };
+
+  /**
+   * @class IndexedGzStreamBuf IndexedGzStream.hpp "io/IndexedGzStream.hpp"
+   * @brief A read-only stream buffer over a gzip file which supports
+   * seeking.
+   *
+   * While the file is read, an access point is recorded at the first
+   * deflate block boundary after every span bytes of uncompressed
+   * data.  A seek restarts the decompression from the nearest access
+   * point before the target (as in zran.c from the zlib examples),
+   * so only part of one span has to be decompressed again.  The
+   * access points can be saved and restored, so a file only has to
+   * be read through once.
+   */
+  class IndexedGzStreamBuf : public std::streambuf {
+  public:
+    IndexedGzStreamBuf(const std::string& filename);
+    ~IndexedGzStreamBuf();
+
+    bool isOpen() { return opened_; }
+
+    const std::vector<GzAccessPoint>& getAccessPoints() { return points_; }
+    void setAccessPoints(const std::vector<GzAccessPoint>& points);
+
+    /** Appends the access points, with compressed windows, to buffer */
+    void packAccessPoints(std::string& buffer);
+    /** 
+     * Reads access points written by packAccessPoints from p, which
+     * may not go past end.  Returns false if they are damaged.
+     */
+    bool unpackAccessPoints(const char*& p, const char* end);
+
+  protected:
+    virtual int_type underflow();
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                             std::ios_base::openmode which);
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+  private:
+    static const int windowSize = 32768;
+    static const int chunkSize = 16384;
+    static const uint64_t span = 4194304;
+
+    bool restart(int whichPoint);
+    void addAccessPoint(int bits);
+
+    std::ifstream file_;
+    bool opened_;
+    bool eof_;
+    std::vector<GzAccessPoint> points_;
+
+    /** uncompressed offset of the end of the get area */
+    uint64_t totalOut_;
+    /** compressed offset of the end of the data read from the file */
+    uint64_t inPos_;
+    /** bytes of window_ filled since it last wrapped around */
+    int have_;
+    bool wrapped_;
+    bool raw_;
+
+    char window_[windowSize];
+    char input_[chunkSize];
+#ifdef HAVE_LIBZ
+    z_stream strm_;
+#endif
+  };
+
+  /**
+   * @class IndexedGzStream IndexedGzStream.hpp "io/IndexedGzStream.hpp"
+   * @brief An input stream over a gzip file with fast seekg.
+   */
+  class IndexedGzStream : public std::istream {
+  public:
+    IndexedGzStream(const std::string& filename) : std::istream(NULL),
+                                                   buf_(filename) {
+      init(&buf_);
+      if (!buf_.isOpen()) setstate(std::ios::failbit);
+    }
+    IndexedGzStreamBuf* rdbuf() { return &buf_; }
+
+  private:
+    IndexedGzStreamBuf buf_;
+  };
+
+}
+#endif
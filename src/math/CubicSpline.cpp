@@ -210,6 +210,11 @@ RealType CubicSpline::getValueAt(const RealType& t) {
   assert(t >= x_.front());
   assert(t <= x_.back());
 
+  // j and dt are kept local so that a generated spline can be shared
+  // between threads.
+  int j;
+  RealType dt;
+
   //  Find the interval ( x[j], x[j+1] ) that contains or is nearest
   //  to t.
 
@@ -249,6 +254,9 @@ void CubicSpline::getValueAt(const RealType& t, RealType& v) {
   assert(t >= x_.front());
   assert(t <= x_.back());
 
+  int j;
+  RealType dt;
+
   //  Find the interval ( x[j], x[j+1] ) that contains or is nearest
   //  to t.
 
@@ -291,6 +299,9 @@ void CubicSpline::getValueAndDerivativeAt(const RealType& t, RealType& v,
   assert(t >= x_.front());
   assert(t <= x_.back());
 
+  int j;
+  RealType dt;
+
   //  Find the interval ( x[j], x[j+1] ) that contains or is nearest
   //  to t.
 
@@ -60,17 +60,17 @@ namespace OpenMD {
     pair<RealType, RealType> getLimits();
     void getValueAt(const RealType& t, RealType& v);
     void getValueAndDerivativeAt(const RealType& t, RealType& v, RealType& d);
+    void generate();
     
   private:
-    void generate();
     std::vector<int> sort_permutation(std::vector<RealType>& v);
     std::vector<RealType> apply_permutation(std::vector<RealType> const& v,
                                             std::vector<int> const& p);
     
     bool isUniform;
     bool generated;
-    RealType dx, dt, yval, dydx;
-    int n, j;
+    RealType dx;
+    int n;
     vector<RealType> x_;
     vector<RealType> y_;
     vector<RealType> b;
@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+ 
+/**
+ * @file Vector3Array.hpp
+ */
+ 
+#ifndef MATH_VECTOR3ARRAY_HPP
+#define MATH_VECTOR3ARRAY_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "math/Vector3.hpp"
+
+namespace OpenMD {
+
+  /**
+   * @class Vector3Ref Vector3Array.hpp "math/Vector3Array.hpp"
+   * @brief A reference to one element of a Vector3Array.
+   *
+   * The three components of the element are p[0], p[stride] and
+   * p[2*stride], so the same reference works for either layout of
+   * the array.  It converts to a Vector3, and can be assigned and
+   * updated in place like one.
+   */
+  template<typename Real>
+  class Vector3Ref {
+  public:
+    Vector3Ref(Real* p, std::size_t stride) : p_(p), stride_(stride) {}
+
+    inline operator Vector3<Real>() const {
+      return Vector3<Real>(p_[0], p_[stride_], p_[2*stride_]);
+    }
+
+    inline Real& operator[](unsigned int i) { return p_[i*stride_]; }
+    inline Real operator[](unsigned int i) const { return p_[i*stride_]; }
+
+    inline Real& x() { return p_[0]; }
+    inline Real x() const { return p_[0]; }
+    inline Real& y() { return p_[stride_]; }
+    inline Real y() const { return p_[stride_]; }
+    inline Real& z() { return p_[2*stride_]; }
+    inline Real z() const { return p_[2*stride_]; }
+
+    /** assigns the value (not the reference) of another element */
+    inline Vector3Ref& operator=(const Vector3Ref& v) {
+      Real vx = v.x(), vy = v.y(), vz = v.z();
+      x() = vx; y() = vy; z() = vz;
+      return *this;
+    }
+
+    inline Vector3Ref& operator=(const Vector<Real, 3>& v) {
+      x() = v[0]; y() = v[1]; z() = v[2];
+      return *this;
+    }
+
+    inline Vector3Ref& operator+=(const Vector<Real, 3>& v) {
+      x() += v[0]; y() += v[1]; z() += v[2];
+      return *this;
+    }
+
+    inline Vector3Ref& operator-=(const Vector<Real, 3>& v) {
+      x() -= v[0]; y() -= v[1]; z() -= v[2];
+      return *this;
+    }
+
+    inline Vector3Ref& operator*=(Real s) {
+      x() *= s; y() *= s; z() *= s;
+      return *this;
+    }
+
+    inline Vector3Ref& operator/=(Real s) {
+      x() /= s; y() /= s; z() /= s;
+      return *this;
+    }
+
+    inline Real lengthSquare() const { 
+      return x()*x() + y()*y() + z()*z(); 
+    }
+
+    inline Real length() const { return sqrt(lengthSquare()); }
+
+  private:
+    Real* p_;
+    std::size_t stride_;
+  };
+
+  template<typename Real>
+  inline Vector3<Real> operator+(const Vector3Ref<Real>& v1, 
+                                 const Vector3Ref<Real>& v2) {
+    return Vector3<Real>(v1.x() + v2.x(), v1.y() + v2.y(), v1.z() + v2.z());
+  }
+
+  template<typename Real>
+  inline Vector3<Real> operator+(const Vector3Ref<Real>& v1, 
+                                 const Vector<Real, 3>& v2) {
+    return Vector3<Real>(v1.x() + v2[0], v1.y() + v2[1], v1.z() + v2[2]);
+  }
+
+  template<typename Real>
+  inline Vector3<Real> operator+(const Vector<Real, 3>& v1,
+                                 const Vector3Ref<Real>& v2) {
+    return Vector3<Real>(v1[0] + v2.x(), v1[1] + v2.y(), v1[2] + v2.z());
+  }
+
+  template<typename Real>
+  inline Vector3<Real> operator-(const Vector3Ref<Real>& v1, 
+                                 const Vector3Ref<Real>& v2) {
+    return Vector3<Real>(v1.x() - v2.x(), v1.y() - v2.y(), v1.z() - v2.z());
+  }
+
+  template<typename Real>
+  inline Vector3<Real> operator-(const Vector3Ref<Real>& v1, 
+                                 const Vector<Real, 3>& v2) {
+    return Vector3<Real>(v1.x() - v2[0], v1.y() - v2[1], v1.z() - v2[2]);
+  }
+
+  template<typename Real>
+  inline Vector3<Real> operator-(const Vector<Real, 3>& v1,
+                                 const Vector3Ref<Real>& v2) {
+    return Vector3<Real>(v1[0] - v2.x(), v1[1] - v2.y(), v1[2] - v2.z());
+  }
+
+  template<typename Real>
+  inline Vector3<Real> operator*(const Vector3Ref<Real>& v, Real s) {
+    return Vector3<Real>(v.x() * s, v.y() * s, v.z() * s);
+  }
+
+  template<typename Real>
+  inline Vector3<Real> operator*(Real s, const Vector3Ref<Real>& v) {
+    return Vector3<Real>(v.x() * s, v.y() * s, v.z() * s);
+  }
+
+  template<typename Real>
+  inline Vector3<Real> operator/(const Vector3Ref<Real>& v, Real s) {
+    return Vector3<Real>(v.x() / s, v.y() / s, v.z() / s);
+  }
+  
+  /**
+   * @class Vector3Array Vector3Array.hpp "math/Vector3Array.hpp"
+   * @brief A resizable array of three-vectors in aligned storage.
+   *
+   * The array is either stored as an array of structures (x0 y0 z0
+   * x1 y1 z1 ...), which is the memory layout of a vector<Vector3>,
+   * or as a structure of arrays, with separate x, y and z blocks
+   * that can be streamed by SIMD loops.  Each block starts on an
+   * Alignment byte boundary.  Elements are accessed through
+   * Vector3Ref, so code written against operator[] works with either
+   * layout, while component() and stride() give the raw arrays to
+   * loops that want them.
+   */
+  template<typename Real>
+  class Vector3Array {
+  public:
+    enum Layout {
+      ArrayOfStructures,
+      StructureOfArrays
+    };
+
+    enum { Alignment = 64 };
+
+    Vector3Array(Layout layout = ArrayOfStructures) : 
+      raw_(NULL), data_(NULL), size_(0), capacity_(0), layout_(layout) {
+      setStrides();
+    }
+
+    Vector3Array(const Vector3Array& v) :
+      raw_(NULL), data_(NULL), size_(0), capacity_(0), layout_(v.layout_) {
+      setStrides();
+      *this = v;
+    }
+
+    ~Vector3Array() {
+      delete[] raw_;
+    }
+
+    Vector3Array& operator=(const Vector3Array& v) {
+      if (this == &v) return *this;
+      if (layout_ != v.layout_) {
+        clear();
+        layout_ = v.layout_;
+        setStrides();
+      }
+      if (capacity_ < v.size_) reallocate(v.size_);
+      size_ = v.size_;
+      if (layout_ == ArrayOfStructures) {
+        if (size_ > 0) memcpy(data_, v.data_, 3 * size_ * sizeof(Real));
+      } else {
+        for (int d = 0; d < 3; d++) 
+          if (size_ > 0) 
+            memcpy(component(d), v.component(d), size_ * sizeof(Real));
+      }
+      return *this;
+    }
+
+    inline std::size_t size() const { return size_; }
+    inline bool empty() const { return size_ == 0; }
+
+    inline Vector3Ref<Real> operator[](std::size_t i) {
+      return Vector3Ref<Real>(data_ + i * elementStride_, componentStride_);
+    }
+
+    inline Vector3<Real> operator[](std::size_t i) const {
+      const Real* p = data_ + i * elementStride_;
+      return Vector3<Real>(p[0], p[componentStride_], p[2*componentStride_]);
+    }
+
+    /** Returns the start of component d (0, 1 or 2) */
+    inline Real* component(int d) { return data_ + d * componentStride_; }
+    inline const Real* component(int d) const { 
+      return data_ + d * componentStride_; 
+    }
+
+    /** Returns the distance between successive values of a component */
+    inline std::size_t stride() const { return elementStride_; }
+
+    /** Returns the start of the storage */
+    inline Real* data() { return data_; }
+
+    Layout getLayout() const { return layout_; }
+
+    /** Changes the layout, rearranging any stored elements. */
+    void setLayout(Layout layout) {
+      if (layout == layout_) return;
+      Vector3Array tmp(layout);
+      tmp.reserve(size_);
+      tmp.size_ = size_;
+      for (std::size_t i = 0; i < size_; i++) 
+        tmp[i] = (*this)[i];
+      swap(tmp);
+    }
+
+    void reserve(std::size_t n) {
+      if (n > capacity_) reallocate(n);
+    }
+
+    /** Changes the size of the array.  New elements are zero. */
+    void resize(std::size_t n) {
+      if (n > capacity_) reallocate(std::max(n, 2 * capacity_));
+      for (std::size_t i = size_; i < n; i++) 
+        (*this)[i] = Vector3<Real>(0.0, 0.0, 0.0);
+      size_ = n;
+    }
+
+    void clear() { size_ = 0; }
+
+    void push_back(const Vector3<Real>& v) {
+      resize(size_ + 1);
+      (*this)[size_ - 1] = v;
+    }
+
+    /** Sets every element to v */
+    void fill(const Vector3<Real>& v) {
+      for (int d = 0; d < 3; d++) {
+        Real* p = component(d);
+        for (std::size_t i = 0; i < size_; i++)
+          p[i * elementStride_] = v[d];
+      }
+    }
+
+    void swap(Vector3Array& v) {
+      std::swap(raw_, v.raw_);
+      std::swap(data_, v.data_);
+      std::swap(size_, v.size_);
+      std::swap(capacity_, v.capacity_);
+      std::swap(layout_, v.layout_);
+      setStrides();
+      v.setStrides();
+    }
+      
+  private:
+    void setStrides() {
+      if (layout_ == ArrayOfStructures) {
+        elementStride_ = 3;
+        componentStride_ = 1;
+      } else {
+        elementStride_ = 1;
+        componentStride_ = capacity_;
+      }
+    }
+
+    void reallocate(std::size_t n) {
+      // round up so that each block of a structure of arrays stays
+      // aligned:
+      std::size_t perLine = Alignment / sizeof(Real);
+      std::size_t capacity = ((n + perLine - 1) / perLine) * perLine;
+
+      char* raw = new char[3 * capacity * sizeof(Real) + Alignment];
+      std::size_t offset = reinterpret_cast<std::size_t>(raw) % Alignment;
+      Real* data = reinterpret_cast<Real*>(raw + (offset ? Alignment - offset
+                                                   : 0));
+
+      if (layout_ == ArrayOfStructures) {
+        if (size_ > 0) memcpy(data, data_, 3 * size_ * sizeof(Real));
+      } else {
+        for (int d = 0; d < 3; d++) 
+          if (size_ > 0) 
+            memcpy(data + d * capacity, component(d), size_ * sizeof(Real));
+      }
+
+      delete[] raw_;
+      raw_ = raw;
+      data_ = data;
+      capacity_ = capacity;
+      setStrides();
+    }
+
+    char* raw_;
+    Real* data_;
+    std::size_t size_;
+    std::size_t capacity_;
+    Layout layout_;
+    std::size_t elementStride_;
+    std::size_t componentStride_;
+  };
+
+  typedef Vector3Array<RealType> Vector3dArray;
+}
+
+#endif
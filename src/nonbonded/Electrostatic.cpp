@@ -70,11 +70,16 @@ namespace OpenMD {
                                   haveDampingAlpha_(false), 
                                   haveDielectric_(false),
                                   haveElectroSplines_(false),
-                                  info_(NULL), forceField_(NULL)
+                                  info_(NULL), forceField_(NULL),
+                                  spme_(NULL)
                                   
   {
     flucQ_ = new FluctuatingChargeForces(info_);
   }
+
+  Electrostatic::~Electrostatic() {
+    if (spme_ != NULL) delete spme_;
+  }
   
   void Electrostatic::setForceField(ForceField *ff) {
     forceField_ = ff;
@@ -151,7 +156,8 @@ namespace OpenMD {
                  "\t(Input file specified %s .)\n"
                  "\telectrostaticSummationMethod must be one of: \"hard\",\n"
                  "\t\"shifted_potential\", \"shifted_force\",\n"
-                 "\t\"taylor_shifted\", or \"reaction_field\".\n", 
+                 "\t\"taylor_shifted\", \"reaction_field\", \"ewald_full\",\n"
+                 "\tor \"ewald_spme\".\n", 
                  myMethod.c_str() );
         painCave.isFatal = 1;
         simError();
@@ -169,6 +175,34 @@ namespace OpenMD {
       }
     }
     
+    if (summationMethod_ == esm_EWALD_PME) {
+      sprintf( painCave.errMsg,
+               "Electrostatic::initialize: The ewald_pme method will be\n"
+               "\thandled with smooth particle mesh Ewald (ewald_spme).\n");
+      painCave.severity = OPENMD_INFO;
+      painCave.isFatal = 0;
+      simError();
+      summationMethod_ = esm_EWALD_SPME;
+    }
+
+    if (summationMethod_ == esm_EWALD_SPME) {
+#ifndef HAVE_FFTW3_H
+      sprintf( painCave.errMsg,
+               "Electrostatic::initialize: ewald_spme requires OpenMD to be\n"
+               "\tbuilt with the FFTW3 library.\n");
+      painCave.severity = OPENMD_ERROR;
+      painCave.isFatal = 1;
+      simError();
+#endif
+    }
+
+    if (summationMethod_ == esm_EWALD_FULL || 
+        summationMethod_ == esm_EWALD_SPME) {
+      ewaldTolerance_ = 1.0e-6;
+      if (simParams_->haveEwaldTolerance()) 
+        ewaldTolerance_ = simParams_->getEwaldTolerance();
+    }
+
     if (summationMethod_ == esm_REACTION_FIELD) {        
       if (!simParams_->haveDielectric()) {
         // throw warning
@@ -202,6 +236,11 @@ namespace OpenMD {
       }
     }
 
+    // the real space part of an Ewald sum is always damped:
+    if (summationMethod_ == esm_EWALD_FULL || 
+        summationMethod_ == esm_EWALD_SPME) 
+      screeningMethod_ = DAMPED;
+
     // check to make sure a cutoff value has been set:
     if (!haveCutoffRadius_) {
       sprintf( painCave.errMsg, "Electrostatic::initialize has no Default "
@@ -211,7 +250,32 @@ namespace OpenMD {
       simError();
     }
            
-    if (screeningMethod_ == DAMPED || summationMethod_ == esm_EWALD_FULL) {
+    if ((summationMethod_ == esm_EWALD_FULL || 
+         summationMethod_ == esm_EWALD_SPME) && 
+        !simParams_->haveDampingAlpha()) {
+      // choose alpha so that the real space sum has converged to the
+      // requested tolerance at the cutoff, erfc(alpha rc) = tolerance:
+      RealType lo = 0.0;
+      RealType hi = 10.0 / cutoffRadius_;
+      for (int iter = 0; iter < 100; iter++) {
+        RealType mid = 0.5 * (lo + hi);
+        if (erfc(mid * cutoffRadius_) > ewaldTolerance_) 
+          lo = mid;
+        else
+          hi = mid;
+      }
+      dampingAlpha_ = 0.5 * (lo + hi);
+      sprintf( painCave.errMsg,
+               "Electrostatic::initialize: dampingAlpha was not specified in the\n"
+               "\tinput file.  A value of %f (1/ang) will be used to reach an\n"
+               "\tewaldTolerance of %g at the cutoff of %f (ang).\n", 
+               dampingAlpha_, ewaldTolerance_, cutoffRadius_);
+      painCave.severity = OPENMD_INFO;
+      painCave.isFatal = 0;
+      simError();
+      haveDampingAlpha_ = true;
+    } else if (screeningMethod_ == DAMPED || 
+               summationMethod_ == esm_EWALD_FULL) {
       if (!simParams_->haveDampingAlpha()) {
         // first set a cutoff dependent alpha value
         // we assume alpha depends linearly with rcut from 0 to 20.5 ang
@@ -306,7 +370,8 @@ namespace OpenMD {
     db0c_4 =          3.0*b2c  - 6.0*r2*b3c     + r2*r2*b4c;
     db0c_5 =                    -15.0*r*b3c + 10.0*r2*r*b4c - r2*r2*r*b5c;   
 
-    if (summationMethod_ != esm_EWALD_FULL) {
+    if (summationMethod_ != esm_EWALD_FULL && 
+        summationMethod_ != esm_EWALD_SPME) {
       selfMult1_ -= b0c;
       selfMult2_ += (db0c_2 + 2.0*db0c_1*ric) /  3.0;
       selfMult4_ -= (db0c_4 + 4.0*db0c_3*ric) / 15.0;
@@ -511,6 +576,7 @@ namespace OpenMD {
       case esm_SWITCHING_FUNCTION:
       case esm_HARD:
       case esm_EWALD_FULL:
+      case esm_EWALD_SPME:
 
         v01 = f;
         v11 = g;
@@ -570,7 +636,6 @@ namespace OpenMD {
         break;
                 
       case esm_EWALD_PME:
-      case esm_EWALD_SPME:
       default :
         map<string, ElectrostaticSummationMethod>::iterator i;
         std::string meth;
@@ -1212,6 +1277,7 @@ namespace OpenMD {
     case esm_SHIFTED_POTENTIAL:
     case esm_TAYLOR_SHIFTED:
     case esm_EWALD_FULL:
+    case esm_EWALD_SPME:
       if (i_is_Charge) {
         self += selfMult1_ * pre11_ * C_a * (C_a + *(sdat.skippedCharge));        
         if (i_is_Fluctuating) {
@@ -1347,11 +1413,27 @@ namespace OpenMD {
   }
 
 
+  /**
+   * Direct Ewald sum over reciprocal lattice vectors.  The k-vectors
+   * are all those with exp(-k^2 / 4 alpha^2) above ewaldTolerance_,
+   * and only half of reciprocal space is visited, since S(-k) =
+   * S(k)*.  The phase factors exp(i k.r) are built from per-site
+   * tables of exp(2 pi i l s_a) (s is the fractional coordinate
+   * along box vector a), and all per-site data is held in contiguous
+   * arrays so the inner loops vectorize.
+   *
+   * The structure factors for every k-vector are computed in a
+   * first pass (and summed across processors in a single reduction),
+   * the forces, torques and site potentials in a second pass, and
+   * they are only added to the atoms at the end.
+   */
   void Electrostatic::ReciprocalSpaceSum(RealType& pot) {
-    
-    RealType kPot = 0.0;
-    RealType kVir = 0.0;
-    
+
+    if (summationMethod_ == esm_EWALD_SPME) {
+      SPMESum(pot);
+      return;
+    }
+
     const RealType mPoleConverter = 0.20819434; // converts from the
                                                 // internal units of
                                                 // Debye (for dipoles)
@@ -1368,313 +1450,364 @@ namespace OpenMD {
                                              // are measured in
                                              // angstroms.
 
-    Mat3x3d hmat = info_->getSnapshotManager()->getCurrentSnapshot()->getHmat();
-    Vector3d box = hmat.diagonals();
-    RealType boxMax = box.max();
-    
-    //int kMax = int(2.0 * M_PI / (pow(dampingAlpha_,2)*cutoffRadius_ * boxMax) );
-    int kMax = 7;
-    int kSqMax = kMax*kMax + 2;
-    
-    int kLimit = kMax+1;
-    int kLim2 = 2*kMax+1;
-    int kSqLim = kSqMax;
-    
-    vector<RealType> AK(kSqLim+1, 0.0);
-    RealType xcl = 2.0 * M_PI / box.x();
-    RealType ycl = 2.0 * M_PI / box.y();
-    RealType zcl = 2.0 * M_PI / box.z();
-    RealType rcl = 2.0 * M_PI / boxMax;
-    RealType rvol = 2.0 * M_PI /(box.x() * box.y() * box.z());
-    
-    if(dampingAlpha_ < 1.0e-12) return;
-    
-    RealType ralph = -0.25/pow(dampingAlpha_,2);
-    
-    // Calculate and store exponential factors  
-    
-    vector<vector<RealType> > elc;
-    vector<vector<RealType> > emc;
-    vector<vector<RealType> > enc;
-    vector<vector<RealType> > els;
-    vector<vector<RealType> > ems;
-    vector<vector<RealType> > ens;
-    
-    int nMax = info_->getNAtoms();
-    
-    elc.resize(kLimit+1);
-    emc.resize(kLimit+1);
-    enc.resize(kLimit+1);
-    els.resize(kLimit+1);
-    ems.resize(kLimit+1);
-    ens.resize(kLimit+1);
-
-    for (int j = 0; j < kLimit+1; j++) {
-      elc[j].resize(nMax);
-      emc[j].resize(nMax);
-      enc[j].resize(nMax);
-      els[j].resize(nMax);
-      ems[j].resize(nMax);
-      ens[j].resize(nMax);
-    }
-    
-    Vector3d t( 2.0 * M_PI );
-    t.Vdiv(t, box);
+    if (!initialized_) initialize();
+    if (dampingAlpha_ < 1.0e-12) return;
+
+    Snapshot* snap = info_->getSnapshotManager()->getCurrentSnapshot();
+    Mat3x3d hmat = snap->getHmat();
+    Mat3x3d hinv = hmat.inverse();
+    RealType volume = fabs(hmat.determinant());
+
+    // gather the electrostatic sites:
+    vector<Atom*> sites;
+    vector<RealType> q, dx, dy, dz, qxx, qyy, qzz, qxy, qxz, qyz;
+    vector<Vector3d> frac;
+    bool haveDipoles = false;
+    bool haveQuadrupoles = false;
 
     SimInfo::MoleculeIterator mi;
     Molecule::AtomIterator ai;
-    int i;
-    Vector3d r;
-    Vector3d tt;
-    
+    ElectrostaticAtomData data;
+
     for (Molecule* mol = info_->beginMolecule(mi); mol != NULL; 
          mol = info_->nextMolecule(mi)) {
       for(Atom* atom = mol->beginAtom(ai); atom != NULL; 
-          atom = mol->nextAtom(ai)) {  
-        
-        i = atom->getLocalIndex();
-        r = atom->getPos();
-        info_->getSnapshotManager()->getCurrentSnapshot()->wrapVector(r);
-        
-        tt.Vmul(t, r);
-
-        elc[1][i] = 1.0;
-        emc[1][i] = 1.0;
-        enc[1][i] = 1.0;
-        els[1][i] = 0.0;
-        ems[1][i] = 0.0;
-        ens[1][i] = 0.0;
-
-        elc[2][i] = cos(tt.x());
-        emc[2][i] = cos(tt.y());
-        enc[2][i] = cos(tt.z());
-        els[2][i] = sin(tt.x());
-        ems[2][i] = sin(tt.y());
-        ens[2][i] = sin(tt.z());
-        
-        for(int l = 3; l <= kLimit; l++) {
-          elc[l][i]=elc[l-1][i]*elc[2][i]-els[l-1][i]*els[2][i];
-          emc[l][i]=emc[l-1][i]*emc[2][i]-ems[l-1][i]*ems[2][i];
-          enc[l][i]=enc[l-1][i]*enc[2][i]-ens[l-1][i]*ens[2][i];
-          els[l][i]=els[l-1][i]*elc[2][i]+elc[l-1][i]*els[2][i];
-          ems[l][i]=ems[l-1][i]*emc[2][i]+emc[l-1][i]*ems[2][i];
-          ens[l][i]=ens[l-1][i]*enc[2][i]+enc[l-1][i]*ens[2][i];
+          atom = mol->nextAtom(ai)) {
+        int atid = atom->getAtomType()->getIdent();
+        if (Etids[atid] == -1) continue;
+        data = ElectrostaticMap[Etids[atid]];
+
+        sites.push_back(atom);
+        frac.push_back(hinv * atom->getPos());
+
+        RealType C = 0.0;
+        if (data.is_Charge) {
+          C = data.fixedCharge;
+          if (data.is_Fluctuating) C += atom->getFlucQPos();
         }
+        q.push_back(C);
+
+        Vector3d D(0.0);
+        if (data.is_Dipole) D = atom->getDipole() * mPoleConverter;
+        dx.push_back(D.x());
+        dy.push_back(D.y());
+        dz.push_back(D.z());
+        
+        Mat3x3d Q(0.0);
+        if (data.is_Quadrupole) Q = atom->getQuadrupole() * mPoleConverter;
+        qxx.push_back(Q(0,0));
+        qyy.push_back(Q(1,1));
+        qzz.push_back(Q(2,2));
+        qxy.push_back(Q(0,1));
+        qxz.push_back(Q(0,2));
+        qyz.push_back(Q(1,2));
+
+        haveDipoles |= data.is_Dipole;
+        haveQuadrupoles |= data.is_Quadrupole;
       }
     }
-    
-    // Calculate and store AK coefficients:
-    
-    RealType eksq = 1.0;
-    RealType expf = 0.0;
-    if (ralph < 0.0) expf = exp(ralph*rcl*rcl);
-    for (i = 1; i <= kSqLim; i++) {
-      RealType rksq = float(i)*rcl*rcl;
-      eksq = expf*eksq;
-      AK[i] = eConverter * eksq/rksq;
+
+#ifdef IS_MPI
+    int flags[2] = {haveDipoles, haveQuadrupoles};
+    MPI_Allreduce(MPI_IN_PLACE, flags, 2, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+    haveDipoles = flags[0];
+    haveQuadrupoles = flags[1];
+#endif
+
+    int n = sites.size();
+
+    // The reciprocal lattice vectors are k = 2 pi hinv^T m.  All
+    // vectors with exp(-k^2 / 4 alpha^2) > tolerance are kept, and
+    // along box vector a this needs |m_a| <= kCut |a| / 2 pi:
+    RealType kCutSq = -4.0 * dampingAlpha_ * dampingAlpha_ * 
+      log(ewaldTolerance_);
+    RealType kCut = sqrt(kCutSq);
+    int kMax[3];
+    for (int a = 0; a < 3; a++) {
+      RealType boxLength = hmat.getColumn(a).length();
+      kMax[a] = int(kCut * boxLength / (2.0 * M_PI));
     }
     
-    /*
-     * Loop over all k vectors k = 2 pi (ll/Lx, mm/Ly, nn/Lz)
-     * the values of ll, mm and nn are selected so that the symmetry of
-     * reciprocal lattice is taken into account i.e. the following
-     * rules apply.
-     *
-     * ll ranges over the values 0 to kMax only.
-     *
-     * mm ranges over 0 to kMax when ll=0 and over
-     *            -kMax to kMax otherwise.
-     * nn ranges over 1 to kMax when ll=mm=0 and over
-     *            -kMax to kMax otherwise.
-     *
-     * Hence the result of the summation must be doubled at the end.     
-     */
-    
-    std::vector<RealType> clm(nMax, 0.0);
-    std::vector<RealType> slm(nMax, 0.0);
-    std::vector<RealType> ckr(nMax, 0.0);
-    std::vector<RealType> skr(nMax, 0.0);
-    std::vector<RealType> ckc(nMax, 0.0);
-    std::vector<RealType> cks(nMax, 0.0);
-    std::vector<RealType> dkc(nMax, 0.0);
-    std::vector<RealType> dks(nMax, 0.0);
-    std::vector<RealType> qkc(nMax, 0.0);
-    std::vector<RealType> qks(nMax, 0.0);
-    std::vector<Vector3d> dxk(nMax, V3Zero);
-    std::vector<Vector3d> qxk(nMax, V3Zero);
-    RealType rl, rm, rn;
-    Vector3d kVec;
-    Vector3d Qk;
-    Mat3x3d k2;
-    RealType ckcs, ckss, dkcs, dkss, qkcs, qkss;
-    int atid;
-    ElectrostaticAtomData data;
-    RealType C, dk, qk;
-    Vector3d D;
-    Mat3x3d  Q;
-
-    int mMin = kLimit;
-    int nMin = kLimit + 1;
-    for (int l = 1; l <= kLimit; l++) {
-      int ll = l - 1; 
-      rl = xcl * float(ll);
-      for (int mmm = mMin; mmm <= kLim2; mmm++) {
-        int mm = mmm - kLimit;
-        int m = abs(mm) + 1;
-        rm = ycl * float(mm);
-        // Set temporary products of exponential terms
-        for (Molecule* mol = info_->beginMolecule(mi); mol != NULL; 
-             mol = info_->nextMolecule(mi)) {
-          for(Atom* atom = mol->beginAtom(ai); atom != NULL; 
-              atom = mol->nextAtom(ai)) {
-            
-            i = atom->getLocalIndex();
-            if(mm < 0) {
-              clm[i]=elc[l][i]*emc[m][i]+els[l][i]*ems[m][i];
-              slm[i]=els[l][i]*emc[m][i]-ems[m][i]*elc[l][i];
-            } else {
-              clm[i]=elc[l][i]*emc[m][i]-els[l][i]*ems[m][i];
-              slm[i]=els[l][i]*emc[m][i]+ems[m][i]*elc[l][i];
-            }
-          }
+    // phase tables, eRe[a][l*n + i] + i eIm[a][l*n + i] = 
+    //     exp(2 pi i l s_a(i)):
+    vector<RealType> eRe[3], eIm[3];
+    for (int a = 0; a < 3; a++) {
+      eRe[a].resize((kMax[a] + 1) * n);
+      eIm[a].resize((kMax[a] + 1) * n);
+      RealType* re = &eRe[a][0];
+      RealType* im = &eIm[a][0];
+      for (int i = 0; i < n; i++) {
+        re[i] = 1.0;
+        im[i] = 0.0;
+        if (kMax[a] > 0) {
+          RealType arg = 2.0 * M_PI * frac[i][a];
+          re[n + i] = cos(arg);
+          im[n + i] = sin(arg);
         }
-        for (int nnn = nMin; nnn <= kLim2; nnn++) {
-          int nn = nnn - kLimit;          
-          int n = abs(nn) + 1;
-          rn = zcl * float(nn);
-          // Test on magnitude of k vector:
-          int kk=ll*ll + mm*mm + nn*nn;
-          if(kk <= kSqLim) {
-            kVec = Vector3d(rl, rm, rn);
-            k2 = outProduct(kVec, kVec);
-            // Calculate exp(ikr) terms
-            for (Molecule* mol = info_->beginMolecule(mi); mol != NULL; 
-                 mol = info_->nextMolecule(mi)) {
-              for(Atom* atom = mol->beginAtom(ai); atom != NULL; 
-                  atom = mol->nextAtom(ai)) { 
-                i = atom->getLocalIndex();
-                
-                if (nn < 0) {
-                  ckr[i]=clm[i]*enc[n][i]+slm[i]*ens[n][i];
-                  skr[i]=slm[i]*enc[n][i]-clm[i]*ens[n][i];
-
-                } else {
-                  ckr[i]=clm[i]*enc[n][i]-slm[i]*ens[n][i];
-                  skr[i]=slm[i]*enc[n][i]+clm[i]*ens[n][i];
-                }
-              }
+      }
+      for (int l = 2; l <= kMax[a]; l++) {
+        RealType* re0 = re + (l - 1) * n;
+        RealType* im0 = im + (l - 1) * n;
+        RealType* re1 = re + l * n;
+        RealType* im1 = im + l * n;
+        for (int i = 0; i < n; i++) {
+          re1[i] = re0[i] * re[n + i] - im0[i] * im[n + i];
+          im1[i] = im0[i] * re[n + i] + re0[i] * im[n + i];
+        }
+      }
+    }
+
+    // the list of k-vectors in the half space:
+    vector<Vector3d> kVecs;
+    vector<RealType> AK;
+    vector<int> kIdx;
+    RealType ralph = -0.25 / (dampingAlpha_ * dampingAlpha_);
+
+    for (int l = 0; l <= kMax[0]; l++) {
+      int mStart = (l == 0) ? 0 : -kMax[1];
+      for (int m = mStart; m <= kMax[1]; m++) {
+        int nStart = (l == 0 && m == 0) ? 1 : -kMax[2];
+        for (int nn = nStart; nn <= kMax[2]; nn++) {
+          Vector3d kVec;
+          for (int a = 0; a < 3; a++) 
+            kVec[a] = 2.0 * M_PI * (l * hinv(0, a) + m * hinv(1, a) + 
+                                    nn * hinv(2, a));
+          RealType ksq = kVec.lengthSquare();
+          if (ksq > kCutSq) continue;
+          kVecs.push_back(kVec);
+          // the factor of 2 accounts for the k-vectors in the other
+          // half space:
+          AK.push_back(2.0 * 2.0 * M_PI * eConverter * exp(ralph * ksq) / 
+                       (volume * ksq));
+          kIdx.push_back(l);
+          kIdx.push_back(m);
+          kIdx.push_back(nn);
+        }
+      }
+    }
+    int nK = kVecs.size();
+
+    vector<RealType> SRe(nK, 0.0);
+    vector<RealType> SIm(nK, 0.0);
+    vector<RealType> ckr(n), skr(n), ak(n), bk(n);
+    vector<RealType> fx(n, 0.0), fy(n, 0.0), fz(n, 0.0), phi(n, 0.0);
+    vector<RealType> tx(n, 0.0), ty(n, 0.0), tz(n, 0.0);
+
+    for (int pass = 0; pass < 2; pass++) {
+      for (int k = 0; k < nK; k++) {
+        int l = kIdx[3*k];
+        int m = kIdx[3*k + 1];
+        int nn = kIdx[3*k + 2];
+        RealType sm = (m < 0) ? -1.0 : 1.0;
+        RealType sn = (nn < 0) ? -1.0 : 1.0;
+        const RealType* xr = &eRe[0][l * n];
+        const RealType* xi = &eIm[0][l * n];
+        const RealType* yr = &eRe[1][abs(m) * n];
+        const RealType* yi = &eIm[1][abs(m) * n];
+        const RealType* zr = &eRe[2][abs(nn) * n];
+        const RealType* zi = &eIm[2][abs(nn) * n];
+        RealType kx = kVecs[k].x();
+        RealType ky = kVecs[k].y();
+        RealType kz = kVecs[k].z();
+        
+        // exp(i k.r), and the real (charge - k.Q.k) and imaginary
+        // (D.k) parts of each site's multipole factor:
+        for (int i = 0; i < n; i++) {
+          RealType cxy = xr[i] * yr[i] - sm * xi[i] * yi[i];
+          RealType sxy = xi[i] * yr[i] + sm * xr[i] * yi[i];
+          ckr[i] = cxy * zr[i] - sn * sxy * zi[i];
+          skr[i] = sxy * zr[i] + sn * cxy * zi[i];
+          ak[i] = q[i];
+          bk[i] = 0.0;
+        }
+        if (haveDipoles) {
+          for (int i = 0; i < n; i++) 
+            bk[i] = dx[i] * kx + dy[i] * ky + dz[i] * kz;
+        }
+        if (haveQuadrupoles) {
+          for (int i = 0; i < n; i++) 
+            ak[i] -= qxx[i] * kx * kx + qyy[i] * ky * ky + qzz[i] * kz * kz 
+              + 2.0 * (qxy[i] * kx * ky + qxz[i] * kx * kz + 
+                       qyz[i] * ky * kz);
+        }
+
+        if (pass == 0) {
+          RealType sr = 0.0;
+          RealType si = 0.0;
+#ifdef _OPENMP
+#pragma omp simd reduction(+:sr, si)
+#endif
+          for (int i = 0; i < n; i++) {
+            sr += ak[i] * ckr[i] - bk[i] * skr[i];
+            si += ak[i] * skr[i] + bk[i] * ckr[i];
+          }
+          SRe[k] = sr;
+          SIm[k] = si;
+        } else {
+          // E_k = AK |S|^2, so for site i with z_i = (a_i + i b_i)
+          // exp(i k.r_i):
+          //    F_i   = 2 AK k Im(S* z_i)
+          //    phi_i = 2 AK Re(S* exp(i k.r_i))
+          RealType pre = 2.0 * AK[k];
+          RealType sr = SRe[k];
+          RealType si = SIm[k];
+          for (int i = 0; i < n; i++) {
+            RealType zr = ak[i] * ckr[i] - bk[i] * skr[i];
+            RealType zi = ak[i] * skr[i] + bk[i] * ckr[i];
+            RealType f = pre * (sr * zi - si * zr);
+            fx[i] += f * kx;
+            fy[i] += f * ky;
+            fz[i] += f * kz;
+            phi[i] += pre * (sr * ckr[i] + si * skr[i]);
+          }
+          if (haveDipoles) {
+            // torque = D x E with E = 2 AK k Im(S* exp(i k.r)):
+            for (int i = 0; i < n; i++) {
+              RealType e = pre * (sr * skr[i] - si * ckr[i]);
+              tx[i] += e * (dy[i] * kz - dz[i] * ky);
+              ty[i] += e * (dz[i] * kx - dx[i] * kz);
+              tz[i] += e * (dx[i] * ky - dy[i] * kx);
             }
-            
-            // Calculate scalar and vector products for each site:
-            
-            for (Molecule* mol = info_->beginMolecule(mi); mol != NULL; 
-                 mol = info_->nextMolecule(mi)) {
-              for(Atom* atom = mol->beginAtom(ai); atom != NULL; 
-                  atom = mol->nextAtom(ai)) {
-                i = atom->getLocalIndex();
-                int atid = atom->getAtomType()->getIdent();
-                data = ElectrostaticMap[Etids[atid]];
-                               
-                if (data.is_Charge) {
-                  C = data.fixedCharge;
-                  if (data.is_Fluctuating) C += atom->getFlucQPos();
-                  ckc[i] = C * ckr[i];
-                  cks[i] = C * skr[i];
-                }
-                
-                if (data.is_Dipole) {
-                  D = atom->getDipole() * mPoleConverter;
-                  dk = dot(D, kVec);
-                  dxk[i] = cross(D, kVec);
-                  dkc[i] = dk * ckr[i];
-                  dks[i] = dk * skr[i];
-                }
-                if (data.is_Quadrupole) {
-                  Q = atom->getQuadrupole() * mPoleConverter; 
-                  Qk = Q * kVec;                  
-                  qk = dot(kVec, Qk);
-                  qxk[i] = -cross(kVec, Qk);
-                  qkc[i] = qk * ckr[i];
-                  qks[i] = qk * skr[i];
-                }              
-              }
+          }
+          if (haveQuadrupoles) {
+            // torque = 2 phi_k (Q.k) x k:
+            for (int i = 0; i < n; i++) {
+              RealType e = 2.0 * pre * (sr * ckr[i] + si * skr[i]);
+              RealType qkx = qxx[i] * kx + qxy[i] * ky + qxz[i] * kz;
+              RealType qky = qxy[i] * kx + qyy[i] * ky + qyz[i] * kz;
+              RealType qkz = qxz[i] * kx + qyz[i] * ky + qzz[i] * kz;
+              tx[i] += e * (qky * kz - qkz * ky);
+              ty[i] += e * (qkz * kx - qkx * kz);
+              tz[i] += e * (qkx * ky - qky * kx);
             }
+          }
+        }
+      }
 
-            // calculate vector sums
-            
-            ckcs = std::accumulate(ckc.begin(),ckc.end(),0.0);
-            ckss = std::accumulate(cks.begin(),cks.end(),0.0);
-            dkcs = std::accumulate(dkc.begin(),dkc.end(),0.0);
-            dkss = std::accumulate(dks.begin(),dks.end(),0.0);
-            qkcs = std::accumulate(qkc.begin(),qkc.end(),0.0);
-            qkss = std::accumulate(qks.begin(),qks.end(),0.0);
-            
+      if (pass == 0) {
 #ifdef IS_MPI
-            MPI_Allreduce(MPI_IN_PLACE, &ckcs, 1, MPI_REALTYPE, 
-                          MPI_SUM, MPI_COMM_WORLD);
-            MPI_Allreduce(MPI_IN_PLACE, &ckss, 1, MPI_REALTYPE, 
-                          MPI_SUM, MPI_COMM_WORLD);
-            MPI_Allreduce(MPI_IN_PLACE, &dkcs, 1, MPI_REALTYPE, 
-                          MPI_SUM, MPI_COMM_WORLD);
-            MPI_Allreduce(MPI_IN_PLACE, &dkss, 1, MPI_REALTYPE, 
-                          MPI_SUM, MPI_COMM_WORLD);
-            MPI_Allreduce(MPI_IN_PLACE, &qkcs, 1, MPI_REALTYPE, 
-                          MPI_SUM, MPI_COMM_WORLD);
-            MPI_Allreduce(MPI_IN_PLACE, &qkss, 1, MPI_REALTYPE, 
-                          MPI_SUM, MPI_COMM_WORLD);
-#endif        
-            
-            // Accumulate potential energy and virial contribution:
+        MPI_Allreduce(MPI_IN_PLACE, &SRe[0], nK, MPI_REALTYPE, 
+                      MPI_SUM, MPI_COMM_WORLD);
+        MPI_Allreduce(MPI_IN_PLACE, &SIm[0], nK, MPI_REALTYPE, 
+                      MPI_SUM, MPI_COMM_WORLD);
+#endif
+      }
+    }
 
-            kPot += 2.0 * rvol * AK[kk]*((ckss+dkcs-qkss)*(ckss+dkcs-qkss)
-                                         + (ckcs-dkss-qkcs)*(ckcs-dkss-qkcs));
+    RealType kPot = 0.0;
+    for (int k = 0; k < nK; k++) 
+      kPot += AK[k] * (SRe[k] * SRe[k] + SIm[k] * SIm[k]);
+
+    for (int i = 0; i < n; i++) {
+      Atom* atom = sites[i];
+      int atid = atom->getAtomType()->getIdent();
+      data = ElectrostaticMap[Etids[atid]];
+      atom->addFrc(Vector3d(fx[i], fy[i], fz[i]));
+      if (data.is_Dipole || data.is_Quadrupole) 
+        atom->addTrq(Vector3d(tx[i], ty[i], tz[i]));
+      if (data.is_Fluctuating) atom->addFlucQFrc(-phi[i]);
+    }
 
-            kVir += 2.0 * rvol  * AK[kk]*(ckcs*ckcs+ckss*ckss
-                                          +4.0*(ckss*dkcs-ckcs*dkss)
-                                          +3.0*(dkcs*dkcs+dkss*dkss)
-                                          -6.0*(ckss*qkss+ckcs*qkcs)
-                                          +8.0*(dkss*qkcs-dkcs*qkss)
-                                          +5.0*(qkss*qkss+qkcs*qkcs));
-            
-            // Calculate force and torque for each site:
-            
-            for (Molecule* mol = info_->beginMolecule(mi); mol != NULL; 
-                 mol = info_->nextMolecule(mi)) {
-              for(Atom* atom = mol->beginAtom(ai); atom != NULL; 
-                  atom = mol->nextAtom(ai)) {
-                
-                i = atom->getLocalIndex();
-                atid = atom->getAtomType()->getIdent();
-                data = ElectrostaticMap[Etids[atid]];
-
-                RealType qfrc = AK[kk]*((cks[i]+dkc[i]-qks[i])*(ckcs-dkss-qkcs)
-                                     - (ckc[i]-dks[i]-qkc[i])*(ckss+dkcs-qkss));
-                RealType qtrq1 = AK[kk]*(skr[i]*(ckcs-dkss-qkcs)
-                                         -ckr[i]*(ckss+dkcs-qkss));
-                RealType qtrq2 = 2.0*AK[kk]*(ckr[i]*(ckcs-dkss-qkcs)
-                                            +skr[i]*(ckss+dkcs-qkss));
-               
-                atom->addFrc( 4.0 * rvol * qfrc * kVec );
-
-                if (data.is_Fluctuating) { 
-                  atom->addFlucQFrc( - 2.0 * rvol * qtrq2 );
-                }
-                  
-                if (data.is_Dipole) {
-                  atom->addTrq( 4.0 * rvol * qtrq1 * dxk[i] );
-                }
-                if (data.is_Quadrupole) {
-                  atom->addTrq( 4.0 * rvol * qtrq2 * qxk[i] );
-                }
-              }
-            }
-          }
+    pot += kPot;  
+  }
+
+  /**
+   * Reciprocal space sum using smooth particle mesh Ewald.  Each
+   * processor hands its local electrostatic sites to the SPME object,
+   * which returns the total reciprocal space energy and the forces,
+   * torques and site potentials on the local sites.
+   */
+  void Electrostatic::SPMESum(RealType& pot) {
+
+    const RealType mPoleConverter = 0.20819434; // converts from the
+                                                // internal units of
+                                                // Debye (for dipoles)
+                                                // or Debye-angstroms
+                                                // (for quadrupoles) to
+                                                // electron angstroms or
+                                                // electron-angstroms^2
+
+    if (!initialized_) initialize();
+
+    if (spme_ == NULL) {
+      spme_ = new SPME();
+      spme_->setParameters(dampingAlpha_, ewaldTolerance_);
+    }
+
+    Snapshot* snap = info_->getSnapshotManager()->getCurrentSnapshot();
+    Mat3x3d hmat = snap->getHmat();
+
+    vector<Atom*> sites;
+    vector<Vector3d> pos;
+    vector<RealType> charge;
+    vector<Vector3d> dipole;
+    vector<Mat3x3d> quadrupole;
+    bool haveDipoles = false;
+    bool haveQuadrupoles = false;
+
+    SimInfo::MoleculeIterator mi;
+    Molecule::AtomIterator ai;
+    ElectrostaticAtomData data;
+    Vector3d r;
+
+    for (Molecule* mol = info_->beginMolecule(mi); mol != NULL; 
+         mol = info_->nextMolecule(mi)) {
+      for(Atom* atom = mol->beginAtom(ai); atom != NULL; 
+          atom = mol->nextAtom(ai)) {
+        int atid = atom->getAtomType()->getIdent();
+        if (Etids[atid] == -1) continue;
+        data = ElectrostaticMap[Etids[atid]];
+
+        r = atom->getPos();
+        snap->wrapVector(r);
+        sites.push_back(atom);
+        pos.push_back(r);
+
+        RealType C = 0.0;
+        if (data.is_Charge) {
+          C = data.fixedCharge;
+          if (data.is_Fluctuating) C += atom->getFlucQPos();
         }
-        nMin = 1;
+        charge.push_back(C);
+
+        Vector3d D(0.0);
+        Mat3x3d Q(0.0);
+        if (data.is_Dipole) D = atom->getDipole() * mPoleConverter;
+        if (data.is_Quadrupole) Q = atom->getQuadrupole() * mPoleConverter;
+        dipole.push_back(D);
+        quadrupole.push_back(Q);
+        haveDipoles |= data.is_Dipole;
+        haveQuadrupoles |= data.is_Quadrupole;
       }
-      mMin = 1;
     }
-    pot += kPot;  
+
+#ifdef IS_MPI
+    // every processor has to make the same choice of spline
+    // derivatives for the mesh to be consistent:
+    int flags[2] = {haveDipoles, haveQuadrupoles};
+    MPI_Allreduce(MPI_IN_PLACE, flags, 2, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+    haveDipoles = flags[0];
+    haveQuadrupoles = flags[1];
+#endif
+    if (!haveDipoles) dipole.clear();
+    if (!haveQuadrupoles) quadrupole.clear();
+
+    int nSites = sites.size();
+    vector<Vector3d> frc(nSites, V3Zero);
+    vector<Vector3d> trq(nSites, V3Zero);
+    vector<RealType> sitePot(nSites, 0.0);
+
+    pot += spme_->calcReciprocal(hmat, pos, charge, dipole, quadrupole,
+                                 frc, trq, sitePot);
+
+    for (int i = 0; i < nSites; i++) {
+      Atom* atom = sites[i];
+      int atid = atom->getAtomType()->getIdent();
+      data = ElectrostaticMap[Etids[atid]];
+      atom->addFrc(frc[i]);
+      if (data.is_Dipole || data.is_Quadrupole) atom->addTrq(trq[i]);
+      if (data.is_Fluctuating) atom->addFlucQFrc(-sitePot[i]);
+    }
   }
 
   void Electrostatic::getSitePotentials(Atom* a1, Atom* a2, bool excluded, 
@@ -51,6 +51,7 @@
 #include "math/CubicSpline.hpp"
 #include "brains/SimInfo.hpp"
 #include "flucq/FluctuatingChargeForces.hpp"
+#include "nonbonded/SPME.hpp"
 
 namespace OpenMD {
 
@@ -80,8 +81,8 @@ namespace OpenMD {
     esm_TAYLOR_SHIFTED,
     esm_REACTION_FIELD,
     esm_EWALD_FULL,  
-    esm_EWALD_PME,   /**< PME  Ewald methods aren't supported yet */
-    esm_EWALD_SPME   /**< SPME Ewald methods aren't supported yet */
+    esm_EWALD_PME,   /**< PME is handled by the smooth PME code */
+    esm_EWALD_SPME   /**< Smooth Particle Mesh Ewald */
   };
 
   enum ElectrostaticScreeningMethod{
@@ -93,6 +94,7 @@ namespace OpenMD {
     
   public:    
     Electrostatic();
+    ~Electrostatic();
     void setForceField(ForceField *ff);
     void setSimulatedAtomTypes(set<AtomType*> &simtypes);
     void setSimInfo(SimInfo* info) {info_ = info;};
@@ -114,6 +116,7 @@ namespace OpenMD {
 
   private:
     void initialize();
+    void SPMESum(RealType &pot);
     string name_;
     bool initialized_;
     bool haveCutoffRadius_;
@@ -155,6 +158,8 @@ namespace OpenMD {
     map<string, ElectrostaticSummationMethod> summationMap_;
     map<string, ElectrostaticScreeningMethod> screeningMap_;
     RealType dampingAlpha_;
+    RealType ewaldTolerance_;
+    SPME* spme_;
     RealType dielectric_;
     RealType preRF_;
     RealType selfMult1_; 
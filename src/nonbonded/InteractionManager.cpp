@@ -52,6 +52,7 @@ namespace OpenMD {
   InteractionManager::InteractionManager() {
 
     initialized_ = false;
+    vdwTable_ = NULL;
 
     lj_ = new LJ();
     gb_ = new GB();
@@ -521,7 +522,7 @@ namespace OpenMD {
 
     if (!initialized_) initialize();
 
-    int& iHash = iHash_[idat.atid1][idat.atid2];
+    int iHash = iHash_[idat.atid1][idat.atid2];
 
     if ((iHash & ELECTROSTATIC_INTERACTION) != 0) electrostatic_->calcForce(idat);
 
@@ -530,6 +531,12 @@ namespace OpenMD {
 
     if (idat.excluded) return;
 
+    // a tabulated pair replaces all of its van der Waals interactions
+    if (vdwTable_ != NULL && (iHash & TABULATED_VDW) != 0 &&
+        vdwTable_->isTabulated(idat.atid1, idat.atid2) &&
+        vdwTable_->calcForce(idat)) 
+      iHash &= ~TABULATED_VDW;
+
     if ((iHash & LJ_INTERACTION) != 0)             lj_->calcForce(idat);
     if ((iHash & GB_INTERACTION) != 0)             gb_->calcForce(idat);
     if ((iHash & STICKY_INTERACTION) != 0)         sticky_->calcForce(idat);
@@ -556,6 +563,59 @@ namespace OpenMD {
     return;
   }
 
+  /**
+   * Pairs of atom types that interact only through Lennard-Jones can
+   * be evaluated in batches with doPairBatch instead of doPair.
+   * Excluded pairs of these types have no interaction at all.
+   */
+  bool InteractionManager::isBatchable(int atid1, int atid2) {
+
+    if (!initialized_) initialize();
+
+    return iHash_[atid1][atid2] == LJ_INTERACTION;
+  }
+
+  void InteractionManager::doPairBatch(PairBatch &batch, RealType rcut,
+                                       bool shiftedPot, bool shiftedForce) {
+
+    if (!initialized_) initialize();
+
+    if (batch.n == 0) return;
+
+    if (vdwTable_ != NULL && vdwTable_->isTabulated(batch.atid1, batch.atid2)
+        && vdwTable_->calcForceBatch(batch)) 
+      return;
+
+    lj_->calcForceBatch(batch, rcut, shiftedPot, shiftedForce);
+  }
+
+  void InteractionManager::tabulateVdW(VanDerWaalsTable* table) {
+
+    if (!initialized_) initialize();
+
+    map<int, AtomType*>::iterator it1, it2;
+    set<NonBondedInteraction*>::iterator it;
+
+    for (it1 = typeMap_.begin(); it1 != typeMap_.end(); ++it1) {
+      int atid1 = (*it1).first;
+      for (it2 = it1; it2 != typeMap_.end(); ++it2) {
+        int atid2 = (*it2).first;
+
+        vector<NonBondedInteraction*> vdw;
+        bool tabulable = true;
+        for (it = interactions_[atid1][atid2].begin();
+             it != interactions_[atid1][atid2].end(); ++it) {
+          if ((*it)->getFamily() != VANDERWAALS_FAMILY) continue;
+          if (((*it)->getHash() & TABULATED_VDW) == 0) tabulable = false;
+          vdw.push_back(*it);
+        }
+        
+        if (tabulable && !vdw.empty())
+          table->addPair((*it1).second, (*it2).second, vdw);
+      }
+    }
+  }
+
   void InteractionManager::doSelfCorrection(SelfData &sdat){
 
     if (!initialized_) initialize();
@@ -56,6 +56,7 @@
 #include "nonbonded/RepulsivePower.hpp"
 #include "nonbonded/Mie.hpp"
 #include "nonbonded/SwitchingFunction.hpp"
+#include "nonbonded/VanDerWaalsTable.hpp"
 #include "flucq/FluctuatingChargeForces.hpp"
 
 using namespace std;
@@ -80,11 +81,22 @@ namespace OpenMD {
     void doPrePair(InteractionData &idat);
     void doPreForce(SelfData &sdat);
     void doPair(InteractionData &idat);    
+    bool isBatchable(int atid1, int atid2);
+    void doPairBatch(PairBatch &batch, RealType rcut, bool shiftedPot,
+                     bool shiftedForce);
     void doSkipCorrection(InteractionData &idat);
     void doSelfCorrection(SelfData &sdat);
     void doSurfaceTerm(RealType &surfacePot);
     void doReciprocalSpaceSum(RealType &recipPot);
     void setCutoffRadius(RealType rCut);
+    /**
+     * Adds every pair of simulated atom types whose van der Waals
+     * interactions are all tabulable (LJ, Morse, RepulsivePower and
+     * Mie) to the table.
+     */
+    void tabulateVdW(VanDerWaalsTable* table);
+    /** Uses a (shared, not owned) table for the tabulated pairs. */
+    void setVdWTable(VanDerWaalsTable* table) {vdwTable_ = table;}
     RealType getSuggestedCutoffRadius(int *atid1);   
     RealType getSuggestedCutoffRadius(AtomType *atype);
     
@@ -126,6 +138,8 @@ namespace OpenMD {
 
     /* sHash_ contains the self-interaction version of iHash_ */
     vector<int> sHash_;
+
+    VanDerWaalsTable* vdwTable_;
   };
 }
 #endif
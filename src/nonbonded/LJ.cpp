@@ -289,6 +289,57 @@ namespace OpenMD {
     return;
   }
   
+  /**
+   * Batched version of calcForce for pairs that share a single pair
+   * of LJ types.  The mixing parameters and the cutoff corrections
+   * are hoisted out of the loop, which the compiler can then
+   * vectorize.  The potential and force are the same as calcForce
+   * (the shifted force correction is written as a line in rij).
+   */
+  void LJ::calcForceBatch(PairBatch &batch, RealType rcut, bool shiftedPot,
+                          bool shiftedForce) {
+    if (!initialized_) initialize();
+
+    LJInteractionData &mixer = MixingMap[LJtids[batch.atid1]][LJtids[batch.atid2]];
+
+    const RealType sigmai = mixer.sigmai;
+    const RealType epsilon = mixer.epsilon;
+
+    // The cutoff correction is potC = c0 + c1 * rij, derivC = c2:
+    RealType c0(0.0), c1(0.0), c2(0.0);
+    if (shiftedPot || shiftedForce) {
+      RealType myPotC, myDerivC;
+      getLJfunc(rcut * sigmai, myPotC, myDerivC);
+      c0 = myPotC;
+      if (shiftedForce) {
+        c0 -= myDerivC * rcut * sigmai;
+        c1 = myDerivC * sigmai;
+        c2 = myDerivC;
+      }
+    }
+
+    const int n = batch.n;
+    const RealType* rij = &batch.rij[0];
+    const RealType* sw = &batch.sw[0];
+    const RealType* vdwMult = &batch.vdwMult[0];
+    RealType* vpair = &batch.vpair[0];
+    RealType* fr = &batch.fr[0];
+
+#pragma omp simd
+    for (int k = 0; k < n; k++) {
+      RealType ri = 1.0 / (rij[k] * sigmai);
+      RealType ri2 = ri * ri;
+      RealType ri6 = ri2 * ri2 * ri2;
+      RealType ri12 = ri6 * ri6;
+      RealType myPot = 4.0 * (ri12 - ri6);
+      RealType myDeriv = 24.0 * (ri6 - 2.0 * ri12) * ri;
+      RealType scale = vdwMult[k] * epsilon;
+
+      vpair[k] = scale * (myPot - c0 - c1 * rij[k]);
+      fr[k] = sw[k] * scale * (myDeriv - c2) * sigmai / rij[k];
+    }
+  }
+
   void LJ::getLJfunc(RealType r, RealType &pot, RealType &deriv) {
 
     RealType ri = 1.0 / r;
@@ -66,6 +66,8 @@ namespace OpenMD {
     void addType(AtomType* atomType);
     void addExplicitInteraction(AtomType* atype1, AtomType* atype2, RealType sigma, RealType epsilon);
     virtual void calcForce(InteractionData &idat);
+    void calcForceBatch(PairBatch &batch, RealType rcut, bool shiftedPot,
+                        bool shiftedForce);
     virtual string getName() {return name_;}
     virtual int getHash() {return LJ_INTERACTION;}
     virtual RealType getSuggestedCutoffRadius(pair<AtomType*, AtomType*> atypes);    
@@ -43,6 +43,7 @@
 #ifndef NONBONDED_NONBONDEDINTERACTION_HPP
 #define NONBONDED_NONBONDEDINTERACTION_HPP
 
+#include <algorithm>
 #include "types/AtomType.hpp"
 #include "math/SquareMatrix3.hpp"
 
@@ -83,6 +84,10 @@ namespace OpenMD {
   const static int MIE_INTERACTION            = (1 << 9);
   const static int BUCKINGHAM_INTERACTION     = (1 << 10);
 
+  /** van der Waals interactions that depend only on separation */
+  const static int TABULATED_VDW = LJ_INTERACTION | MORSE_INTERACTION | 
+    REPULSIVEPOWER_INTERACTION | MIE_INTERACTION;
+
   typedef Vector<RealType, N_INTERACTION_FAMILIES> potVec;
 
   /**
@@ -178,7 +183,62 @@ namespace OpenMD {
     potVec* selePot;       /**< potential energy of the selected site */
     /*@}*/
   };
-  
+
+  /**
+   * The PairBatch struct.
+   *
+   * A structure-of-arrays block of pairs which share the same first
+   * atom and the same pair of atom types.  Interactions that support
+   * batching evaluate every pair in the block in a single loop, with
+   * the mixing parameters for the type pair looked up only once.  The
+   * arrays only grow, so a batch that is reused does not allocate.
+   */
+  struct PairBatch {
+    /*@{*/
+    int atid1;                /**< atomType ident for the first atom */
+    int atid2;                /**< atomType ident for all second atoms */
+    int n;                    /**< number of pairs in the batch */
+    vector<int> atom2;        /**< second atom of each pair */
+    vector<RealType> dx;      /**< interatomic vectors (already wrapped into box) */
+    vector<RealType> dy;
+    vector<RealType> dz;
+    vector<RealType> rij;     /**< interatomic separations */
+    vector<RealType> sw;      /**< switching function values */
+    vector<RealType> dswdr;   /**< switching function derivatives */
+    vector<RealType> vdwMult; /**< multipliers for van der Waals interactions */
+    vector<RealType> vpair;   /**< unswitched pair potential (output) */
+    vector<RealType> fr;      /**< magnitude of f1 divided by rij (output) */
+    /*@}*/
+
+    PairBatch() : atid1(-1), atid2(-1), n(0) {}
+
+    void add(int a2, const Vector3d& d, RealType r, RealType s,
+             RealType ds, RealType mult) {
+      if (n == int(atom2.size())) {
+        int newSize = max(2 * n, 16);
+        atom2.resize(newSize);
+        dx.resize(newSize);
+        dy.resize(newSize);
+        dz.resize(newSize);
+        rij.resize(newSize);
+        sw.resize(newSize);
+        dswdr.resize(newSize);
+        vdwMult.resize(newSize);
+        vpair.resize(newSize);
+        fr.resize(newSize);
+      }
+      atom2[n] = a2;
+      dx[n] = d.x();
+      dy[n] = d.y();
+      dz[n] = d.z();
+      rij[n] = r;
+      sw[n] = s;
+      dswdr[n] = ds;
+      vdwMult[n] = mult;
+      n++;
+    }
+  };
+
     
   /**
    * The basic interface for non-bonded interactions.  
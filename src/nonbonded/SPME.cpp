@@ -0,0 +1,501 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+#ifdef IS_MPI
+#include <mpi.h>
+#endif
+
+#include <cmath>
+#include <algorithm>
+#include "nonbonded/SPME.hpp"
+#include "utils/simError.h"
+
+namespace OpenMD {
+
+  const RealType eConverter = 332.0637778; // convert the Charge-Charge
+                                           // electrostatic interactions
+                                           // into kcal / mol assuming
+                                           // distances are measured in
+                                           // angstroms.
+
+  // The B-spline tables are padded so that M_m(w + j - 3) can be
+  // looked up without bounds checks:
+  const int splinePad = 3;
+  const int maxOrder = 12;
+
+  SPME::SPME() : alpha_(0.0), tolerance_(1.0e-6), order_(6),
+                 gridSize_(0, 0, 0), haveGrid_(false), lastHmat_(0.0) {
+#ifdef HAVE_FFTW3_H
+    realGrid_ = NULL;
+    kGrid_ = NULL;
+#endif
+  }
+
+  SPME::~SPME() {
+#ifdef HAVE_FFTW3_H
+    if (haveGrid_) {
+      fftw_destroy_plan(forwardPlan_);
+      fftw_destroy_plan(backwardPlan_);
+      fftw_free(realGrid_);
+      fftw_free(kGrid_);
+    }
+#endif
+  }
+
+  void SPME::setParameters(RealType alpha, RealType tolerance) {
+    alpha_ = alpha;
+    tolerance_ = tolerance;
+
+    // Tighter tolerances need higher order splines, but the higher
+    // orders allow a coarser mesh:
+    if (tolerance_ >= 1.0e-5) 
+      order_ = 4;
+    else if (tolerance_ >= 1.0e-7)
+      order_ = 6;
+    else
+      order_ = 8;
+  }
+
+  int SPME::nextFFTSize(int n) {
+    // FFTW is fastest for sizes with only small prime factors:
+    for (int m = n; ; m++) {
+      int r = m;
+      while (r % 2 == 0) r /= 2;
+      while (r % 3 == 0) r /= 3;
+      while (r % 5 == 0) r /= 5;
+      if (r == 1) return m;
+    }
+  }
+
+  /**
+   * Fills the B-spline weights (and their first three derivatives)
+   * for a site with fractional mesh offset w.  Entry j is the weight
+   * of mesh point floor(u) - j, i.e. M_n(w + j).
+   */
+  void SPME::fillBSplines(RealType w, RealType* theta, RealType* dtheta,
+                          RealType* d2theta, RealType* d3theta) {
+    RealType M[maxOrder + 1][maxOrder + splinePad];
+    int n = order_;
+    
+    for (int m = 0; m <= n; m++) 
+      for (int j = 0; j < n + splinePad; j++) 
+        M[m][j] = 0.0;
+
+    // M_1 is the unit box on [0,1), and the higher orders follow from
+    // the usual recursion:
+    // M_m(x) = (x M_{m-1}(x) + (m - x) M_{m-1}(x - 1)) / (m - 1)
+    M[1][splinePad] = 1.0;
+    for (int m = 2; m <= n; m++) {
+      for (int j = 0; j < m; j++) {
+        RealType x = w + RealType(j);
+        int p = j + splinePad;
+        M[m][p] = (x * M[m-1][p] + (RealType(m) - x) * M[m-1][p-1]) / 
+          RealType(m - 1);
+      }
+    }
+
+    // Derivatives are differences of the lower order splines:
+    for (int j = 0; j < n; j++) {
+      int p = j + splinePad;
+      theta[j] = M[n][p];
+      dtheta[j] = M[n-1][p] - M[n-1][p-1];
+      d2theta[j] = M[n-2][p] - 2.0 * M[n-2][p-1] + M[n-2][p-2];
+      d3theta[j] = M[n-3][p] - 3.0 * M[n-3][p-1] + 3.0 * M[n-3][p-2] 
+        - M[n-3][p-3];
+    }
+  }
+
+  void SPME::setupGrid(const Mat3x3d& hmat) {
+#ifdef HAVE_FFTW3_H
+    // The mesh has to resolve all reciprocal lattice vectors m (in
+    // units of 1/angstroms) with exp(-pi^2 m^2 / alpha^2) above the
+    // tolerance.  Along box vector a, the largest index needed is
+    // mMax |a|, and the oversampling covers the interpolation error
+    // of the splines.
+    RealType mMax = alpha_ * sqrt(-log(tolerance_)) / M_PI;
+    RealType oversample;
+    switch (order_) {
+    case 4:
+      oversample = 1.25;
+      break;
+    case 6:
+      oversample = 1.15;
+      break;
+    default:
+      oversample = 1.05;
+    }
+
+    Mat3x3d h(hmat);
+    for (int a = 0; a < 3; a++) {
+      RealType boxLength = h.getColumn(a).length();
+      int k = int(ceil(2.0 * mMax * boxLength * oversample));
+      gridSize_[a] = nextFFTSize(max(k, 2 * order_));
+    }
+
+    int K1 = gridSize_[0];
+    int K2 = gridSize_[1];
+    int K3 = gridSize_[2];
+    int nReal = K1 * K2 * K3;
+    int nComplex = K1 * K2 * (K3 / 2 + 1);
+
+    realGrid_ = (double*) fftw_malloc(sizeof(double) * nReal);
+    kGrid_ = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nComplex);
+    forwardPlan_ = fftw_plan_dft_r2c_3d(K1, K2, K3, realGrid_, kGrid_,
+                                        FFTW_ESTIMATE);
+    backwardPlan_ = fftw_plan_dft_c2r_3d(K1, K2, K3, kGrid_, realGrid_,
+                                         FFTW_ESTIMATE);
+
+    // Moduli of the Euler exponential splines, |b(m)|^2:
+    vector<RealType> mn(order_), d1(order_), d2(order_), d3(order_);
+    fillBSplines(0.0, &mn[0], &d1[0], &d2[0], &d3[0]);
+
+    for (int a = 0; a < 3; a++) {
+      int K = gridSize_[a];
+      bsp_[a].resize(K);
+      for (int m = 0; m < K; m++) {
+        RealType sc = 0.0;
+        RealType ss = 0.0;
+        for (int k = 0; k < order_ - 1; k++) {
+          RealType arg = 2.0 * M_PI * RealType(m * k) / RealType(K);
+          sc += mn[k + 1] * cos(arg);
+          ss += mn[k + 1] * sin(arg);
+        }
+        RealType denom = sc * sc + ss * ss;
+        bsp_[a][m] = (denom > 1.0e-10) ? 1.0 / denom : 0.0;
+      }
+    }
+
+    sprintf(painCave.errMsg,
+            "SPME: using a %d x %d x %d mesh with order %d B-splines.\n",
+            K1, K2, K3, order_);
+    painCave.severity = OPENMD_INFO;
+    painCave.isFatal = 0;
+    simError();
+
+    haveGrid_ = true;
+#endif
+  }
+
+  /**
+   * The influence function (the Fourier transform of the reciprocal
+   * space Ewald kernel, corrected for the spline interpolation) only
+   * changes when the box does, so it is kept between calls.
+   */
+  void SPME::computeInfluenceFunction(const Mat3x3d& hmat) {
+    Mat3x3d hinv = hmat.inverse();
+    RealType volume = fabs(hmat.determinant());
+    RealType pi2a2 = M_PI * M_PI / (alpha_ * alpha_);
+    int K1 = gridSize_[0];
+    int K2 = gridSize_[1];
+    int K3 = gridSize_[2];
+    int K3h = K3 / 2 + 1;
+
+    influence_.resize(K1 * K2 * K3h);
+
+    for (int m1 = 0; m1 < K1; m1++) {
+      int mm1 = (m1 <= K1 / 2) ? m1 : m1 - K1;
+      for (int m2 = 0; m2 < K2; m2++) {
+        int mm2 = (m2 <= K2 / 2) ? m2 : m2 - K2;
+        for (int m3 = 0; m3 < K3h; m3++) {
+          int index = (m1 * K2 + m2) * K3h + m3;
+          if (m1 == 0 && m2 == 0 && m3 == 0) {
+            influence_[index] = 0.0;
+            continue;
+          }
+          // reciprocal lattice vectors are the rows of hinv:
+          Vector3d m;
+          for (int a = 0; a < 3; a++) 
+            m[a] = mm1 * hinv(0, a) + mm2 * hinv(1, a) + m3 * hinv(2, a);
+          RealType msq = m.lengthSquare();
+          influence_[index] = eConverter * exp(-pi2a2 * msq) / 
+            (M_PI * volume * msq) * bsp_[0][m1] * bsp_[1][m2] * bsp_[2][m3];
+        }
+      }
+    }
+  }
+
+  RealType SPME::calcReciprocal(const Mat3x3d& hmat,
+                                const vector<Vector3d>& pos,
+                                const vector<RealType>& charge,
+                                const vector<Vector3d>& dipole,
+                                const vector<Mat3x3d>& quadrupole,
+                                vector<Vector3d>& force,
+                                vector<Vector3d>& torque,
+                                vector<RealType>& potential) {
+    RealType energy = 0.0;
+
+#ifdef HAVE_FFTW3_H
+    if (!haveGrid_) setupGrid(hmat);
+
+    bool boxChanged = influence_.empty();
+    for (int a = 0; a < 3; a++)
+      for (int b = 0; b < 3; b++)
+        if (hmat(a, b) != lastHmat_(a, b)) boxChanged = true;
+    if (boxChanged) {
+      computeInfluenceFunction(hmat);
+      lastHmat_ = hmat;
+    }
+
+    int n = order_;
+    int nSites = pos.size();
+    bool doDipoles = !dipole.empty();
+    bool doQuadrupoles = !quadrupole.empty();
+    int K1 = gridSize_[0];
+    int K2 = gridSize_[1];
+    int K3 = gridSize_[2];
+    int K3h = K3 / 2 + 1;
+
+    // A maps cartesian derivatives onto mesh derivatives: 
+    //     d/dr = A^T d/du
+    Mat3x3d hinv = hmat.inverse();
+    Mat3x3d A;
+    for (int a = 0; a < 3; a++) 
+      for (int b = 0; b < 3; b++)
+        A(a, b) = RealType(gridSize_[a]) * hinv(a, b);
+    Mat3x3d At = A.transpose();
+
+    for (int a = 0; a < 3; a++) {
+      theta_[a].resize(nSites * n);
+      dtheta_[a].resize(nSites * n);
+      d2theta_[a].resize(nSites * n);
+      d3theta_[a].resize(nSites * n);
+    }
+    base_.resize(nSites);
+    vector<Vector3d> Du(doDipoles ? nSites : 0);
+    vector<Mat3x3d> Qu(doQuadrupoles ? nSites : 0);
+
+    fill(realGrid_, realGrid_ + K1 * K2 * K3, 0.0);
+
+    // Spread the multipoles onto the mesh:
+    for (int i = 0; i < nSites; i++) {
+      Vector3d s = hinv * pos[i];
+      for (int a = 0; a < 3; a++) {
+        RealType u = (s[a] - floor(s[a])) * RealType(gridSize_[a]);
+        int iu = int(u);
+        RealType w = u - RealType(iu);
+        if (iu >= gridSize_[a]) iu -= gridSize_[a];
+        base_[i][a] = iu;
+        fillBSplines(w, &theta_[a][i*n], &dtheta_[a][i*n], 
+                     &d2theta_[a][i*n], &d3theta_[a][i*n]);
+      }
+      if (doDipoles) Du[i] = A * dipole[i];
+      if (doQuadrupoles) Qu[i] = A * quadrupole[i] * At;
+
+      const RealType* t1 = &theta_[0][i*n];
+      const RealType* t2 = &theta_[1][i*n];
+      const RealType* t3 = &theta_[2][i*n];
+      const RealType* dt1 = &dtheta_[0][i*n];
+      const RealType* dt2 = &dtheta_[1][i*n];
+      const RealType* dt3 = &dtheta_[2][i*n];
+      const RealType* ddt1 = &d2theta_[0][i*n];
+      const RealType* ddt2 = &d2theta_[1][i*n];
+      const RealType* ddt3 = &d2theta_[2][i*n];
+
+      for (int j1 = 0; j1 < n; j1++) {
+        int k1 = base_[i][0] - j1;
+        if (k1 < 0) k1 += K1;
+        for (int j2 = 0; j2 < n; j2++) {
+          int k2 = base_[i][1] - j2;
+          if (k2 < 0) k2 += K2;
+          double* row = &realGrid_[(k1 * K2 + k2) * K3];
+          for (int j3 = 0; j3 < n; j3++) {
+            int k3 = base_[i][2] - j3;
+            if (k3 < 0) k3 += K3;
+            
+            RealType val = charge[i] * t1[j1] * t2[j2] * t3[j3];
+            if (doDipoles) {
+              val += Du[i][0] * dt1[j1] * t2[j2] * t3[j3] + 
+                Du[i][1] * t1[j1] * dt2[j2] * t3[j3] + 
+                Du[i][2] * t1[j1] * t2[j2] * dt3[j3];
+            }
+            if (doQuadrupoles) {
+              val += Qu[i](0,0) * ddt1[j1] * t2[j2] * t3[j3] + 
+                Qu[i](1,1) * t1[j1] * ddt2[j2] * t3[j3] + 
+                Qu[i](2,2) * t1[j1] * t2[j2] * ddt3[j3] + 
+                2.0 * Qu[i](0,1) * dt1[j1] * dt2[j2] * t3[j3] + 
+                2.0 * Qu[i](0,2) * dt1[j1] * t2[j2] * dt3[j3] + 
+                2.0 * Qu[i](1,2) * t1[j1] * dt2[j2] * dt3[j3];
+            }
+            row[k3] += val;
+          }
+        }
+      }
+    }
+
+#ifdef IS_MPI
+    MPI_Allreduce(MPI_IN_PLACE, realGrid_, K1 * K2 * K3, MPI_DOUBLE, 
+                  MPI_SUM, MPI_COMM_WORLD);
+#endif
+
+    // Convolve with the influence function.  Only half of the last
+    // dimension is stored, so the other points are counted twice in
+    // the energy.
+    fftw_execute(forwardPlan_);
+
+    for (int m1 = 0; m1 < K1; m1++) {
+      for (int m2 = 0; m2 < K2; m2++) {
+        for (int m3 = 0; m3 < K3h; m3++) {
+          int index = (m1 * K2 + m2) * K3h + m3;
+          RealType G = influence_[index];
+          RealType re = kGrid_[index][0];
+          RealType im = kGrid_[index][1];
+          RealType weight = (m3 == 0 || (K3 % 2 == 0 && m3 == K3 / 2)) ? 
+            0.5 : 1.0;
+          energy += weight * G * (re * re + im * im);
+          kGrid_[index][0] *= G;
+          kGrid_[index][1] *= G;
+        }
+      }
+    }
+
+    // realGrid_ now holds the mesh potential:
+    fftw_execute(backwardPlan_);
+
+    // Interpolate the potential and its derivatives back to the sites:
+    for (int i = 0; i < nSites; i++) {
+      const RealType* t1 = &theta_[0][i*n];
+      const RealType* t2 = &theta_[1][i*n];
+      const RealType* t3 = &theta_[2][i*n];
+      const RealType* dt1 = &dtheta_[0][i*n];
+      const RealType* dt2 = &dtheta_[1][i*n];
+      const RealType* dt3 = &dtheta_[2][i*n];
+      const RealType* ddt1 = &d2theta_[0][i*n];
+      const RealType* ddt2 = &d2theta_[1][i*n];
+      const RealType* ddt3 = &d2theta_[2][i*n];
+      const RealType* dddt1 = &d3theta_[0][i*n];
+      const RealType* dddt2 = &d3theta_[1][i*n];
+      const RealType* dddt3 = &d3theta_[2][i*n];
+
+      RealType phi = 0.0;
+      Vector3d gu(0.0);
+      Mat3x3d Hu(0.0);
+      // unique elements of the third derivative tensor: 
+      // xxx, yyy, zzz, xxy, xxz, yyx, yyz, zzx, zzy, xyz
+      RealType T[10];
+      for (int t = 0; t < 10; t++) T[t] = 0.0;
+
+      for (int j1 = 0; j1 < n; j1++) {
+        int k1 = base_[i][0] - j1;
+        if (k1 < 0) k1 += K1;
+        for (int j2 = 0; j2 < n; j2++) {
+          int k2 = base_[i][1] - j2;
+          if (k2 < 0) k2 += K2;
+          double* row = &realGrid_[(k1 * K2 + k2) * K3];
+          for (int j3 = 0; j3 < n; j3++) {
+            int k3 = base_[i][2] - j3;
+            if (k3 < 0) k3 += K3;
+            RealType p = row[k3];
+
+            phi   += p * t1[j1] * t2[j2] * t3[j3];
+            gu[0] += p * dt1[j1] * t2[j2] * t3[j3];
+            gu[1] += p * t1[j1] * dt2[j2] * t3[j3];
+            gu[2] += p * t1[j1] * t2[j2] * dt3[j3];
+
+            if (doDipoles || doQuadrupoles) {
+              Hu(0,0) += p * ddt1[j1] * t2[j2] * t3[j3];
+              Hu(1,1) += p * t1[j1] * ddt2[j2] * t3[j3];
+              Hu(2,2) += p * t1[j1] * t2[j2] * ddt3[j3];
+              Hu(0,1) += p * dt1[j1] * dt2[j2] * t3[j3];
+              Hu(0,2) += p * dt1[j1] * t2[j2] * dt3[j3];
+              Hu(1,2) += p * t1[j1] * dt2[j2] * dt3[j3];
+            }
+
+            if (doQuadrupoles) {
+              T[0] += p * dddt1[j1] * t2[j2] * t3[j3];
+              T[1] += p * t1[j1] * dddt2[j2] * t3[j3];
+              T[2] += p * t1[j1] * t2[j2] * dddt3[j3];
+              T[3] += p * ddt1[j1] * dt2[j2] * t3[j3];
+              T[4] += p * ddt1[j1] * t2[j2] * dt3[j3];
+              T[5] += p * dt1[j1] * ddt2[j2] * t3[j3];
+              T[6] += p * t1[j1] * ddt2[j2] * dt3[j3];
+              T[7] += p * dt1[j1] * t2[j2] * ddt3[j3];
+              T[8] += p * t1[j1] * dt2[j2] * ddt3[j3];
+              T[9] += p * dt1[j1] * dt2[j2] * dt3[j3];
+            }
+          }
+        }
+      }
+      Hu(1,0) = Hu(0,1);
+      Hu(2,0) = Hu(0,2);
+      Hu(2,1) = Hu(1,2);
+
+      // derivative of the energy with respect to the mesh coordinates
+      // of this site:
+      Vector3d fu = charge[i] * gu;
+
+      if (doDipoles) {
+        fu += Hu * Du[i];
+        // torque on the dipole is D x E, with E = -grad(phi):
+        Vector3d gradPhi = At * gu;
+        torque[i] -= cross(dipole[i], gradPhi);
+      }
+
+      if (doQuadrupoles) {
+        // expand the symmetric third derivative tensor:
+        RealType T3[3][3][3];
+        int idx[3][3][3] = { { {0, 3, 4}, {3, 5, 9}, {4, 9, 7} },
+                             { {3, 5, 9}, {5, 1, 6}, {9, 6, 8} },
+                             { {4, 9, 7}, {9, 6, 8}, {7, 8, 2} } };
+        for (int a = 0; a < 3; a++)
+          for (int b = 0; b < 3; b++)
+            for (int c = 0; c < 3; c++)
+              T3[a][b][c] = T[idx[a][b][c]];
+
+        for (int c = 0; c < 3; c++) 
+          for (int a = 0; a < 3; a++)
+            for (int b = 0; b < 3; b++)
+              fu[c] += Qu[i](a, b) * T3[a][b][c];
+
+        // torque on the quadrupole is -2 epsilon : (Q grad grad phi)
+        Mat3x3d QG = quadrupole[i] * (At * Hu * A);
+        torque[i] -= 2.0 * Vector3d(QG(1,2) - QG(2,1),
+                                    QG(2,0) - QG(0,2),
+                                    QG(0,1) - QG(1,0));
+      }
+
+      force[i] -= At * fu;
+      potential[i] += phi;
+    }
+#endif
+    return energy;
+  }
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+ 
+#ifndef NONBONDED_SPME_HPP
+#define NONBONDED_SPME_HPP
+
+#include "config.h"
+#include <vector>
+#include "math/Vector3.hpp"
+#include "math/SquareMatrix3.hpp"
+
+#ifdef HAVE_FFTW3_H
+#include <fftw3.h>
+#endif
+
+using namespace std;
+
+namespace OpenMD {
+
+  /**
+   * @class SPME
+   *
+   * Reciprocal-space part of the Ewald sum using the Smooth Particle
+   * Mesh Ewald method [Essmann et al., J. Chem. Phys. 103, 8577
+   * (1995)].  Charges, point dipoles and point quadrupoles are spread
+   * onto a regular mesh with cardinal B-splines, the mesh is
+   * convolved with the Ewald influence function using 3D FFTs, and
+   * the resulting mesh potential is interpolated back onto the sites
+   * to get the forces, torques, and site potentials.
+   *
+   * The spline order and mesh dimensions are chosen from a relative
+   * accuracy tolerance (the same tolerance that sets the Ewald
+   * damping parameter, erfc(alpha rcut) = tolerance).
+   */
+  class SPME {
+  public:
+    SPME();
+    ~SPME();
+
+    /**
+     * Sets the Ewald damping parameter (1/angstroms) and the
+     * relative accuracy used to choose the spline order and mesh.
+     */
+    void setParameters(RealType alpha, RealType tolerance);
+
+    int getOrder() { return order_; }
+    Vector3i getGridSize() { return gridSize_; }
+
+    /**
+     * Computes the reciprocal space energy (in kcal/mol) for a set of
+     * sites.  Multipoles are in electron-angstrom units and
+     * space-fixed coordinates; the dipole and quadrupole vectors may
+     * be empty if there are no sites carrying these moments.  The
+     * forces, torques, and site potentials (kcal/mol/e) are added to
+     * the output vectors, which must be sized to match pos.
+     *
+     * In parallel, each processor passes only its local sites, and
+     * the returned energy is the total for the whole system.
+     */
+    RealType calcReciprocal(const Mat3x3d& hmat,
+                            const vector<Vector3d>& pos,
+                            const vector<RealType>& charge,
+                            const vector<Vector3d>& dipole,
+                            const vector<Mat3x3d>& quadrupole,
+                            vector<Vector3d>& force,
+                            vector<Vector3d>& torque,
+                            vector<RealType>& potential);
+
+  private:
+    void setupGrid(const Mat3x3d& hmat);
+    void computeInfluenceFunction(const Mat3x3d& hmat);
+    void fillBSplines(RealType w, RealType* theta, RealType* dtheta,
+                      RealType* d2theta, RealType* d3theta);
+    static int nextFFTSize(int n);
+
+    RealType alpha_;
+    RealType tolerance_;
+    int order_;
+    Vector3i gridSize_;
+    bool haveGrid_;
+    Mat3x3d lastHmat_;
+
+    vector<RealType> influence_;  /**< influence function on the half mesh */
+    vector<RealType> bsp_[3];     /**< |b(m)|^2 for each direction */
+
+    // spline values for each site, order_ entries per direction:
+    vector<RealType> theta_[3];
+    vector<RealType> dtheta_[3];
+    vector<RealType> d2theta_[3];
+    vector<RealType> d3theta_[3];
+    vector<Vector3i> base_;
+
+#ifdef HAVE_FFTW3_H
+    double* realGrid_;
+    fftw_complex* kGrid_;
+    fftw_plan forwardPlan_;
+    fftw_plan backwardPlan_;
+#endif
+  };
+}
+#endif
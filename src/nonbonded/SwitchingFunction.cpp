@@ -142,6 +142,9 @@ namespace OpenMD {
       switchSpline_->addPoint(rin_, 1.0);
       switchSpline_->addPoint(rout_, 0.0);
     }
+    // generate the coefficients now so that getSwitch is read-only and
+    // may be called from several threads at once:
+    switchSpline_->generate();
     haveSpline_ = true;
     return;
   }
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+#include <stdio.h>
+#include <cmath>
+#include "nonbonded/VanDerWaalsTable.hpp"
+#include "utils/simError.h"
+
+namespace OpenMD {
+
+  /**
+   * Evaluates the polynomial c[0] + c[1] t + ... + c[Order] t^Order
+   * and its derivative with respect to t.
+   */
+  template<int Order>
+  inline void evaluatePolynomial(const RealType* c, RealType t, 
+                                 RealType &u, RealType &du) {
+    u = c[Order];
+    du = Order * c[Order];
+    for (int k = Order - 1; k > 0; k--) {
+      u = u * t + c[k];
+      du = du * t + k * c[k];
+    }
+    u = u * t + c[0];
+  }
+
+  VanDerWaalsTable::VanDerWaalsTable(int nTypes, RealType rcut, 
+                                     bool shiftedPot, bool shiftedForce,
+                                     RealType spacing, int order) : 
+    rcut_(rcut), shiftedPot_(shiftedPot), shiftedForce_(shiftedForce),
+    spacing_(spacing), order_(order) {
+
+    if (order_ != 3 && order_ != 5) {
+      sprintf( painCave.errMsg,
+               "VanDerWaalsTable: vdwTableOrder must be 3 (cubic) or\n"
+               "\t5 (quintic), not %d.\n", order_);
+      painCave.severity = OPENMD_ERROR;
+      painCave.isFatal = 1;
+      simError();
+    }
+    invSpacing_ = 1.0 / spacing_;
+    nCoeff_ = order_ + 1;
+    pairIndex_.resize(nTypes, vector<int>(nTypes, -1));
+  }
+
+  void VanDerWaalsTable::evaluate(int atid1, int atid2, 
+                                  vector<NonBondedInteraction*>& interactions,
+                                  RealType r, RealType &pot, RealType &dudr) {
+    InteractionData idat;
+    Vector3d d(r, 0.0, 0.0);
+    Vector3d f1(0.0);
+    RealType r2 = r * r;
+    RealType rcut = rcut_;
+    RealType sw = 1.0;
+    RealType vdwMult = 1.0;
+    RealType vpair = 0.0;
+    potVec potential(0.0);
+    potVec selePot(0.0);
+
+    idat.atid1 = atid1;
+    idat.atid2 = atid2;
+    idat.d = &d;
+    idat.rij = &r;
+    idat.r2 = &r2;
+    idat.rcut = &rcut;
+    idat.shiftedPot = shiftedPot_;
+    idat.shiftedForce = shiftedForce_;
+    idat.sw = &sw;
+    idat.excluded = false;
+    idat.vdwMult = &vdwMult;
+    idat.pot = &potential;
+    idat.vpair = &vpair;
+    idat.isSelected = false;
+    idat.selePot = &selePot;
+    idat.f1 = &f1;
+
+    for (unsigned int i = 0; i < interactions.size(); i++) 
+      interactions[i]->calcForce(idat);
+
+    // f1 = d * (dU/dr) / r, and d lies along x:
+    pot = vpair;
+    dudr = f1.x();
+  }
+
+  void VanDerWaalsTable::addPair(AtomType* atype1, AtomType* atype2, 
+                                 vector<NonBondedInteraction*>& interactions) {
+
+    int atid1 = atype1->getIdent();
+    int atid2 = atype2->getIdent();
+
+    if (pairIndex_[atid1][atid2] != -1) return;
+
+    PairTable table;
+    table.name = atype1->getName() + " - " + atype2->getName();
+
+    // The table starts where the pair potential becomes too
+    // repulsive for any reasonable configuration; closer pairs fall
+    // back to the analytic forms.
+    const RealType maxPot = 1.0e3;
+    const RealType rFloor = 0.5;
+    const RealType dr = 0.01;
+    RealType rMin = rcut_;
+    RealType pot, dudr;
+    while (rMin - dr > rFloor) {
+      evaluate(atid1, atid2, interactions, rMin - dr, pot, dudr);
+      if (fabs(pot) > maxPot) break;
+      rMin -= dr;
+    }
+
+    RealType sMax = rcut_ * rcut_;
+    table.nBins = int(ceil((sMax - rMin * rMin) * invSpacing_));
+    if (table.nBins < 1) table.nBins = 1;
+    table.sMin = sMax - table.nBins * spacing_;
+    while (table.sMin <= rFloor * rFloor && table.nBins > 1) {
+      table.nBins--;
+      table.sMin += spacing_;
+    }
+    table.offset = coefficients_.size();
+
+    // values and scaled derivatives (in r^2) at the grid points:
+    int nPoints = table.nBins + 1;
+    vector<RealType> U(nPoints), D(nPoints), E(nPoints, 0.0);
+    for (int i = 0; i < nPoints; i++) {
+      RealType s = table.sMin + i * spacing_;
+      RealType r = sqrt(s);
+      evaluate(atid1, atid2, interactions, r, U[i], dudr);
+      // dU/ds = (dU/dr) / 2r
+      D[i] = dudr / (2.0 * r) * spacing_;
+      if (order_ == 5) {
+        // d2U/ds2 = (d2U/dr2 - (dU/dr) / r) / 4r^2
+        RealType h = 1.0e-4 * r;
+        RealType dudrP, dudrM;
+        evaluate(atid1, atid2, interactions, r + h, pot, dudrP);
+        evaluate(atid1, atid2, interactions, r - h, pot, dudrM);
+        RealType d2udr2 = (dudrP - dudrM) / (2.0 * h);
+        E[i] = (d2udr2 - dudr / r) / (4.0 * s) * spacing_ * spacing_;
+      }
+    }
+
+    coefficients_.resize(table.offset + table.nBins * nCoeff_);
+
+    for (int i = 0; i < table.nBins; i++) {
+      RealType* c = &coefficients_[table.offset + i * nCoeff_];
+      RealType dU = U[i+1] - U[i];
+      c[0] = U[i];
+      c[1] = D[i];
+      if (order_ == 3) {
+        c[2] = 3.0 * dU - 2.0 * D[i] - D[i+1];
+        c[3] = -2.0 * dU + D[i] + D[i+1];
+      } else {
+        c[2] = 0.5 * E[i];
+        c[3] = 10.0 * dU - 6.0 * D[i] - 4.0 * D[i+1] 
+          - 0.5 * (3.0 * E[i] - E[i+1]);
+        c[4] = -15.0 * dU + 8.0 * D[i] + 7.0 * D[i+1] 
+          + 0.5 * (3.0 * E[i] - 2.0 * E[i+1]);
+        c[5] = 6.0 * dU - 3.0 * D[i] - 3.0 * D[i+1] 
+          - 0.5 * (E[i] - E[i+1]);
+      }
+    }
+
+    // accuracy of the table between the grid points:
+    const int nSamples = 6;
+    RealType tabPot, tabDudrOverR;
+    RealType sumErr2(0.0), sumFrc2(0.0);
+    table.maxPotErr = 0.0;
+    table.maxFrcErr = 0.0;
+    for (int i = 0; i < table.nBins; i++) {
+      for (int j = 1; j < nSamples; j++) {
+        RealType s = table.sMin + (i + RealType(j) / nSamples) * spacing_;
+        RealType r = sqrt(s);
+        evaluate(atid1, atid2, interactions, r, pot, dudr);
+        lookup(table, s, tabPot, tabDudrOverR);
+        RealType frcErr = fabs(tabDudrOverR * r - dudr);
+        table.maxPotErr = max(table.maxPotErr, fabs(tabPot - pot));
+        table.maxFrcErr = max(table.maxFrcErr, frcErr);
+        sumErr2 += frcErr * frcErr;
+        sumFrc2 += dudr * dudr;
+      }
+    }
+    table.rmsRelErr = (sumFrc2 > 0.0) ? sqrt(sumErr2 / sumFrc2) : 0.0;
+
+    pairIndex_[atid1][atid2] = tables_.size();
+    pairIndex_[atid2][atid1] = tables_.size();
+    tables_.push_back(table);
+  }
+
+  void VanDerWaalsTable::lookup(const PairTable& table, RealType s,
+                                       RealType &pot, RealType &dudrOverR) {
+    RealType x = (s - table.sMin) * invSpacing_;
+    int bin = min(int(x), table.nBins - 1);
+    RealType t = x - bin;
+    const RealType* c = &coefficients_[table.offset + bin * nCoeff_];
+    RealType du;
+
+    if (order_ == 3) 
+      evaluatePolynomial<3>(c, t, pot, du);
+    else
+      evaluatePolynomial<5>(c, t, pot, du);
+
+    // (dU/dr) / r = 2 dU/ds
+    dudrOverR = 2.0 * du * invSpacing_;
+  }
+
+  bool VanDerWaalsTable::calcForce(InteractionData &idat) {
+
+    const PairTable& table = tables_[pairIndex_[idat.atid1][idat.atid2]];
+    RealType s = *(idat.r2);
+    
+    if (s < table.sMin || s > table.sMin + table.nBins * spacing_)
+      return false;
+
+    RealType myPot, myDudrOverR;
+    lookup(table, s, myPot, myDudrOverR);
+
+    RealType pot_temp = *(idat.vdwMult) * myPot;
+    *(idat.vpair) += pot_temp;
+
+    (*(idat.pot))[VANDERWAALS_FAMILY] += *(idat.sw) * pot_temp;
+    if (idat.isSelected)
+      (*(idat.selePot))[VANDERWAALS_FAMILY] += *(idat.sw) * pot_temp;
+
+    *(idat.f1) += *(idat.d) * (*(idat.sw) * *(idat.vdwMult) * myDudrOverR);
+
+    return true;
+  }
+
+  bool VanDerWaalsTable::calcForceBatch(PairBatch &batch) {
+
+    const PairTable& table = tables_[pairIndex_[batch.atid1][batch.atid2]];
+    const int n = batch.n;
+    const RealType* rij = &batch.rij[0];
+    const RealType* sw = &batch.sw[0];
+    const RealType* vdwMult = &batch.vdwMult[0];
+    RealType* vpair = &batch.vpair[0];
+    RealType* fr = &batch.fr[0];
+    const RealType sMin = table.sMin;
+    const RealType sMax = table.sMin + table.nBins * spacing_;
+    const RealType* coeff = &coefficients_[table.offset];
+    const int lastBin = table.nBins - 1;
+    const RealType invSpacing = invSpacing_;
+
+    for (int k = 0; k < n; k++) {
+      RealType s = rij[k] * rij[k];
+      if (s < sMin || s > sMax) return false;
+    }
+
+    if (order_ == 3) {
+#pragma omp simd
+      for (int k = 0; k < n; k++) {
+        RealType x = (rij[k] * rij[k] - sMin) * invSpacing;
+        int bin = min(int(x), lastBin);
+        RealType u, du;
+        evaluatePolynomial<3>(coeff + 4 * bin, x - bin, u, du);
+        RealType scale = vdwMult[k];
+        vpair[k] = scale * u;
+        fr[k] = sw[k] * scale * 2.0 * du * invSpacing;
+      }
+    } else {
+#pragma omp simd
+      for (int k = 0; k < n; k++) {
+        RealType x = (rij[k] * rij[k] - sMin) * invSpacing;
+        int bin = min(int(x), lastBin);
+        RealType u, du;
+        evaluatePolynomial<5>(coeff + 6 * bin, x - bin, u, du);
+        RealType scale = vdwMult[k];
+        vpair[k] = scale * u;
+        fr[k] = sw[k] * scale * 2.0 * du * invSpacing;
+      }
+    }
+    return true;
+  }
+
+  void VanDerWaalsTable::report() {
+    for (unsigned int i = 0; i < tables_.size(); i++) {
+      PairTable& table = tables_[i];
+      sprintf( painCave.errMsg,
+               "VanDerWaalsTable: %s tabulated from %.3f to %.3f Angstroms\n"
+               "\tin %d intervals; max |dU| = %.3g kcal/mol,\n"
+               "\tmax |dF| = %.3g kcal/mol/A, rms relative force error = %.3g\n",
+               table.name.c_str(), sqrt(table.sMin), rcut_, table.nBins, 
+               table.maxPotErr, table.maxFrcErr, table.rmsRelErr);
+      painCave.severity = OPENMD_INFO;
+      painCave.isFatal = 0;
+      simError();
+    }
+  }
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+ 
+#ifndef NONBONDED_VANDERWAALSTABLE_HPP
+#define NONBONDED_VANDERWAALSTABLE_HPP
+
+#include "nonbonded/NonBondedInteraction.hpp"
+#include "types/AtomType.hpp"
+
+using namespace std;
+namespace OpenMD {
+
+  /**
+   * @class VanDerWaalsTable
+   *
+   * Tabulated van der Waals interactions for pairs of atom types.
+   *
+   * For each tabulated pair, the sum of the analytic van der Waals
+   * interactions (including any shifted potential or shifted force
+   * correction at the cutoff) is sampled on a uniform grid in r^2
+   * and stored as one cubic or quintic Hermite polynomial per grid
+   * interval.  The polynomials for all pairs share one coefficient
+   * array, so every pair is evaluated by the same kernel.  The
+   * force comes from the derivative of the same polynomial, so
+   * tabulated energies and forces are consistent.
+   *
+   * Switching is not tabulated: the switching function depends on
+   * the separation of the cutoff groups, so it is applied through
+   * idat.sw exactly as in the analytic interactions.  Separations
+   * outside the tabulated range are left to the analytic forms.
+   */
+  class VanDerWaalsTable {
+
+  public:
+    /**
+     * @param nTypes number of AtomType idents in the force field
+     * @param rcut cutoff radius (the top of the table)
+     * @param shiftedPot tabulate the shifted potential
+     * @param shiftedForce tabulate the shifted force potential
+     * @param spacing grid spacing in r^2 (Angstroms^2)
+     * @param order polynomial order (3 or 5)
+     */
+    VanDerWaalsTable(int nTypes, RealType rcut, bool shiftedPot,
+                     bool shiftedForce, RealType spacing, int order);
+
+    /**
+     * Tabulates the sum of interactions for a pair of atom types.
+     * The interactions must not depend on orientations.
+     */
+    void addPair(AtomType* atype1, AtomType* atype2, 
+                 vector<NonBondedInteraction*>& interactions);
+
+    bool isTabulated(int atid1, int atid2) {
+      return pairIndex_[atid1][atid2] != -1;
+    }
+
+    /**
+     * Tabulated replacement for the van der Waals calcForce calls.
+     * @return false (and nothing is added) if rij is outside the
+     * table
+     */
+    bool calcForce(InteractionData &idat);
+
+    /**
+     * Tabulated replacement for LJ::calcForceBatch.
+     * @return false (and nothing is written) if any rij in the batch
+     * is outside the table
+     */
+    bool calcForceBatch(PairBatch &batch);
+
+    /** Reports the accuracy of each tabulated pair. */
+    void report();
+
+  private:
+    struct PairTable {
+      string name;         /**< names of the two atom types */
+      RealType sMin;       /**< r^2 at the start of the table */
+      int nBins;           /**< number of grid intervals */
+      int offset;          /**< index of the first coefficient */
+      RealType maxPotErr;  /**< largest energy error (kcal/mol) */
+      RealType maxFrcErr;  /**< largest error in dU/dr (kcal/mol/A) */
+      RealType rmsRelErr;  /**< rms error in dU/dr relative to rms dU/dr */
+    };
+
+    void evaluate(int atid1, int atid2, 
+                  vector<NonBondedInteraction*>& interactions,
+                  RealType r, RealType &pot, RealType &dudr);
+    void lookup(const PairTable& table, RealType s, RealType &pot, 
+                RealType &dudrOverR);
+
+    RealType rcut_;
+    bool shiftedPot_;
+    bool shiftedForce_;
+    RealType spacing_;
+    RealType invSpacing_;
+    int order_;
+    int nCoeff_;
+    vector<vector<int> > pairIndex_;  /**< AtomType idents -> table, or -1 */
+    vector<PairTable> tables_;
+    vector<RealType> coefficients_;   /**< nCoeff_ per interval, all pairs */
+  };
+}
+#endif
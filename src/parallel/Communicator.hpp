@@ -52,6 +52,7 @@
 #include <config.h>
 #include <mpi.h>
 #include "math/SquareMatrix3.hpp"
+#include "math/Vector3Array.hpp"
 
 using namespace std;
 namespace OpenMD{
@@ -173,6 +174,8 @@ namespace OpenMD{
       for (int i = 0; i < nCommProcs; i++) {
         size_ += counts[i];
       }
+
+      componentGeometry(componentCounts_, componentDisplacements_);
     }
 
     
@@ -199,17 +202,301 @@ namespace OpenMD{
                          MPITraits<T>::Type(), MPI_SUM, myComm);
     }
     
+    /**
+     * Vector3Array versions of gather and scatter.  Arrays of
+     * structures are sent as a block, just like the vector versions.
+     * A structure of arrays is sent one component at a time.
+     */
+    void gather(Vector3dArray& v1, Vector3dArray& v2) {
+      if (v1.getLayout() != v2.getLayout()) {
+        Vector3dArray tmp(v1);
+        tmp.setLayout(v2.getLayout());
+        gather(tmp, v2);
+        return;
+      }
+      if (v1.getLayout() == Vector3dArray::ArrayOfStructures) {
+        MPI_Allgatherv(v1.data(), planSize_, MPITraits<T>::Type(), 
+                       v2.data(), &counts[0], &displacements[0], 
+                       MPITraits<T>::Type(), myComm);
+      } else {
+        vector<int> c, d;
+        componentGeometry(c, d);
+        for (int k = 0; k < 3; k++) 
+          MPI_Allgatherv(v1.component(k), planSize_ / 3, 
+                         MPITraits<RealType>::Type(), v2.component(k), 
+                         &c[0], &d[0], MPITraits<RealType>::Type(), myComm);
+      }
+    }
+
+    void scatter(Vector3dArray& v1, Vector3dArray& v2) {
+      if (v1.getLayout() != v2.getLayout()) {
+        Vector3dArray tmp(v2);
+        tmp.setLayout(v1.getLayout());
+        scatter(v1, tmp);
+        tmp.setLayout(v2.getLayout());
+        v2 = tmp;
+        return;
+      }
+      if (v1.getLayout() == Vector3dArray::ArrayOfStructures) {
+        MPI_Reduce_scatter(v1.data(), v2.data(), &counts[0], 
+                           MPITraits<T>::Type(), MPI_SUM, myComm);
+      } else {
+        vector<int> c, d;
+        componentGeometry(c, d);
+        for (int k = 0; k < 3; k++) 
+          MPI_Reduce_scatter(v1.component(k), v2.component(k), &c[0],
+                             MPITraits<RealType>::Type(), MPI_SUM, myComm);
+      }
+    }
+
+    /**
+     * Non-blocking versions of gather and scatter.  The requests are
+     * appended to the list, and neither vector may be touched until
+     * they have completed.  Vector3dArrays with different layouts on
+     * the two sides need a temporary copy, so they fall back to the
+     * blocking versions.
+     */
+    void igather(vector<T>& v1, vector<T>& v2,
+                 vector<MPI_Request>& requests) {
+      MPI_Request request;
+      MPI_Iallgatherv(&v1[0], planSize_, MPITraits<T>::Type(),
+                      &v2[0], &counts[0], &displacements[0],
+                      MPITraits<T>::Type(), myComm, &request);
+      requests.push_back(request);
+    }
+
+    void iscatter(vector<T>& v1, vector<T>& v2,
+                  vector<MPI_Request>& requests) {
+      MPI_Request request;
+      MPI_Ireduce_scatter(&v1[0], &v2[0], &counts[0],
+                          MPITraits<T>::Type(), MPI_SUM, myComm, &request);
+      requests.push_back(request);
+    }
+
+    void igather(Vector3dArray& v1, Vector3dArray& v2,
+                 vector<MPI_Request>& requests) {
+      if (v1.getLayout() != v2.getLayout()) {
+        gather(v1, v2);
+        return;
+      }
+      MPI_Request request;
+      if (v1.getLayout() == Vector3dArray::ArrayOfStructures) {
+        MPI_Iallgatherv(v1.data(), planSize_, MPITraits<T>::Type(),
+                        v2.data(), &counts[0], &displacements[0],
+                        MPITraits<T>::Type(), myComm, &request);
+        requests.push_back(request);
+      } else {
+        for (int k = 0; k < 3; k++) {
+          MPI_Iallgatherv(v1.component(k), planSize_ / 3,
+                          MPITraits<RealType>::Type(), v2.component(k),
+                          &componentCounts_[0], &componentDisplacements_[0],
+                          MPITraits<RealType>::Type(), myComm, &request);
+          requests.push_back(request);
+        }
+      }
+    }
+
+    void iscatter(Vector3dArray& v1, Vector3dArray& v2,
+                  vector<MPI_Request>& requests) {
+      if (v1.getLayout() != v2.getLayout()) {
+        scatter(v1, v2);
+        return;
+      }
+      MPI_Request request;
+      if (v1.getLayout() == Vector3dArray::ArrayOfStructures) {
+        MPI_Ireduce_scatter(v1.data(), v2.data(), &counts[0],
+                            MPITraits<T>::Type(), MPI_SUM, myComm, &request);
+        requests.push_back(request);
+      } else {
+        for (int k = 0; k < 3; k++) {
+          MPI_Ireduce_scatter(v1.component(k), v2.component(k),
+                              &componentCounts_[0],
+                              MPITraits<RealType>::Type(), MPI_SUM, myComm,
+                              &request);
+          requests.push_back(request);
+        }
+      }
+    }
+
     int getSize() {
       return size_;
     }
-    
+
   private:
+    /** counts and displacements of a single component of a vector */
+    void componentGeometry(vector<int>& c, vector<int>& d) {
+      c.resize(counts.size());
+      d.resize(displacements.size());
+      for (unsigned int i = 0; i < counts.size(); i++) {
+        c[i] = counts[i] / 3;
+        d[i] = displacements[i] / 3;
+      }
+    }
+
     int planSize_;     ///< how many are on local proc
     int size_;
     vector<int> counts;
     vector<int> displacements;
+    /** per-component geometry, kept alive for non-blocking calls */
+    vector<int> componentCounts_;
+    vector<int> componentDisplacements_;
     MPI_Comm myComm;
-  }; 
+  };
+
+
+  /**
+   * @class ExchangePlan
+   *
+   * A point-to-point exchange between the objects on this processor
+   * and copies of them held by other processors.  Each local object
+   * may be sent to any number of processors (including this one).
+   * The copies received from other processors are stored
+   * contiguously, ordered by the rank of the sending processor and
+   * then by the order of the sender's index list.
+   *
+   * gather() sends the local values out to the copies, and scatter()
+   * sends values from the copies back, summing them into the local
+   * objects.  Only processors that actually share objects talk to
+   * each other.
+   */
+  class ExchangePlan {
+  public:
+
+    ExchangePlan(MPI_Comm comm, const vector<vector<int> >& sendIndices) :
+      myComm(comm) {
+
+      int nCommProcs;
+      MPI_Comm_size( myComm, &nCommProcs );
+
+      vector<int> sendCounts(nCommProcs, 0);
+      vector<int> recvCounts(nCommProcs, 0);
+      for (int i = 0; i < nCommProcs; i++)
+        sendCounts[i] = sendIndices[i].size();
+
+      MPI_Alltoall(&sendCounts[0], 1, MPI_INT, &recvCounts[0], 1, MPI_INT,
+                   myComm);
+
+      int nSend = 0;
+      for (int i = 0; i < nCommProcs; i++) {
+        if (sendCounts[i] > 0) {
+          sendProcs_.push_back(i);
+          sendCounts_.push_back(sendCounts[i]);
+          sendOffsets_.push_back(nSend);
+          indices_.insert(indices_.end(), sendIndices[i].begin(),
+                          sendIndices[i].end());
+          nSend += sendCounts[i];
+        }
+      }
+
+      size_ = 0;
+      for (int i = 0; i < nCommProcs; i++) {
+        if (recvCounts[i] > 0) {
+          recvProcs_.push_back(i);
+          recvCounts_.push_back(recvCounts[i]);
+          recvOffsets_.push_back(size_);
+          size_ += recvCounts[i];
+        }
+      }
+      requests_.resize(sendProcs_.size() + recvProcs_.size());
+    }
+
+    /** number of copies held by this processor */
+    int getSize() { return size_; }
+
+    /** number of processors this one exchanges data with */
+    int getNumberOfPeers() {
+      return max(int(sendProcs_.size()), int(recvProcs_.size()));
+    }
+
+    template<typename T>
+    void gather(vector<T>& v1, vector<T>& v2) {
+      vector<T> sendBuffer(indices_.size());
+      for (unsigned int k = 0; k < indices_.size(); k++)
+        sendBuffer[k] = v1[indices_[k]];
+      exchange(sendBuffer.empty() ? NULL : &sendBuffer[0],
+               v2.empty() ? NULL : &v2[0], false);
+    }
+
+    template<typename T>
+    void scatter(vector<T>& v1, vector<T>& v2) {
+      vector<T> recvBuffer(indices_.size());
+      exchange(recvBuffer.empty() ? NULL : &recvBuffer[0],
+               v1.empty() ? NULL : &v1[0], true);
+      for (unsigned int k = 0; k < indices_.size(); k++)
+        v2[indices_[k]] += recvBuffer[k];
+    }
+
+    /**
+     * Vector3Array versions of gather and scatter.  The values are
+     * packed into a contiguous buffer whatever the array layout.
+     */
+    void gather(Vector3dArray& v1, Vector3dArray& v2) {
+      vector<Vector3d> sendBuffer(indices_.size());
+      vector<Vector3d> recvBuffer(size_);
+      for (unsigned int k = 0; k < indices_.size(); k++)
+        sendBuffer[k] = v1[indices_[k]];
+      exchange(sendBuffer.empty() ? NULL : &sendBuffer[0],
+               recvBuffer.empty() ? NULL : &recvBuffer[0], false);
+      for (int k = 0; k < size_; k++)
+        v2[k] = recvBuffer[k];
+    }
+
+    void scatter(Vector3dArray& v1, Vector3dArray& v2) {
+      vector<Vector3d> sendBuffer(size_);
+      vector<Vector3d> recvBuffer(indices_.size());
+      for (int k = 0; k < size_; k++)
+        sendBuffer[k] = v1[k];
+      exchange(recvBuffer.empty() ? NULL : &recvBuffer[0],
+               sendBuffer.empty() ? NULL : &sendBuffer[0], true);
+      for (unsigned int k = 0; k < indices_.size(); k++)
+        v2[indices_[k]] += recvBuffer[k];
+    }
+
+  private:
+    /**
+     * Moves data between the packed local buffer and the copies.  In
+     * the forward direction, local values go out to the copies; in
+     * reverse, the copies come back into the local buffer.
+     */
+    template<typename T>
+    void exchange(T* local, T* copies, bool reverse) {
+      MPI_Datatype type = MPITraits<T>::Type();
+      int length = MPITraits<T>::Length();
+      int nReq = 0;
+
+      for (unsigned int i = 0; i < recvProcs_.size(); i++) {
+        T* buf = copies + recvOffsets_[i];
+        if (reverse)
+          MPI_Isend(buf, recvCounts_[i] * length, type, recvProcs_[i], 0,
+                    myComm, &requests_[nReq++]);
+        else
+          MPI_Irecv(buf, recvCounts_[i] * length, type, recvProcs_[i], 0,
+                    myComm, &requests_[nReq++]);
+      }
+      for (unsigned int i = 0; i < sendProcs_.size(); i++) {
+        T* buf = local + sendOffsets_[i];
+        if (reverse)
+          MPI_Irecv(buf, sendCounts_[i] * length, type, sendProcs_[i], 0,
+                    myComm, &requests_[nReq++]);
+        else
+          MPI_Isend(buf, sendCounts_[i] * length, type, sendProcs_[i], 0,
+                    myComm, &requests_[nReq++]);
+      }
+      if (nReq > 0)
+        MPI_Waitall(nReq, &requests_[0], MPI_STATUSES_IGNORE);
+    }
+
+    int size_;
+    vector<int> indices_;       ///< local objects, packed by destination
+    vector<int> sendProcs_;
+    vector<int> sendCounts_;
+    vector<int> sendOffsets_;
+    vector<int> recvProcs_;
+    vector<int> recvCounts_;
+    vector<int> recvOffsets_;
+    vector<MPI_Request> requests_;
+    MPI_Comm myComm;
+  };
 
 #endif
 }
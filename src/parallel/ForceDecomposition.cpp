@@ -50,7 +50,7 @@
 using namespace std;
 namespace OpenMD {
 
-  ForceDecomposition::ForceDecomposition(SimInfo* info, InteractionManager* iMan) : info_(info), interactionMan_(iMan), needVelocities_(false) {
+  ForceDecomposition::ForceDecomposition(SimInfo* info, InteractionManager* iMan) : info_(info), interactionMan_(iMan), nThreads_(1), needVelocities_(false), nSubCells_(2), nCells_(0, 0, 0), nNeighborListBuilds_(0), neighborListTime_(0.0), pairLoopTime_(0.0), autoTuneSkin_(false), nTuneCycles_(4), tuneCycle_(0), tuneSteps_(0), tuneStart_(-1.0), tuneFactor_(1.25), tuneDirection_(1), bestSkin_(0.0), bestCost_(-1.0) {
 
     sman_ = info_->getSnapshotManager();
     storageLayout_ = sman_->getStorageLayout();
@@ -76,25 +76,109 @@ namespace OpenMD {
       painCave.severity = OPENMD_INFO;
       painCave.isFatal = 0;
       simError();
-    }             
+    }
+    autoTuneSkin_ = simParams_->getAutoTuneSkinThickness();
+  }
 
-    // cellOffsets are the partial space for the cell lists used in
-    // constructing the neighbor lists
+  /**
+   * Builds the stencil of cell offsets that must be visited around
+   * each cell.  Cells are a fraction (1/nSubCells_) of rList wide, so
+   * the stencil reaches nSubCells_ cells in each direction, and cells
+   * which can't hold a pair closer than rList are dropped.  In small
+   * boxes, the offsets are folded back into the box so that no cell
+   * is visited twice.
+   *
+   * With halfShell, only one of each pair of offsets (o, -o) is kept
+   * so every pair of cells is visited once.  Offsets that are their
+   * own inverse (the home cell, and half-way across an even number of
+   * cells) are flagged in orderedOffset_, and only pairs with j2 >= j1
+   * should be kept for these.
+   */
+  void ForceDecomposition::buildCellStencil(const Vector3d& widths,
+                                            bool orthoRhombic, 
+                                            bool halfShell) {
     cellOffsets_.clear();
-    cellOffsets_.push_back( Vector3i(0, 0, 0) );
-    cellOffsets_.push_back( Vector3i(1, 0, 0) );
-    cellOffsets_.push_back( Vector3i(1, 1, 0) );
-    cellOffsets_.push_back( Vector3i(0, 1, 0) );
-    cellOffsets_.push_back( Vector3i(-1,1, 0) );
-    cellOffsets_.push_back( Vector3i(0, 0, 1) );
-    cellOffsets_.push_back( Vector3i(1, 0, 1) );
-    cellOffsets_.push_back( Vector3i(1, 1, 1) );
-    cellOffsets_.push_back( Vector3i(0, 1, 1) );
-    cellOffsets_.push_back( Vector3i(-1,1, 1) );
-    cellOffsets_.push_back( Vector3i(-1,0, 1) );
-    cellOffsets_.push_back( Vector3i(-1,-1,1) );
-    cellOffsets_.push_back( Vector3i(0, -1,1) );
-    cellOffsets_.push_back( Vector3i(1, -1,1) );
+    orderedOffset_.clear();
+
+    int lo[3], hi[3];
+    for (int d = 0; d < 3; d++) {
+      if (nCells_[d] >= 2 * nSubCells_ + 1) {
+        lo[d] = -nSubCells_;
+        hi[d] = nSubCells_;
+      } else {
+        // every cell, using the offset of smallest magnitude:
+        lo[d] = -((nCells_[d] - 1) / 2);
+        hi[d] = nCells_[d] / 2;
+      }
+    }
+
+    for (int i = lo[0]; i <= hi[0]; i++) {
+      for (int j = lo[1]; j <= hi[1]; j++) {
+        for (int k = lo[2]; k <= hi[2]; k++) {
+          Vector3i o(i, j, k);
+
+          // closest approach of two cells separated by this offset:
+          RealType gap, sum(0.0), largest(0.0);
+          for (int d = 0; d < 3; d++) {
+            gap = max(abs(o[d]) - 1, 0) * widths[d] / nCells_[d];
+            sum += gap * gap;
+            largest = max(largest, gap);
+          }
+          RealType closest = orthoRhombic ? sqrt(sum) : largest;
+          if (closest >= rList_) continue;
+
+          // the inverse offset, folded back into the stencil's range:
+          Vector3i inv;
+          for (int d = 0; d < 3; d++) {
+            inv[d] = -o[d];
+            if (inv[d] > hi[d]) inv[d] -= nCells_[d];
+            if (inv[d] < lo[d]) inv[d] += nCells_[d];
+          }
+          bool selfInverse = (inv == o);
+
+          if (halfShell && !selfInverse) {
+            // keep the lexically larger of o and -o:
+            if (o[2] != inv[2]) {
+              if (o[2] < inv[2]) continue;
+            } else if (o[1] != inv[1]) {
+              if (o[1] < inv[1]) continue;
+            } else if (o[0] < inv[0]) continue;
+          }
+
+          cellOffsets_.push_back(o);
+          orderedOffset_.push_back(halfShell && selfInverse);
+        }
+      }
+    }
+  }
+
+  /**
+   * Numbers the cells along a Morton (Z-order) curve so that cells
+   * which are close in space are also close in the cell list.
+   */
+  void ForceDecomposition::buildCellSlots() {
+    int nCtot = nCells_.x() * nCells_.y() * nCells_.z();
+    vector<pair<unsigned long long, int> > keys(nCtot);
+
+    for (int k = 0; k < nCells_.z(); k++) {
+      for (int j = 0; j < nCells_.y(); j++) {
+        for (int i = 0; i < nCells_.x(); i++) {
+          unsigned long long key = 0;
+          for (int b = 0; b < 21; b++) {
+            key |= ((unsigned long long)((i >> b) & 1)) << (3 * b);
+            key |= ((unsigned long long)((j >> b) & 1)) << (3 * b + 1);
+            key |= ((unsigned long long)((k >> b) & 1)) << (3 * b + 2);
+          }
+          int c = Vlinear(Vector3i(i, j, k), nCells_);
+          keys[c] = make_pair(key, c);
+        }
+      }
+    }
+    sort(keys.begin(), keys.end());
+
+    cellSlot_.resize(nCtot);
+    for (int s = 0; s < nCtot; s++)
+      cellSlot_[keys[s].second] = s;
   }
 
   void ForceDecomposition::setCutoffRadius(RealType rcut) {
@@ -152,32 +236,127 @@ namespace OpenMD {
     }
   }
 
+  /**
+   * Returns the largest squared displacement between two arrays of
+   * positions.  Stride is the distance between successive values of
+   * one component (1 for a structure of arrays, where the loop can be
+   * vectorized).
+   */
+  template<int Stride>
+  static RealType maxDisplacementSquared(Vector3dArray& pos, 
+                                         Vector3dArray& saved, int n,
+                                         int nThreads) {
+    const RealType* x = pos.component(0);
+    const RealType* y = pos.component(1);
+    const RealType* z = pos.component(2);
+    const RealType* sx = saved.component(0);
+    const RealType* sy = saved.component(1);
+    const RealType* sz = saved.component(2);
+    RealType dispmax = 0.0;
+
+#pragma omp parallel for simd num_threads(nThreads) schedule(static) reduction(max:dispmax)
+    for (int i = 0; i < n; i++) {
+      RealType dx = x[i * Stride] - sx[i * Stride];
+      RealType dy = y[i * Stride] - sy[i * Stride];
+      RealType dz = z[i * Stride] - sz[i * Stride];
+      RealType d2 = dx * dx + dy * dy + dz * dz;
+      dispmax = (d2 > dispmax) ? d2 : dispmax;
+    }
+    return dispmax;
+  }
+
   bool ForceDecomposition::checkNeighborList() {
     RealType st2 = pow( skinThickness_ / 2.0, 2);
-    std::size_t nGroups = snap_->cgData.position.size();
+    int nGroups = snap_->cgData.position.size();
     if (needVelocities_) 
       snap_->cgData.setStorageLayout(DataStorage::dslPosition |
-                                     DataStorage::dslVelocity);
-    
+                                     DataStorage::dslVelocity |
+                                     (storageLayout_ & 
+                                      DataStorage::dslStructureOfArrays));
+
+    if (autoTuneSkin_) tuneSteps_++;
+
     // if we have changed the group identities or haven't set up the
     // saved positions we automatically will need a neighbor list update:
     
-    if ( saved_CG_positions_.size() != nGroups ) return true;
+    if ( int(saved_CG_positions_.size()) != nGroups ) return true;
 
-    RealType dispmax = 0.0;
-    Vector3d disp;    
+    Vector3dArray& pos = snap_->cgData.position;
+    if (saved_CG_positions_.getLayout() != pos.getLayout())
+      saved_CG_positions_.setLayout(pos.getLayout());
 
-    for (std::size_t i = 0; i < nGroups; i++) {
-      disp = snap_->cgData.position[i]  - saved_CG_positions_[i];
-      dispmax = max(dispmax, disp.lengthSquare());
-    }
+    RealType dispmax;
+    if (pos.stride() == 1)
+      dispmax = maxDisplacementSquared<1>(pos, saved_CG_positions_, nGroups,
+                                          nThreads_);
+    else
+      dispmax = maxDisplacementSquared<3>(pos, saved_CG_positions_, nGroups,
+                                          nThreads_);
 
 #ifdef IS_MPI
     MPI_Allreduce(MPI_IN_PLACE, &dispmax, 1, MPI_REALTYPE, MPI_MAX, 
                   MPI_COMM_WORLD);
 #endif
 
-    return (dispmax > st2) ? true : false;
+    bool update = (dispmax > st2);
+    if (update && autoTuneSkin_) tuneSkinThickness(wallTime());
+    return update;
+  }
+
+  void ForceDecomposition::tuneSkinThickness(RealType now) {
+    // the first build just starts the clock:
+    if (tuneStart_ < 0.0) {
+      tuneStart_ = now;
+      tuneSteps_ = 0;
+      return;
+    }
+
+    tuneCycle_++;
+    if (tuneCycle_ < nTuneCycles_) return;
+
+    // every processor has to make the same decision, so use the
+    // slowest one's timing:
+    RealType cost = (now - tuneStart_) / RealType(max(tuneSteps_, 1));
+#ifdef IS_MPI
+    MPI_Allreduce(MPI_IN_PLACE, &cost, 1, MPI_REALTYPE, MPI_MAX, 
+                  MPI_COMM_WORLD);
+#endif
+
+    if (bestCost_ < 0.0 || cost < bestCost_) {
+      bestCost_ = cost;
+      bestSkin_ = skinThickness_;
+    } else {
+      // overshot the minimum, so turn around with a smaller step
+      tuneDirection_ = -tuneDirection_;
+      tuneFactor_ = sqrt(tuneFactor_);
+    }
+
+    RealType skin = bestSkin_ * pow(tuneFactor_, tuneDirection_);
+    // keep the skin between a small fraction of the cutoff and the
+    // cutoff itself:
+    if (skin < 0.05 * rCut_ || skin > rCut_) {
+      tuneDirection_ = -tuneDirection_;
+      tuneFactor_ = sqrt(tuneFactor_);
+      skin = bestSkin_ * pow(tuneFactor_, tuneDirection_);
+    }
+
+    if (tuneFactor_ < 1.02) {
+      autoTuneSkin_ = false;
+      skin = bestSkin_;
+      sprintf(painCave.errMsg,
+              "ForceDecomposition: skinThickness was tuned to %f Angstroms\n"
+              "\t(%g seconds per step).\n", bestSkin_, bestCost_);
+      painCave.severity = OPENMD_INFO;
+      painCave.isFatal = 0;
+      simError();
+    }
+
+    skinThickness_ = skin;
+    setCutoffRadius(rCut_);
+
+    tuneCycle_ = 0;
+    tuneSteps_ = 0;
+    tuneStart_ = now;
   }
 
   void ForceDecomposition::addToHeatFlux(Vector3d hf) {
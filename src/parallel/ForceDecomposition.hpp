@@ -52,6 +52,29 @@
 using namespace std;
 namespace OpenMD { 
 
+  /**
+   * @class AtomSpan
+   *
+   * A read-only view of a contiguous run of atom indices.  The atoms
+   * belonging to each cutoff group are stored in compressed (offset /
+   * index) form by the decomposition, and an AtomSpan points into that
+   * storage so the pair loop can walk a group without copying it.
+   */
+  class AtomSpan {
+  public:
+    AtomSpan() : first_(NULL), size_(0) {}
+    AtomSpan(const int* first, int size) : first_(first), size_(size) {}
+
+    const int* begin() const { return first_; }
+    const int* end() const { return first_ + size_; }
+    int size() const { return size_; }
+    int operator[](int i) const { return first_[i]; }
+
+  private:
+    const int* first_;
+    int size_;
+  };
+
   /**
    * @class ForceDecomposition 
    *
@@ -66,7 +89,8 @@ namespace OpenMD {
    * local processor, data must be exchanged among the processors.
    * This can happen at different times in the calculation:
    *
-   *  distributeInitialData      (parallel communication - one time only)
+   *  distributeInitialData      (parallel communication - at setup, and
+   *                              again if the local atoms are renumbered)
    *  distributeData             (parallel communication - every ForceLoop)
    *
    *  loop iLoop over nLoops     (nLoops may be 1, 2, or until self consistent)
@@ -89,6 +113,13 @@ namespace OpenMD {
    * ForceDecomposition provides the interface for ForceLoop to do the
    * communication steps and to iterate using the correct set of atoms
    * and cutoff groups.
+   *
+   * distributeData and collectData may also be split into start and
+   * finish calls.  A decomposition that can send its data in the
+   * background returns from the start call with the messages in
+   * flight, and the caller is free to do unrelated work before the
+   * finish call.  The default start call does the whole blocking
+   * exchange.
    */
   class ForceDecomposition {
   public:
@@ -103,6 +134,17 @@ namespace OpenMD {
     virtual void distributeIntermediateData() = 0;
     virtual void collectData() = 0;
     virtual void collectSelfData() = 0;
+
+    virtual void startDistributeData() { distributeData(); }
+    virtual void finishDistributeData() {}
+    virtual void startCollectData() { collectData(); }
+    virtual void finishCollectData() {}
+
+    // threaded pair loop support
+    virtual void setNumberOfThreads(int nThreads) { nThreads_ = nThreads; }
+    int getNumberOfThreads() { return nThreads_; }
+    virtual void collectThreadIntermediateData() = 0;
+    virtual void collectThreadData() = 0;
     virtual potVec* getSelfPotential() { return &selfPot; }
     virtual potVec* getPairwisePotential() { return &pairwisePot; }
     virtual potVec* getExcludedPotential() { return &excludedPot; }
@@ -113,15 +155,21 @@ namespace OpenMD {
     // neighbor list routines
     virtual bool checkNeighborList();
     virtual void buildNeighborList(vector<int>& neighborList, vector<int>& point) = 0;
+    int getNeighborListBuilds() { return nNeighborListBuilds_; }
+    RealType getNeighborListTime() { return neighborListTime_; }
+    RealType getSkinThickness() { return skinThickness_; }
+
+    /** the wall time of each pair loop, for load balancing */
+    void addPairLoopTime(RealType t) { pairLoopTime_ += t; }
 
     void setCutoffRadius(RealType rCut);
     
     // group bookkeeping
-    virtual Vector3d& getGroupVelocityColumn(int atom2) = 0;
+    virtual Vector3d getGroupVelocityColumn(int atom2) = 0;
 
     // Group->atom bookkeeping
-    virtual vector<int>& getAtomsInGroupRow(int cg1) = 0; 
-    virtual vector<int>& getAtomsInGroupColumn(int cg2) = 0;
+    virtual AtomSpan getAtomsInGroupRow(int cg1) = 0; 
+    virtual AtomSpan getAtomsInGroupColumn(int cg2) = 0;
 
     virtual Vector3d getAtomToGroupVectorRow(int atom1, int cg1) = 0;
     virtual Vector3d getAtomToGroupVectorColumn(int atom2, int cg2) = 0;
@@ -140,15 +188,18 @@ namespace OpenMD {
     virtual int getGlobalIDRow(int atom1) = 0;
     virtual int getGlobalIDCol(int atom2) = 0;
     virtual int getGlobalID(int atom1) = 0;
+    virtual int getIdentRow(int atom1) = 0;
+    virtual int getIdentCol(int atom2) = 0;
     
     virtual int getTopologicalDistance(int atom1, int atom2) = 0;
-    virtual void addForceToAtomRow(int atom1, Vector3d fg) = 0;
-    virtual void addForceToAtomColumn(int atom2, Vector3d fg) = 0;
-    virtual Vector3d& getAtomVelocityColumn(int atom2) = 0;
+    virtual void addForceToAtomRow(int atom1, Vector3d fg, int tid = 0) = 0;
+    virtual void addForceToAtomColumn(int atom2, Vector3d fg, int tid = 0) = 0;
+    virtual Vector3d getAtomVelocityColumn(int atom2) = 0;
 
     // filling interaction blocks with pointers
-    virtual void fillInteractionData(InteractionData &idat, int atom1, int atom2, bool newAtom1 = true) = 0;
-    virtual void unpackInteractionData(InteractionData &idat, int atom1, int atom2) = 0;
+    virtual void fillInteractionData(InteractionData &idat, int atom1, int atom2, bool newAtom1 = true, int tid = 0) = 0;
+    virtual void unpackInteractionData(InteractionData &idat, int atom1, int atom2, int tid = 0) = 0;
+    virtual void unpackPairBatch(PairBatch &batch, int atom1, bool doParticlePot, int tid = 0) = 0;
 
     virtual void fillSelfData(SelfData &sdat, int atom1);
 
@@ -163,6 +214,7 @@ namespace OpenMD {
     InteractionManager* interactionMan_;
 
     int storageLayout_;
+    int nThreads_;     /**< number of threads sharing the pair loop */
     bool needVelocities_;
     bool usePeriodicBoundaryConditions_;
     RealType skinThickness_;   /**< Verlet neighbor list skin thickness */
@@ -191,14 +243,59 @@ namespace OpenMD {
     vector<vector<int> > toposForAtom; 
     vector<vector<int> > topoDist;                                       
     vector<vector<int> > excludesForAtom;
-    vector<vector<int> > groupList_;
+    /** 
+     * Group membership in compressed form: the atoms in group i are
+     * groupAtoms_[groupOffsets_[i]] ... groupAtoms_[groupOffsets_[i+1]-1]
+     */
+    vector<int> groupOffsets_;
+    vector<int> groupAtoms_;
     vector<RealType> massFactors;
     vector<AtomType*> atypesLocal;
 
-    vector<Vector3i> cellOffsets_;
+    void buildCellStencil(const Vector3d& widths, bool orthoRhombic,
+                          bool halfShell);
+    void buildCellSlots();
+
+    int nSubCells_;             /**< number of cells spanning rList */
     Vector3i nCells_;
-    vector<vector<int> > cellList_;
-    vector<Vector3d> saved_CG_positions_;
+    vector<Vector3i> cellOffsets_;
+    vector<bool> orderedOffset_; /**< offsets where only j2 >= j1 is kept */
+
+    /**
+     * The cell list in compressed form.  Cells are laid out along a
+     * space-filling (Morton) curve: cellSlot_ maps a linear cell index
+     * to its slot, and the groups in slot c are cellGroups_[cellStart_[c]]
+     * ... cellGroups_[cellStart_[c+1]-1], with cellPositions_ holding
+     * their positions in the same order.
+     */
+    vector<int> cellSlot_;
+    vector<int> cellStart_;
+    vector<int> cellGroups_;
+    vector<Vector3d> cellPositions_;
+    Vector3dArray saved_CG_positions_;
+
+    int nNeighborListBuilds_;
+    RealType neighborListTime_; /**< wall time (s) spent building neighbor lists */
+    RealType pairLoopTime_;     /**< pair loop wall time (s) since the last balancing */
+
+    /**
+     * Skin thickness tuning.  The cost of a skin is the wall time per
+     * step between neighbor list builds, averaged over nTuneCycles_
+     * builds.  The skin is scaled by tuneFactor_ while the cost drops;
+     * on a rise the search returns to the best skin, turns around and
+     * narrows the step, stopping once the step is below 2%.
+     */
+    void tuneSkinThickness(RealType now);
+
+    bool autoTuneSkin_;
+    int nTuneCycles_;
+    int tuneCycle_;
+    int tuneSteps_;             /**< steps since the tuning cycle began */
+    RealType tuneStart_;        /**< wall time when the tuning cycle began */
+    RealType tuneFactor_;
+    int tuneDirection_;
+    RealType bestSkin_;
+    RealType bestCost_;
   };    
 }
 #endif
@@ -48,43 +48,32 @@
 using namespace std;
 namespace OpenMD {
 
-  ForceMatrixDecomposition::ForceMatrixDecomposition(SimInfo* info, InteractionManager* iMan) : ForceDecomposition(info, iMan) {
-
-    // Row and colum scans must visit all surrounding cells
-    cellOffsets_.clear();
-    cellOffsets_.push_back( Vector3i(-1,-1,-1) );
-    cellOffsets_.push_back( Vector3i( 0,-1,-1) );
-    cellOffsets_.push_back( Vector3i( 1,-1,-1) );                          
-    cellOffsets_.push_back( Vector3i(-1, 0,-1) );
-    cellOffsets_.push_back( Vector3i( 0, 0,-1) );
-    cellOffsets_.push_back( Vector3i( 1, 0,-1) );
-    cellOffsets_.push_back( Vector3i(-1, 1,-1) );
-    cellOffsets_.push_back( Vector3i( 0, 1,-1) );      
-    cellOffsets_.push_back( Vector3i( 1, 1,-1) );
-    cellOffsets_.push_back( Vector3i(-1,-1, 0) );
-    cellOffsets_.push_back( Vector3i( 0,-1, 0) );
-    cellOffsets_.push_back( Vector3i( 1,-1, 0) );
-    cellOffsets_.push_back( Vector3i(-1, 0, 0) );       
-    cellOffsets_.push_back( Vector3i( 0, 0, 0) );
-    cellOffsets_.push_back( Vector3i( 1, 0, 0) );
-    cellOffsets_.push_back( Vector3i(-1, 1, 0) );
-    cellOffsets_.push_back( Vector3i( 0, 1, 0) );
-    cellOffsets_.push_back( Vector3i( 1, 1, 0) );
-    cellOffsets_.push_back( Vector3i(-1,-1, 1) );
-    cellOffsets_.push_back( Vector3i( 0,-1, 1) );
-    cellOffsets_.push_back( Vector3i( 1,-1, 1) );
-    cellOffsets_.push_back( Vector3i(-1, 0, 1) );
-    cellOffsets_.push_back( Vector3i( 0, 0, 1) );
-    cellOffsets_.push_back( Vector3i( 1, 0, 1) );
-    cellOffsets_.push_back( Vector3i(-1, 1, 1) );
-    cellOffsets_.push_back( Vector3i( 0, 1, 1) );
-    cellOffsets_.push_back( Vector3i( 1, 1, 1) );
+  ForceMatrixDecomposition::ForceMatrixDecomposition(SimInfo* info, InteractionManager* iMan) : ForceDecomposition(info, iMan), threadLayout_(0) {
+#ifdef IS_MPI
+    AtomPlanIntRow = NULL;
+    AtomPlanRealRow = NULL;
+    AtomPlanVectorRow = NULL;
+    AtomPlanMatrixRow = NULL;
+    AtomPlanPotRow = NULL;
+    AtomPlanIntColumn = NULL;
+    AtomPlanRealColumn = NULL;
+    AtomPlanVectorColumn = NULL;
+    AtomPlanMatrixColumn = NULL;
+    AtomPlanPotColumn = NULL;
+    cgPlanIntRow = NULL;
+    cgPlanVectorRow = NULL;
+    cgPlanIntColumn = NULL;
+    cgPlanVectorColumn = NULL;
+#endif
   }
 
 
   /**
    * distributeInitialData is essentially a copy of the older fortran 
-   * SimulationSetup
+   * SimulationSetup.  It is called again whenever the local atoms
+   * and cutoff groups are renumbered, so everything built here is
+   * replaced, and the next force calculation rebuilds the neighbor
+   * list.
    */
   void ForceMatrixDecomposition::distributeInitialData() {
     snap_ = sman_->getCurrentSnapshot();
@@ -102,22 +91,34 @@ namespace OpenMD {
 
     massFactors = info_->getMassFactors();
 
-    PairList* excludes = info_->getExcludedInteractions();
-    PairList* oneTwo = info_->getOneTwoInteractions();
-    PairList* oneThree = info_->getOneThreeInteractions();
-    PairList* oneFour = info_->getOneFourInteractions();
-    
-    if (needVelocities_) 
-      snap_->cgData.setStorageLayout(DataStorage::dslPosition | 
-                                     DataStorage::dslVelocity);
-    else 
-      snap_->cgData.setStorageLayout(DataStorage::dslPosition);
+    saved_CG_positions_.clear();
+
+    // the cutoff groups use the same array layout as the atoms:
+    int cgLayout = DataStorage::dslPosition | 
+      (storageLayout_ & DataStorage::dslStructureOfArrays);
+    if (needVelocities_) cgLayout |= DataStorage::dslVelocity;
+    snap_->cgData.setStorageLayout(cgLayout);
     
 #ifdef IS_MPI
  
     MPI_Comm row = rowComm.getComm();
     MPI_Comm col = colComm.getComm();
 
+    delete AtomPlanIntRow;
+    delete AtomPlanRealRow;
+    delete AtomPlanVectorRow;
+    delete AtomPlanMatrixRow;
+    delete AtomPlanPotRow;
+    delete AtomPlanIntColumn;
+    delete AtomPlanRealColumn;
+    delete AtomPlanVectorColumn;
+    delete AtomPlanMatrixColumn;
+    delete AtomPlanPotColumn;
+    delete cgPlanIntRow;
+    delete cgPlanVectorRow;
+    delete cgPlanIntColumn;
+    delete cgPlanVectorColumn;
+
     AtomPlanIntRow = new Plan<int>(row, nLocal_);
     AtomPlanRealRow = new Plan<RealType>(row, nLocal_);
     AtomPlanVectorRow = new Plan<Vector3d>(row, nLocal_);
@@ -146,14 +147,10 @@ namespace OpenMD {
     atomColData.resize(nAtomsInCol_);
     atomColData.setStorageLayout(storageLayout_);
     cgRowData.resize(nGroupsInRow_);
-    cgRowData.setStorageLayout(DataStorage::dslPosition);
+    cgRowData.setStorageLayout(cgLayout & ~DataStorage::dslVelocity);
     cgColData.resize(nGroupsInCol_);
-    if (needVelocities_)
-      // we only need column velocities if we need them.
-      cgColData.setStorageLayout(DataStorage::dslPosition |
-                                 DataStorage::dslVelocity);
-    else     
-      cgColData.setStorageLayout(DataStorage::dslPosition);
+    // we only need column velocities if we need them.
+    cgColData.setStorageLayout(cgLayout);
       
     identsRow.resize(nAtomsInRow_);
     identsCol.resize(nAtomsInCol_);
@@ -200,112 +197,311 @@ namespace OpenMD {
     AtomPlanRealRow->gather(massFactors, massFactorsRow);
     AtomPlanRealColumn->gather(massFactors, massFactorsCol);
 
-    groupListRow_.clear();
-    groupListRow_.resize(nGroupsInRow_);
-    for (int i = 0; i < nGroupsInRow_; i++) {
-      int gid = cgRowToGlobal[i];
-      for (int j = 0; j < nAtomsInRow_; j++) {
-        int aid = AtomRowToGlobal[j];
-        if (globalGroupMembership[aid] == gid)
-          groupListRow_[i].push_back(j);
-      }      
-    }
-
-    groupListCol_.clear();
-    groupListCol_.resize(nGroupsInCol_);
-    for (int i = 0; i < nGroupsInCol_; i++) {
-      int gid = cgColToGlobal[i];
-      for (int j = 0; j < nAtomsInCol_; j++) {
-        int aid = AtomColToGlobal[j];
-        if (globalGroupMembership[aid] == gid)
-          groupListCol_[i].push_back(j);
-      }      
-    }
-
-    excludesForAtom.clear();
-    excludesForAtom.resize(nAtomsInRow_);
-    toposForAtom.clear();
-    toposForAtom.resize(nAtomsInRow_);
-    topoDist.clear();
-    topoDist.resize(nAtomsInRow_);
-    for (int i = 0; i < nAtomsInRow_; i++) {
-      int iglob = AtomRowToGlobal[i];
-
-      for (int j = 0; j < nAtomsInCol_; j++) {
-        int jglob = AtomColToGlobal[j];
-
-        if (excludes->hasPair(iglob, jglob)) 
-          excludesForAtom[i].push_back(j);       
-        
-        if (oneTwo->hasPair(iglob, jglob)) {
-          toposForAtom[i].push_back(j);
-          topoDist[i].push_back(1);
-        } else {
-          if (oneThree->hasPair(iglob, jglob)) {
-            toposForAtom[i].push_back(j);
-            topoDist[i].push_back(2);
-          } else {
-            if (oneFour->hasPair(iglob, jglob)) {
-              toposForAtom[i].push_back(j);
-              topoDist[i].push_back(3);
-            }
-          }
-        }
-      }      
-    }
+    buildGroupLists(cgRowToGlobal, AtomRowToGlobal, globalGroupMembership,
+                    groupOffsetsRow_, groupAtomsRow_);
+    buildGroupLists(cgColToGlobal, AtomColToGlobal, globalGroupMembership,
+                    groupOffsetsCol_, groupAtomsCol_);
+
+    buildTopology(AtomRowToGlobal, AtomColToGlobal);
 
 #else
-    excludesForAtom.clear();
-    excludesForAtom.resize(nLocal_);
-    toposForAtom.clear();
-    toposForAtom.resize(nLocal_);
-    topoDist.clear();
-    topoDist.resize(nLocal_);
+    buildTopology(AtomLocalToGlobal, AtomLocalToGlobal);
+#endif
+
+    // allocate memory for the parallel objects
+    atypesLocal.resize(nLocal_);
 
-    for (int i = 0; i < nLocal_; i++) {
-      int iglob = AtomLocalToGlobal[i];
+    for (int i = 0; i < nLocal_; i++) 
+      atypesLocal[i] = ff_->getAtomType(idents[i]);
 
-      for (int j = 0; j < nLocal_; j++) {
-        int jglob = AtomLocalToGlobal[j];
+    buildGroupLists(cgLocalToGlobal, AtomLocalToGlobal, globalGroupMembership,
+                    groupOffsets_, groupAtoms_);
 
-        if (excludes->hasPair(iglob, jglob)) 
-          excludesForAtom[i].push_back(j);              
-        
-        if (oneTwo->hasPair(iglob, jglob)) {
-          toposForAtom[i].push_back(j);
-          topoDist[i].push_back(1);
-        } else {
-          if (oneThree->hasPair(iglob, jglob)) {
-            toposForAtom[i].push_back(j);
-            topoDist[i].push_back(2);
+    allocateThreadData();
+  }
+
+  /**
+   * Fills the exclusion and topological distance lists of the row
+   * atoms by walking the pair lists, rather than testing every row /
+   * column pair.  When an atom pair appears in more than one of the
+   * 1-2, 1-3, and 1-4 lists, the shortest distance is kept.  Each
+   * list ends up in ascending column order.
+   */
+  void ForceMatrixDecomposition::buildTopology(const vector<int>& rowToGlobal,
+                                               const vector<int>& colToGlobal) {
+    int nRow = rowToGlobal.size();
+    int nGlobal = info_->getNGlobalAtoms();
+    vector<int> globalToRow(nGlobal, -1);
+    vector<int> globalToCol(nGlobal, -1);
+    for (int i = 0; i < nRow; i++)
+      globalToRow[rowToGlobal[i]] = i;
+    for (unsigned int j = 0; j < colToGlobal.size(); j++)
+      globalToCol[colToGlobal[j]] = j;
+
+    excludesForAtom.assign(nRow, vector<int>());
+    vector<vector<pair<int, int> > > topos(nRow);
+
+    PairList* lists[4] = {info_->getExcludedInteractions(),
+                          info_->getOneTwoInteractions(),
+                          info_->getOneThreeInteractions(),
+                          info_->getOneFourInteractions()};
+
+    for (int l = 0; l < 4; l++) {
+      int nPairs = lists[l]->getSize();
+      int* pairs = lists[l]->getPairList();
+
+      for (int k = 0; k < nPairs; k++) {
+        // the pair list is 1-based:
+        int gid[2] = {pairs[2 * k] - 1, pairs[2 * k + 1] - 1};
+
+        for (int m = 0; m < 2; m++) {
+          int i = globalToRow[gid[m]];
+          int j = globalToCol[gid[1 - m]];
+          if (i < 0 || j < 0) continue;
+
+          if (l == 0) {
+            excludesForAtom[i].push_back(j);
           } else {
-            if (oneFour->hasPair(iglob, jglob)) {
-              toposForAtom[i].push_back(j);
-              topoDist[i].push_back(3);
-            }
+            bool found = false;
+            for (unsigned int n = 0; n < topos[i].size(); n++) 
+              if (topos[i][n].first == j) found = true;
+            // the lists are visited closest first:
+            if (!found) topos[i].push_back(make_pair(j, l));
           }
         }
-      }      
+      }
+    }
+
+    toposForAtom.assign(nRow, vector<int>());
+    topoDist.assign(nRow, vector<int>());
+    for (int i = 0; i < nRow; i++) {
+      sort(excludesForAtom[i].begin(), excludesForAtom[i].end());
+      sort(topos[i].begin(), topos[i].end());
+      for (unsigned int n = 0; n < topos[i].size(); n++) {
+        toposForAtom[i].push_back(topos[i][n].first);
+        topoDist[i].push_back(topos[i][n].second);
+      }
+    }
+  }
+
+  /**
+   * Builds the compressed group->atom lists.  Atoms are counted into
+   * their groups, the counts are turned into offsets, and the atom
+   * indices are then scattered into place.  Within a group, atoms keep
+   * their ascending local (or row / column) order.
+   */
+  void ForceMatrixDecomposition::buildGroupLists(const vector<int>& groupToGlobal,
+                                                 const vector<int>& atomToGlobal,
+                                                 const vector<int>& globalGroupMembership,
+                                                 vector<int>& offsets,
+                                                 vector<int>& atoms) {
+    int nG = groupToGlobal.size();
+    int nA = atomToGlobal.size();
+    vector<int> globalToGroup(info_->getNGlobalCutoffGroups(), -1);
+    for (int i = 0; i < nG; i++)
+      globalToGroup[groupToGlobal[i]] = i;
+
+    vector<int> atomGroup(nA, -1);
+    offsets.assign(nG + 1, 0);
+    for (int j = 0; j < nA; j++) {
+      int gid = globalGroupMembership[atomToGlobal[j]];
+      if (gid >= 0 && gid < int(globalToGroup.size())) {
+        atomGroup[j] = globalToGroup[gid];
+        if (atomGroup[j] >= 0) offsets[atomGroup[j] + 1]++;
+      }
     }
+    for (int i = 0; i < nG; i++)
+      offsets[i + 1] += offsets[i];
+
+    atoms.resize(offsets[nG]);
+    vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (int j = 0; j < nA; j++)
+      if (atomGroup[j] >= 0) atoms[fill[atomGroup[j]]++] = j;
+  }
+
+  /**
+   * If the thread count changes after distributeInitialData, the
+   * per-thread accumulators are resized by the next zeroWorkArrays.
+   */
+  void ForceMatrixDecomposition::setNumberOfThreads(int nThreads) {
+    ForceDecomposition::setNumberOfThreads(max(nThreads, 1));
+  }
+
+  void ForceMatrixDecomposition::allocateThreadData() {
+    // only the properties that are accumulated in the pair loop need
+    // thread-private copies:
+    threadLayout_ = storageLayout_ & (DataStorage::dslForce | 
+                                      DataStorage::dslTorque |
+                                      DataStorage::dslParticlePot |
+                                      DataStorage::dslDensity |
+                                      DataStorage::dslSkippedCharge |
+                                      DataStorage::dslFlucQForce |
+                                      DataStorage::dslElectricField |
+                                      DataStorage::dslSitePotential |
+                                      DataStorage::dslStructureOfArrays);
+    threadData_.clear();
+    threadData_.resize(nThreads_);
+
+    for (int tid = 1; tid < nThreads_; tid++) {
+      ThreadData& td = threadData_[tid];
+#ifdef IS_MPI
+      td.rowData.resize(nAtomsInRow_);
+      td.rowData.setStorageLayout(threadLayout_);
+      td.colData.resize(nAtomsInCol_);
+      td.colData.setStorageLayout(threadLayout_);
+      td.pot_row.resize(nAtomsInRow_);
+      td.pot_col.resize(nAtomsInCol_);
+      td.expot_row.resize(nAtomsInRow_);
+      td.expot_col.resize(nAtomsInCol_);
+      td.selepot_row.resize(nAtomsInRow_);
+      td.selepot_col.resize(nAtomsInCol_);
+#else
+      td.rowData.resize(nLocal_);
+      td.rowData.setStorageLayout(threadLayout_);
 #endif
+    }
+    zeroThreadData();
+  }
 
-    // allocate memory for the parallel objects
-    atypesLocal.resize(nLocal_);
+  void ForceMatrixDecomposition::zeroThreadData() {
+    for (int tid = 1; tid < nThreads_; tid++) {
+      ThreadData& td = threadData_[tid];
+      td.pairwisePot = 0.0;
+      td.excludedPot = 0.0;
+      td.selectedPot = 0.0;
+#ifdef IS_MPI
+      fill(td.pot_row.begin(), td.pot_row.end(), potVec(0.0));
+      fill(td.pot_col.begin(), td.pot_col.end(), potVec(0.0));
+      fill(td.expot_row.begin(), td.expot_row.end(), potVec(0.0));
+      fill(td.expot_col.begin(), td.expot_col.end(), potVec(0.0));
+      fill(td.selepot_row.begin(), td.selepot_row.end(), potVec(0.0));
+      fill(td.selepot_col.begin(), td.selepot_col.end(), potVec(0.0));
+      DataStorage* stores[2] = {&td.rowData, &td.colData};
+#else
+      DataStorage* stores[1] = {&td.rowData};
+#endif
+      for (unsigned int k = 0; k < sizeof(stores) / sizeof(stores[0]); k++) {
+        DataStorage* ds = stores[k];
+        if (threadLayout_ & DataStorage::dslForce) 
+          ds->force.fill(V3Zero);
+        if (threadLayout_ & DataStorage::dslTorque) 
+          fill(ds->torque.begin(), ds->torque.end(), V3Zero);
+        if (threadLayout_ & DataStorage::dslParticlePot) 
+          fill(ds->particlePot.begin(), ds->particlePot.end(), 0.0);
+        if (threadLayout_ & DataStorage::dslDensity) 
+          fill(ds->density.begin(), ds->density.end(), 0.0);
+        if (threadLayout_ & DataStorage::dslSkippedCharge) 
+          fill(ds->skippedCharge.begin(), ds->skippedCharge.end(), 0.0);
+        if (threadLayout_ & DataStorage::dslFlucQForce) 
+          fill(ds->flucQFrc.begin(), ds->flucQFrc.end(), 0.0);
+        if (threadLayout_ & DataStorage::dslElectricField) 
+          fill(ds->electricField.begin(), ds->electricField.end(), V3Zero);
+        if (threadLayout_ & DataStorage::dslSitePotential) 
+          fill(ds->sitePotential.begin(), ds->sitePotential.end(), 0.0);
+      }
+    }
+  }
 
-    for (int i = 0; i < nLocal_; i++) 
-      atypesLocal[i] = ff_->getAtomType(idents[i]);
+  /**
+   * Adds a thread-private array into the shared one, and optionally
+   * copies the sum back into the thread-private array.
+   */
+  template<typename T>
+  static void reduceThreadArray(vector<T>& shared, vector<T>& local,
+                                bool broadcast = false) {
+    for (unsigned int i = 0; i < local.size(); i++) 
+      shared[i] += local[i];
+    if (broadcast) 
+      local = shared;
+  }
 
-    groupList_.clear();
-    groupList_.resize(nGroups_);
-    for (int i = 0; i < nGroups_; i++) {
-      int gid = cgLocalToGlobal[i];
-      for (int j = 0; j < nLocal_; j++) {
-        int aid = AtomLocalToGlobal[j];
-        if (globalGroupMembership[aid] == gid) {
-          groupList_[i].push_back(j);
-        }
-      }      
-    }    
+  static void reduceThreadArray(Vector3dArray& shared, Vector3dArray& local) {
+    if (shared.getLayout() != local.getLayout()) {
+      for (unsigned int i = 0; i < local.size(); i++) 
+        shared[i] += local[i];
+      return;
+    }
+    std::size_t n = local.size();
+    std::size_t stride = local.stride();
+    for (int d = 0; d < 3; d++) {
+      RealType* s = shared.component(d);
+      const RealType* l = local.component(d);
+#pragma omp simd
+      for (std::size_t i = 0; i < n; i++) 
+        s[i * stride] += l[i * stride];
+    }
+  }
+
+  /**
+   * collectThreadIntermediateData folds the densities accumulated by
+   * each thread in the pre-pair loop together.  The pair loop reads
+   * the densities back through the same pointers, so every thread's
+   * copy is replaced with the total.
+   */
+  void ForceMatrixDecomposition::collectThreadIntermediateData() {
+    if (!(threadLayout_ & DataStorage::dslDensity)) return;
+
+    for (int tid = 1; tid < nThreads_; tid++) {
+#ifdef IS_MPI
+      reduceThreadArray(atomRowData.density, threadData_[tid].rowData.density);
+      reduceThreadArray(atomColData.density, threadData_[tid].colData.density);
+#else
+      reduceThreadArray(snap_->atomData.density, 
+                        threadData_[tid].rowData.density);
+#endif
+    }
+    for (int tid = 1; tid < nThreads_; tid++) {
+#ifdef IS_MPI
+      threadData_[tid].rowData.density = atomRowData.density;
+      threadData_[tid].colData.density = atomColData.density;
+#else
+      threadData_[tid].rowData.density = snap_->atomData.density;
+#endif
+    }
+  }
+
+  /**
+   * collectThreadData folds the forces, torques and potentials
+   * accumulated by each thread in the pair loop into the
+   * decomposition's own arrays, ahead of collectData.
+   */
+  void ForceMatrixDecomposition::collectThreadData() {
+    for (int tid = 1; tid < nThreads_; tid++) {
+      ThreadData& td = threadData_[tid];
+      pairwisePot += td.pairwisePot;
+      excludedPot += td.excludedPot;
+      selectedPot += td.selectedPot;
+
+#ifdef IS_MPI
+      reduceThreadArray(pot_row, td.pot_row);
+      reduceThreadArray(pot_col, td.pot_col);
+      reduceThreadArray(expot_row, td.expot_row);
+      reduceThreadArray(expot_col, td.expot_col);
+      reduceThreadArray(selepot_row, td.selepot_row);
+      reduceThreadArray(selepot_col, td.selepot_col);
+      DataStorage* shared[2] = {&atomRowData, &atomColData};
+      DataStorage* local[2] = {&td.rowData, &td.colData};
+#else
+      DataStorage* shared[1] = {&(snap_->atomData)};
+      DataStorage* local[1] = {&td.rowData};
+#endif
+      for (unsigned int k = 0; k < sizeof(shared) / sizeof(shared[0]); k++) {
+        if (threadLayout_ & DataStorage::dslForce) 
+          reduceThreadArray(shared[k]->force, local[k]->force);
+        if (threadLayout_ & DataStorage::dslTorque) 
+          reduceThreadArray(shared[k]->torque, local[k]->torque);
+        if (threadLayout_ & DataStorage::dslParticlePot) 
+          reduceThreadArray(shared[k]->particlePot, local[k]->particlePot);
+        if (threadLayout_ & DataStorage::dslSkippedCharge) 
+          reduceThreadArray(shared[k]->skippedCharge, local[k]->skippedCharge);
+        if (threadLayout_ & DataStorage::dslFlucQForce) 
+          reduceThreadArray(shared[k]->flucQFrc, local[k]->flucQFrc);
+        if (threadLayout_ & DataStorage::dslElectricField) 
+          reduceThreadArray(shared[k]->electricField, local[k]->electricField);
+        if (threadLayout_ & DataStorage::dslSitePotential) 
+          reduceThreadArray(shared[k]->sitePotential, local[k]->sitePotential);
+      }
+    }
   }
     
   int ForceMatrixDecomposition::getTopologicalDistance(int atom1, int atom2) {
@@ -317,6 +513,11 @@ namespace OpenMD {
   }
 
   void ForceMatrixDecomposition::zeroWorkArrays() {
+    if (int(threadData_.size()) != nThreads_) 
+      allocateThreadData();
+    else
+      zeroThreadData();
+
     pairwisePot = 0.0;
     selfPot = 0.0;
     excludedPot = 0.0;
@@ -326,8 +527,8 @@ namespace OpenMD {
 
 #ifdef IS_MPI
     if (storageLayout_ & DataStorage::dslForce) {
-      fill(atomRowData.force.begin(), atomRowData.force.end(), V3Zero);
-      fill(atomColData.force.begin(), atomColData.force.end(), V3Zero);
+      atomRowData.force.fill(V3Zero);
+      atomColData.force.fill(V3Zero);
     }
 
     if (storageLayout_ & DataStorage::dslTorque) {
@@ -447,6 +648,17 @@ namespace OpenMD {
 
 
   void ForceMatrixDecomposition::distributeData()  {
+    startDistributeData();
+    finishDistributeData();
+  }
+
+  /**
+   * Starts gathering the local data into the row and column arrays.
+   * The gathers are non-blocking: the row and column arrays they fill
+   * must not be read, and the local arrays must not be changed, until
+   * finishDistributeData has been called.
+   */
+  void ForceMatrixDecomposition::startDistributeData()  {
    
 #ifdef IS_MPI
 
@@ -458,67 +670,82 @@ namespace OpenMD {
       needsCG = false;
 
     // gather up the atomic positions
-    AtomPlanVectorRow->gather(snap_->atomData.position, 
-                              atomRowData.position);
-    AtomPlanVectorColumn->gather(snap_->atomData.position, 
-                                 atomColData.position);
+    AtomPlanVectorRow->igather(snap_->atomData.position,
+                               atomRowData.position, requests_);
+    AtomPlanVectorColumn->igather(snap_->atomData.position,
+                                  atomColData.position, requests_);
     
     // gather up the cutoff group positions
 
     if (needsCG) {
-      cgPlanVectorRow->gather(snap_->cgData.position, 
-                              cgRowData.position);
+      cgPlanVectorRow->igather(snap_->cgData.position,
+                               cgRowData.position, requests_);
       
-      cgPlanVectorColumn->gather(snap_->cgData.position, 
-                                 cgColData.position);
+      cgPlanVectorColumn->igather(snap_->cgData.position,
+                                  cgColData.position, requests_);
     }
 
 
     if (needVelocities_) {
       // gather up the atomic velocities
-      AtomPlanVectorColumn->gather(snap_->atomData.velocity, 
-                                   atomColData.velocity);
+      AtomPlanVectorColumn->igather(snap_->atomData.velocity,
+                                    atomColData.velocity, requests_);
 
       if (needsCG) {        
-        cgPlanVectorColumn->gather(snap_->cgData.velocity, 
-                                   cgColData.velocity);
+        cgPlanVectorColumn->igather(snap_->cgData.velocity,
+                                    cgColData.velocity, requests_);
       }
     }
 
     
     // if needed, gather the atomic rotation matrices
     if (storageLayout_ & DataStorage::dslAmat) {
-      AtomPlanMatrixRow->gather(snap_->atomData.aMat, 
-                                atomRowData.aMat);
-      AtomPlanMatrixColumn->gather(snap_->atomData.aMat, 
-                                   atomColData.aMat);
+      AtomPlanMatrixRow->igather(snap_->atomData.aMat,
+                                 atomRowData.aMat, requests_);
+      AtomPlanMatrixColumn->igather(snap_->atomData.aMat,
+                                    atomColData.aMat, requests_);
     }
 
     // if needed, gather the atomic eletrostatic information
     if (storageLayout_ & DataStorage::dslDipole) {
-      AtomPlanVectorRow->gather(snap_->atomData.dipole, 
-                                atomRowData.dipole);
-      AtomPlanVectorColumn->gather(snap_->atomData.dipole, 
-                                   atomColData.dipole);
+      AtomPlanVectorRow->igather(snap_->atomData.dipole,
+                                 atomRowData.dipole, requests_);
+      AtomPlanVectorColumn->igather(snap_->atomData.dipole,
+                                    atomColData.dipole, requests_);
     }
 
     if (storageLayout_ & DataStorage::dslQuadrupole) {
-      AtomPlanMatrixRow->gather(snap_->atomData.quadrupole, 
-                                atomRowData.quadrupole);
-      AtomPlanMatrixColumn->gather(snap_->atomData.quadrupole, 
-                                   atomColData.quadrupole);
+      AtomPlanMatrixRow->igather(snap_->atomData.quadrupole,
+                                 atomRowData.quadrupole, requests_);
+      AtomPlanMatrixColumn->igather(snap_->atomData.quadrupole,
+                                    atomColData.quadrupole, requests_);
     }
         
     // if needed, gather the atomic fluctuating charge values
     if (storageLayout_ & DataStorage::dslFlucQPosition) {
-      AtomPlanRealRow->gather(snap_->atomData.flucQPos, 
-                              atomRowData.flucQPos);
-      AtomPlanRealColumn->gather(snap_->atomData.flucQPos, 
-                                 atomColData.flucQPos);
+      AtomPlanRealRow->igather(snap_->atomData.flucQPos,
+                               atomRowData.flucQPos, requests_);
+      AtomPlanRealColumn->igather(snap_->atomData.flucQPos,
+                                  atomColData.flucQPos, requests_);
     }
 
 #endif      
   }
+
+  void ForceMatrixDecomposition::finishDistributeData()  {
+#ifdef IS_MPI
+    waitForRequests();
+#endif
+  }
+
+#ifdef IS_MPI
+  void ForceMatrixDecomposition::waitForRequests() {
+    if (!requests_.empty()) {
+      MPI_Waitall(requests_.size(), &requests_[0], MPI_STATUSES_IGNORE);
+      requests_.clear();
+    }
+  }
+#endif
   
   /* collects information obtained during the pre-pair loop onto local
    * data structures.
@@ -585,129 +812,160 @@ namespace OpenMD {
   
   
   void ForceMatrixDecomposition::collectData() {
+    startCollectData();
+    finishCollectData();
+  }
+
+  /**
+   * Starts the reduce-scatters of the row and column arrays onto the
+   * local atoms.  The results land in receive buffers, so the local
+   * arrays may be changed while the messages are in flight, but the
+   * row and column arrays may not.
+   */
+  void ForceMatrixDecomposition::startCollectData() {
 #ifdef IS_MPI
     snap_ = sman_->getCurrentSnapshot();
     storageLayout_ = sman_->getStorageLayout();
+    nLocal_ = snap_->getNumberOfAtoms();
 
-    int n = snap_->atomData.force.size();
-    vector<Vector3d> frc_tmp(n, V3Zero);
-    
-    AtomPlanVectorRow->scatter(atomRowData.force, frc_tmp);
-    for (int i = 0; i < n; i++) {
-      snap_->atomData.force[i] += frc_tmp[i];
-      frc_tmp[i] = 0.0;
-    }
-    
-    AtomPlanVectorColumn->scatter(atomColData.force, frc_tmp);
-    for (int i = 0; i < n; i++) {
-      snap_->atomData.force[i] += frc_tmp[i];
+    int returnLayout = atomRowData.getStorageLayout() & 
+      (DataStorage::dslForce | DataStorage::dslTorque | 
+       DataStorage::dslSkippedCharge | DataStorage::dslFlucQForce | 
+       DataStorage::dslElectricField | DataStorage::dslSitePotential | 
+       DataStorage::dslParticlePot | DataStorage::dslStructureOfArrays);
+
+    if (rowReturn_.getStorageLayout() != returnLayout) {
+      rowReturn_.setStorageLayout(returnLayout);
+      colReturn_.setStorageLayout(returnLayout);
     }
-        
-    if (storageLayout_ & DataStorage::dslTorque) {
+    rowReturn_.resize(nLocal_);
+    colReturn_.resize(nLocal_);
 
-      int nt = snap_->atomData.torque.size();
-      vector<Vector3d> trq_tmp(nt, V3Zero);
+    AtomPlanVectorRow->iscatter(atomRowData.force, rowReturn_.force, 
+                                requests_);
+    AtomPlanVectorColumn->iscatter(atomColData.force, colReturn_.force, 
+                                   requests_);
 
-      AtomPlanVectorRow->scatter(atomRowData.torque, trq_tmp);
-      for (int i = 0; i < nt; i++) {
-        snap_->atomData.torque[i] += trq_tmp[i];
-        trq_tmp[i] = 0.0;
-      }
-      
-      AtomPlanVectorColumn->scatter(atomColData.torque, trq_tmp);
-      for (int i = 0; i < nt; i++)
-        snap_->atomData.torque[i] += trq_tmp[i];
+    if (storageLayout_ & DataStorage::dslTorque) {
+      AtomPlanVectorRow->iscatter(atomRowData.torque, rowReturn_.torque, 
+                                  requests_);
+      AtomPlanVectorColumn->iscatter(atomColData.torque, colReturn_.torque,
+                                     requests_);
     }
 
     if (storageLayout_ & DataStorage::dslSkippedCharge) {
-
-      int ns = snap_->atomData.skippedCharge.size();
-      vector<RealType> skch_tmp(ns, 0.0);
-
-      AtomPlanRealRow->scatter(atomRowData.skippedCharge, skch_tmp);
-      for (int i = 0; i < ns; i++) {
-        snap_->atomData.skippedCharge[i] += skch_tmp[i];
-        skch_tmp[i] = 0.0;
-      }
-      
-      AtomPlanRealColumn->scatter(atomColData.skippedCharge, skch_tmp);
-      for (int i = 0; i < ns; i++) 
-        snap_->atomData.skippedCharge[i] += skch_tmp[i];
-            
+      AtomPlanRealRow->iscatter(atomRowData.skippedCharge, 
+                                rowReturn_.skippedCharge, requests_);
+      AtomPlanRealColumn->iscatter(atomColData.skippedCharge, 
+                                   colReturn_.skippedCharge, requests_);
     }
-    
+
     if (storageLayout_ & DataStorage::dslFlucQForce) {
+      AtomPlanRealRow->iscatter(atomRowData.flucQFrc, 
+                                rowReturn_.flucQFrc, requests_);
+      AtomPlanRealColumn->iscatter(atomColData.flucQFrc, 
+                                   colReturn_.flucQFrc, requests_);
+    }
 
-      int nq = snap_->atomData.flucQFrc.size();
-      vector<RealType> fqfrc_tmp(nq, 0.0);
+    if (storageLayout_ & DataStorage::dslElectricField) {
+      AtomPlanVectorRow->iscatter(atomRowData.electricField, 
+                                  rowReturn_.electricField, requests_);
+      AtomPlanVectorColumn->iscatter(atomColData.electricField, 
+                                     colReturn_.electricField, requests_);
+    }
 
-      AtomPlanRealRow->scatter(atomRowData.flucQFrc, fqfrc_tmp);
-      for (int i = 0; i < nq; i++) {
-        snap_->atomData.flucQFrc[i] += fqfrc_tmp[i];
-        fqfrc_tmp[i] = 0.0;
-      }
-      
-      AtomPlanRealColumn->scatter(atomColData.flucQFrc, fqfrc_tmp);
-      for (int i = 0; i < nq; i++) 
-        snap_->atomData.flucQFrc[i] += fqfrc_tmp[i];
-            
+    if (storageLayout_ & DataStorage::dslSitePotential) {
+      AtomPlanRealRow->iscatter(atomRowData.sitePotential, 
+                                rowReturn_.sitePotential, requests_);
+      AtomPlanRealColumn->iscatter(atomColData.sitePotential, 
+                                   colReturn_.sitePotential, requests_);
     }
 
-    if (storageLayout_ & DataStorage::dslElectricField) {
+    // scatter/gather pot_row into the members of my column
 
-      int nef = snap_->atomData.electricField.size();
-      vector<Vector3d> efield_tmp(nef, V3Zero);
+    potRowReturn_.resize(nLocal_);
+    expotRowReturn_.resize(nLocal_);
+    selepotRowReturn_.resize(nLocal_);
+    potColReturn_.resize(nLocal_);
+    expotColReturn_.resize(nLocal_);
+    selepotColReturn_.resize(nLocal_);
 
-      AtomPlanVectorRow->scatter(atomRowData.electricField, efield_tmp);
-      for (int i = 0; i < nef; i++) {
-        snap_->atomData.electricField[i] += efield_tmp[i];
-        efield_tmp[i] = 0.0;
-      }
-      
-      AtomPlanVectorColumn->scatter(atomColData.electricField, efield_tmp);
-      for (int i = 0; i < nef; i++)
-        snap_->atomData.electricField[i] += efield_tmp[i];
+    AtomPlanPotRow->iscatter(pot_row, potRowReturn_, requests_);
+    AtomPlanPotRow->iscatter(expot_row, expotRowReturn_, requests_);
+    AtomPlanPotRow->iscatter(selepot_row, selepotRowReturn_, requests_);
+
+    AtomPlanPotColumn->iscatter(pot_col, potColReturn_, requests_);
+    AtomPlanPotColumn->iscatter(expot_col, expotColReturn_, requests_);
+    AtomPlanPotColumn->iscatter(selepot_col, selepotColReturn_, requests_);
+
+    if (storageLayout_ & DataStorage::dslParticlePot) {
+      // This is the direct or embedding contribution to the particle
+      // pot.
+      AtomPlanRealRow->iscatter(atomRowData.particlePot, 
+                                rowReturn_.particlePot, requests_);
+      AtomPlanRealColumn->iscatter(atomColData.particlePot, 
+                                   colReturn_.particlePot, requests_);
     }
+#endif
+  }
 
-    if (storageLayout_ & DataStorage::dslSitePotential) {
+  /**
+   * Waits for the reduce-scatters started by startCollectData, adds
+   * the row and column contributions into the local arrays (rows
+   * first), and sums the potentials over all processors.
+   */
+  void ForceMatrixDecomposition::finishCollectData() {
+#ifdef IS_MPI
+    waitForRequests();
 
-      int nsp = snap_->atomData.sitePotential.size();
-      vector<RealType> sp_tmp(nsp, 0.0);
+    for (int i = 0; i < nLocal_; i++) 
+      snap_->atomData.force[i] += rowReturn_.force[i];
+    for (int i = 0; i < nLocal_; i++)
+      snap_->atomData.force[i] += colReturn_.force[i];
 
-      AtomPlanRealRow->scatter(atomRowData.sitePotential, sp_tmp);
-      for (int i = 0; i < nsp; i++) {
-        snap_->atomData.sitePotential[i] += sp_tmp[i];
-        sp_tmp[i] = 0.0;
-      }
-      
-      AtomPlanRealColumn->scatter(atomColData.sitePotential, sp_tmp);
-      for (int i = 0; i < nsp; i++)
-        snap_->atomData.sitePotential[i] += sp_tmp[i];
+    if (storageLayout_ & DataStorage::dslTorque) {
+      for (int i = 0; i < nLocal_; i++) 
+        snap_->atomData.torque[i] += rowReturn_.torque[i];
+      for (int i = 0; i < nLocal_; i++) 
+        snap_->atomData.torque[i] += colReturn_.torque[i];
     }
 
-    nLocal_ = snap_->getNumberOfAtoms();
+    if (storageLayout_ & DataStorage::dslSkippedCharge) {
+      for (int i = 0; i < nLocal_; i++) 
+        snap_->atomData.skippedCharge[i] += rowReturn_.skippedCharge[i];
+      for (int i = 0; i < nLocal_; i++) 
+        snap_->atomData.skippedCharge[i] += colReturn_.skippedCharge[i];
+    }
 
-    vector<potVec> pot_temp(nLocal_, 
-                            Vector<RealType, N_INTERACTION_FAMILIES> (0.0));
-    vector<potVec> expot_temp(nLocal_, 
-                              Vector<RealType, N_INTERACTION_FAMILIES> (0.0));
-    vector<potVec> selepot_temp(nLocal_, 
-                                Vector<RealType, N_INTERACTION_FAMILIES> (0.0));
+    if (storageLayout_ & DataStorage::dslFlucQForce) {
+      for (int i = 0; i < nLocal_; i++) 
+        snap_->atomData.flucQFrc[i] += rowReturn_.flucQFrc[i];
+      for (int i = 0; i < nLocal_; i++) 
+        snap_->atomData.flucQFrc[i] += colReturn_.flucQFrc[i];
+    }
 
-    // scatter/gather pot_row into the members of my column
-          
-    AtomPlanPotRow->scatter(pot_row, pot_temp);
-    AtomPlanPotRow->scatter(expot_row, expot_temp);
-    AtomPlanPotRow->scatter(selepot_row, selepot_temp);
+    if (storageLayout_ & DataStorage::dslElectricField) {
+      for (int i = 0; i < nLocal_; i++) 
+        snap_->atomData.electricField[i] += rowReturn_.electricField[i];
+      for (int i = 0; i < nLocal_; i++) 
+        snap_->atomData.electricField[i] += colReturn_.electricField[i];
+    }
 
-    for (std::size_t ii = 0;  ii < pot_temp.size(); ii++ ) 
-      pairwisePot += pot_temp[ii];
+    if (storageLayout_ & DataStorage::dslSitePotential) {
+      for (int i = 0; i < nLocal_; i++) 
+        snap_->atomData.sitePotential[i] += rowReturn_.sitePotential[i];
+      for (int i = 0; i < nLocal_; i++) 
+        snap_->atomData.sitePotential[i] += colReturn_.sitePotential[i];
+    }
 
-    for (std::size_t ii = 0;  ii < expot_temp.size(); ii++ ) 
-      excludedPot += expot_temp[ii];
+    for (int i = 0; i < nLocal_; i++) 
+      pairwisePot += potRowReturn_[i];
+
+    for (int i = 0; i < nLocal_; i++) 
+      excludedPot += expotRowReturn_[i];
     
-    for (std::size_t ii = 0;  ii < selepot_temp.size(); ii++ ) 
-      selectedPot += selepot_temp[ii];
+    for (int i = 0; i < nLocal_; i++) 
+      selectedPot += selepotRowReturn_[i];
     
     if (storageLayout_ & DataStorage::dslParticlePot) {
       // This is the pairwise contribution to the particle pot.  The
@@ -718,63 +976,31 @@ namespace OpenMD {
         for (int i = 0; i < nLocal_; i++) {
           // factor of two is because the total potential terms are divided
           // by 2 in parallel due to row/ column scatter       
-          snap_->atomData.particlePot[i] += 2.0 * pot_temp[i](ii);
+          snap_->atomData.particlePot[i] += 2.0 * potRowReturn_[i](ii);
         }
       }
     }
 
-    fill(pot_temp.begin(), pot_temp.end(), 
-         Vector<RealType, N_INTERACTION_FAMILIES> (0.0));
-    fill(expot_temp.begin(), expot_temp.end(), 
-         Vector<RealType, N_INTERACTION_FAMILIES> (0.0));
-    fill(selepot_temp.begin(), selepot_temp.end(), 
-         Vector<RealType, N_INTERACTION_FAMILIES> (0.0));
-      
-    AtomPlanPotColumn->scatter(pot_col, pot_temp);    
-    AtomPlanPotColumn->scatter(expot_col, expot_temp);
-    AtomPlanPotColumn->scatter(selepot_col, selepot_temp);    
-    
-    for (std::size_t ii = 0;  ii < pot_temp.size(); ii++ )
-      pairwisePot += pot_temp[ii];    
+    for (int i = 0; i < nLocal_; i++) 
+      pairwisePot += potColReturn_[i];
 
-    for (std::size_t ii = 0;  ii < expot_temp.size(); ii++ )
-      excludedPot += expot_temp[ii];    
+    for (int i = 0; i < nLocal_; i++) 
+      excludedPot += expotColReturn_[i];
 
-    for (std::size_t ii = 0;  ii < selepot_temp.size(); ii++ )
-      selectedPot += selepot_temp[ii];    
+    for (int i = 0; i < nLocal_; i++) 
+      selectedPot += selepotColReturn_[i];
     
     if (storageLayout_ & DataStorage::dslParticlePot) {
-      // This is the pairwise contribution to the particle pot.  The
-      // embedding contribution is added in each of the low level
-      // non-bonded routines.  In single processor, this is done in
-      // unpackInteractionData, not in collectData.
       for (int ii = 0; ii < N_INTERACTION_FAMILIES; ii++) {
         for (int i = 0; i < nLocal_; i++) {
-          // factor of two is because the total potential terms are divided
-          // by 2 in parallel due to row/ column scatter       
-          snap_->atomData.particlePot[i] += 2.0 * pot_temp[i](ii);
+          snap_->atomData.particlePot[i] += 2.0 * potColReturn_[i](ii);
         }
       }
-    }
-    
-    if (storageLayout_ & DataStorage::dslParticlePot) {
-      int npp = snap_->atomData.particlePot.size();
-      vector<RealType> ppot_temp(npp, 0.0);
-
-      // This is the direct or embedding contribution to the particle
-      // pot.
-      
-      AtomPlanRealRow->scatter(atomRowData.particlePot, ppot_temp);
-      for (int i = 0; i < npp; i++) {
-        snap_->atomData.particlePot[i] += ppot_temp[i];
-      }
 
-      fill(ppot_temp.begin(), ppot_temp.end(), 0.0);
-      
-      AtomPlanRealColumn->scatter(atomColData.particlePot, ppot_temp);
-      for (int i = 0; i < npp; i++) {
-        snap_->atomData.particlePot[i] += ppot_temp[i];
-      }
+      for (int i = 0; i < nLocal_; i++) 
+        snap_->atomData.particlePot[i] += rowReturn_.particlePot[i];
+      for (int i = 0; i < nLocal_; i++) 
+        snap_->atomData.particlePot[i] += colReturn_.particlePot[i];
     }
 
     for (int ii = 0; ii < N_INTERACTION_FAMILIES; ii++) {
@@ -850,19 +1076,23 @@ namespace OpenMD {
   /**
    * returns the list of atoms belonging to this group.  
    */
-  vector<int>& ForceMatrixDecomposition::getAtomsInGroupRow(int cg1){
+  AtomSpan ForceMatrixDecomposition::getAtomsInGroupRow(int cg1){
 #ifdef IS_MPI
-    return groupListRow_[cg1];
+    return AtomSpan(&groupAtomsRow_[0] + groupOffsetsRow_[cg1],
+                    groupOffsetsRow_[cg1+1] - groupOffsetsRow_[cg1]);
 #else 
-    return groupList_[cg1];
+    return AtomSpan(&groupAtoms_[0] + groupOffsets_[cg1],
+                    groupOffsets_[cg1+1] - groupOffsets_[cg1]);
 #endif
   }
 
-  vector<int>& ForceMatrixDecomposition::getAtomsInGroupColumn(int cg2){
+  AtomSpan ForceMatrixDecomposition::getAtomsInGroupColumn(int cg2){
 #ifdef IS_MPI
-    return groupListCol_[cg2];
+    return AtomSpan(&groupAtomsCol_[0] + groupOffsetsCol_[cg2],
+                    groupOffsetsCol_[cg2+1] - groupOffsetsCol_[cg2]);
 #else 
-    return groupList_[cg2];
+    return AtomSpan(&groupAtoms_[0] + groupOffsets_[cg2],
+                    groupOffsets_[cg2+1] - groupOffsets_[cg2]);
 #endif
   }
   
@@ -882,7 +1112,7 @@ namespace OpenMD {
     return d;    
   }
 
-  Vector3d& ForceMatrixDecomposition::getGroupVelocityColumn(int cg2){
+  Vector3d ForceMatrixDecomposition::getGroupVelocityColumn(int cg2){
 #ifdef IS_MPI
     return cgColData.velocity[cg2];
 #else
@@ -890,7 +1120,7 @@ namespace OpenMD {
 #endif
   }
 
-  Vector3d& ForceMatrixDecomposition::getAtomVelocityColumn(int atom2){
+  Vector3d ForceMatrixDecomposition::getAtomVelocityColumn(int atom2){
 #ifdef IS_MPI
     return atomColData.velocity[atom2];
 #else
@@ -1029,7 +1259,12 @@ namespace OpenMD {
   }
 
 
-  void ForceMatrixDecomposition::addForceToAtomRow(int atom1, Vector3d fg){
+  void ForceMatrixDecomposition::addForceToAtomRow(int atom1, Vector3d fg,
+                                                   int tid){
+    if (tid > 0) {
+      threadData_[tid].rowData.force[atom1] += fg;
+      return;
+    }
 #ifdef IS_MPI
     atomRowData.force[atom1] += fg;
 #else
@@ -1037,7 +1272,16 @@ namespace OpenMD {
 #endif
   }
 
-  void ForceMatrixDecomposition::addForceToAtomColumn(int atom2, Vector3d fg){
+  void ForceMatrixDecomposition::addForceToAtomColumn(int atom2, Vector3d fg,
+                                                      int tid){
+    if (tid > 0) {
+#ifdef IS_MPI
+      threadData_[tid].colData.force[atom2] += fg;
+#else
+      threadData_[tid].rowData.force[atom2] += fg;
+#endif
+      return;
+    }
 #ifdef IS_MPI
     atomColData.force[atom2] += fg;
 #else
@@ -1048,7 +1292,7 @@ namespace OpenMD {
     // filling interaction blocks with pointers
   void ForceMatrixDecomposition::fillInteractionData(InteractionData &idat, 
                                                      int atom1, int atom2,
-                                                     bool newAtom1) {
+                                                     bool newAtom1, int tid) {
 
     idat.excluded = excludeAtomPair(atom1, atom2);
 
@@ -1278,72 +1522,161 @@ namespace OpenMD {
 
 #endif
     }
+
+    if (tid > 0) {
+      // Properties that the interactions accumulate are redirected
+      // to this thread's private copies:
+      DataStorage& rowData = threadData_[tid].rowData;
+#ifdef IS_MPI
+      DataStorage& colData = threadData_[tid].colData;
+#else
+      DataStorage& colData = threadData_[tid].rowData;
+#endif
+      if (threadLayout_ & DataStorage::dslTorque) {
+        if (newAtom1) idat.t1 = &(rowData.torque[atom1]);
+        idat.t2 = &(colData.torque[atom2]);
+      }
+      if (threadLayout_ & DataStorage::dslDensity) {
+        if (newAtom1) idat.rho1 = &(rowData.density[atom1]);
+        idat.rho2 = &(colData.density[atom2]);
+      }
+      if (threadLayout_ & DataStorage::dslParticlePot) {
+        if (newAtom1) idat.particlePot1 = &(rowData.particlePot[atom1]);
+        idat.particlePot2 = &(colData.particlePot[atom2]);
+      }
+      if (threadLayout_ & DataStorage::dslSkippedCharge) {
+        if (newAtom1) idat.skippedCharge1 = &(rowData.skippedCharge[atom1]);
+        idat.skippedCharge2 = &(colData.skippedCharge[atom2]);
+      }
+    }
   }
   
   void ForceMatrixDecomposition::unpackInteractionData(InteractionData &idat,
-                                                       int atom1, int atom2) {  
-#ifdef IS_MPI
-    pot_row[atom1] += RealType(0.5) *  *(idat.pot);
-    pot_col[atom2] += RealType(0.5) *  *(idat.pot);
-    expot_row[atom1] += RealType(0.5) *  *(idat.excludedPot);
-    expot_col[atom2] += RealType(0.5) *  *(idat.excludedPot);
-    selepot_row[atom1] += RealType(0.5) *  *(idat.selePot);
-    selepot_col[atom2] += RealType(0.5) *  *(idat.selePot);
+                                                       int atom1, int atom2,
+                                                       int tid) {  
+    // thread 0 works on the shared arrays, the others on private copies:
+    ThreadData* td = (tid > 0) ? &threadData_[tid] : NULL;
 
-    atomRowData.force[atom1] += *(idat.f1);
-    atomColData.force[atom2] -= *(idat.f1);
+#ifdef IS_MPI
+    DataStorage& rowData = td ? td->rowData : atomRowData;
+    DataStorage& colData = td ? td->colData : atomColData;
+
+    (td ? td->pot_row : pot_row)[atom1] += RealType(0.5) *  *(idat.pot);
+    (td ? td->pot_col : pot_col)[atom2] += RealType(0.5) *  *(idat.pot);
+    (td ? td->expot_row : expot_row)[atom1] += 
+      RealType(0.5) *  *(idat.excludedPot);
+    (td ? td->expot_col : expot_col)[atom2] += 
+      RealType(0.5) *  *(idat.excludedPot);
+    (td ? td->selepot_row : selepot_row)[atom1] += 
+      RealType(0.5) *  *(idat.selePot);
+    (td ? td->selepot_col : selepot_col)[atom2] += 
+      RealType(0.5) *  *(idat.selePot);
+
+    rowData.force[atom1] += *(idat.f1);
+    colData.force[atom2] -= *(idat.f1);
 
     if (storageLayout_ & DataStorage::dslFlucQForce) {              
-      atomRowData.flucQFrc[atom1] -= *(idat.dVdFQ1);
-      atomColData.flucQFrc[atom2] -= *(idat.dVdFQ2);
+      rowData.flucQFrc[atom1] -= *(idat.dVdFQ1);
+      colData.flucQFrc[atom2] -= *(idat.dVdFQ2);
     }
 
     if (storageLayout_ & DataStorage::dslElectricField) {              
-      atomRowData.electricField[atom1] += *(idat.eField1);
-      atomColData.electricField[atom2] += *(idat.eField2);
+      rowData.electricField[atom1] += *(idat.eField1);
+      colData.electricField[atom2] += *(idat.eField2);
     }
 
     if (storageLayout_ & DataStorage::dslSitePotential) {              
-      atomRowData.sitePotential[atom1] += *(idat.sPot1);
-      atomColData.sitePotential[atom2] += *(idat.sPot2);
+      rowData.sitePotential[atom1] += *(idat.sPot1);
+      colData.sitePotential[atom2] += *(idat.sPot2);
     }
 
 #else
-    pairwisePot += *(idat.pot);
-    excludedPot += *(idat.excludedPot);
-    selectedPot += *(idat.selePot);
+    DataStorage& atomData = td ? td->rowData : snap_->atomData;
 
-    snap_->atomData.force[atom1] += *(idat.f1);
-    snap_->atomData.force[atom2] -= *(idat.f1);
+    (td ? td->pairwisePot : pairwisePot) += *(idat.pot);
+    (td ? td->excludedPot : excludedPot) += *(idat.excludedPot);
+    (td ? td->selectedPot : selectedPot) += *(idat.selePot);
+
+    atomData.force[atom1] += *(idat.f1);
+    atomData.force[atom2] -= *(idat.f1);
 
     if (idat.doParticlePot) {
       // This is the pairwise contribution to the particle pot.  The
       // self and embedding contribution is added in each of the low
       // level non-bonded routines.  In parallel, this calculation is
       // done in collectData, not in unpackInteractionData.
-      snap_->atomData.particlePot[atom1] += *(idat.vpair) * *(idat.sw);
-      snap_->atomData.particlePot[atom2] += *(idat.vpair) * *(idat.sw);
+      atomData.particlePot[atom1] += *(idat.vpair) * *(idat.sw);
+      atomData.particlePot[atom2] += *(idat.vpair) * *(idat.sw);
     }
     
     if (storageLayout_ & DataStorage::dslFlucQForce) {              
-      snap_->atomData.flucQFrc[atom1] -= *(idat.dVdFQ1);
-      snap_->atomData.flucQFrc[atom2] -= *(idat.dVdFQ2);
+      atomData.flucQFrc[atom1] -= *(idat.dVdFQ1);
+      atomData.flucQFrc[atom2] -= *(idat.dVdFQ2);
     }
 
     if (storageLayout_ & DataStorage::dslElectricField) {              
-      snap_->atomData.electricField[atom1] += *(idat.eField1);
-      snap_->atomData.electricField[atom2] += *(idat.eField2);
+      atomData.electricField[atom1] += *(idat.eField1);
+      atomData.electricField[atom2] += *(idat.eField2);
     }
 
     if (storageLayout_ & DataStorage::dslSitePotential) {              
-      snap_->atomData.sitePotential[atom1] += *(idat.sPot1);
-      snap_->atomData.sitePotential[atom2] += *(idat.sPot2);
+      atomData.sitePotential[atom1] += *(idat.sPot1);
+      atomData.sitePotential[atom2] += *(idat.sPot2);
     }
 
 #endif
     
   }
 
+  /**
+   * Scatters the results of a batched pair kernel.  Only the van der
+   * Waals family is populated by the batched interactions, and the
+   * switching function has already been folded into fr.
+   */
+  void ForceMatrixDecomposition::unpackPairBatch(PairBatch &batch, int atom1,
+                                                 bool doParticlePot, int tid) {
+    ThreadData* td = (tid > 0) ? &threadData_[tid] : NULL;
+    Vector3d f1;
+    RealType pot;
+
+#ifdef IS_MPI
+    DataStorage& rowData = td ? td->rowData : atomRowData;
+    DataStorage& colData = td ? td->colData : atomColData;
+    vector<potVec>& potRow = td ? td->pot_row : pot_row;
+    vector<potVec>& potCol = td ? td->pot_col : pot_col;
+
+    for (int k = 0; k < batch.n; k++) {
+      int atom2 = batch.atom2[k];
+      f1 = Vector3d(batch.dx[k], batch.dy[k], batch.dz[k]) * batch.fr[k];
+      pot = RealType(0.5) * batch.sw[k] * batch.vpair[k];
+
+      potRow[atom1][VANDERWAALS_FAMILY] += pot;
+      potCol[atom2][VANDERWAALS_FAMILY] += pot;
+      rowData.force[atom1] += f1;
+      colData.force[atom2] -= f1;
+    }
+#else
+    DataStorage& atomData = td ? td->rowData : snap_->atomData;
+    RealType vdwPot(0.0);
+
+    for (int k = 0; k < batch.n; k++) {
+      int atom2 = batch.atom2[k];
+      f1 = Vector3d(batch.dx[k], batch.dy[k], batch.dz[k]) * batch.fr[k];
+      pot = batch.sw[k] * batch.vpair[k];
+
+      vdwPot += pot;
+      atomData.force[atom1] += f1;
+      atomData.force[atom2] -= f1;
+
+      if (doParticlePot) {
+        atomData.particlePot[atom1] += pot;
+        atomData.particlePot[atom2] += pot;
+      }
+    }
+    (td ? td->pairwisePot : pairwisePot)[VANDERWAALS_FAMILY] += vdwPot;
+#endif
+  }
+
   /*
    * buildNeighborList
    *
@@ -1355,30 +1688,36 @@ namespace OpenMD {
    * column-ordered CutoffGroups.  The starting position in
    * neighborList for each row-ordered CutoffGroup is given by the
    * returned vector point.
+   *
+   * The column groups are binned into cells that are a fraction of
+   * rList wide (so small boxes still get a cell list), and the cells
+   * are stored contiguously along a space-filling curve.  The row
+   * groups are visited in the same order, so neighboring rows scan
+   * the same stretch of the cell list.  In serial, rows and columns
+   * are the same groups, and only half of the stencil is needed.  In
+   * parallel, we need to visit *all* pairs of row & column indices
+   * and will divide labor in the force evaluation later.
    */
   void ForceMatrixDecomposition::buildNeighborList(vector<int>& neighborList,
                                                    vector<int>& point) {
-    neighborList.clear();
-    point.clear();
-    int len = 0;
-    
-    bool doAllPairs = false;
+    RealType tStart = wallTime();
 
     Snapshot* snap_ = sman_->getCurrentSnapshot();
     Mat3x3d box;
     Mat3x3d invBox;
 
-    Vector3d rs, scaled, dr;
-    Vector3i whichCell;
-    int cellIndex;
-
 #ifdef IS_MPI
-    cellListRow_.clear();
-    cellListCol_.clear();
-    point.resize(nGroupsInRow_+1);
+    int nRows = nGroupsInRow_;
+    int nCols = nGroupsInCol_;
+    Vector3dArray& rowPos = cgRowData.position;
+    Vector3dArray& colPos = cgColData.position;
+    bool halfShell = false;
 #else
-    cellList_.clear();
-    point.resize(nGroups_+1);
+    int nRows = nGroups_;
+    int nCols = nGroups_;
+    Vector3dArray& rowPos = snap_->cgData.position;
+    Vector3dArray& colPos = snap_->cgData.position;
+    bool halfShell = true;
 #endif
     
     if (!usePeriodicBoundaryConditions_) {
@@ -1404,266 +1743,186 @@ namespace OpenMD {
     CxA.normalize();
 
     // A set of perpendicular lengths in triclinic cells:
-    RealType Wa = abs(dot(A, BxC));
-    RealType Wb = abs(dot(B, CxA));
-    RealType Wc = abs(dot(C, AxB));
-    
-    nCells_.x() = int( Wa / rList_ );
-    nCells_.y() = int( Wb / rList_ );
-    nCells_.z() = int( Wc / rList_ );
-    
-    // handle small boxes where the cell offsets can end up repeating cells
-    if (nCells_.x() < 3) doAllPairs = true;
-    if (nCells_.y() < 3) doAllPairs = true;
-    if (nCells_.z() < 3) doAllPairs = true;
-    
+    Vector3d widths(abs(dot(A, BxC)), abs(dot(B, CxA)), abs(dot(C, AxB)));
+    bool orthoRhombic = (box(0,1) == 0.0 && box(0,2) == 0.0 && 
+                         box(1,0) == 0.0 && box(1,2) == 0.0 &&
+                         box(2,0) == 0.0 && box(2,1) == 0.0);
+
+    Vector3i nCells;
+    for (int d = 0; d < 3; d++)
+      nCells[d] = max(1, int( widths[d] * nSubCells_ / rList_ ));
+
+    bool rebinAll = (nCells != nCells_ || cellSlot_.empty() ||
+                     int(colCell_.size()) != nCols);
+    if (nCells != nCells_ || cellSlot_.empty()) {
+      nCells_ = nCells;
+      buildCellSlots();
+    }
+    buildCellStencil(widths, orthoRhombic, halfShell);
+
     int nCtot = nCells_.x() * nCells_.y() * nCells_.z();
-    
-#ifdef IS_MPI
-    cellListRow_.resize(nCtot);
-    cellListCol_.resize(nCtot);
-#else
-    cellList_.resize(nCtot);
-#endif
-    
-    if (!doAllPairs) {
-      
-#ifdef IS_MPI
-      
-      for (int i = 0; i < nGroupsInRow_; i++) {
-        rs = cgRowData.position[i];
-        
-        // scaled positions relative to the box vectors
-        scaled = invBox * rs;
-        
-        // wrap the vector back into the unit box by subtracting integer box 
-        // numbers
-        for (int j = 0; j < 3; j++) {
-          scaled[j] -= roundMe(scaled[j]);
-          scaled[j] += 0.5;
-          // Handle the special case when an object is exactly on the
-          // boundary (a scaled coordinate of 1.0 is the same as
-          // scaled coordinate of 0.0)
-          if (scaled[j] >= 1.0) scaled[j] -= 1.0;
-        }
-        
-        // find xyz-indices of cell that cutoffGroup is in.
-        whichCell.x() = nCells_.x() * scaled.x();
-        whichCell.y() = nCells_.y() * scaled.y();
-        whichCell.z() = nCells_.z() * scaled.z();
-        
-        // find single index of this cell:
-        cellIndex = Vlinear(whichCell, nCells_);
-        
-        // add this cutoff group to the list of groups in this cell;
-        cellListRow_[cellIndex].push_back(i);
-      }
-      for (int i = 0; i < nGroupsInCol_; i++) {
-        rs = cgColData.position[i];
-        
-        // scaled positions relative to the box vectors
-        scaled = invBox * rs;
-        
-        // wrap the vector back into the unit box by subtracting integer box 
-        // numbers
-        for (int j = 0; j < 3; j++) {
-          scaled[j] -= roundMe(scaled[j]);
-          scaled[j] += 0.5;
-          // Handle the special case when an object is exactly on the
-          // boundary (a scaled coordinate of 1.0 is the same as
-          // scaled coordinate of 0.0)
-          if (scaled[j] >= 1.0) scaled[j] -= 1.0;
-        }
-        
-        // find xyz-indices of cell that cutoffGroup is in.
-        whichCell.x() = nCells_.x() * scaled.x();
-        whichCell.y() = nCells_.y() * scaled.y();
-        whichCell.z() = nCells_.z() * scaled.z();
-        
-        // find single index of this cell:
-        cellIndex = Vlinear(whichCell, nCells_);
-        
-        // add this cutoff group to the list of groups in this cell;
-        cellListCol_[cellIndex].push_back(i);
-      }
-            
-#else
-      for (int i = 0; i < nGroups_; i++) {
-        rs = snap_->cgData.position[i];
-        
-        // scaled positions relative to the box vectors
-        scaled = invBox * rs;
-        
-        // wrap the vector back into the unit box by subtracting integer box 
-        // numbers
-        for (int j = 0; j < 3; j++) {
-          scaled[j] -= roundMe(scaled[j]);
-          scaled[j] += 0.5;
-          // Handle the special case when an object is exactly on the
-          // boundary (a scaled coordinate of 1.0 is the same as
-          // scaled coordinate of 0.0)
-          if (scaled[j] >= 1.0) scaled[j] -= 1.0;
-        }
-        
-        // find xyz-indices of cell that cutoffGroup is in.
-        whichCell.x() = int(nCells_.x() * scaled.x());
-        whichCell.y() = int(nCells_.y() * scaled.y());
-        whichCell.z() = int(nCells_.z() * scaled.z());
-        
-        // find single index of this cell:
-        cellIndex = Vlinear(whichCell, nCells_);
-        
-        // add this cutoff group to the list of groups in this cell;
-        cellList_[cellIndex].push_back(i);
+
+    // find the cell of each column group, counting the groups that
+    // have crossed into a new cell since the last build:
+    colCell_.resize(nCols);
+    int nMoved = 0;
+#pragma omp parallel for num_threads(nThreads_) schedule(static) reduction(+:nMoved)
+    for (int i = 0; i < nCols; i++) {
+      int c = cellSlot_[Vlinear(getCell(colPos[i], invBox), nCells_)];
+      if (rebinAll || c != colCell_[i]) {
+        colCell_[i] = c;
+        nMoved++;
       }
+    }
 
-#endif
+    // If no group changed cells, the cell list is still good and
+    // only the positions need refreshing.  Otherwise, re-bin with a
+    // counting sort by cell slot:
+    if (nMoved > 0 || int(cellStart_.size()) != nCtot + 1) {
+      cellStart_.assign(nCtot + 1, 0);
+      for (int i = 0; i < nCols; i++) 
+        cellStart_[colCell_[i] + 1]++;
+      for (int c = 0; c < nCtot; c++)
+        cellStart_[c + 1] += cellStart_[c];
+      
+      cellGroups_.resize(nCols);
+      cellFill_.assign(cellStart_.begin(), cellStart_.end() - 1);
+      for (int i = 0; i < nCols; i++) 
+        cellGroups_[cellFill_[colCell_[i]]++] = i;
+    }
 
+    cellPositions_.resize(nCols);
+#pragma omp parallel for num_threads(nThreads_) schedule(static)
+    for (int k = 0; k < nCols; k++)
+      cellPositions_[k] = colPos[cellGroups_[k]];
+
+    // visit the row groups in cell order:
 #ifdef IS_MPI
-      for (int j1 = 0; j1 < nGroupsInRow_; j1++) {
-        rs = cgRowData.position[j1];
+    rowOrder_.resize(nRows);
+    vector<pair<int, int> > rowSlots(nRows);
+#pragma omp parallel for num_threads(nThreads_) schedule(static)
+    for (int i = 0; i < nRows; i++)
+      rowSlots[i] = make_pair(cellSlot_[Vlinear(getCell(rowPos[i], invBox),
+                                                nCells_)], i);
+    sort(rowSlots.begin(), rowSlots.end());
+    for (int i = 0; i < nRows; i++)
+      rowOrder_[i] = rowSlots[i].second;
 #else
+    rowOrder_ = cellGroups_;
+#endif
 
-      for (int j1 = 0; j1 < nGroups_; j1++) {
-        rs = snap_->cgData.position[j1];
+    // Each thread takes a contiguous stretch of rows (and so a
+    // compact region of space) and keeps its own neighbor buffer:
+    rowStart_.resize(nRows);
+    rowCount_.resize(nRows);
+    rowThread_.resize(nRows);
+    threadNeighbors_.resize(nThreads_);
+
+#pragma omp parallel num_threads(nThreads_)
+    {
+#ifdef _OPENMP
+      int tid = omp_get_thread_num();
+#else
+      int tid = 0;
 #endif
-        point[j1] = len;
+      vector<int>& buffer = threadNeighbors_[tid];
+      buffer.clear();
+      Vector3d rs, dr;
+
+#pragma omp for schedule(static)
+      for (int r = 0; r < nRows; r++) {
+        int j1 = rowOrder_[r];
+        rs = rowPos[j1];
+        Vector3i whichCell = getCell(rs, invBox);
+        rowStart_[j1] = buffer.size();
+        rowThread_[j1] = tid;
         
-        // scaled positions relative to the box vectors
-        scaled = invBox * rs;
-        
-        // wrap the vector back into the unit box by subtracting integer box 
-        // numbers
-        for (int j = 0; j < 3; j++) {
-          scaled[j] -= roundMe(scaled[j]);
-          scaled[j] += 0.5;
-          // Handle the special case when an object is exactly on the
-          // boundary (a scaled coordinate of 1.0 is the same as
-          // scaled coordinate of 0.0)
-          if (scaled[j] >= 1.0) scaled[j] -= 1.0;
-        }
-        
-        // find xyz-indices of cell that cutoffGroup is in.
-        whichCell.x() = int(nCells_.x() * scaled.x());
-        whichCell.y() = int(nCells_.y() * scaled.y());
-        whichCell.z() = int(nCells_.z() * scaled.z());
-        
-        for (vector<Vector3i>::iterator os = cellOffsets_.begin();
-             os != cellOffsets_.end(); ++os) {
-              
-          Vector3i m2v = whichCell + (*os);
-
-          if (m2v.x() >= nCells_.x()) {
-            m2v.x() = 0;           
-          } else if (m2v.x() < 0) {
-            m2v.x() = nCells_.x() - 1; 
-          }
-          
-          if (m2v.y() >= nCells_.y()) {
-            m2v.y() = 0;           
-          } else if (m2v.y() < 0) {
-            m2v.y() = nCells_.y() - 1; 
+        for (unsigned int os = 0; os < cellOffsets_.size(); os++) {
+          Vector3i m2v = whichCell + cellOffsets_[os];
+          for (int d = 0; d < 3; d++) {
+            if (m2v[d] >= nCells_[d]) m2v[d] -= nCells_[d];
+            else if (m2v[d] < 0) m2v[d] += nCells_[d];
           }
+          int m2 = cellSlot_[Vlinear(m2v, nCells_)];
+          bool ordered = orderedOffset_[os];
           
-          if (m2v.z() >= nCells_.z()) {
-            m2v.z() = 0;           
-          } else if (m2v.z() < 0) {
-            m2v.z() = nCells_.z() - 1; 
-          }
-          int m2 = Vlinear (m2v, nCells_);                                      
-#ifdef IS_MPI
-          for (vector<int>::iterator j2 = cellListCol_[m2].begin(); 
-               j2 != cellListCol_[m2].end(); ++j2) {
+          for (int k = cellStart_[m2]; k < cellStart_[m2 + 1]; k++) {
+            int j2 = cellGroups_[k];
+            
+            // For the self-inverse offsets (including the home cell),
+            // both cells see each other, so keep the pair once.  Note
+            // that Rappaport's code has a "less than" conditional here,
+            // but that deals with atom-by-atom computation.  OpenMD
+            // allows atoms within a single cutoff group to interact
+            // with each other.
+            if (ordered && j2 < j1) continue;
             
-            // In parallel, we need to visit *all* pairs of row
-            // & column indicies and will divide labor in the
-            // force evaluation later.
-            dr = cgColData.position[(*j2)] - rs;
+            dr = cellPositions_[k] - rs;
             if (usePeriodicBoundaryConditions_) {
               snap_->wrapVector(dr);
             }
             if (dr.lengthSquare() < rListSq_) {
-              neighborList.push_back( (*j2) );
-              ++len;
-            }                 
-          }        
-#else
-          for (vector<int>::iterator j2 = cellList_[m2].begin(); 
-               j2 != cellList_[m2].end(); ++j2) {
-          
-            // Always do this if we're in different cells or if
-            // we're in the same cell and the global index of
-            // the j2 cutoff group is greater than or equal to
-            // the j1 cutoff group.  Note that Rappaport's code
-            // has a "less than" conditional here, but that
-            // deals with atom-by-atom computation.  OpenMD
-            // allows atoms within a single cutoff group to
-            // interact with each other.
-            
-            if ( (*j2) >= j1 ) {
-              
-              dr = snap_->cgData.position[(*j2)] - rs;
-              if (usePeriodicBoundaryConditions_) {
-                snap_->wrapVector(dr);
-              }
-              if ( dr.lengthSquare() < rListSq_) {
-                neighborList.push_back( (*j2) );
-                ++len;
-              }
+              buffer.push_back(j2);
             }
-          }                
-#endif
-        }
-      }      
-    } else {
-      // branch to do all cutoff group pairs
-#ifdef IS_MPI
-      for (int j1 = 0; j1 < nGroupsInRow_; j1++) {
-        point[j1] = len;
-        rs = cgRowData.position[j1];
-        for (int j2 = 0; j2 < nGroupsInCol_; j2++) {    
-          dr = cgColData.position[j2] - rs;
-          if (usePeriodicBoundaryConditions_) {
-            snap_->wrapVector(dr);
-          }
-          if (dr.lengthSquare() < rListSq_) {
-            neighborList.push_back( j2 );
-            ++len;
           }
         }
-      }      
-#else
-      // include all groups here.
-      for (int j1 = 0; j1 < nGroups_; j1++) {
-        point[j1] = len;
-        rs = snap_->cgData.position[j1];
-        // include self group interactions j2 == j1
-        for (int j2 = j1; j2 < nGroups_; j2++) {
-          dr = snap_->cgData.position[j2] - rs;
-          if (usePeriodicBoundaryConditions_) {
-            snap_->wrapVector(dr);
-          }
-          if (dr.lengthSquare() < rListSq_) {
-            neighborList.push_back( j2 );
-            ++len;
-          }
-        }    
+        rowCount_[j1] = buffer.size() - rowStart_[j1];
       }
-#endif
     }
 
-#ifdef IS_MPI
-    point[nGroupsInRow_] = len;
-#else
-    point[nGroups_] = len;
-#endif
+    // pack the lists back into row order:
+    point.resize(nRows + 1);
+    int len = 0;
+    for (int j1 = 0; j1 < nRows; j1++) {
+      point[j1] = len;
+      len += rowCount_[j1];
+    }
+    point[nRows] = len;
+
+    neighborList.resize(len);
+#pragma omp parallel for num_threads(nThreads_) schedule(static)
+    for (int j1 = 0; j1 < nRows; j1++) {
+      if (rowCount_[j1] > 0) {
+        vector<int>& buffer = threadNeighbors_[rowThread_[j1]];
+        copy(buffer.begin() + rowStart_[j1],
+             buffer.begin() + rowStart_[j1] + rowCount_[j1],
+             neighborList.begin() + point[j1]);
+      }
+    }
   
     // save the local cutoff group positions for the check that is
     // done on each loop:
-    saved_CG_positions_.clear();
-    saved_CG_positions_.reserve(nGroups_);
-    for (int i = 0; i < nGroups_; i++)
-      saved_CG_positions_.push_back(snap_->cgData.position[i]);
+    saved_CG_positions_ = snap_->cgData.position;
+
+    nNeighborListBuilds_++;
+    neighborListTime_ += wallTime() - tStart;
+  }
+
+  /**
+   * Returns the xyz-indices of the cell containing a position.
+   */
+  Vector3i ForceMatrixDecomposition::getCell(const Vector3d& pos,
+                                             const Mat3x3d& invBox) {
+    // scaled positions relative to the box vectors
+    Vector3d scaled = invBox * pos;
+    Vector3i whichCell;
+
+    // wrap the vector back into the unit box by subtracting integer box 
+    // numbers
+    for (int j = 0; j < 3; j++) {
+      scaled[j] -= roundMe(scaled[j]);
+      scaled[j] += 0.5;
+      // Handle the special case when an object is exactly on the
+      // boundary (a scaled coordinate of 1.0 is the same as
+      // scaled coordinate of 0.0)
+      if (scaled[j] >= 1.0) scaled[j] -= 1.0;
+
+      whichCell[j] = int(nCells_[j] * scaled[j]);
+      // guard against round-off at the upper edge:
+      if (whichCell[j] >= nCells_[j]) whichCell[j] = nCells_[j] - 1;
+      if (whichCell[j] < 0) whichCell[j] = 0;
+    }
+    return whichCell;
   }
     
     
@@ -1688,6 +1947,22 @@ namespace OpenMD {
       return AtomLocalToGlobal[atom1];
 #else
       return atom1;
+#endif
+    }
+
+    int ForceMatrixDecomposition::getIdentRow(int atom1) {
+#ifdef IS_MPI
+      return identsRow[atom1];
+#else
+      return idents[atom1];
+#endif
+    }
+
+    int ForceMatrixDecomposition::getIdentCol(int atom2) {
+#ifdef IS_MPI
+      return identsCol[atom2];
+#else
+      return idents[atom2];
 #endif
     }
 } //end namespace OpenMD
@@ -66,15 +66,25 @@ namespace OpenMD {
     void collectSelfData();
     void collectData();
 
+    void startDistributeData();
+    void finishDistributeData();
+    void startCollectData();
+    void finishCollectData();
+
+    // threaded pair loop support
+    void setNumberOfThreads(int nThreads);
+    void collectThreadIntermediateData();
+    void collectThreadData();
+
     // neighbor list routines
     void buildNeighborList(vector<int>& neighborList, vector<int>& point);
 
     // group bookkeeping
-    Vector3d& getGroupVelocityColumn(int cg2);
+    Vector3d getGroupVelocityColumn(int cg2);
 
     // Group->atom bookkeeping
-    vector<int>& getAtomsInGroupRow(int cg1);
-    vector<int>& getAtomsInGroupColumn(int cg2);
+    AtomSpan getAtomsInGroupRow(int cg1);
+    AtomSpan getAtomsInGroupColumn(int cg2);
     Vector3d getAtomToGroupVectorRow(int atom1, int cg1);
     Vector3d getAtomToGroupVectorColumn(int atom2, int cg2);
     RealType& getMassFactorRow(int atom1);
@@ -93,15 +103,18 @@ namespace OpenMD {
     int getGlobalIDRow(int atom1);
     int getGlobalIDCol(int atom1);
     int getGlobalID(int atom1);
-    void addForceToAtomRow(int atom1, Vector3d fg);
-    void addForceToAtomColumn(int atom2, Vector3d fg);
-    Vector3d& getAtomVelocityColumn(int atom2);
+    int getIdentRow(int atom1);
+    int getIdentCol(int atom2);
+    void addForceToAtomRow(int atom1, Vector3d fg, int tid = 0);
+    void addForceToAtomColumn(int atom2, Vector3d fg, int tid = 0);
+    Vector3d getAtomVelocityColumn(int atom2);
 
     // filling interaction blocks with pointers
-    void fillInteractionData(InteractionData &idat, int atom1, int atom2, bool newAtom1 = true);
-    void unpackInteractionData(InteractionData &idat, int atom1, int atom2);
+    void fillInteractionData(InteractionData &idat, int atom1, int atom2, bool newAtom1 = true, int tid = 0);
+    void unpackInteractionData(InteractionData &idat, int atom1, int atom2, int tid = 0);
+    void unpackPairBatch(PairBatch &batch, int atom1, bool doParticlePot, int tid = 0);
 
-  private:     
+  protected:     
     int nLocal_;
     int nGroups_;
     vector<int> AtomLocalToGlobal;
@@ -109,6 +122,52 @@ namespace OpenMD {
     vector<RealType> groupCutoff;
     vector<int> groupToGtype;
 
+    /**
+     * Private accumulators for one thread of a threaded pair loop.
+     * Thread 0 works directly on the decomposition's own arrays; every
+     * other thread accumulates into one of these, and the results are
+     * folded back in by collectThreadIntermediateData and
+     * collectThreadData.  In serial, only rowData is used.
+     */
+    struct ThreadData {
+      DataStorage rowData;
+      DataStorage colData;
+      potVec pairwisePot;
+      potVec excludedPot;
+      potVec selectedPot;
+#ifdef IS_MPI
+      vector<potVec> pot_row;
+      vector<potVec> pot_col;
+      vector<potVec> expot_row;
+      vector<potVec> expot_col;
+      vector<potVec> selepot_row;
+      vector<potVec> selepot_col;
+#endif
+    };
+    vector<ThreadData> threadData_; /**< entry 0 is unused */
+    int threadLayout_;  /**< accumulated properties in threadData_ */
+
+    void allocateThreadData();
+    void zeroThreadData();
+
+    Vector3i getCell(const Vector3d& pos, const Mat3x3d& invBox);
+
+    // neighbor list work arrays, kept between builds:
+    vector<int> colCell_;
+    vector<int> cellFill_;
+    vector<int> rowOrder_;
+    vector<int> rowStart_;
+    vector<int> rowCount_;
+    vector<int> rowThread_;
+    vector<vector<int> > threadNeighbors_;
+
+    void buildTopology(const vector<int>& rowToGlobal,
+                       const vector<int>& colToGlobal);
+    void buildGroupLists(const vector<int>& groupToGlobal,
+                         const vector<int>& atomToGlobal,
+                         const vector<int>& globalGroupMembership,
+                         vector<int>& offsets, vector<int>& atoms);
+
 #ifdef IS_MPI    
     DataStorage atomRowData;
     DataStorage atomColData;
@@ -150,6 +209,24 @@ namespace OpenMD {
     vector<potVec> selepot_row;
     vector<potVec> selepot_col;
 
+    /**
+     * Receive buffers for the non-blocking reduce-scatters in
+     * startCollectData.  finishCollectData adds them into the local
+     * arrays.
+     */
+    DataStorage rowReturn_;
+    DataStorage colReturn_;
+    vector<potVec> potRowReturn_;
+    vector<potVec> expotRowReturn_;
+    vector<potVec> selepotRowReturn_;
+    vector<potVec> potColReturn_;
+    vector<potVec> expotColReturn_;
+    vector<potVec> selepotColReturn_;
+
+    /** requests in flight between the start and finish calls */
+    vector<MPI_Request> requests_;
+    void waitForRequests();
+
     vector<int> identsRow;
     vector<int> identsCol;
 
@@ -166,12 +243,12 @@ public:
     vector<int> cgRowToGlobal;
     vector<int> cgColToGlobal;
 
-private:
-    vector<vector<int> > cellListRow_;
-    vector<vector<int> > cellListCol_;
+protected:
 
-    vector<vector<int> > groupListRow_;
-    vector<vector<int> > groupListCol_;
+    vector<int> groupOffsetsRow_;
+    vector<int> groupAtomsRow_;
+    vector<int> groupOffsetsCol_;
+    vector<int> groupAtomsCol_;
 
     vector<RealType> massFactorsRow;
     vector<RealType> massFactorsCol;
@@ -0,0 +1,824 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+
+#include "parallel/ForceSpatialDecomposition.hpp"
+#include "brains/PairList.hpp"
+#include "utils/simError.h"
+#include "utils/Utility.hpp"
+
+#include <algorithm>
+
+using namespace std;
+namespace OpenMD {
+
+  ForceSpatialDecomposition::ForceSpatialDecomposition(SimInfo* info,
+                                                       InteractionManager* iMan) : ForceMatrixDecomposition(info, iMan) {
+#ifdef IS_MPI
+    layoutCurrent_ = false;
+    atomPlan_ = NULL;
+    cgPlan_ = NULL;
+    dynamicBalance_ = info->getSimParams()->getDynamicLoadBalancing();
+#endif
+  }
+
+  ForceSpatialDecomposition::~ForceSpatialDecomposition() {
+#ifdef IS_MPI
+    delete atomPlan_;
+    delete cgPlan_;
+#endif
+  }
+
+#ifdef IS_MPI
+  /**
+   * Perpendicular widths of a (possibly triclinic) box.
+   */
+  static Vector3d boxWidths(Mat3x3d box) {
+    Vector3d A = box.getColumn(0);
+    Vector3d B = box.getColumn(1);
+    Vector3d C = box.getColumn(2);
+    Vector3d AxB = cross(A, B);
+    Vector3d BxC = cross(B, C);
+    Vector3d CxA = cross(C, A);
+    AxB.normalize();
+    BxC.normalize();
+    CxA.normalize();
+    return Vector3d(abs(dot(A, BxC)), abs(dot(B, CxA)), abs(dot(C, AxB)));
+  }
+
+  template<typename T>
+  static void copyToRows(vector<T>& col, vector<T>& row,
+                         const vector<int>& rowToCol) {
+    for (unsigned int i = 0; i < rowToCol.size(); i++)
+      row[i] = col[rowToCol[i]];
+  }
+
+  static void copyToRows(Vector3dArray& col, Vector3dArray& row,
+                         const vector<int>& rowToCol) {
+    for (unsigned int i = 0; i < rowToCol.size(); i++)
+      row[i] = Vector3d(col[rowToCol[i]]);
+  }
+
+  /**
+   * Adds the values accumulated on the rows into the matching
+   * columns, so that only the columns need to be sent home.
+   */
+  template<typename T>
+  static void foldRows(vector<T>& row, vector<T>& col,
+                       const vector<int>& rowToCol) {
+    for (unsigned int i = 0; i < rowToCol.size(); i++)
+      col[rowToCol[i]] += row[i];
+  }
+
+  static void foldRows(Vector3dArray& row, Vector3dArray& col,
+                       const vector<int>& rowToCol) {
+    for (unsigned int i = 0; i < rowToCol.size(); i++)
+      col[rowToCol[i]] += Vector3d(row[i]);
+  }
+#endif
+
+  void ForceSpatialDecomposition::distributeInitialData() {
+#ifndef IS_MPI
+    ForceMatrixDecomposition::distributeInitialData();
+#else
+    snap_ = sman_->getCurrentSnapshot();
+    storageLayout_ = sman_->getStorageLayout();
+    ff_ = info_->getForceField();
+    nLocal_ = snap_->getNumberOfAtoms();
+    nGroups_ = info_->getNLocalCutoffGroups();
+
+    idents = info_->getIdentArray();
+    regions = info_->getRegions();
+    AtomLocalToGlobal = info_->getGlobalAtomIndices();
+    cgLocalToGlobal = info_->getGlobalGroupIndices();
+    vector<int> globalGroupMembership = info_->getGlobalGroupMembership();
+    massFactors = info_->getMassFactors();
+
+    // the cutoff groups use the same array layout as the atoms:
+    int cgLayout = DataStorage::dslPosition | 
+      (storageLayout_ & DataStorage::dslStructureOfArrays);
+    if (needVelocities_) cgLayout |= DataStorage::dslVelocity;
+    snap_->cgData.setStorageLayout(cgLayout);
+
+    atomRowData.setStorageLayout(storageLayout_);
+    atomColData.setStorageLayout(storageLayout_);
+    cgRowData.setStorageLayout(cgLayout & ~DataStorage::dslVelocity);
+    cgColData.setStorageLayout(cgLayout);
+
+    atypesLocal.resize(nLocal_);
+    for (int i = 0; i < nLocal_; i++) 
+      atypesLocal[i] = ff_->getAtomType(idents[i]);
+
+    buildGroupLists(cgLocalToGlobal, AtomLocalToGlobal, globalGroupMembership,
+                    groupOffsets_, groupAtoms_);
+
+    globalToCol_.assign(info_->getNGlobalAtoms(), -1);
+    buildLocalTopology();
+    // a renumbering of the local atoms keeps the (possibly balanced)
+    // domain boundaries:
+    if (bounds_[0].empty()) chooseDomainGrid();
+    saved_CG_positions_.clear();
+
+    // the groups are assigned to their domains once the positions of
+    // the cutoff groups are known, in the first distributeData:
+    delete atomPlan_;
+    delete cgPlan_;
+    atomPlan_ = NULL;
+    cgPlan_ = NULL;
+    layoutCurrent_ = false;
+    nAtomsInRow_ = 0;
+    nAtomsInCol_ = 0;
+    nGroupsInRow_ = 0;
+    nGroupsInCol_ = 0;
+
+    allocateThreadData();
+#endif
+  }
+
+#ifdef IS_MPI
+  /**
+   * Collects the exclusions and 1-2, 1-3, and 1-4 partners of each
+   * local atom.  The pair lists only hold the pairs from the local
+   * molecules, so the lists have to travel with the atoms.
+   */
+  void ForceSpatialDecomposition::buildLocalTopology() {
+    vector<int> globalToLocal(info_->getNGlobalAtoms(), -1);
+    for (int i = 0; i < nLocal_; i++)
+      globalToLocal[AtomLocalToGlobal[i]] = i;
+
+    localExcludes_.assign(nLocal_, vector<int>());
+    localTopos_.assign(nLocal_, vector<int>());
+    localTopoDist_.assign(nLocal_, vector<int>());
+
+    // the closest topological relationship is the one that counts, so
+    // the 1-2 pairs are added first:
+    PairList* lists[4] = {info_->getExcludedInteractions(),
+                          info_->getOneTwoInteractions(),
+                          info_->getOneThreeInteractions(),
+                          info_->getOneFourInteractions()};
+
+    for (int l = 0; l < 4; l++) {
+      int nPairs = lists[l]->getSize();
+      int* pairs = lists[l]->getPairList();
+
+      for (int k = 0; k < nPairs; k++) {
+        // the pair list is 1-based:
+        int gid[2] = {pairs[2 * k] - 1, pairs[2 * k + 1] - 1};
+
+        for (int m = 0; m < 2; m++) {
+          int i = globalToLocal[gid[m]];
+          int partner = gid[1 - m];
+          if (i < 0) continue;
+
+          if (l == 0) {
+            localExcludes_[i].push_back(partner);
+          } else if (find(localTopos_[i].begin(), localTopos_[i].end(),
+                          partner) == localTopos_[i].end()) {
+            localTopos_[i].push_back(partner);
+            localTopoDist_[i].push_back(l);
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * Picks the grid of domains which has the smallest surface area for
+   * the starting box.  The halo of each domain grows with its surface.
+   */
+  void ForceSpatialDecomposition::chooseDomainGrid() {
+    int nProcs;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+
+    Vector3d widths(1.0);
+    if (usePeriodicBoundaryConditions_)
+      widths = boxWidths(snap_->getHmat());
+
+    RealType bestArea = -1.0;
+    for (int nx = 1; nx <= nProcs; nx++) {
+      if (nProcs % nx != 0) continue;
+      for (int ny = 1; ny <= nProcs / nx; ny++) {
+        if ((nProcs / nx) % ny != 0) continue;
+        int nz = nProcs / (nx * ny);
+        RealType lx = widths[0] / nx;
+        RealType ly = widths[1] / ny;
+        RealType lz = widths[2] / nz;
+        RealType area = lx * ly + ly * lz + lz * lx;
+        if (bestArea < 0.0 || area < bestArea) {
+          bestArea = area;
+          nDomains_ = Vector3i(nx, ny, nz);
+        }
+      }
+    }
+
+    for (int d = 0; d < 3; d++) {
+      bounds_[d].resize(nDomains_[d] + 1);
+      for (int k = 0; k <= nDomains_[d]; k++)
+        bounds_[d][k] = RealType(k) / nDomains_[d];
+    }
+
+    sprintf(painCave.errMsg,
+            "ForceSpatialDecomposition: using a %d x %d x %d grid of "
+            "domains.\n", nDomains_[0], nDomains_[1], nDomains_[2]);
+    painCave.severity = OPENMD_INFO;
+    painCave.isFatal = 0;
+    simError();
+  }
+
+  /**
+   * Moves the domain boundaries to even out the pair loop times
+   * measured since the last call.  Along each box vector, the time of
+   * a slab is the sum over its domains.  Spreading each slab's time
+   * evenly across its width gives a cumulative load, and the new
+   * boundaries split that evenly.  The boundaries only move half way
+   * there, and no slab gets thinner than half of its uniform width.
+   * Every processor has the same times, so they all agree on the new
+   * boundaries.
+   */
+  void ForceSpatialDecomposition::balanceDomains() {
+    int nProcs;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+
+    vector<RealType> times(nProcs, 0.0);
+    MPI_Allgather(&pairLoopTime_, 1, MPI_REALTYPE, &times[0], 1,
+                  MPI_REALTYPE, MPI_COMM_WORLD);
+    pairLoopTime_ = 0.0;
+
+    RealType total(0.0), slowest(0.0);
+    for (int p = 0; p < nProcs; p++) {
+      total += times[p];
+      slowest = max(slowest, times[p]);
+    }
+    // nothing measured yet, or within 5% of a perfect balance:
+    if (total <= 0.0 || slowest < 1.05 * total / nProcs) return;
+
+    for (int d = 0; d < 3; d++) {
+      int n = nDomains_[d];
+      if (n == 1) continue;
+
+      vector<RealType> load(n, 0.0);
+      for (int p = 0; p < nProcs; p++) {
+        Vector3i c(p % nDomains_[0], (p / nDomains_[0]) % nDomains_[1],
+                   p / (nDomains_[0] * nDomains_[1]));
+        load[c[d]] += times[p];
+      }
+
+      vector<RealType>& b = bounds_[d];
+      vector<RealType> target(b);
+      RealType sum = 0.0;
+      int k = 0;
+      for (int m = 1; m < n; m++) {
+        RealType want = total * m / n;
+        while (k < n - 1 && sum + load[k] < want) {
+          sum += load[k];
+          k++;
+        }
+        RealType frac = (load[k] > 0.0) ? (want - sum) / load[k] : 0.5;
+        frac = min(max(frac, RealType(0.0)), RealType(1.0));
+        target[m] = b[k] + frac * (b[k + 1] - b[k]);
+      }
+
+      RealType minWidth = 0.5 / n;
+      for (int m = 1; m < n; m++) 
+        b[m] = 0.5 * (b[m] + target[m]);
+      for (int m = 1; m < n; m++) 
+        b[m] = max(b[m], b[m - 1] + minWidth);
+      for (int m = n - 1; m > 0; m--) 
+        b[m] = min(b[m], b[m + 1] - minWidth);
+    }
+  }
+
+  /**
+   * Assigns every cutoff group to the domain containing its center,
+   * and to the halos of the domains within rList of it, then rebuilds
+   * the row and column data for the new layout.
+   *
+   * Each processor sends its own groups to their home and halo
+   * domains, along with the atomic identities and (for the home
+   * domain only) the exclusion and topology lists.  The copies
+   * arrive in order of the sending processor, which is the column
+   * order; the home groups among them are the rows.
+   */
+  void ForceSpatialDecomposition::migrateGroups() {
+    int nProcs;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+
+    snap_ = sman_->getCurrentSnapshot();
+    storageLayout_ = sman_->getStorageLayout();
+    nLocal_ = snap_->getNumberOfAtoms();
+
+    Mat3x3d box, invBox;
+    if (!usePeriodicBoundaryConditions_) {
+      box = snap_->getBoundingBox();
+      invBox = snap_->getInvBoundingBox();
+    } else {
+      box = snap_->getHmat();
+      invBox = snap_->getInvHmat();
+    }
+
+    // the halo thickness along each box vector, in scaled coordinates:
+    Vector3d widths = boxWidths(box);
+    Vector3d halo;
+    for (int d = 0; d < 3; d++)
+      halo[d] = rList_ / widths[d];
+
+    vector<vector<int> > sendGroups(nProcs);
+    vector<vector<int> > sendAtoms(nProcs);
+    vector<vector<int> > sendInts(nProcs);
+    vector<vector<RealType> > sendReals(nProcs);
+    vector<int> near[3];
+    Vector3i home;
+
+    for (int cg = 0; cg < nGroups_; cg++) {
+      Vector3d scaled = invBox * Vector3d(snap_->cgData.position[cg]);
+
+      for (int d = 0; d < 3; d++) {
+        int n = nDomains_[d];
+        RealType s = scaled[d] - floor(scaled[d]);
+        if (s >= 1.0) s -= 1.0;
+        const vector<RealType>& b = bounds_[d];
+        home[d] = 0;
+        while (home[d] < n - 1 && s >= b[home[d] + 1]) home[d]++;
+
+        // domains whose slab along this box vector is within the halo
+        // thickness of the group:
+        near[d].clear();
+        for (int k = 0; k < n; k++) {
+          RealType lo = b[k];
+          RealType hi = b[k + 1];
+          RealType dist = 0.0;
+          if (k != home[d]) {
+            RealType dlo = lo - s;
+            RealType dhi = s - hi;
+            dist = min(dlo - floor(dlo), dhi - floor(dhi));
+          }
+          if (k == home[d] || dist < halo[d]) near[d].push_back(k);
+        }
+      }
+
+      int homeProc = home[0] + nDomains_[0] * (home[1] + nDomains_[1] *
+                                               home[2]);
+
+      for (unsigned int i = 0; i < near[0].size(); i++) {
+        for (unsigned int j = 0; j < near[1].size(); j++) {
+          for (unsigned int k = 0; k < near[2].size(); k++) {
+            int p = near[0][i] + nDomains_[0] * (near[1][j] + nDomains_[1] *
+                                                 near[2][k]);
+            bool isHome = (p == homeProc);
+            vector<int>& ints = sendInts[p];
+
+            sendGroups[p].push_back(cg);
+            ints.push_back(cgLocalToGlobal[cg]);
+            ints.push_back(isHome);
+            ints.push_back(groupOffsets_[cg + 1] - groupOffsets_[cg]);
+
+            for (int m = groupOffsets_[cg]; m < groupOffsets_[cg + 1]; m++) {
+              int atom = groupAtoms_[m];
+              sendAtoms[p].push_back(atom);
+              sendReals[p].push_back(massFactors[atom]);
+              ints.push_back(AtomLocalToGlobal[atom]);
+              ints.push_back(idents[atom]);
+              ints.push_back(regions[atom]);
+
+              if (isHome) {
+                ints.push_back(localExcludes_[atom].size());
+                ints.insert(ints.end(), localExcludes_[atom].begin(),
+                            localExcludes_[atom].end());
+                ints.push_back(localTopos_[atom].size());
+                for (unsigned int t = 0; t < localTopos_[atom].size(); t++) {
+                  ints.push_back(localTopos_[atom][t]);
+                  ints.push_back(localTopoDist_[atom][t]);
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+
+    // exchange the group descriptions:
+    vector<int> intCounts(nProcs), intDispls(nProcs);
+    vector<int> realCounts(nProcs), realDispls(nProcs);
+    vector<int> recvIntCounts(nProcs), recvIntDispls(nProcs);
+    vector<int> recvRealCounts(nProcs), recvRealDispls(nProcs);
+    vector<RealType> realBuffer;
+    vector<int> intBuffer;
+
+    for (int p = 0; p < nProcs; p++) {
+      intDispls[p] = intBuffer.size();
+      intCounts[p] = sendInts[p].size();
+      intBuffer.insert(intBuffer.end(), sendInts[p].begin(),
+                       sendInts[p].end());
+      realDispls[p] = realBuffer.size();
+      realCounts[p] = sendReals[p].size();
+      realBuffer.insert(realBuffer.end(), sendReals[p].begin(),
+                        sendReals[p].end());
+    }
+
+    MPI_Alltoall(&intCounts[0], 1, MPI_INT, &recvIntCounts[0], 1, MPI_INT,
+                 MPI_COMM_WORLD);
+    MPI_Alltoall(&realCounts[0], 1, MPI_INT, &recvRealCounts[0], 1, MPI_INT,
+                 MPI_COMM_WORLD);
+
+    int nRecvInts = 0;
+    int nRecvReals = 0;
+    for (int p = 0; p < nProcs; p++) {
+      recvIntDispls[p] = nRecvInts;
+      nRecvInts += recvIntCounts[p];
+      recvRealDispls[p] = nRecvReals;
+      nRecvReals += recvRealCounts[p];
+    }
+
+    vector<int> recvInts(max(nRecvInts, 1));
+    vector<RealType> recvReals(max(nRecvReals, 1));
+    intBuffer.resize(max(int(intBuffer.size()), 1));
+    realBuffer.resize(max(int(realBuffer.size()), 1));
+
+    MPI_Alltoallv(&intBuffer[0], &intCounts[0], &intDispls[0], MPI_INT,
+                  &recvInts[0], &recvIntCounts[0], &recvIntDispls[0],
+                  MPI_INT, MPI_COMM_WORLD);
+    MPI_Alltoallv(&realBuffer[0], &realCounts[0], &realDispls[0],
+                  MPI_REALTYPE, &recvReals[0], &recvRealCounts[0],
+                  &recvRealDispls[0], MPI_REALTYPE, MPI_COMM_WORLD);
+
+    // unpack the groups into the column (all copies) and row (home
+    // copies) arrays:
+    cgColToGlobal.clear();
+    cgRowToGlobal.clear();
+    cgRowToCol_.clear();
+    groupOffsetsCol_.clear();
+    groupOffsetsRow_.clear();
+    AtomColToGlobal.clear();
+    AtomRowToGlobal.clear();
+    atomRowToCol_.clear();
+    identsCol.clear();
+    identsRow.clear();
+    regionsCol.clear();
+    regionsRow.clear();
+    massFactorsCol.clear();
+    massFactorsRow.clear();
+    excludesForAtom.clear();
+    toposForAtom.clear();
+    topoDist.clear();
+
+    int pos = 0;
+    int rpos = 0;
+    while (pos < nRecvInts) {
+      int cgGlobal = recvInts[pos++];
+      bool isHome = recvInts[pos++];
+      int nAtoms = recvInts[pos++];
+
+      if (isHome) {
+        cgRowToCol_.push_back(cgColToGlobal.size());
+        cgRowToGlobal.push_back(cgGlobal);
+        groupOffsetsRow_.push_back(AtomRowToGlobal.size());
+      }
+      cgColToGlobal.push_back(cgGlobal);
+      groupOffsetsCol_.push_back(AtomColToGlobal.size());
+
+      for (int a = 0; a < nAtoms; a++) {
+        int gid = recvInts[pos++];
+        int ident = recvInts[pos++];
+        int region = recvInts[pos++];
+        RealType mf = recvReals[rpos++];
+
+        if (isHome) {
+          atomRowToCol_.push_back(AtomColToGlobal.size());
+          AtomRowToGlobal.push_back(gid);
+          identsRow.push_back(ident);
+          regionsRow.push_back(region);
+          massFactorsRow.push_back(mf);
+
+          // the partners are kept as global indices until all of the
+          // columns are known:
+          int nExcludes = recvInts[pos++];
+          excludesForAtom.push_back(vector<int>(recvInts.begin() + pos,
+                                                recvInts.begin() + pos +
+                                                nExcludes));
+          pos += nExcludes;
+          int nTopos = recvInts[pos++];
+          toposForAtom.push_back(vector<int>(nTopos));
+          topoDist.push_back(vector<int>(nTopos));
+          for (int t = 0; t < nTopos; t++) {
+            toposForAtom.back()[t] = recvInts[pos++];
+            topoDist.back()[t] = recvInts[pos++];
+          }
+        }
+        AtomColToGlobal.push_back(gid);
+        identsCol.push_back(ident);
+        regionsCol.push_back(region);
+        massFactorsCol.push_back(mf);
+      }
+    }
+
+    nAtomsInRow_ = AtomRowToGlobal.size();
+    nAtomsInCol_ = AtomColToGlobal.size();
+    nGroupsInRow_ = cgRowToGlobal.size();
+    nGroupsInCol_ = cgColToGlobal.size();
+    groupOffsetsRow_.push_back(nAtomsInRow_);
+    groupOffsetsCol_.push_back(nAtomsInCol_);
+
+    // the atoms of each group were received together:
+    groupAtomsRow_.resize(nAtomsInRow_);
+    for (int i = 0; i < nAtomsInRow_; i++) groupAtomsRow_[i] = i;
+    groupAtomsCol_.resize(nAtomsInCol_);
+    for (int j = 0; j < nAtomsInCol_; j++) groupAtomsCol_[j] = j;
+
+    // switch the exclusion and topology partners over to column
+    // indices.  Partners outside the halo can't be in the neighbor
+    // list, so they are dropped:
+    for (int j = 0; j < nAtomsInCol_; j++)
+      globalToCol_[AtomColToGlobal[j]] = j;
+
+    for (int i = 0; i < nAtomsInRow_; i++) {
+      vector<int>& ex = excludesForAtom[i];
+      int n = 0;
+      for (unsigned int k = 0; k < ex.size(); k++)
+        if (globalToCol_[ex[k]] >= 0) ex[n++] = globalToCol_[ex[k]];
+      ex.resize(n);
+
+      vector<int>& tp = toposForAtom[i];
+      vector<int>& td = topoDist[i];
+      n = 0;
+      for (unsigned int k = 0; k < tp.size(); k++) {
+        if (globalToCol_[tp[k]] >= 0) {
+          tp[n] = globalToCol_[tp[k]];
+          td[n] = td[k];
+          n++;
+        }
+      }
+      tp.resize(n);
+      td.resize(n);
+    }
+
+    for (int j = 0; j < nAtomsInCol_; j++)
+      globalToCol_[AtomColToGlobal[j]] = -1;
+
+    // size the row and column storage for the new layout:
+    atomRowData.resize(nAtomsInRow_);
+    atomColData.resize(nAtomsInCol_);
+    cgRowData.resize(nGroupsInRow_);
+    cgColData.resize(nGroupsInCol_);
+
+    atypesRow.resize(nAtomsInRow_);
+    atypesCol.resize(nAtomsInCol_);
+    for (int i = 0; i < nAtomsInRow_; i++) 
+      atypesRow[i] = ff_->getAtomType(identsRow[i]);
+    for (int j = 0; j < nAtomsInCol_; j++) 
+      atypesCol[j] = ff_->getAtomType(identsCol[j]);
+
+    pot_row.resize(nAtomsInRow_);
+    pot_col.resize(nAtomsInCol_);
+    expot_row.resize(nAtomsInRow_);
+    expot_col.resize(nAtomsInCol_);
+    selepot_row.resize(nAtomsInRow_);
+    selepot_col.resize(nAtomsInCol_);
+
+    delete atomPlan_;
+    delete cgPlan_;
+    atomPlan_ = new ExchangePlan(MPI_COMM_WORLD, sendAtoms);
+    cgPlan_ = new ExchangePlan(MPI_COMM_WORLD, sendGroups);
+
+    allocateThreadData();
+  }
+
+  /**
+   * Sends the local atomic and group data out to the home and halo
+   * copies.  Everything lands in the columns, and the rows are copied
+   * from their columns.
+   */
+  void ForceSpatialDecomposition::exchangeData() {
+    atomPlan_->gather(snap_->atomData.position, atomColData.position);
+    cgPlan_->gather(snap_->cgData.position, cgColData.position);
+    copyToRows(atomColData.position, atomRowData.position, atomRowToCol_);
+    copyToRows(cgColData.position, cgRowData.position, cgRowToCol_);
+
+    if (needVelocities_) {
+      atomPlan_->gather(snap_->atomData.velocity, atomColData.velocity);
+      cgPlan_->gather(snap_->cgData.velocity, cgColData.velocity);
+    }
+
+    if (storageLayout_ & DataStorage::dslAmat) {
+      atomPlan_->gather(snap_->atomData.aMat, atomColData.aMat);
+      copyToRows(atomColData.aMat, atomRowData.aMat, atomRowToCol_);
+    }
+
+    if (storageLayout_ & DataStorage::dslDipole) {
+      atomPlan_->gather(snap_->atomData.dipole, atomColData.dipole);
+      copyToRows(atomColData.dipole, atomRowData.dipole, atomRowToCol_);
+    }
+
+    if (storageLayout_ & DataStorage::dslQuadrupole) {
+      atomPlan_->gather(snap_->atomData.quadrupole, atomColData.quadrupole);
+      copyToRows(atomColData.quadrupole, atomRowData.quadrupole,
+                 atomRowToCol_);
+    }
+
+    if (storageLayout_ & DataStorage::dslFlucQPosition) {
+      atomPlan_->gather(snap_->atomData.flucQPos, atomColData.flucQPos);
+      copyToRows(atomColData.flucQPos, atomRowData.flucQPos, atomRowToCol_);
+    }
+  }
+#endif
+
+  void ForceSpatialDecomposition::distributeData() {
+#ifdef IS_MPI
+    snap_ = sman_->getCurrentSnapshot();
+    storageLayout_ = sman_->getStorageLayout();
+
+    if (atomPlan_ == NULL) {
+      migrateGroups();
+      zeroWorkArrays();
+      layoutCurrent_ = true;
+    }
+    exchangeData();
+#endif
+  }
+
+  /**
+   * Migrates the groups to their current domains before building the
+   * neighbor list over each domain and its halo.
+   */
+  void ForceSpatialDecomposition::buildNeighborList(vector<int>& neighborList,
+                                                    vector<int>& point) {
+#ifdef IS_MPI
+    if (!layoutCurrent_) {
+      RealType tStart = wallTime();
+      if (dynamicBalance_) balanceDomains();
+      migrateGroups();
+      zeroWorkArrays();
+      exchangeData();
+      neighborListTime_ += wallTime() - tStart;
+    }
+    layoutCurrent_ = false;
+#endif
+    ForceMatrixDecomposition::buildNeighborList(neighborList, point);
+  }
+
+  /* collects information obtained during the pre-pair loop onto local
+   * data structures.
+   */
+  void ForceSpatialDecomposition::collectIntermediateData() {
+#ifdef IS_MPI
+    snap_ = sman_->getCurrentSnapshot();
+    storageLayout_ = sman_->getStorageLayout();
+
+    if (storageLayout_ & DataStorage::dslDensity) {
+      foldRows(atomRowData.density, atomColData.density, atomRowToCol_);
+      atomPlan_->scatter(atomColData.density, snap_->atomData.density);
+    }
+#endif
+  }
+
+  /*
+   * redistributes information obtained during the pre-pair loop out to 
+   * row and column-indexed data structures
+   */
+  void ForceSpatialDecomposition::distributeIntermediateData() {
+#ifdef IS_MPI
+    snap_ = sman_->getCurrentSnapshot();
+    storageLayout_ = sman_->getStorageLayout();
+
+    if (storageLayout_ & DataStorage::dslFunctional) {
+      atomPlan_->gather(snap_->atomData.functional, atomColData.functional);
+      copyToRows(atomColData.functional, atomRowData.functional,
+                 atomRowToCol_);
+    }
+
+    if (storageLayout_ & DataStorage::dslFunctionalDerivative) {
+      atomPlan_->gather(snap_->atomData.functionalDerivative,
+                        atomColData.functionalDerivative);
+      copyToRows(atomColData.functionalDerivative,
+                 atomRowData.functionalDerivative, atomRowToCol_);
+    }
+#endif
+  }
+
+  /**
+   * The rows are folded into their columns, and the columns are sent
+   * back to the processors that own the atoms.
+   */
+  void ForceSpatialDecomposition::collectData() {
+#ifdef IS_MPI
+    snap_ = sman_->getCurrentSnapshot();
+    storageLayout_ = sman_->getStorageLayout();
+    nLocal_ = snap_->getNumberOfAtoms();
+
+    foldRows(atomRowData.force, atomColData.force, atomRowToCol_);
+    atomPlan_->scatter(atomColData.force, snap_->atomData.force);
+
+    if (storageLayout_ & DataStorage::dslTorque) {
+      foldRows(atomRowData.torque, atomColData.torque, atomRowToCol_);
+      atomPlan_->scatter(atomColData.torque, snap_->atomData.torque);
+    }
+
+    if (storageLayout_ & DataStorage::dslSkippedCharge) {
+      foldRows(atomRowData.skippedCharge, atomColData.skippedCharge,
+               atomRowToCol_);
+      atomPlan_->scatter(atomColData.skippedCharge,
+                         snap_->atomData.skippedCharge);
+    }
+
+    if (storageLayout_ & DataStorage::dslFlucQForce) {
+      foldRows(atomRowData.flucQFrc, atomColData.flucQFrc, atomRowToCol_);
+      atomPlan_->scatter(atomColData.flucQFrc, snap_->atomData.flucQFrc);
+    }
+
+    if (storageLayout_ & DataStorage::dslElectricField) {
+      foldRows(atomRowData.electricField, atomColData.electricField,
+               atomRowToCol_);
+      atomPlan_->scatter(atomColData.electricField,
+                         snap_->atomData.electricField);
+    }
+
+    if (storageLayout_ & DataStorage::dslSitePotential) {
+      foldRows(atomRowData.sitePotential, atomColData.sitePotential,
+               atomRowToCol_);
+      atomPlan_->scatter(atomColData.sitePotential,
+                         snap_->atomData.sitePotential);
+    }
+
+    foldRows(pot_row, pot_col, atomRowToCol_);
+    foldRows(expot_row, expot_col, atomRowToCol_);
+    foldRows(selepot_row, selepot_col, atomRowToCol_);
+
+    // every pair was computed on exactly one processor, so the
+    // totals can be summed without sending the per-atom values home:
+    for (int j = 0; j < nAtomsInCol_; j++) {
+      pairwisePot += pot_col[j];
+      excludedPot += expot_col[j];
+      selectedPot += selepot_col[j];
+    }
+
+    if (storageLayout_ & DataStorage::dslParticlePot) {
+      // This is the pairwise contribution to the particle pot.  The
+      // factor of two is because the pair potential was split evenly
+      // between the row and column atoms.
+      vector<potVec> pot_temp(nLocal_, 
+                              Vector<RealType, N_INTERACTION_FAMILIES> (0.0));
+      atomPlan_->scatter(pot_col, pot_temp);
+      for (int i = 0; i < nLocal_; i++) {
+        for (int ii = 0; ii < N_INTERACTION_FAMILIES; ii++) {
+          snap_->atomData.particlePot[i] += 2.0 * pot_temp[i](ii);
+        }
+      }
+
+      // This is the direct or embedding contribution to the particle
+      // pot.
+      foldRows(atomRowData.particlePot, atomColData.particlePot,
+               atomRowToCol_);
+      atomPlan_->scatter(atomColData.particlePot,
+                         snap_->atomData.particlePot);
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &pairwisePot[0], N_INTERACTION_FAMILIES,
+                  MPI_REALTYPE, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &excludedPot[0], N_INTERACTION_FAMILIES,
+                  MPI_REALTYPE, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &selectedPot[0], N_INTERACTION_FAMILIES,
+                  MPI_REALTYPE, MPI_SUM, MPI_COMM_WORLD);
+
+    MPI_Allreduce(MPI_IN_PLACE, 
+                  &snap_->frameData.conductiveHeatFlux[0], 3, 
+                  MPI_REALTYPE, MPI_SUM, MPI_COMM_WORLD);
+#endif
+  }
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2009 The University of Notre Dame. All Rights Reserved.
+ *
+ * The University of Notre Dame grants you ("Licensee") a
+ * non-exclusive, royalty free, license to use, modify and
+ * redistribute this software in source and binary code form, provided
+ * that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * This software is provided "AS IS," without a warranty of any
+ * kind. All express or implied conditions, representations and
+ * warranties, including any implied warranty of merchantability,
+ * fitness for a particular purpose or non-infringement, are hereby
+ * excluded.  The University of Notre Dame and its licensors shall not
+ * be liable for any damages suffered by licensee as a result of
+ * using, modifying or distributing the software or its
+ * derivatives. In no event will the University of Notre Dame or its
+ * licensors be liable for any lost revenue, profit or data, or for
+ * direct, indirect, special, consequential, incidental or punitive
+ * damages, however caused and regardless of the theory of liability,
+ * arising out of the use of or inability to use software, even if the
+ * University of Notre Dame has been advised of the possibility of
+ * such damages.
+ *
+ * SUPPORT OPEN SCIENCE!  If you use OpenMD or its source code in your
+ * research, please cite the appropriate papers when you publish your
+ * work.  Good starting points are:
+ *                                                                      
+ * [1]  Meineke, et al., J. Comp. Chem. 26, 252-271 (2005).             
+ * [2]  Fennell & Gezelter, J. Chem. Phys. 124, 234104 (2006).          
+ * [3]  Sun, Lin & Gezelter, J. Chem. Phys. 128, 234107 (2008).          
+ * [4]  Kuang & Gezelter,  J. Chem. Phys. 133, 164101 (2010).
+ * [5]  Vardeman, Stocker & Gezelter, J. Chem. Theory Comput. 7, 834 (2011).
+ */
+ 
+#ifndef PARALLEL_FORCESPATIALDECOMPOSITION_HPP
+#define PARALLEL_FORCESPATIALDECOMPOSITION_HPP
+
+#include "parallel/ForceMatrixDecomposition.hpp"
+
+using namespace std;
+namespace OpenMD {
+
+  /**
+   * @class ForceSpatialDecomposition
+   *
+   * A spatial (domain) decomposition of the non-bonded force loop.
+   * The simulation box is cut into a grid of domains, one per
+   * processor.  Each cutoff group has a home domain (the one holding
+   * its center), and each domain also keeps ghost copies of the
+   * groups that lie within rList of its boundary (the halo).  The
+   * rows are the home groups and the columns are the home and ghost
+   * groups, so the pair loop and the row / column bookkeeping of
+   * ForceMatrixDecomposition are reused unchanged.  Each neighbor
+   * list is built over a single domain and its halo.
+   *
+   * Home domains are reassigned every time the neighbor list is
+   * rebuilt, so groups migrate from one processor to another as they
+   * cross domain boundaries.  All communication is point-to-point
+   * between processors that share groups, so the traffic grows with
+   * the surface of a domain instead of with N / sqrt(P).
+   *
+   * The molecules themselves stay on the processor that created
+   * them: positions are sent from that processor directly to the
+   * home and halo domains, and forces are summed back the same way.
+   * In serial, this is identical to ForceMatrixDecomposition.
+   *
+   * With dynamicLoadBalancing, the domain boundaries along each box
+   * vector are moved before each migration so that the slabs of
+   * domains share the measured pair loop time evenly.
+   */
+  class ForceSpatialDecomposition : public ForceMatrixDecomposition {
+  public:
+    ForceSpatialDecomposition(SimInfo* info, InteractionManager* iMan);
+    ~ForceSpatialDecomposition();
+
+    void distributeInitialData();
+    void distributeData();
+    void collectIntermediateData();
+    void distributeIntermediateData();
+    void collectData();
+
+    // the halo exchanges are blocking
+    void startDistributeData() { distributeData(); }
+    void finishDistributeData() {}
+    void startCollectData() { collectData(); }
+    void finishCollectData() {}
+
+    void buildNeighborList(vector<int>& neighborList, vector<int>& point);
+
+#ifdef IS_MPI
+  private:
+    void chooseDomainGrid();
+    void buildLocalTopology();
+    void migrateGroups();
+    void exchangeData();
+    void balanceDomains();
+
+    Vector3i nDomains_;    /**< number of domains along each box vector */
+    /** 
+     * Domain boundaries along each box vector in scaled coordinates:
+     * slab k spans bounds_[d][k] to bounds_[d][k+1].
+     */
+    vector<RealType> bounds_[3];
+    bool dynamicBalance_;
+    bool layoutCurrent_;   /**< groups were just migrated by distributeData */
+
+    ExchangePlan* atomPlan_;
+    ExchangePlan* cgPlan_;
+
+    /** column index of each row atom and row group */
+    vector<int> atomRowToCol_;
+    vector<int> cgRowToCol_;
+    /** column index of each global atom, or -1 (only set while migrating) */
+    vector<int> globalToCol_;
+
+    /**
+     * Exclusions and topological distances of the local atoms, using
+     * global atom indices.  These travel with the atoms to their home
+     * domains.
+     */
+    vector<vector<int> > localExcludes_;
+    vector<vector<int> > localTopos_;
+    vector<vector<int> > localTopoDist_;
+#endif
+  };
+}
+#endif
@@ -83,6 +83,10 @@ namespace OpenMD {
       return isDynamic_;
     }
 
+    const std::string& getScript() const {
+      return script;
+    }
+
     bool hadRuntimeError() const{
       return error;
     }
@@ -294,4 +294,130 @@ namespace OpenMD {
     return ret;
   }
   
+
+  static inline bool isDelimiter(char c) {
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ';');
+  }
+
+  static inline bool isDigit(char c) {
+    return (c >= '0' && c <= '9');
+  }
+
+  static const double exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  bool scanDouble(const char*& p, double& value) {
+    const char* s = p;
+    while (isDelimiter(*s)) s++;
+    const char* start = s;
+
+    bool negative = false;
+    if (*s == '-' || *s == '+') {
+      negative = (*s == '-');
+      s++;
+    }
+
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool anyDigits = false;
+    bool truncated = false;
+
+    for (; isDigit(*s); s++) {
+      anyDigits = true;
+      if (digits < 19) {
+        mantissa = 10 * mantissa + (*s - '0');
+        if (mantissa != 0) digits++;
+      } else {
+        truncated = true;
+      }
+    }
+    if (*s == '.') {
+      s++;
+      for (; isDigit(*s); s++) {
+        anyDigits = true;
+        if (digits < 19) {
+          mantissa = 10 * mantissa + (*s - '0');
+          if (mantissa != 0) digits++;
+          exponent--;
+        } else {
+          truncated = true;
+        }
+      }
+    }
+
+    if (anyDigits && (*s == 'e' || *s == 'E' || *s == 'd' || *s == 'D')) {
+      const char* e = s + 1;
+      bool negativeExponent = false;
+      if (*e == '-' || *e == '+') {
+        negativeExponent = (*e == '-');
+        e++;
+      }
+      if (isDigit(*e)) {
+        int exp10 = 0;
+        for (; isDigit(*e); e++) 
+          if (exp10 < 100000) exp10 = 10 * exp10 + (*e - '0');
+        exponent += negativeExponent ? -exp10 : exp10;
+        s = e;
+      }
+    }
+
+    if (anyDigits && !truncated && mantissa <= (1ULL << 53) &&
+        exponent >= -22 && exponent <= 22) {
+      double v = double(mantissa);
+      if (exponent < 0) 
+        v /= exactPowersOfTen[-exponent];
+      else
+        v *= exactPowersOfTen[exponent];
+      value = negative ? -v : v;
+      p = s;
+      return true;
+    }
+
+    // the slow path handles long mantissas, large exponents, inf and nan:
+    char buffer[64];
+    int n = 0;
+    for (const char* c = start; *c != '\0' && !isDelimiter(*c) && n < 63; 
+         c++, n++) 
+      buffer[n] = (*c == 'd' || *c == 'D') ? 'e' : *c;
+    buffer[n] = '\0';
+    
+    char* end;
+    value = strtod(buffer, &end);
+    if (end == buffer) return false;
+    p = start + (end - buffer);
+    return true;
+  }
+
+  bool scanInt(const char*& p, int& value) {
+    const char* s = p;
+    while (isDelimiter(*s)) s++;
+
+    bool negative = false;
+    if (*s == '-' || *s == '+') {
+      negative = (*s == '-');
+      s++;
+    }
+    if (!isDigit(*s)) return false;
+
+    long v = 0;
+    for (; isDigit(*s); s++) v = 10 * v + (*s - '0');
+    value = negative ? -v : v;
+    p = s;
+    return true;
+  }
+
+  bool scanToken(const char*& p, const char*& begin, const char*& end) {
+    const char* s = p;
+    while (isDelimiter(*s)) s++;
+    if (*s == '\0') return false;
+
+    begin = s;
+    while (*s != '\0' && !isDelimiter(*s)) s++;
+    end = s;
+    p = s;
+    return true;
+  }
 }
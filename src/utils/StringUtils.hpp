@@ -181,5 +181,29 @@ std::string containerToString(const ContainerType& cont) {
     return oss.str();
 }  
   unsigned long long memparse (char *ptr,  char **retptr); 
+
+  /**
+   * Reads the next number from a line in place, without the
+   * allocations of StringTokenizer.  Leading delimiters (the default
+   * StringTokenizer delimiters) are skipped, and on success p is left
+   * just past the number.  Fortran exponents (1.0D-3) are accepted.
+   *
+   * Numbers with at most 19 significant digits and a power of ten
+   * no larger than 22 (which covers everything DumpWriter writes) are
+   * converted with a single multiplication or division, which is
+   * exact (Clinger's fast path).  Anything else goes to strtod.
+   *
+   * @return false if there is no number at p
+   */
+  bool scanDouble(const char*& p, double& value);
+
+  /** Reads the next integer from a line in place, see scanDouble */
+  bool scanInt(const char*& p, int& value);
+
+  /**
+   * Finds the next token of a line in place.  On success, [begin,
+   * end) is the token and p is left at end.
+   */
+  bool scanToken(const char*& p, const char*& begin, const char*& end);
 }  
 #endif
@@ -46,6 +46,13 @@
 #include <math.h>
 #include "config.h"
 #include "utils/next_combination.hpp"
+#ifdef _OPENMP
+#include <omp.h>
+#elif defined(IS_MPI)
+#include <mpi.h>
+#else
+#include <sys/time.h>
+#endif
 
 using namespace std;
 namespace OpenMD {
@@ -53,6 +60,21 @@ namespace OpenMD {
     return ( x >= 0 ) ? floor( x + 0.5 ) : ceil( x - 0.5 );
   }
 
+  /**
+   * @brief wall clock time in seconds, for timing sections of code
+   */
+  inline RealType wallTime() {
+#ifdef _OPENMP
+    return omp_get_wtime();
+#elif defined(IS_MPI)
+    return MPI_Wtime();
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + 1.0e-6 * tv.tv_usec;
+#endif
+  }
+
   /**
    * @brief iteratively replace the sequence with wild cards
    * @return true if more combination sequence is avaliable, otherwise